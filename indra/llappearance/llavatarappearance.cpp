@@ -209,6 +209,7 @@ void LLAvatarAppearance::initInstance()
 	//-------------------------------------------------------------------------
 	mRoot = createAvatarJoint();
 	mRoot->setName( "mRoot" );
+	mJointHierarchy.setRoot(mRoot);
 
 	for (LLAvatarAppearanceDictionary::MeshEntries::const_iterator iter = LLAvatarAppearanceDictionary::getInstance()->getMeshEntries().begin();
 		 iter != LLAvatarAppearanceDictionary::getInstance()->getMeshEntries().end();
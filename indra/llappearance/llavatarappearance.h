@@ -30,6 +30,7 @@
 #include "llcharacter.h"
 #include "llavatarappearancedefines.h"
 #include "llavatarjointmesh.h"
+#include "lljointhierarchy.h"
 #include "lldriverparam.h"
 #include "lltexlayer.h"
 #include "llviewervisualparam.h"
@@ -133,6 +134,7 @@ public:
 
 	LLVector3			mHeadOffset; // current head position
 	LLAvatarJoint		*mRoot;
+	LLJointHierarchy	mJointHierarchy;	// flattened mRoot, use for world matrix updates
 
 	typedef std::map<std::string, LLJoint*> joint_map_t;
 	joint_map_t			mJointMap;
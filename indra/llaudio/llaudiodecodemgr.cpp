@@ -28,7 +28,9 @@
 #include "llaudiodecodemgr.h"
 
 #include "llaudioengine.h"
-#include "lllfsthread.h"
+#include "llfile.h"
+#include "llthread.h"
+#include "lltimer.h"
 #include "llvfile.h"
 #include "llstring.h"
 #include "lldir.h"
@@ -42,58 +44,50 @@
 #include "vorbis/vorbisfile.h"
 #include <iterator>
 #include <deque>
+#include <list>
+#include <map>
+#include <set>
 
 extern LLAudioEngine *gAudiop;
 
 LLAudioDecodeMgr *gAudioDecodeMgrp = NULL;
 
+U32 LLAudioDecodeMgr::sNumDecodeThreads = 2;
+U64 LLAudioDecodeMgr::sMaxCacheBytes = 32*1024*1024;
+
 static const S32 WAV_HEADER_SIZE = 44;
 
 
 //////////////////////////////////////////////////////////////////////////////
 
 
+// Decodes one sound start to finish, used by a single decode thread
 class LLVorbisDecodeState : public LLRefCount
 {
 public:
-	class WriteResponder : public LLLFSThread::Responder
-	{
-	public:
-		WriteResponder(LLVorbisDecodeState* decoder) : mDecoder(decoder) {}
-		~WriteResponder() {}
-		void completed(S32 bytes)
-		{
-			mDecoder->ioComplete(bytes);
-		}
-		LLPointer<LLVorbisDecodeState> mDecoder;
-	};
-	
 	LLVorbisDecodeState(const LLUUID &uuid, const std::string &out_filename);
 
 	BOOL initDecode();
 	BOOL decodeSection(); // Return TRUE if done.
-	BOOL finishDecode();
+	BOOL finishDecode(); // Return TRUE if the WAV image is good.
+	BOOL writeDecodedFile();
 
 	void flushBadFile();
 
-	void ioComplete(S32 bytes)			{ mBytesRead = bytes; }
 	BOOL isValid() const				{ return mValid; }
 	BOOL isDone() const					{ return mDone; }
 	const LLUUID &getUUID() const		{ return mUUID; }
+	const std::vector<U8> &getWAVBuffer() const { return mWAVBuffer; }
 
 protected:
 	virtual ~LLVorbisDecodeState();
 
 	BOOL mValid;
 	BOOL mDone;
-	LLAtomicS32 mBytesRead;
 	LLUUID mUUID;
 
 	std::vector<U8> mWAVBuffer;
-#if !defined(USE_WAV_VFILE)
 	std::string mOutFilename;
-	LLLFSThread::handle_t mFileHandle;
-#endif
 	
 	LLVFile *mInFilep;
 	OggVorbis_File mVF;
@@ -168,14 +162,10 @@ LLVorbisDecodeState::LLVorbisDecodeState(const LLUUID &uuid, const std::string &
 {
 	mDone = FALSE;
 	mValid = FALSE;
-	mBytesRead = -1;
 	mUUID = uuid;
 	mInFilep = NULL;
 	mCurrentSection = 0;
-#if !defined(USE_WAV_VFILE)
 	mOutFilename = out_filename;
-	mFileHandle = LLLFSThread::nullHandle();
-#endif
 	// No default value for mVF, it's an ogg structure?
 	// Hey, let's zero it anyway, for predictability.
 	memset(&mVF, 0, sizeof(mVF));
@@ -408,12 +398,9 @@ BOOL LLVorbisDecodeState::finishDecode()
 	if (!isValid())
 	{
 		LL_WARNS("AudioEngine") << "Bogus vorbis decode state for " << getUUID() << ", aborting!" << LL_ENDL;
-		return TRUE; // We've finished
+		return FALSE;
 	}
 
-#if !defined(USE_WAV_VFILE)	
-	if (mFileHandle == LLLFSThread::nullHandle())
-#endif
 	{
 		ov_clear(&mVF);
   
@@ -484,42 +471,52 @@ BOOL LLVorbisDecodeState::finishDecode()
 		{
 			LL_WARNS("AudioEngine") << "BAD Vorbis decode in finishDecode!" << LL_ENDL;
 			mValid = FALSE;
-			return TRUE; // we've finished
-		}
-#if !defined(USE_WAV_VFILE)
-		mBytesRead = -1;
-		mFileHandle = LLLFSThread::sLocal->write(mOutFilename, &mWAVBuffer[0], 0, mWAVBuffer.size(),
-							 new WriteResponder(this));
-#endif
-	}
-
-	if (mFileHandle != LLLFSThread::nullHandle())
-	{
-		if (mBytesRead >= 0)
-		{
-			if (mBytesRead == 0)
-			{
-				LL_WARNS("AudioEngine") << "Unable to write file in LLVorbisDecodeState::finishDecode" << LL_ENDL;
-				mValid = FALSE;
-				return TRUE; // we've finished
-			}
-		}
-		else
-		{
-			return FALSE; // not done
+			return FALSE;
 		}
 	}
 	
 	mDone = TRUE;
 
+	LL_DEBUGS("AudioEngine") << "Finished decode for " << getUUID() << LL_ENDL;
+
+	return TRUE;
+}
+
+BOOL LLVorbisDecodeState::writeDecodedFile()
+{
 #if defined(USE_WAV_VFILE)
 	// write the data.
 	LLVFile output(gVFS, mUUID, LLAssetType::AT_SOUND_WAV);
-	output.write(&mWAVBuffer[0], mWAVBuffer.size());
-#endif
-	LL_DEBUGS("AudioEngine") << "Finished decode for " << getUUID() << LL_ENDL;
+	return output.write(&mWAVBuffer[0], mWAVBuffer.size());
+#else
+	// write under a per-thread name and move into place so the engine never
+	// loads a partial file
+	std::string tmp_filename = mOutFilename + llformat(".%u.tmp", LLThread::currentID());
+
+	LLFILE* fp = LLFile::fopen(tmp_filename, "wb");
+	if (!fp)
+	{
+		LL_WARNS("AudioEngine") << "Unable to open " << tmp_filename << " for writing" << LL_ENDL;
+		return FALSE;
+	}
 
-	return TRUE;
+	BOOL success = fwrite(&mWAVBuffer[0], 1, mWAVBuffer.size(), fp) == mWAVBuffer.size();
+	fclose(fp);
+
+	if (success)
+	{
+		// rename doesn't replace an existing file on every platform
+		LLFile::remove(mOutFilename);
+		success = LLFile::rename(tmp_filename, mOutFilename) == 0;
+	}
+
+	if (!success)
+	{
+		LL_WARNS("AudioEngine") << "Unable to write file " << mOutFilename << LL_ENDL;
+		LLFile::remove(tmp_filename);
+	}
+	return success;
+#endif
 }
 
 void LLVorbisDecodeState::flushBadFile()
@@ -537,134 +534,314 @@ class LLAudioDecodeMgr::Impl
 {
 	friend class LLAudioDecodeMgr;
 public:
-	Impl() {};
-	~Impl() {};
+	struct Request
+	{
+		LLUUID mUUID;
+		std::string mOutFilename;
+	};
 
-	void processQueue(const F32 num_secs = 0.005);
+	enum EDecodeStatus
+	{
+		DECODE_OK,
+		DECODE_BAD_DATA,	// bad vorbis data, the VFS copy has been flushed
+		DECODE_FAILED
+	};
+
+	struct Result
+	{
+		LLUUID mUUID;
+		EDecodeStatus mStatus;
+		std::vector<U8> mWAVData;
+	};
+
+	class DecodeThread : public LLThread
+	{
+	public:
+		DecodeThread(Impl* impl, const std::string& name);
+		virtual void run();
+
+		Impl* mImpl;
+	};
+
+	Impl(U32 num_threads);
+	~Impl();
+
+	void processQueue();
+	void submitRequest(const LLUUID &uuid);
+
+	// Blocks until a request is available, false when shutting down
+	bool getNextRequest(Request& request);
+	void processRequest(const Request& request);
+
+	void addToCache(const LLUUID &uuid, std::vector<U8>& data);
+	const std::vector<U8>* getCachedData(const LLUUID &uuid);
 
 protected:
-	std::deque<LLUUID> mDecodeQueue;
-	LLPointer<LLVorbisDecodeState> mCurrentDecodep;
+	struct CacheEntry
+	{
+		std::vector<U8> mData;
+		std::list<LLUUID>::iterator mLRUIter;
+	};
+	typedef std::map<LLUUID, CacheEntry> cache_map_t;
+
+	LLCondition* mSignal;				// guards mRequestQ and mQuitting
+	std::deque<Request> mRequestQ;
+	bool mQuitting;
+	LLMutex* mResultMutex;				// guards mResultQ
+	std::deque<Result> mResultQ;
+	std::vector<DecodeThread*> mThreads;
+
+	// Thread:  main
+	std::set<LLUUID> mPending;			// queued or being decoded
+	cache_map_t mCache;
+	std::list<LLUUID> mLRU;				// most recently used first
+	U64 mCacheBytes;
 };
 
+LLAudioDecodeMgr::Impl::DecodeThread::DecodeThread(Impl* impl, const std::string& name)
+:	LLThread(name),
+	mImpl(impl)
+{
+}
 
-void LLAudioDecodeMgr::Impl::processQueue(const F32 num_secs)
+void LLAudioDecodeMgr::Impl::DecodeThread::run()
 {
-	LLUUID uuid;
+	Request request;
+	while (mImpl->getNextRequest(request))
+	{
+		mImpl->processRequest(request);
+	}
+}
+
+LLAudioDecodeMgr::Impl::Impl(U32 num_threads)
+:	mQuitting(false),
+	mCacheBytes(0)
+{
+	mSignal = new LLCondition(NULL);
+	mResultMutex = new LLMutex(NULL);
+
+	num_threads = llclamp(num_threads, (U32) 1, (U32) 8);
+	for (U32 i = 0; i < num_threads; ++i)
+	{
+		DecodeThread* thread = new DecodeThread(this, llformat("audio decode %d", i));
+		mThreads.push_back(thread);
+		thread->start();
+	}
+}
 
-	LLTimer decode_timer;
+LLAudioDecodeMgr::Impl::~Impl()
+{
+	mSignal->lock();
+	mQuitting = true;
+	mSignal->broadcast();
+	mSignal->unlock();
 
-	BOOL done = FALSE;
-	while (!done)
+	// a thread finishes the sound it is on before it notices
+	for (U32 i = 0; i < mThreads.size(); ++i)
 	{
-		if (mCurrentDecodep)
+		while (!mThreads[i]->isStopped())
 		{
-			BOOL res;
+			ms_sleep(10);
+		}
+		delete mThreads[i];
+	}
+	mThreads.clear();
 
-			// Decode in a loop until we're done or have run out of time.
-			while(!(res = mCurrentDecodep->decodeSection()) && (decode_timer.getElapsedTimeF32() < num_secs))
-			{
-				// decodeSection does all of the work above
-			}
+	delete mResultMutex;
+	mResultMutex = NULL;
+	delete mSignal;
+	mSignal = NULL;
+}
 
-			if (mCurrentDecodep->isDone() && !mCurrentDecodep->isValid())
-			{
-				// We had an error when decoding, abort.
-				LL_WARNS("AudioEngine") << mCurrentDecodep->getUUID() << " has invalid vorbis data, aborting decode" << LL_ENDL;
-				mCurrentDecodep->flushBadFile();
-
-				if (gAudiop)
-				{
-					LLAudioData *adp = gAudiop->getAudioData(mCurrentDecodep->getUUID());
-					adp->setHasValidData(false);
-					adp->setHasCompletedDecode(true);
-				}
-
-				mCurrentDecodep = NULL;
-				done = TRUE;
-			}
+void LLAudioDecodeMgr::Impl::submitRequest(const LLUUID &uuid)
+{
+	if (!mPending.insert(uuid).second)
+	{
+		// already on its way
+		return;
+	}
 
-			if (!res)
-			{
-				// We've used up out time slice, bail...
-				done = TRUE;
-			}
-			else if (mCurrentDecodep)
-			{
-				if (gAudiop && mCurrentDecodep->finishDecode())
-				{
-					// We finished!
-					LLAudioData *adp = gAudiop->getAudioData(mCurrentDecodep->getUUID());
-					if (!adp)
-					{
-						LL_WARNS("AudioEngine") << "Missing LLAudioData for decode of " << mCurrentDecodep->getUUID() << LL_ENDL;
-					}
-					else if (mCurrentDecodep->isValid() && mCurrentDecodep->isDone())
-					{
-						adp->setHasCompletedDecode(true);
-						adp->setHasDecodedData(true);
-						adp->setHasValidData(true);
-
-						// At this point, we could see if anyone needs this sound immediately, but
-						// I'm not sure that there's a reason to - we need to poll all of the playing
-						// sounds anyway.
-						//LL_INFOS("AudioEngine") << "Finished the vorbis decode, now what?" << LL_ENDL;
-					}
-					else
-					{
-						adp->setHasCompletedDecode(true);
-						LL_INFOS("AudioEngine") << "Vorbis decode failed for " << mCurrentDecodep->getUUID() << LL_ENDL;
-					}
-					mCurrentDecodep = NULL;
-				}
-				done = TRUE; // done for now
-			}
+	Request request;
+	request.mUUID = uuid;
+	request.mOutFilename = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, uuid.asString()) + ".dsf";
+
+	mSignal->lock();
+	mRequestQ.push_back(request);
+	mSignal->signal();
+	mSignal->unlock();
+}
+
+bool LLAudioDecodeMgr::Impl::getNextRequest(Request& request)
+{
+	mSignal->lock();
+	while (!mQuitting && mRequestQ.empty())
+	{
+		mSignal->wait();
+	}
+
+	bool ret = !mQuitting;
+	if (ret)
+	{
+		request = mRequestQ.front();
+		mRequestQ.pop_front();
+	}
+	mSignal->unlock();
+
+	return ret;
+}
+
+// Thread:  decode pool
+void LLAudioDecodeMgr::Impl::processRequest(const Request& request)
+{
+	LL_DEBUGS("AudioEngine") << "Decoding " << request.mUUID << " from audio queue!" << LL_ENDL;
+
+	Result result;
+	result.mUUID = request.mUUID;
+	result.mStatus = DECODE_FAILED;
+
+	LLPointer<LLVorbisDecodeState> decoder = new LLVorbisDecodeState(request.mUUID, request.mOutFilename);
+	if (decoder->initDecode())
+	{
+		while (!decoder->decodeSection())
+		{
+			// decodeSection does all of the work above
 		}
 
-		if (!done)
+		if (decoder->isDone() && !decoder->isValid())
 		{
-			if (mDecodeQueue.empty())
-			{
-				// Nothing else on the queue.
-				done = TRUE;
-			}
-			else
+			// We had an error when decoding, abort.
+			LL_WARNS("AudioEngine") << request.mUUID << " has invalid vorbis data, aborting decode" << LL_ENDL;
+			decoder->flushBadFile();
+			result.mStatus = DECODE_BAD_DATA;
+		}
+		else if (decoder->finishDecode())
+		{
+			result.mStatus = DECODE_OK;
+		}
+	}
+
+	// Without the memory cache the engine can only play the file, so
+	// it has to be on disk before the sound is reported as decoded.
+	bool write_first = sMaxCacheBytes == 0;
+	if (result.mStatus == DECODE_OK)
+	{
+		if (write_first)
+		{
+			if (!decoder->writeDecodedFile())
 			{
-				LLUUID uuid;
-				uuid = mDecodeQueue.front();
-				mDecodeQueue.pop_front();
-				if (!gAudiop || gAudiop->hasDecodedFile(uuid))
-				{
-					// This file has already been decoded, don't decode it again.
-					continue;
-				}
-
-				LL_DEBUGS() << "Decoding " << uuid << " from audio queue!" << LL_ENDL;
-
-				std::string uuid_str;
-				std::string d_path;
-
-				LLTimer timer;
-				timer.reset();
-
-				uuid.toString(uuid_str);
-				d_path = gDirUtilp->getExpandedFilename(LL_PATH_CACHE,uuid_str) + ".dsf";
-
-				mCurrentDecodep = new LLVorbisDecodeState(uuid, d_path);
-				if (!mCurrentDecodep->initDecode())
-				{
-					mCurrentDecodep = NULL;
-				}
+				result.mStatus = DECODE_FAILED;
 			}
 		}
+		else
+		{
+			result.mWAVData = decoder->getWAVBuffer();
+		}
+	}
+
+	{
+		LLMutexLock lock(mResultMutex);
+		mResultQ.push_back(Result());
+		mResultQ.back().mUUID = result.mUUID;
+		mResultQ.back().mStatus = result.mStatus;
+		mResultQ.back().mWAVData.swap(result.mWAVData);
+	}
+
+	// the sound can play from memory already, the file is for next time
+	if (result.mStatus == DECODE_OK && !write_first)
+	{
+		decoder->writeDecodedFile();
 	}
 }
 
+void LLAudioDecodeMgr::Impl::processQueue()
+{
+	std::deque<Result> results;
+	{
+		LLMutexLock lock(mResultMutex);
+		results.swap(mResultQ);
+	}
+
+	for (std::deque<Result>::iterator iter = results.begin(); iter != results.end(); ++iter)
+	{
+		Result& result = *iter;
+		mPending.erase(result.mUUID);
+
+		if (result.mStatus == DECODE_OK && !result.mWAVData.empty())
+		{
+			addToCache(result.mUUID, result.mWAVData);
+		}
+
+		LLAudioData *adp = gAudiop ? gAudiop->getAudioData(result.mUUID) : NULL;
+		if (!adp)
+		{
+			LL_WARNS("AudioEngine") << "Missing LLAudioData for decode of " << result.mUUID << LL_ENDL;
+		}
+		else if (result.mStatus == DECODE_OK)
+		{
+			adp->setHasCompletedDecode(true);
+			adp->setHasDecodedData(true);
+			adp->setHasValidData(true);
+
+			// At this point, we could see if anyone needs this sound immediately, but
+			// I'm not sure that there's a reason to - we need to poll all of the playing
+			// sounds anyway.
+		}
+		else if (result.mStatus == DECODE_BAD_DATA)
+		{
+			adp->setHasValidData(false);
+			adp->setHasCompletedDecode(true);
+		}
+		else
+		{
+			adp->setHasCompletedDecode(true);
+			LL_INFOS("AudioEngine") << "Vorbis decode failed for " << result.mUUID << LL_ENDL;
+		}
+	}
+}
+
+void LLAudioDecodeMgr::Impl::addToCache(const LLUUID &uuid, std::vector<U8>& data)
+{
+	cache_map_t::iterator iter = mCache.find(uuid);
+	if (iter != mCache.end())
+	{
+		mCacheBytes -= iter->second.mData.size();
+		mLRU.erase(iter->second.mLRUIter);
+		mCache.erase(iter);
+	}
+
+	mLRU.push_front(uuid);
+	CacheEntry& entry = mCache[uuid];
+	entry.mData.swap(data);
+	entry.mLRUIter = mLRU.begin();
+	mCacheBytes += entry.mData.size();
+
+	// always keep the newest sound, it is about to be loaded
+	while (mCacheBytes > sMaxCacheBytes && mLRU.size() > 1)
+	{
+		iter = mCache.find(mLRU.back());
+		mCacheBytes -= iter->second.mData.size();
+		mCache.erase(iter);
+		mLRU.pop_back();
+	}
+}
+
+const std::vector<U8>* LLAudioDecodeMgr::Impl::getCachedData(const LLUUID &uuid)
+{
+	cache_map_t::iterator iter = mCache.find(uuid);
+	if (iter == mCache.end())
+	{
+		return NULL;
+	}
+
+	mLRU.splice(mLRU.begin(), mLRU, iter->second.mLRUIter);
+	return &iter->second.mData;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 LLAudioDecodeMgr::LLAudioDecodeMgr()
 {
-	mImpl = new Impl;
+	mImpl = new Impl(sNumDecodeThreads);
 }
 
 LLAudioDecodeMgr::~LLAudioDecodeMgr()
@@ -674,7 +851,17 @@ LLAudioDecodeMgr::~LLAudioDecodeMgr()
 
 void LLAudioDecodeMgr::processQueue(const F32 num_secs)
 {
-	mImpl->processQueue(num_secs);
+	mImpl->processQueue();
+}
+
+const std::vector<U8>* LLAudioDecodeMgr::getDecodedData(const LLUUID &uuid)
+{
+	return mImpl->getCachedData(uuid);
+}
+
+bool LLAudioDecodeMgr::hasDecodedData(const LLUUID &uuid) const
+{
+	return mImpl->mCache.find(uuid) != mImpl->mCache.end();
 }
 
 BOOL LLAudioDecodeMgr::addDecodeRequest(const LLUUID &uuid)
@@ -690,7 +877,7 @@ BOOL LLAudioDecodeMgr::addDecodeRequest(const LLUUID &uuid)
 	{
 		// Just put it on the decode queue.
 		LL_DEBUGS("AudioEngine") << "addDecodeRequest for " << uuid << " has local asset file already" << LL_ENDL;
-		mImpl->mDecodeQueue.push_back(uuid);
+		mImpl->submitRequest(uuid);
 		return TRUE;
 	}
 
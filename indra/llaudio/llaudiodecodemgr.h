@@ -33,19 +33,37 @@
 #include "llassettype.h"
 #include "llframetimer.h"
 
+#include <vector>
+
 class LLVFS;
 class LLVorbisDecodeState;
 
+// Sounds are decoded from Vorbis to WAV on a pool of worker threads, several
+// at a time.  Finished WAVs go into a bounded in-memory LRU and are marked
+// ready for playback right away; the .dsf file in the cache directory is
+// written by the worker afterwards and only used once the sound has been
+// evicted from memory.
 class LLAudioDecodeMgr
 {
 public:
 	LLAudioDecodeMgr();
 	~LLAudioDecodeMgr();
 
+	// Picks up finished decodes, the decoding itself happens on the pool.
+	// num_secs is no longer used.
 	void processQueue(const F32 num_secs = 0.005);
 	BOOL addDecodeRequest(const LLUUID &uuid);
 	void addAudioRequest(const LLUUID &uuid);
-	
+
+	// WAV image of a decoded sound if it is still in memory, NULL otherwise.
+	// Valid until the next call to processQueue.
+	// Thread:  main
+	const std::vector<U8>* getDecodedData(const LLUUID &uuid);
+	bool hasDecodedData(const LLUUID &uuid) const;
+
+	static U32 sNumDecodeThreads;	// read when the manager is created
+	static U64 sMaxCacheBytes;		// decoded PCM kept in memory
+
 protected:
 	class Impl;
 	Impl* mImpl;
@@ -1011,6 +1011,12 @@ void LLAudioEngine::cleanupAudioSource(LLAudioSource *asp)
 
 bool LLAudioEngine::hasDecodedFile(const LLUUID &uuid)
 {
+	if (gAudioDecodeMgrp && gAudioDecodeMgrp->hasDecodedData(uuid))
+	{
+		// still in memory, the file may not have been written yet
+		return true;
+	}
+
 	std::string uuid_str;
 	uuid.toString(uuid_str);
 
@@ -1847,6 +1853,13 @@ bool LLAudioData::load()
 		return true;
 	}
 
+	const std::vector<U8>* wav_data = gAudioDecodeMgrp ? gAudioDecodeMgrp->getDecodedData(mID) : NULL;
+	if (wav_data && mBufferp->loadWAVData(&(*wav_data)[0], wav_data->size()))
+	{
+		mBufferp->mAudioDatap = this;
+		return true;
+	}
+
 	std::string uuid_str;
 	std::string wav_path;
 	mID.toString(uuid_str);
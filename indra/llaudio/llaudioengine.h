@@ -444,6 +444,8 @@ class LLAudioBuffer
 public:
 	virtual ~LLAudioBuffer() {};
 	virtual bool loadWAV(const std::string& filename) = 0;
+	// Load from a WAV image in memory, false if the engine can't
+	virtual bool loadWAVData(const U8* data, U32 size) { return false; }
 	virtual U32 getLength() = 0;
 
 	friend class LLAudioEngine;
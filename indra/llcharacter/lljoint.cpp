@@ -35,6 +35,7 @@
 
 S32 LLJoint::sNumUpdates = 0;
 S32 LLJoint::sNumTouches = 0;
+U32 LLJoint::sTopologySerial = 0;
 
 template <class T> 
 bool attachment_map_iter_compare_key(const T& a, const T& b)
@@ -242,6 +243,7 @@ void LLJoint::addChild(LLJoint* joint)
 	joint->mXform.setParent(&mXform);
 	joint->mParent = this;	
 	joint->touch();
+	sTopologySerial++;
 }
 
 
@@ -258,6 +260,7 @@ void LLJoint::removeChild(LLJoint* joint)
 		joint->mXform.setParent(NULL);
 		joint->mParent = NULL;
 		joint->touch();
+		sTopologySerial++;
 	}
 }
 
@@ -276,6 +279,7 @@ void LLJoint::removeAllChildren()
 		joint->mXform.setParent(NULL);
 		joint->mParent = NULL;
 		joint->touch();
+		sTopologySerial++;
 	}
 }
 
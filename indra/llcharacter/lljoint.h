@@ -114,6 +114,10 @@ public:
 	static S32		sNumTouches;
 	static S32		sNumUpdates;
 
+	// bumped whenever any joint gains or loses a child, lets flattened
+	// copies of a hierarchy (LLJointHierarchy) know they are stale
+	static U32		sTopologySerial;
+
 	LLPosOverrideMap m_attachmentOverrides;
 	LLVector3 m_posBeforeOverrides;
 
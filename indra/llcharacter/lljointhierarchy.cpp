@@ -0,0 +1,219 @@
+/**
+ * @file lljointhierarchy.cpp
+ * @brief Implementation of LLJointHierarchy class.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+//-----------------------------------------------------------------------------
+// Header Files
+//-----------------------------------------------------------------------------
+#include "linden_common.h"
+
+#include "lljointhierarchy.h"
+
+#include "lljoint.h"
+#include "llmath.h"
+#include "llvector4a.h"
+#include "llvector4logical.h"
+#include "llquaternion2.h"
+
+//-----------------------------------------------------------------------------
+// Same product as LLQuaternion's a * b: rotate by a, then by b
+//-----------------------------------------------------------------------------
+static inline void quat_mul(const LLQuaternion2& a, const LLQuaternion2& b, LLQuaternion2& res)
+{
+	const LLVector4a& qa = a.getVector4a();
+	const LLVector4a& qb = b.getVector4a();
+
+	LLVector4a aw; aw.splat<3>(qa);
+	LLVector4a bw; bw.splat<3>(qb);
+
+	// xyz = b.w * a + a.w * b + b x a, w = 2 * a.w * b.w so far
+	LLVector4a& out = res.getVector4aRw();
+	out.setMul(qa, bw);
+	LLVector4a tmp;
+	tmp.setMul(qb, aw);
+	out.add(tmp);
+	tmp.setCross3(qb, qa);
+	out.add(tmp);
+
+	// w = a.w * b.w - dot3(a, b)
+	LLVector4a dot;
+	dot.setAllDot4(qa, qb);
+	LLVector4Logical w_only;
+	w_only.clear();
+	w_only.setElement<3>();
+	tmp.setSelectWithMask(w_only, dot, LLVector4a::getZero());
+	out.sub(tmp);
+}
+
+LLJointHierarchy::LLJointHierarchy()
+:	mRoot(NULL),
+	mNeedsRebuild(true),
+	mTopologySerial(0),
+	mWorldPositions(NULL),
+	mWorldRotations(NULL),
+	mCapacity(0)
+{
+}
+
+LLJointHierarchy::~LLJointHierarchy()
+{
+	ll_aligned_free_16(mWorldPositions);
+	ll_aligned_free_16(mWorldRotations);
+}
+
+void LLJointHierarchy::setRoot(LLJoint* root)
+{
+	mRoot = root;
+	mNeedsRebuild = true;
+}
+
+//-----------------------------------------------------------------------------
+// rebuild()
+// Flattens the tree under mRoot, depth first so every subtree is a
+// contiguous range starting at its root.
+//-----------------------------------------------------------------------------
+void LLJointHierarchy::rebuild()
+{
+	mJoints.clear();
+	mParents.clear();
+	mSubtreeEnds.clear();
+
+	mNeedsRebuild = false;
+	mTopologySerial = LLJoint::sTopologySerial;
+
+	if (!mRoot)
+	{
+		return;
+	}
+
+	// pairs of joint and index of its parent, children pushed in reverse so
+	// they come off the stack in list order, same as the recursive walk
+	std::vector<std::pair<LLJoint*, S32> > stack;
+	stack.push_back(std::make_pair(mRoot, -1));
+	while (!stack.empty())
+	{
+		LLJoint* joint = stack.back().first;
+		S32 parent = stack.back().second;
+		stack.pop_back();
+
+		S32 index = (S32) mJoints.size();
+		mJoints.push_back(joint);
+		mParents.push_back(parent);
+		mSubtreeEnds.push_back(index + 1);
+
+		for (LLJoint::child_list_t::reverse_iterator iter = joint->mChildren.rbegin();
+			 iter != joint->mChildren.rend(); ++iter)
+		{
+			stack.push_back(std::make_pair(*iter, index));
+		}
+	}
+
+	// every joint extends the range of all its ancestors
+	for (S32 i = (S32) mJoints.size() - 1; i > 0; --i)
+	{
+		S32 parent = mParents[i];
+		mSubtreeEnds[parent] = llmax(mSubtreeEnds[parent], mSubtreeEnds[i]);
+	}
+
+	if ((S32) mJoints.size() > mCapacity)
+	{
+		ll_aligned_free_16(mWorldPositions);
+		ll_aligned_free_16(mWorldRotations);
+		mCapacity = mJoints.size();
+		mWorldPositions = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * mCapacity);
+		mWorldRotations = (LLQuaternion2*) ll_aligned_malloc_16(sizeof(LLQuaternion2) * mCapacity);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// updateWorldMatrices()
+//-----------------------------------------------------------------------------
+void LLJointHierarchy::updateWorldMatrices()
+{
+	if (mNeedsRebuild || mTopologySerial != LLJoint::sTopologySerial)
+	{
+		rebuild();
+	}
+
+	const S32 num_joints = (S32) mJoints.size();
+	S32 i = 0;
+	while (i < num_joints)
+	{
+		LLJoint* joint = mJoints[i];
+		if (!joint->mUpdateXform)
+		{
+			i = mSubtreeEnds[i];
+			continue;
+		}
+
+		LLXformMatrix* xform = joint->getXform();
+		S32 parent = mParents[i];
+
+		if (!(joint->mDirtyFlags & LLJoint::MATRIX_DIRTY))
+		{
+			// up to date, children still need our world transform
+			mWorldPositions[i].load3(xform->getWorldPosition().mV);
+			mWorldRotations[i] = xform->getWorldRotation();
+		}
+		else if (parent < 0 || xform->getParent() != mJoints[parent]->getXform())
+		{
+			// the root may hang off an object xform outside the hierarchy
+			joint->updateWorldMatrix();
+			mWorldPositions[i].load3(xform->getWorldPosition().mV);
+			mWorldRotations[i] = xform->getWorldRotation();
+		}
+		else
+		{
+			LLJoint::sNumUpdates++;
+
+			LLVector4a local_pos;
+			local_pos.load3(xform->getPosition().mV);
+
+			LLXformMatrix* parent_xform = mJoints[parent]->getXform();
+			if (parent_xform->getScaleChildOffset())
+			{
+				LLVector4a parent_scale;
+				parent_scale.load3(parent_xform->getScale().mV);
+				local_pos.mul(parent_scale);
+			}
+
+			LLVector4a& world_pos = mWorldPositions[i];
+			world_pos.setRotated(mWorldRotations[parent], local_pos);
+			world_pos.add(mWorldPositions[parent]);
+
+			LLQuaternion2& world_rot = mWorldRotations[i];
+			quat_mul(LLQuaternion2(xform->getRotation()), mWorldRotations[parent], world_rot);
+
+			LLVector3 pos(world_pos.getF32ptr());
+			LLQuaternion rot;
+			memcpy(rot.mQ, world_rot.getVector4a().getF32ptr(), sizeof(rot.mQ));
+			xform->setWorldTransform(pos, rot);
+
+			joint->mDirtyFlags = 0x0;
+		}
+
+		++i;
+	}
+}
@@ -0,0 +1,82 @@
+/**
+ * @file lljointhierarchy.h
+ * @brief Flattened joint hierarchy for batched world matrix updates.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLJOINTHIERARCHY_H
+#define LL_LLJOINTHIERARCHY_H
+
+#include <vector>
+
+class LLJoint;
+class LLQuaternion2;
+class LLVector4a;
+
+//-----------------------------------------------------------------------------
+// class LLJointHierarchy
+//
+// Pre-order copy of a joint tree so world matrices can be brought up to date
+// in one linear pass instead of a recursive walk over std::list children.
+// Parents always come before their children, so by the time a joint is
+// reached its parent's world position and rotation sit in the aligned
+// arrays below and the joint's own can be computed with SSE.
+//
+// The LLJoints stay the interface everyone else uses: local transforms are
+// still set on the joints and results are written back to their xforms.
+// The flattened copy is rebuilt whenever LLJoint::sTopologySerial changes.
+//-----------------------------------------------------------------------------
+class LLJointHierarchy
+{
+public:
+	LLJointHierarchy();
+	~LLJointHierarchy();
+
+	void setRoot(LLJoint* root);
+	LLJoint* getRoot() const { return mRoot; }
+
+	// same result as getRoot()->updateWorldMatrixChildren()
+	void updateWorldMatrices();
+
+	S32 getNumJoints() const { return (S32) mJoints.size(); }
+	LLJoint* getJoint(S32 index) const { return mJoints[index]; }
+	S32 getParentIndex(S32 index) const { return mParents[index]; }
+
+private:
+	void rebuild();
+
+	LLJoint*				mRoot;
+	bool					mNeedsRebuild;
+	U32						mTopologySerial;	// LLJoint::sTopologySerial at last rebuild
+
+	std::vector<LLJoint*>	mJoints;			// pre-order
+	std::vector<S32>		mParents;			// index into mJoints, -1 for the root
+	std::vector<S32>		mSubtreeEnds;		// index one past the joint's last descendant
+
+	// world transforms by joint index, 16 byte aligned
+	LLVector4a*				mWorldPositions;
+	LLQuaternion2*			mWorldRotations;
+	S32						mCapacity;
+};
+
+#endif // LL_LLJOINTHIERARCHY_H
@@ -39,6 +39,7 @@
 #include "llendianswizzle.h"
 #include "llkeyframemotion.h"
 #include "llquantize.h"
+#include "llvector4a.h"
 #include "llvfile.h"
 #include "m3math.h"
 #include "message.h"
@@ -129,6 +130,62 @@ U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo()
 //-----------------------------------------------------------------------------
 
 
+//-----------------------------------------------------------------------------
+// KeyTimes::insert()
+//-----------------------------------------------------------------------------
+S32 LLKeyframeMotion::KeyTimes::insert(F32 time, bool& replaced)
+{
+	std::vector<F32>::iterator iter = std::lower_bound(mTimes.begin(), mTimes.end(), time);
+	S32 index = iter - mTimes.begin();
+	replaced = iter != mTimes.end() && *iter == time;
+	if (!replaced)
+	{
+		mTimes.insert(iter, time);
+	}
+	return index;
+}
+
+//-----------------------------------------------------------------------------
+// KeyTimes::find()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::KeyTimes::find(F32 time, S32& cursor, S32& before, S32& after, F32& u) const
+{
+	const S32 num_keys = size();
+	llassert(num_keys > 0);
+
+	// right is the first key at or after time, try the last result and the
+	// key after it before falling back to a binary search
+	S32 right = llclamp(cursor, 0, num_keys);
+	if (!((right == 0 || mTimes[right - 1] < time) && (right == num_keys || time <= mTimes[right])))
+	{
+		++right;
+		if (!(right <= num_keys && mTimes[right - 1] < time && (right == num_keys || time <= mTimes[right])))
+		{
+			right = std::lower_bound(mTimes.begin(), mTimes.end(), time) - mTimes.begin();
+		}
+	}
+	cursor = right;
+
+	u = 0.f;
+	if (right == num_keys)
+	{
+		// Past last key
+		before = after = num_keys - 1;
+	}
+	else if (right == 0 || mTimes[right] == time)
+	{
+		// Before first key or exactly on a key
+		before = after = right;
+	}
+	else
+	{
+		// Between two keys
+		before = right - 1;
+		after = right;
+		u = (time - mTimes[before]) / (mTimes[after] - mTimes[before]);
+	}
+}
+
 //-----------------------------------------------------------------------------
 // ScaleCurve::ScaleCurve()
 //-----------------------------------------------------------------------------
@@ -143,51 +200,56 @@ LLKeyframeMotion::ScaleCurve::ScaleCurve()
 //-----------------------------------------------------------------------------
 LLKeyframeMotion::ScaleCurve::~ScaleCurve() 
 {
-	mKeys.clear();
+	mKeyScales.clear();
 	mNumKeys = 0;
 }
 
+//-----------------------------------------------------------------------------
+// addKey()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::ScaleCurve::addKey(const ScaleKey& key)
+{
+	bool replaced;
+	S32 index = mKeyTimes.insert(key.mTime, replaced);
+	if (replaced)
+	{
+		mKeyScales[index] = key.mScale;
+	}
+	else
+	{
+		mKeyScales.insert(mKeyScales.begin() + index, key.mScale);
+	}
+}
+
 //-----------------------------------------------------------------------------
 // getValue()
 //-----------------------------------------------------------------------------
 LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
+{
+	S32 cursor = 0;
+	return getValue(time, duration, cursor);
+}
+
+LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration, S32& cursor)
 {
 	LLVector3 value;
 
-	if (mKeys.empty())
+	if (mKeyTimes.empty())
 	{
 		value.clearVec();
 		return value;
 	}
-	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
-	{
-		// Past last key
-		--right;
-		value = right->second.mScale;
-	}
-	else if (right == mKeys.begin() || right->first == time)
+
+	S32 before, after;
+	F32 u;
+	mKeyTimes.find(time, cursor, before, after, u);
+	if (before == after)
 	{
-		// Before first key or exactly on a key
-		value = right->second.mScale;
+		value = mKeyScales[before];
 	}
 	else
 	{
-		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		ScaleKey& scale_before = left->second;
-		ScaleKey& scale_after = right->second;
-		if (right == mKeys.end())
-		{
-			scale_after = mLoopInKey;
-			index_after = duration;
-		}
-
-		F32 u = (time - index_before) / (index_after - index_before);
-		value = interp(u, scale_before, scale_after);
+		value = interp(u, mKeyScales[before], mKeyScales[after]);
 	}
 	return value;
 }
@@ -195,17 +257,17 @@ LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, ScaleKey& before, ScaleKey& after)
+LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, const LLVector3& before, const LLVector3& after)
 {
 	switch (mInterpolationType)
 	{
 	case IT_STEP:
-		return before.mScale;
+		return before;
 
 	default:
 	case IT_LINEAR:
 	case IT_SPLINE:
-		return lerp(before.mScale, after.mScale, u);
+		return lerp(before, after, u);
 	}
 }
 
@@ -223,51 +285,56 @@ LLKeyframeMotion::RotationCurve::RotationCurve()
 //-----------------------------------------------------------------------------
 LLKeyframeMotion::RotationCurve::~RotationCurve()
 {
-	mKeys.clear();
+	mKeyRotations.clear();
 	mNumKeys = 0;
 }
 
+//-----------------------------------------------------------------------------
+// RotationCurve::addKey()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::RotationCurve::addKey(const RotationKey& key)
+{
+	bool replaced;
+	S32 index = mKeyTimes.insert(key.mTime, replaced);
+	if (replaced)
+	{
+		mKeyRotations[index] = key.mRotation;
+	}
+	else
+	{
+		mKeyRotations.insert(mKeyRotations.begin() + index, key.mRotation);
+	}
+}
+
 //-----------------------------------------------------------------------------
 // RotationCurve::getValue()
 //-----------------------------------------------------------------------------
 LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration)
+{
+	S32 cursor = 0;
+	return getValue(time, duration, cursor);
+}
+
+LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration, S32& cursor)
 {
 	LLQuaternion value;
 
-	if (mKeys.empty())
+	if (mKeyTimes.empty())
 	{
 		value = LLQuaternion::DEFAULT;
 		return value;
 	}
-	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
-	{
-		// Past last key
-		--right;
-		value = right->second.mRotation;
-	}
-	else if (right == mKeys.begin() || right->first == time)
+
+	S32 before, after;
+	F32 u;
+	mKeyTimes.find(time, cursor, before, after, u);
+	if (before == after)
 	{
-		// Before first key or exactly on a key
-		value = right->second.mRotation;
+		value = mKeyRotations[before];
 	}
 	else
 	{
-		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		RotationKey& rot_before = left->second;
-		RotationKey& rot_after = right->second;
-		if (right == mKeys.end())
-		{
-			rot_after = mLoopInKey;
-			index_after = duration;
-		}
-
-		F32 u = (time - index_before) / (index_after - index_before);
-		value = interp(u, rot_before, rot_after);
+		value = interp(u, mKeyRotations[before], mKeyRotations[after]);
 	}
 	return value;
 }
@@ -275,17 +342,17 @@ LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration)
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, RotationKey& before, RotationKey& after)
+LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, const LLQuaternion& before, const LLQuaternion& after)
 {
 	switch (mInterpolationType)
 	{
 	case IT_STEP:
-		return before.mRotation;
+		return before;
 
 	default:
 	case IT_LINEAR:
 	case IT_SPLINE:
-		return nlerp(u, before.mRotation, after.mRotation);
+		return nlerp(u, before, after);
 	}
 }
 
@@ -304,51 +371,56 @@ LLKeyframeMotion::PositionCurve::PositionCurve()
 //-----------------------------------------------------------------------------
 LLKeyframeMotion::PositionCurve::~PositionCurve()
 {
-	mKeys.clear();
+	mKeyPositions.clear();
 	mNumKeys = 0;
 }
 
+//-----------------------------------------------------------------------------
+// PositionCurve::addKey()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::PositionCurve::addKey(const PositionKey& key)
+{
+	bool replaced;
+	S32 index = mKeyTimes.insert(key.mTime, replaced);
+	if (replaced)
+	{
+		mKeyPositions[index] = key.mPosition;
+	}
+	else
+	{
+		mKeyPositions.insert(mKeyPositions.begin() + index, key.mPosition);
+	}
+}
+
 //-----------------------------------------------------------------------------
 // PositionCurve::getValue()
 //-----------------------------------------------------------------------------
 LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
+{
+	S32 cursor = 0;
+	return getValue(time, duration, cursor);
+}
+
+LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration, S32& cursor)
 {
 	LLVector3 value;
 
-	if (mKeys.empty())
+	if (mKeyTimes.empty())
 	{
 		value.clearVec();
 		return value;
 	}
-	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
-	{
-		// Past last key
-		--right;
-		value = right->second.mPosition;
-	}
-	else if (right == mKeys.begin() || right->first == time)
+
+	S32 before, after;
+	F32 u;
+	mKeyTimes.find(time, cursor, before, after, u);
+	if (before == after)
 	{
-		// Before first key or exactly on a key
-		value = right->second.mPosition;
+		value = mKeyPositions[before];
 	}
 	else
 	{
-		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		PositionKey& pos_before = left->second;
-		PositionKey& pos_after = right->second;
-		if (right == mKeys.end())
-		{
-			pos_after = mLoopInKey;
-			index_after = duration;
-		}
-
-		F32 u = (time - index_before) / (index_after - index_before);
-		value = interp(u, pos_before, pos_after);
+		value = interp(u, mKeyPositions[before], mKeyPositions[after]);
 	}
 
 	llassert(value.isFinite());
@@ -359,20 +431,85 @@ LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, PositionKey& after)
+LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, const LLVector3& before, const LLVector3& after)
 {
 	switch (mInterpolationType)
 	{
 	case IT_STEP:
-		return before.mPosition;
+		return before;
 	default:
 	case IT_LINEAR:
 	case IT_SPLINE:
-		return lerp(before.mPosition, after.mPosition, u);
+		return lerp(before, after, u);
 	}
 }
 
 
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// RotationBatch class
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Rotation blends of one motion update, collected so they are normalized
+// back to back over aligned arrays instead of one nlerp call per joint.
+//-----------------------------------------------------------------------------
+class LLKeyframeMotion::RotationBatch
+{
+public:
+	RotationBatch() : mCount(0) {}
+
+	void add(LLJointState* joint_state, const LLQuaternion& before, const LLQuaternion& after, F32 u)
+	{
+		if (mCount == BATCH_SIZE)
+		{
+			flush();
+		}
+		mJointStates[mCount] = joint_state;
+		mBefore[mCount].loadua(before.mQ);
+		mAfter[mCount].loadua(after.mQ);
+		mWeights[mCount] = u;
+		++mCount;
+	}
+
+	// same result as nlerp(u, before, after) for each entry
+	void flush()
+	{
+		LLQuaternion result;
+		for (S32 i = 0; i < mCount; ++i)
+		{
+			if (mBefore[i].dot4(mAfter[i]).getF32() < 0.f)
+			{
+				// opposite hemispheres, nlerp hands these to slerp
+				LLQuaternion before, after;
+				memcpy(before.mQ, mBefore[i].getF32ptr(), sizeof(before.mQ));
+				memcpy(after.mQ, mAfter[i].getF32ptr(), sizeof(after.mQ));
+				mJointStates[i]->setRotation(slerp(mWeights[i], before, after));
+				continue;
+			}
+
+			LLVector4a& blend = mBefore[i];
+			blend.setLerp(mBefore[i], mAfter[i], mWeights[i]);
+			blend.normalize4();
+
+			memcpy(result.mQ, blend.getF32ptr(), sizeof(result.mQ));
+			mJointStates[i]->setRotation(result);
+		}
+		mCount = 0;
+	}
+
+private:
+	enum { BATCH_SIZE = LL_CHARACTER_MAX_JOINTS };
+
+	LLVector4a		mBefore[BATCH_SIZE];
+	LLVector4a		mAfter[BATCH_SIZE];
+	F32				mWeights[BATCH_SIZE];
+	LLJointState*	mJointStates[BATCH_SIZE];
+	S32				mCount;
+};
+
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 // JointMotion class
@@ -382,7 +519,7 @@ LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, Po
 //-----------------------------------------------------------------------------
 // JointMotion::update()
 //-----------------------------------------------------------------------------
-void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, F32 duration)
+void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, F32 duration, KeyCursors& cursors, RotationBatch& rotations)
 {
 	// this value being 0 is the cause of https://jira.lindenlab.com/browse/SL-22678 but I haven't 
 	// managed to get a stack to see how it got here. Testing for 0 here will stop the crash.
@@ -398,15 +535,25 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::SCALE) && mScaleCurve.mNumKeys)
 	{
-		joint_state->setScale( mScaleCurve.getValue( time, duration ) );
+		joint_state->setScale( mScaleCurve.getValue( time, duration, cursors.mScale ) );
 	}
 
 	//-------------------------------------------------------------------------
-	// update rotation component of joint state
+	// update rotation component of joint state, blends go through the batch
 	//-------------------------------------------------------------------------
-	if ((usage & LLJointState::ROT) && mRotationCurve.mNumKeys)
+	if ((usage & LLJointState::ROT) && !mRotationCurve.mKeyTimes.empty())
 	{
-		joint_state->setRotation( mRotationCurve.getValue( time, duration ) );
+		S32 before, after;
+		F32 u;
+		mRotationCurve.mKeyTimes.find(time, cursors.mRotation, before, after, u);
+		if (before == after || mRotationCurve.mInterpolationType == IT_STEP)
+		{
+			joint_state->setRotation( mRotationCurve.mKeyRotations[before] );
+		}
+		else
+		{
+			rotations.add(joint_state, mRotationCurve.mKeyRotations[before], mRotationCurve.mKeyRotations[after], u);
+		}
 	}
 
 	//-------------------------------------------------------------------------
@@ -414,7 +561,7 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::POS) && mPositionCurve.mNumKeys)
 	{
-		joint_state->setPosition( mPositionCurve.getValue( time, duration ) );
+		joint_state->setPosition( mPositionCurve.getValue( time, duration, cursors.mPosition ) );
 	}
 }
 
@@ -727,12 +874,21 @@ BOOL LLKeyframeMotion::onUpdate(F32 time, U8* joint_mask)
 void LLKeyframeMotion::applyKeyframes(F32 time)
 {
 	llassert_always (mJointMotionList->getNumJointMotions() <= mJointStates.size());
+	if (mKeyCursors.size() != mJointStates.size())
+	{
+		mKeyCursors.resize(mJointStates.size());
+	}
+
+	RotationBatch rotations;
 	for (U32 i=0; i<mJointMotionList->getNumJointMotions(); i++)
 	{
 		mJointMotionList->getJointMotion(i)->update(mJointStates[i],
 													  time, 
-													  mJointMotionList->mDuration );
+													  mJointMotionList->mDuration,
+													  mKeyCursors[i],
+													  rotations );
 	}
+	rotations.flush();
 
 	LLJoint::JointPriority* pose_priority = (LLJoint::JointPriority* )mCharacter->getAnimationData("Hand Pose Priority");
 	if (pose_priority)
@@ -1550,7 +1706,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 				return FALSE;
 			}
 
-			rCurve->mKeys[time] = rot_key;
+			rCurve->addKey(rot_key);
 		}
 
 		//---------------------------------------------------------------------
@@ -1629,7 +1785,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 				return FALSE;
 			}
 			
-			pCurve->mKeys[pos_key.mTime] = pos_key;
+			pCurve->addKey(pos_key);
 
 			if (is_pelvis)
 			{
@@ -1888,14 +2044,13 @@ BOOL LLKeyframeMotion::serialize(LLDataPacker& dp) const
 		success &= dp.packS32(joint_motionp->mPriority, "joint_priority");
 		success &= dp.packS32(joint_motionp->mRotationCurve.mNumKeys, "num_rot_keys");
 
-		for (RotationCurve::key_map_t::iterator iter = joint_motionp->mRotationCurve.mKeys.begin();
-			 iter != joint_motionp->mRotationCurve.mKeys.end(); ++iter)
+		RotationCurve& rot_curve = joint_motionp->mRotationCurve;
+		for (S32 k = 0; k < rot_curve.mKeyTimes.size(); ++k)
 		{
-			RotationKey& rot_key = iter->second;
-			U16 time_short = F32_to_U16(rot_key.mTime, 0.f, mJointMotionList->mDuration);
+			U16 time_short = F32_to_U16(rot_curve.mKeyTimes[k], 0.f, mJointMotionList->mDuration);
 			success &= dp.packU16(time_short, "time");
 
-			LLVector3 rot_angles = rot_key.mRotation.packToVector3();
+			LLVector3 rot_angles = rot_curve.mKeyRotations[k].packToVector3();
 			
 			U16 x, y, z;
 			rot_angles.quantize16(-1.f, 1.f, -1.f, 1.f);
@@ -1908,18 +2063,18 @@ BOOL LLKeyframeMotion::serialize(LLDataPacker& dp) const
 		}
 
 		success &= dp.packS32(joint_motionp->mPositionCurve.mNumKeys, "num_pos_keys");
-		for (PositionCurve::key_map_t::iterator iter = joint_motionp->mPositionCurve.mKeys.begin();
-			 iter != joint_motionp->mPositionCurve.mKeys.end(); ++iter)
+		PositionCurve& pos_curve = joint_motionp->mPositionCurve;
+		for (S32 k = 0; k < pos_curve.mKeyTimes.size(); ++k)
 		{
-			PositionKey& pos_key = iter->second;
-			U16 time_short = F32_to_U16(pos_key.mTime, 0.f, mJointMotionList->mDuration);
+			U16 time_short = F32_to_U16(pos_curve.mKeyTimes[k], 0.f, mJointMotionList->mDuration);
 			success &= dp.packU16(time_short, "time");
 
 			U16 x, y, z;
-			pos_key.mPosition.quantize16(-LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET, -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-			x = F32_to_U16(pos_key.mPosition.mV[VX], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-			y = F32_to_U16(pos_key.mPosition.mV[VY], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-			z = F32_to_U16(pos_key.mPosition.mV[VZ], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+			LLVector3& position = pos_curve.mKeyPositions[k];
+			position.quantize16(-LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET, -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+			x = F32_to_U16(position.mV[VX], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+			y = F32_to_U16(position.mV[VY], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+			z = F32_to_U16(position.mV[VZ], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
 			success &= dp.packU16(x, "pos_x");
 			success &= dp.packU16(y, "pos_y");
 			success &= dp.packU16(z, "pos_z");
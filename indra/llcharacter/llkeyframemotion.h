@@ -311,6 +311,33 @@ public:
 		LLVector3	mPosition;
 	};
 
+	//-------------------------------------------------------------------------
+	// KeyTimes
+	// Sorted, unique key times of a curve, the curve keeps its values in a
+	// parallel array.  Curves are shared by every avatar playing the motion
+	// (see LLKeyframeDataCache) so the lookup cursor belongs to the caller.
+	//-------------------------------------------------------------------------
+	class KeyTimes
+	{
+	public:
+		// index to store the value of a key at time, replaced is set when
+		// a key at that time already exists
+		S32 insert(F32 time, bool& replaced);
+
+		// keys to blend for time and the weight of after, before == after
+		// when time is on a key or outside the curve.  cursor is the lookup
+		// result of the previous call, playing forward only ever checks it
+		// and the key after it.
+		void find(F32 time, S32& cursor, S32& before, S32& after, F32& u) const;
+
+		S32 size() const { return (S32) mTimes.size(); }
+		bool empty() const { return mTimes.empty(); }
+		F32 operator[](S32 index) const { return mTimes[index]; }
+
+	private:
+		std::vector<F32>	mTimes;
+	};
+
 	//-------------------------------------------------------------------------
 	// ScaleCurve
 	//-------------------------------------------------------------------------
@@ -319,13 +346,15 @@ public:
 	public:
 		ScaleCurve();
 		~ScaleCurve();
+		void addKey(const ScaleKey& key);
 		LLVector3 getValue(F32 time, F32 duration);
-		LLVector3 interp(F32 u, ScaleKey& before, ScaleKey& after);
+		LLVector3 getValue(F32 time, F32 duration, S32& cursor);
+		LLVector3 interp(F32 u, const LLVector3& before, const LLVector3& after);
 
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
-		typedef std::map<F32, ScaleKey> key_map_t;
-		key_map_t 			mKeys;
+		KeyTimes			mKeyTimes;
+		std::vector<LLVector3> mKeyScales;
 		ScaleKey			mLoopInKey;
 		ScaleKey			mLoopOutKey;
 	};
@@ -338,13 +367,15 @@ public:
 	public:
 		RotationCurve();
 		~RotationCurve();
+		void addKey(const RotationKey& key);
 		LLQuaternion getValue(F32 time, F32 duration);
-		LLQuaternion interp(F32 u, RotationKey& before, RotationKey& after);
+		LLQuaternion getValue(F32 time, F32 duration, S32& cursor);
+		LLQuaternion interp(F32 u, const LLQuaternion& before, const LLQuaternion& after);
 
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
-		typedef std::map<F32, RotationKey> key_map_t;
-		key_map_t		mKeys;
+		KeyTimes			mKeyTimes;
+		std::vector<LLQuaternion> mKeyRotations;
 		RotationKey		mLoopInKey;
 		RotationKey		mLoopOutKey;
 	};
@@ -357,17 +388,35 @@ public:
 	public:
 		PositionCurve();
 		~PositionCurve();
+		void addKey(const PositionKey& key);
 		LLVector3 getValue(F32 time, F32 duration);
-		LLVector3 interp(F32 u, PositionKey& before, PositionKey& after);
+		LLVector3 getValue(F32 time, F32 duration, S32& cursor);
+		LLVector3 interp(F32 u, const LLVector3& before, const LLVector3& after);
 
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
-		typedef std::map<F32, PositionKey> key_map_t;
-		key_map_t		mKeys;
+		KeyTimes			mKeyTimes;
+		std::vector<LLVector3> mKeyPositions;
 		PositionKey		mLoopInKey;
 		PositionKey		mLoopOutKey;
 	};
 
+	//-------------------------------------------------------------------------
+	// KeyCursors
+	// Where this motion instance last sampled each curve of a joint motion
+	//-------------------------------------------------------------------------
+	class KeyCursors
+	{
+	public:
+		KeyCursors() : mScale(0), mRotation(0), mPosition(0) {}
+
+		S32		mScale;
+		S32		mRotation;
+		S32		mPosition;
+	};
+
+	class RotationBatch;
+
 	//-------------------------------------------------------------------------
 	// JointMotion
 	//-------------------------------------------------------------------------
@@ -381,7 +430,7 @@ public:
 		U32				mUsage;
 		LLJoint::JointPriority	mPriority;
 
-		void update(LLJointState* joint_state, F32 time, F32 duration);
+		void update(LLJointState* joint_state, F32 time, F32 duration, KeyCursors& cursors, RotationBatch& rotations);
 	};
 	
 	//-------------------------------------------------------------------------
@@ -424,6 +473,7 @@ protected:
 	//-------------------------------------------------------------------------
 	JointMotionList*				mJointMotionList;
 	std::vector<LLPointer<LLJointState> > mJointStates;
+	std::vector<KeyCursors>			mKeyCursors;		// parallel to mJointStates
 	LLJoint*						mPelvisp;
 	LLCharacter*					mCharacter;
 	typedef std::list<JointConstraint*>	constraint_list_t;
@@ -0,0 +1,185 @@
+/**
+ * @file lljointhierarchy_test.cpp
+ * @brief LLJointHierarchy test cases.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "m4math.h"
+#include "v3math.h"
+
+#include "../lljoint.h"
+#include "../lljointhierarchy.h"
+
+#include "../test/lltut.h"
+
+
+namespace tut
+{
+	const S32 NUM_TEST_JOINTS = 12;
+
+	// two identical trees, one updated recursively and one by LLJointHierarchy
+	struct lljointhierarchy_data
+	{
+		LLJoint mRecursive[NUM_TEST_JOINTS];
+		LLJoint mFlattened[NUM_TEST_JOINTS];
+
+		lljointhierarchy_data()
+		{
+			// 0 is the root, a spine with limbs hanging off it
+			static const S32 parents[NUM_TEST_JOINTS] = { -1, 0, 1, 2, 3, 2, 5, 2, 7, 0, 9, 0 };
+			for (S32 i = 0; i < NUM_TEST_JOINTS; ++i)
+			{
+				if (parents[i] >= 0)
+				{
+					mRecursive[parents[i]].addChild(&mRecursive[i]);
+					mFlattened[parents[i]].addChild(&mFlattened[i]);
+				}
+			}
+			pose(0.f);
+		}
+
+		void pose(F32 t)
+		{
+			for (S32 i = 0; i < NUM_TEST_JOINTS; ++i)
+			{
+				LLVector3 pos(0.1f * i, 0.5f - 0.05f * i, 0.2f + t);
+				LLQuaternion rot(0.3f * i + t, LLVector3(1.f, 0.5f * i, 2.f - i));
+				LLVector3 scale(1.f, 1.f + 0.1f * i, 1.f);
+				mRecursive[i].setPosition(pos);
+				mRecursive[i].setRotation(rot);
+				mRecursive[i].setScale(scale);
+				mFlattened[i].setPosition(pos);
+				mFlattened[i].setRotation(rot);
+				mFlattened[i].setScale(scale);
+			}
+			mRecursive[2].getXform()->setScaleChildOffset(TRUE);
+			mFlattened[2].getXform()->setScaleChildOffset(TRUE);
+		}
+
+		void ensureSame(const std::string& msg)
+		{
+			for (S32 i = 0; i < NUM_TEST_JOINTS; ++i)
+			{
+				const LLXformMatrix* a = mRecursive[i].getXform();
+				const LLXformMatrix* b = mFlattened[i].getXform();
+				ensure(msg + " world position", dist_vec(a->getWorldPosition(), b->getWorldPosition()) < 1.e-5f);
+				ensure(msg + " world rotation", dot(a->getWorldRotation(), b->getWorldRotation()) > 0.99999f);
+				for (S32 r = 0; r < 4; ++r)
+				{
+					for (S32 c = 0; c < 4; ++c)
+					{
+						ensure(msg + " world matrix", fabs(a->getWorldMatrix().mMatrix[r][c] - b->getWorldMatrix().mMatrix[r][c]) < 1.e-5f);
+					}
+				}
+				ensure(msg + " dirty flags", mRecursive[i].mDirtyFlags == mFlattened[i].mDirtyFlags);
+			}
+		}
+	};
+	typedef test_group<lljointhierarchy_data> lljointhierarchy_test;
+	typedef lljointhierarchy_test::object lljointhierarchy_object;
+	tut::lljointhierarchy_test lljointhierarchy_testcase("LLJointHierarchy");
+
+	template<> template<>
+	void lljointhierarchy_object::test<1>()
+	{
+		LLJointHierarchy hierarchy;
+		hierarchy.setRoot(&mFlattened[0]);
+		hierarchy.updateWorldMatrices();
+
+		ensure_equals("joint count", hierarchy.getNumJoints(), NUM_TEST_JOINTS);
+		ensure("root first", hierarchy.getJoint(0) == &mFlattened[0] && hierarchy.getParentIndex(0) == -1);
+		for (S32 i = 1; i < hierarchy.getNumJoints(); ++i)
+		{
+			S32 parent = hierarchy.getParentIndex(i);
+			ensure("parents before children", parent >= 0 && parent < i);
+			ensure("parent index", hierarchy.getJoint(parent) == hierarchy.getJoint(i)->getParent());
+		}
+	}
+
+	template<> template<>
+	void lljointhierarchy_object::test<2>()
+	{
+		LLJointHierarchy hierarchy;
+		hierarchy.setRoot(&mFlattened[0]);
+
+		mRecursive[0].updateWorldMatrixChildren();
+		hierarchy.updateWorldMatrices();
+		ensureSame("initial");
+
+		// move a few joints, only their subtrees are dirty
+		mRecursive[5].setRotation(LLQuaternion(1.f, LLVector3(0.f, 0.f, 1.f)));
+		mFlattened[5].setRotation(LLQuaternion(1.f, LLVector3(0.f, 0.f, 1.f)));
+		mRecursive[0].setPosition(LLVector3(10.f, 20.f, 30.f));
+		mFlattened[0].setPosition(LLVector3(10.f, 20.f, 30.f));
+		mRecursive[2].setScale(LLVector3(2.f, 0.5f, 1.5f));
+		mFlattened[2].setScale(LLVector3(2.f, 0.5f, 1.5f));
+		mRecursive[3].touch();
+		mFlattened[3].touch();
+
+		mRecursive[0].updateWorldMatrixChildren();
+		hierarchy.updateWorldMatrices();
+		ensureSame("partial");
+
+		pose(0.7f);
+		mRecursive[0].updateWorldMatrixChildren();
+		hierarchy.updateWorldMatrices();
+		ensureSame("posed");
+	}
+
+	template<> template<>
+	void lljointhierarchy_object::test<3>()
+	{
+		LLJointHierarchy hierarchy;
+		hierarchy.setRoot(&mFlattened[0]);
+		hierarchy.updateWorldMatrices();
+		mRecursive[0].updateWorldMatrixChildren();
+
+		// subtrees that opt out are left dirty
+		mRecursive[2].mUpdateXform = FALSE;
+		mFlattened[2].mUpdateXform = FALSE;
+		pose(1.3f);
+		mRecursive[0].updateWorldMatrixChildren();
+		hierarchy.updateWorldMatrices();
+		ensureSame("skipped");
+		ensure("skipped subtree still dirty", mFlattened[4].mDirtyFlags & LLJoint::MATRIX_DIRTY);
+
+		// topology changes are picked up without calling setRoot() again
+		LLJoint recursive_extra, flattened_extra;
+		recursive_extra.setPosition(LLVector3(1.f, 2.f, 3.f));
+		flattened_extra.setPosition(LLVector3(1.f, 2.f, 3.f));
+		mRecursive[10].addChild(&recursive_extra);
+		mFlattened[10].addChild(&flattened_extra);
+		mRecursive[0].updateWorldMatrixChildren();
+		hierarchy.updateWorldMatrices();
+		ensure_equals("rebuilt", hierarchy.getNumJoints(), NUM_TEST_JOINTS + 1);
+		ensure("new joint world position", dist_vec(recursive_extra.getXform()->getWorldPosition(),
+													flattened_extra.getXform()->getWorldPosition()) < 1.e-5f);
+		ensureSame("rebuilt");
+
+		mFlattened[10].removeChild(&flattened_extra);
+		mRecursive[10].removeChild(&recursive_extra);
+		hierarchy.updateWorldMatrices();
+		ensure_equals("removed", hierarchy.getNumJoints(), NUM_TEST_JOINTS);
+	}
+}
@@ -35,6 +35,7 @@ apr_pool_t *gAPRPoolp = NULL; // Global APR memory pool
 LLVolatileAPRPool *LLAPRFile::sAPRFilePoolp = NULL ; //global volatile APR memory pool.
 apr_thread_mutex_t *gLogMutexp = NULL;
 apr_thread_mutex_t *gCallStacksLogMutexp = NULL;
+apr_thread_mutex_t *gLogRecordersMutexp = NULL;
 
 const S32 FULL_VOLATILE_APR_POOL = 1024 ; //number of references to LLVolatileAPRPool
 
@@ -52,6 +53,9 @@ void ll_init_apr()
 		// Initialize the logging mutex
 		apr_thread_mutex_create(&gLogMutexp, APR_THREAD_MUTEX_UNNESTED, gAPRPoolp);
 		apr_thread_mutex_create(&gCallStacksLogMutexp, APR_THREAD_MUTEX_UNNESTED, gAPRPoolp);
+		// nested, recorders may log and the log writer thread writes its
+		// own messages right away
+		apr_thread_mutex_create(&gLogRecordersMutexp, APR_THREAD_MUTEX_NESTED, gAPRPoolp);
 	}
 
 	if(!LLAPRFile::sAPRFilePoolp)
@@ -91,6 +95,11 @@ void ll_cleanup_apr()
 		apr_thread_mutex_destroy(gCallStacksLogMutexp);
 		gCallStacksLogMutexp = NULL;
 	}
+	if (gLogRecordersMutexp)
+	{
+		apr_thread_mutex_destroy(gLogRecordersMutexp);
+		gLogRecordersMutexp = NULL;
+	}
 
 	LLThreadLocalPointerBase::destroyAllThreadLocalStorage();
 
@@ -45,6 +45,7 @@
 
 extern LL_COMMON_API apr_thread_mutex_t* gLogMutexp;
 extern apr_thread_mutex_t* gCallStacksLogMutexp;
+extern apr_thread_mutex_t* gLogRecordersMutexp;
 
 struct apr_dso_handle_t;
 /**
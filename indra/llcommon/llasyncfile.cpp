@@ -0,0 +1,309 @@
+/**
+ * @file llasyncfile.cpp
+ * @brief File reads and writes on I/O threads, for coroutines.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llasyncfile.h"
+
+#include "llfile.h"
+#include "llthread.h"
+#include "lltimer.h"
+
+#include <errno.h>
+#if LL_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+const std::string LLAsyncFile::PUMP_NAME("LLAsyncFile");
+
+// enough to overlap the few files a coroutine waits for with the network,
+// without the threads fighting over the disk
+static const S32 DEFAULT_IO_THREADS = 2;
+
+class LLAsyncFile::IOThread : public LLThread
+{
+public:
+	IOThread(LLAsyncFile* async_file, S32 index)
+	:	LLThread(llformat("LLAsyncFile %d", index)),
+		mAsyncFile(async_file)
+	{
+	}
+
+	/*virtual*/ void run()
+	{
+		while (true)
+		{
+			Request* request = mAsyncFile->mRequests.popBack();
+			if (request->mOperation == OP_QUIT)
+			{
+				delete request;
+				break;
+			}
+			process(request);
+			mAsyncFile->mResults.pushFront(request);
+		}
+	}
+
+private:
+	LLAsyncFile* mAsyncFile;
+};
+
+LLAsyncFile::LLAsyncFile()
+:	mRequestPump(PUMP_NAME),
+	mNumThreads(DEFAULT_IO_THREADS),
+	mPending(0)
+{
+	mRequestPump.listen("LLAsyncFile", boost::bind(&LLAsyncFile::post, this, _1));
+}
+
+LLAsyncFile::~LLAsyncFile()
+{
+	// the requests queued before the quit ones are still done, but nobody
+	// gets their results
+	for (S32 i = 0; i < (S32) mThreads.size(); ++i)
+	{
+		Request* quit = new Request;
+		quit->mOperation = OP_QUIT;
+		mRequests.pushFront(quit);
+	}
+	for (std::vector<LLThread*>::iterator it = mThreads.begin(); it != mThreads.end(); ++it)
+	{
+		while (!(*it)->isStopped())
+		{
+			ms_sleep(1);
+		}
+		delete *it;
+	}
+	mThreads.clear();
+
+	Request* request = NULL;
+	while (mResults.tryPopBack(request))
+	{
+		delete request;
+	}
+}
+
+void LLAsyncFile::startThreads()
+{
+	for (S32 i = 0; i < mNumThreads; ++i)
+	{
+		IOThread* thread = new IOThread(this, i);
+		mThreads.push_back(thread);
+		thread->start();
+	}
+}
+
+bool LLAsyncFile::post(const LLSD& event)
+{
+	Request* request = new Request;
+	const std::string& op = event["op"].asString();
+	if (op == "read")
+	{
+		request->mOperation = OP_READ;
+	}
+	else if (op == "write")
+	{
+		request->mOperation = OP_WRITE;
+		request->mData = event["data"].asBinary();
+	}
+	else if (op == "sync")
+	{
+		request->mOperation = OP_SYNC;
+	}
+	else
+	{
+		LL_WARNS() << "Unknown operation \"" << op << "\" for " << event["path"].asString() << LL_ENDL;
+		LLSD reply;
+		reply["status"] = EINVAL;
+		reply["size"] = 0;
+		sendReply(reply, event);
+		delete request;
+		return false;
+	}
+	request->mPath = event["path"].asString();
+	request->mOffset = event.has("offset") ? event["offset"].asInteger() : (request->mOperation == OP_READ ? 0 : -1);
+	request->mSize = event.has("size") ? event["size"].asInteger() : -1;
+	request->mTruncate = event["truncate"].asBoolean();
+	request->mSync = event["sync"].asBoolean();
+	request->mStatus = 0;
+	// what sendReply() needs, not the data to write again
+	request->mEvent["reply"] = event["reply"];
+	if (event.has("reqid"))
+	{
+		request->mEvent["reqid"] = event["reqid"];
+	}
+
+	if (mThreads.empty())
+	{
+		startThreads();
+	}
+	if (mPending++ == 0)
+	{
+		mMainloopConnection = LLEventPumps::instance().obtain("mainloop")
+			.listen("LLAsyncFile", boost::bind(&LLAsyncFile::tick, this, _1));
+	}
+	mRequests.pushFront(request);
+	return false;
+}
+
+// called once per frame by the "mainloop" LLEventPump while requests are pending
+bool LLAsyncFile::tick(const LLSD&)
+{
+	Request* request = NULL;
+	while (mResults.tryPopBack(request))
+	{
+		LLSD reply;
+		reply["status"] = request->mStatus;
+		if (request->mOperation == OP_READ)
+		{
+			reply["size"] = (S32) request->mData.size();
+			reply["data"] = request->mData;
+		}
+		else
+		{
+			reply["size"] = request->mSize;
+		}
+		LLSD event(request->mEvent);
+		delete request;
+
+		// the reply may resume a coroutine that posts the next request
+		// right away, so count this one out first
+		if (--mPending == 0)
+		{
+			mMainloopConnection.disconnect();
+		}
+		sendReply(reply, event);
+	}
+	return false;
+}
+
+// on an I/O thread
+//static
+void LLAsyncFile::process(Request* request)
+{
+	LLFILE* file = NULL;
+	errno = 0;
+	switch (request->mOperation)
+	{
+	case OP_READ:
+		file = LLFile::fopen(request->mPath, "rb");	/* Flawfinder: ignore */
+		break;
+	case OP_WRITE:
+		if (request->mTruncate)
+		{
+			file = LLFile::fopen(request->mPath, "wb");	/* Flawfinder: ignore */
+		}
+		else if (request->mOffset < 0)
+		{
+			file = LLFile::fopen(request->mPath, "ab");	/* Flawfinder: ignore */
+		}
+		else
+		{
+			file = LLFile::fopen(request->mPath, "r+b");	/* Flawfinder: ignore */
+			if (!file)
+			{
+				file = LLFile::fopen(request->mPath, "wb");	/* Flawfinder: ignore */
+			}
+		}
+		break;
+	case OP_SYNC:
+		request->mSize = 0;
+		// appending writes nothing, but the descriptor can be flushed
+		file = LLFile::fopen(request->mPath, "ab");	/* Flawfinder: ignore */
+		break;
+	default:
+		break;
+	}
+	if (!file)
+	{
+		request->mStatus = errno ? errno : ENOENT;
+		request->mData.clear();
+		request->mSize = 0;
+		return;
+	}
+
+	if (request->mOperation == OP_READ)
+	{
+		S32 size = request->mSize;
+		if (size < 0)
+		{
+			fseek(file, 0, SEEK_END);
+			size = llmax((S32) ftell(file) - request->mOffset, 0);
+		}
+		request->mData.resize(size);
+		if (fseek(file, request->mOffset, SEEK_SET) != 0)
+		{
+			request->mStatus = errno;
+			request->mData.clear();
+		}
+		else if (size > 0)
+		{
+			size_t read = fread(&request->mData[0], 1, size, file);
+			request->mData.resize(read);
+			if ((S32) read != size)
+			{
+				request->mStatus = ferror(file) ? EIO : ERANGE;
+			}
+		}
+	}
+	else if (request->mOperation == OP_WRITE)
+	{
+		S32 size = (S32) request->mData.size();
+		request->mSize = 0;
+		if (request->mOffset >= 0 && !request->mTruncate && fseek(file, request->mOffset, SEEK_SET) != 0)
+		{
+			request->mStatus = errno;
+		}
+		else if (size > 0)
+		{
+			request->mSize = (S32) fwrite(&request->mData[0], 1, size, file);
+			if (request->mSize != size)
+			{
+				request->mStatus = EIO;
+			}
+		}
+		request->mData.clear();
+	}
+
+	if (request->mStatus == 0 && (request->mOperation == OP_SYNC || request->mSync))
+	{
+		fflush(file);
+#if LL_WINDOWS
+		if (_commit(_fileno(file)) != 0)
+#else
+		if (fsync(fileno(file)) != 0)
+#endif
+		{
+			request->mStatus = errno;
+		}
+	}
+	if (fclose(file) != 0 && request->mStatus == 0)
+	{
+		request->mStatus = errno;
+	}
+}
@@ -0,0 +1,185 @@
+/**
+ * @file llasyncfile.h
+ * @brief File reads and writes on I/O threads, for coroutines.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLASYNCFILE_H
+#define LL_LLASYNCFILE_H
+
+// lleventcoro.h brings in Boost.Coroutine, which must come first
+#include "lleventcoro.h"
+#include "llevents.h"
+#include "llsd.h"
+#include "llsingleton.h"
+#include "llthreadsafequeue.h"
+
+#include <string>
+#include <vector>
+
+class LLThread;
+
+/**
+ * @class LLAsyncFile
+ * @brief Runs file reads, writes and fsyncs on a few I/O threads.
+ *
+ * Requests are LLSD maps posted on the "LLAsyncFile" LLEventPump, from the
+ * main thread once the instance exists:
+ *   - "op": "read", "write" or "sync"
+ *   - "path": the file
+ *   - "offset": where to read or write, writes append by default
+ *   - "size": bytes to read, to the end of the file by default
+ *   - "data": LLSD::Binary to write
+ *   - "truncate": true to replace the file being written
+ *   - "sync": true to fsync the file once written
+ *   - "reply": name of the LLEventPump for the result
+ *
+ * The result, with the "reqid" of the request, is a map of "status", 0 or
+ * an errno value, "size", the bytes read or written, and for reads "data".
+ * It is posted on the main thread, from the next "mainloop" tick after an
+ * I/O thread is done, so a coroutine waiting with postAndWait() lets the
+ * others and the rest of the frame carry on meanwhile.  read(), write()
+ * and sync() below do just that.
+ */
+class LL_COMMON_API LLAsyncFile : public LLSingleton<LLAsyncFile>
+{
+	LOG_CLASS(LLAsyncFile);
+
+	friend class LLSingleton<LLAsyncFile>;
+	LLAsyncFile();
+	~LLAsyncFile();
+
+public:
+	static const std::string PUMP_NAME;
+
+	/**
+	 * @brief I/O threads started with the first request.
+	 */
+	void setNumThreads(S32 num_threads) { mNumThreads = llmax(num_threads, 1); }
+
+	/**
+	 * @return Returns the requests not replied to yet.
+	 */
+	S32 getPending() const { return mPending; }
+
+	/**
+	 * @brief Suspends the coroutine until the request is done.
+	 * @return Returns the result event.
+	 */
+	template <typename SELF>
+	static LLSD request(SELF& self, const LLSD& event)
+	{
+		LLEventStream reply_pump("LLAsyncFileReply", true);
+		return postAndWait(self, event, getInstance()->mRequestPump, reply_pump, "reply");
+	}
+
+	/**
+	 * @brief Reads size bytes from offset, or the whole file.
+	 * @return Returns true if the bytes asked for were read.
+	 */
+	template <typename SELF>
+	static bool read(SELF& self, const std::string& path, LLSD::Binary& data, S32 offset = 0, S32 size = -1)
+	{
+		LLSD event;
+		event["op"] = "read";
+		event["path"] = path;
+		event["offset"] = offset;
+		event["size"] = size;
+		LLSD result = request(self, event);
+		data = result["data"].asBinary();
+		return result["status"].asInteger() == 0;
+	}
+
+	/**
+	 * @brief Writes data at offset, appends it by default.
+	 * @param[in] truncate - Replaces the file.
+	 * @param[in] sync - Waits for the data to be on disk.
+	 * @return Returns true if everything was written.
+	 */
+	template <typename SELF>
+	static bool write(SELF& self, const std::string& path, const LLSD::Binary& data, S32 offset = -1,
+					  bool truncate = false, bool sync = false)
+	{
+		LLSD event;
+		event["op"] = "write";
+		event["path"] = path;
+		event["offset"] = offset;
+		event["data"] = data;
+		event["truncate"] = truncate;
+		event["sync"] = sync;
+		return request(self, event)["status"].asInteger() == 0;
+	}
+
+	/**
+	 * @brief Waits for the data written to the file to be on disk.
+	 */
+	template <typename SELF>
+	static bool sync(SELF& self, const std::string& path)
+	{
+		LLSD event;
+		event["op"] = "sync";
+		event["path"] = path;
+		return request(self, event)["status"].asInteger() == 0;
+	}
+
+private:
+	enum EOperation
+	{
+		OP_READ,
+		OP_WRITE,
+		OP_SYNC,
+		OP_QUIT
+	};
+
+	// touched by one I/O thread between the queues, mEvent only on the
+	// main thread
+	struct Request
+	{
+		EOperation		mOperation;
+		std::string		mPath;
+		S32				mOffset;
+		S32				mSize;
+		bool			mTruncate;
+		bool			mSync;
+		LLSD::Binary	mData;
+		S32				mStatus;
+		LLSD			mEvent;			// "reply" and "reqid" of the request
+	};
+
+	class IOThread;
+
+	bool post(const LLSD& event);
+	bool tick(const LLSD&);
+	void startThreads();
+	static void process(Request* request);
+
+	LLEventStream						mRequestPump;
+	LLTempBoundListener					mMainloopConnection;
+	LLThreadSafeQueue<Request*>			mRequests;
+	LLThreadSafeQueue<Request*>			mResults;
+	std::vector<LLThread*>				mThreads;
+	S32									mNumThreads;
+	S32									mPending;
+};
+
+#endif // LL_LLASYNCFILE_H
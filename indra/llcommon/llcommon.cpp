@@ -27,6 +27,7 @@
 
 #include "llcommon.h"
 
+#include "llerrorcontrol.h"
 #include "llmemory.h"
 #include "llthread.h"
 #include "lltrace.h"
@@ -64,6 +65,7 @@ void LLCommon::cleanupClass()
 	LLTrace::set_master_thread_recorder(NULL);
 	LLThreadSafeRefCount::cleanupThreadSafeRefCount();
 	LLTimer::cleanupClass();
+	LLError::setAsyncLogging(false);
 	if (sAprInitialized)
 	{
 		ll_cleanup_apr();
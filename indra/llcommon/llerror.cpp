@@ -45,12 +45,16 @@
 #include "llapr.h"
 #include "llfile.h"
 #include "lllivefile.h"
+#include "lllockfreequeue.h"
 #include "llsd.h"
 #include "llsdserialize.h"
 #include "llsingleton.h"
 #include "llstl.h"
 #include "lltimer.h"
 
+#include "apr_portable.h"
+#include "apr_thread_cond.h"
+
 namespace {
 #if LL_WINDOWS
 	void debugger_print(const std::string& s)
@@ -440,7 +444,8 @@ namespace LLError
 	public:
 		Settings();
 
-		SettingsConfigPtr getSettingsConfig();
+		// the log writer thread binds a reference, the count isn't atomic
+		const SettingsConfigPtr& getSettingsConfig();
 	
 		void reset();
 		SettingsStoragePtr saveAndReset();
@@ -480,7 +485,7 @@ namespace LLError
 	{
 	}
 
-	SettingsConfigPtr Settings::getSettingsConfig()
+	const SettingsConfigPtr& Settings::getSettingsConfig()
 	{
 		return mSettingsConfig;
 	}
@@ -790,6 +795,153 @@ namespace LLError
 	}
 }
 
+namespace
+{
+	class LogLock
+	{
+	public:
+		// wait is for the rare calls that can't go on without the lock
+		LogLock(bool wait = false);
+		~LogLock();
+		bool ok() const { return mOK; }
+	private:
+		bool mLocked;
+		bool mOK;
+	};
+	
+	LogLock::LogLock(bool wait)
+		: mLocked(false), mOK(false)
+	{
+		if (!gLogMutexp)
+		{
+			mOK = true;
+			return;
+		}
+
+		if (wait)
+		{
+			apr_thread_mutex_lock(gLogMutexp);
+			mLocked = true;
+			mOK = true;
+			return;
+		}
+		
+		const int MAX_RETRIES = 5;
+		for (int attempts = 0; attempts < MAX_RETRIES; ++attempts)
+		{
+			apr_status_t s = apr_thread_mutex_trylock(gLogMutexp);
+			if (!APR_STATUS_IS_EBUSY(s))
+			{
+				mLocked = true;
+				mOK = true;
+				return;
+			}
+
+			ms_sleep(1);
+			//apr_thread_yield();
+				// Just yielding won't necessarily work, I had problems with
+				// this on Linux - doug 12/02/04
+		}
+
+		// We're hosed, we can't get the mutex.  Blah.
+		std::cerr << "LogLock::LogLock: failed to get mutex for log"
+					<< std::endl;
+	}
+	
+	LogLock::~LogLock()
+	{
+		if (mLocked)
+		{
+			apr_thread_mutex_unlock(gLogMutexp);
+		}
+	}
+
+	// A message waiting for the writer thread, formatted but for the parts
+	// each recorder asks for.
+	struct PendingMessage
+	{
+		const LLError::CallSite*	mSite;
+		std::string					mMessage;
+		std::string					mTime;
+	};
+
+	// Hands messages from the threads that log them to a writer thread
+	// through a lock-free ring, so slow recorders (files on slow disks) don't
+	// stall them.  Messages go in the ring under the log lock, so they come
+	// out in the order they were logged in.  When the ring is full, warnings
+	// wait for room and lesser messages are dropped and counted.
+	class AsyncLog
+	{
+	public:
+		AsyncLog();
+		~AsyncLog();
+
+		// false when the ring is full
+		bool tryPush(PendingMessage* pending) { return mQueue.tryPush(pending); }
+		// waits for room, for the messages that can't be dropped
+		void push(PendingMessage* pending);
+		void drop(PendingMessage* pending);
+
+		// writes the pending messages on the calling thread
+		void write();
+
+		// joins the writer thread, then writes what it left
+		void stop();
+
+		bool isWriterThread() const;
+		U32 getDroppedCount() const { return LLLockFree::load(&mDroppedCount); }
+
+	private:
+		static void* APR_THREAD_FUNC run(apr_thread_t* thread, void* data);
+		void wakeWriter();
+
+		enum { CAPACITY = 4096 };
+
+		LLBoundedMPMCQueue<PendingMessage*>	mQueue;
+		apr_pool_t*							mPoolp;
+		apr_thread_t*						mThreadp;
+		apr_os_thread_t						mWriterThreadID;
+		apr_thread_mutex_t*					mWakeMutexp;
+		apr_thread_cond_t*					mWakeConditionp;
+		volatile U32						mWriterWaiting;
+		volatile U32						mStopping;
+		volatile U32						mDroppedCount;
+		U32									mReportedDroppedCount;
+	};
+
+	// only changed under the log lock
+	AsyncLog* gAsyncLogp = NULL;
+	// threads waiting for room in the ring, which happens outside the log
+	// lock
+	volatile U32 gAsyncLogPushers = 0;
+
+	// Held while writing to or changing the recorders.  The mutex lives as
+	// long as APR, since the writer thread writes without the log lock, and
+	// recorders may be added or removed on any thread meanwhile.
+	class RecordersLock
+	{
+	public:
+		RecordersLock()
+		:	mMutexp(gLogRecordersMutexp)
+		{
+			if (mMutexp)
+			{
+				apr_thread_mutex_lock(mMutexp);
+			}
+		}
+
+		~RecordersLock()
+		{
+			if (mMutexp)
+			{
+				apr_thread_mutex_unlock(mMutexp);
+			}
+		}
+
+	private:
+		apr_thread_mutex_t* mMutexp;
+	};
+}
 
 namespace LLError
 {
@@ -841,6 +993,9 @@ namespace LLError
 		{
 			return;
 		}
+		// the log lock first, like loggers take them
+		LogLock log_lock(true);
+		RecordersLock lock;
 		SettingsConfigPtr s = Settings::getInstance()->getSettingsConfig();
 		s->mRecorders.push_back(recorder);
 	}
@@ -851,6 +1006,8 @@ namespace LLError
 		{
 			return;
 		}
+		LogLock log_lock(true);
+		RecordersLock lock;
 		SettingsConfigPtr s = Settings::getInstance()->getSettingsConfig();
 		s->mRecorders.erase(std::remove(s->mRecorders.begin(), s->mRecorders.end(), recorder),
 							s->mRecorders.end());
@@ -907,10 +1064,13 @@ namespace LLError
 
 namespace
 {
-	void writeToRecorders(const LLError::CallSite& site, const std::string& message, bool show_location = true, bool show_time = true, bool show_tags = true, bool show_level = true, bool show_function = true)
+	// time is what the time function returned when the message was logged,
+	// NULL to call it now
+	void writeToRecorders(const LLError::CallSite& site, const std::string& message, bool show_location = true, bool show_time = true, bool show_tags = true, bool show_level = true, bool show_function = true, const std::string* time = NULL)
 	{
 		LLError::ELevel level = site.mLevel;
-		LLError::SettingsConfigPtr s = LLError::Settings::getInstance()->getSettingsConfig();
+		RecordersLock lock;
+		const LLError::SettingsConfigPtr& s = LLError::Settings::getInstance()->getSettingsConfig();
 	
 		for (Recorders::const_iterator i = s->mRecorders.begin();
 			i != s->mRecorders.end();
@@ -925,7 +1085,11 @@ namespace
 				message_stream << site.mLocationString << " ";
 			}
 
-			if (show_time && r->wantsTime() && s->mTimeFunction != NULL)
+			if (show_time && r->wantsTime() && time)
+			{
+				message_stream << *time << " ";
+			}
+			else if (show_time && r->wantsTime() && s->mTimeFunction != NULL)
 			{
 				message_stream << s->mTimeFunction() << " ";
 			}
@@ -993,54 +1157,131 @@ namespace {
 		return found_level;
 	}
 	
-	class LogLock
+	AsyncLog::AsyncLog()
+	:	mQueue(CAPACITY),
+		mPoolp(NULL),
+		mThreadp(NULL),
+		mWriterThreadID(),
+		mWakeMutexp(NULL),
+		mWakeConditionp(NULL),
+		mWriterWaiting(0),
+		mStopping(0),
+		mDroppedCount(0),
+		mReportedDroppedCount(0)
 	{
-	public:
-		LogLock();
-		~LogLock();
-		bool ok() const { return mOK; }
-	private:
-		bool mLocked;
-		bool mOK;
-	};
-	
-	LogLock::LogLock()
-		: mLocked(false), mOK(false)
+		apr_pool_create(&mPoolp, NULL);
+		apr_thread_mutex_create(&mWakeMutexp, APR_THREAD_MUTEX_UNNESTED, mPoolp);
+		apr_thread_cond_create(&mWakeConditionp, mPoolp);
+		apr_thread_create(&mThreadp, NULL, run, this, mPoolp);
+	}
+
+	AsyncLog::~AsyncLog()
 	{
-		if (!gLogMutexp)
+		stop();
+
+		apr_thread_cond_destroy(mWakeConditionp);
+		apr_thread_mutex_destroy(mWakeMutexp);
+		apr_pool_destroy(mPoolp);
+	}
+
+	void AsyncLog::stop()
+	{
+		if (!mThreadp)
 		{
-			mOK = true;
 			return;
 		}
-		
-		const int MAX_RETRIES = 5;
-		for (int attempts = 0; attempts < MAX_RETRIES; ++attempts)
-		{
-			apr_status_t s = apr_thread_mutex_trylock(gLogMutexp);
-			if (!APR_STATUS_IS_EBUSY(s))
-			{
-				mLocked = true;
-				mOK = true;
-				return;
-			}
 
+		LLLockFree::store(&mStopping, (U32) 1);
+		wakeWriter();
+
+		apr_status_t status;
+		apr_thread_join(&status, mThreadp);
+		mThreadp = NULL;
+		write();
+	}
+
+	void AsyncLog::push(PendingMessage* pending)
+	{
+		// backpressure, warnings aren't dropped
+		while (!mQueue.tryPush(pending))
+		{
+			wakeWriter();
 			ms_sleep(1);
-			//apr_thread_yield();
-				// Just yielding won't necessarily work, I had problems with
-				// this on Linux - doug 12/02/04
 		}
 
-		// We're hosed, we can't get the mutex.  Blah.
-		std::cerr << "LogLock::LogLock: failed to get mutex for log"
-					<< std::endl;
+		if (LLLockFree::load(&mWriterWaiting))
+		{
+			wakeWriter();
+		}
 	}
-	
-	LogLock::~LogLock()
+
+	void AsyncLog::drop(PendingMessage* pending)
 	{
-		if (mLocked)
+		LLLockFree::fetchAdd(&mDroppedCount, 1);
+		delete pending;
+	}
+
+	void AsyncLog::write()
+	{
+		RecordersLock lock;
+
+		PendingMessage* pending = NULL;
+		while (mQueue.tryPop(pending))
 		{
-			apr_thread_mutex_unlock(gLogMutexp);
+			writeToRecorders(*pending->mSite, pending->mMessage, true, true, true, true, true, &pending->mTime);
+			delete pending;
+		}
+
+		U32 dropped_count = getDroppedCount();
+		if (dropped_count != mReportedDroppedCount)
+		{
+			std::string message = llformat("%u log messages dropped, the log writer fell behind", dropped_count - mReportedDroppedCount);
+			mReportedDroppedCount = dropped_count;
+
+			const LLError::SettingsConfigPtr& s = LLError::Settings::getInstance()->getSettingsConfig();
+			for (Recorders::const_iterator i = s->mRecorders.begin(); i != s->mRecorders.end(); ++i)
+			{
+				(*i)->recordMessage(LLError::LEVEL_WARN, message);
+			}
+		}
+	}
+
+	//static
+	void* APR_THREAD_FUNC AsyncLog::run(apr_thread_t* thread, void* data)
+	{
+		AsyncLog* log = (AsyncLog*) data;
+		log->mWriterThreadID = apr_os_thread_current();
+
+		while (!LLLockFree::load(&log->mStopping))
+		{
+			log->write();
+
+			// the flag is set before looking for messages, pushers that
+			// miss it pushed before the look
+			apr_thread_mutex_lock(log->mWakeMutexp);
+			LLLockFree::compareAndSwap(&log->mWriterWaiting, 0, 1);
+			if (log->mQueue.size() == 0 && !LLLockFree::load(&log->mStopping))
+			{
+				apr_thread_cond_timedwait(log->mWakeConditionp, log->mWakeMutexp, 100000);
+			}
+			LLLockFree::store(&log->mWriterWaiting, (U32) 0);
+			apr_thread_mutex_unlock(log->mWakeMutexp);
 		}
+
+		apr_thread_exit(thread, APR_SUCCESS);
+		return NULL;
+	}
+
+	bool AsyncLog::isWriterThread() const
+	{
+		return mThreadp && apr_os_thread_equal(mWriterThreadID, apr_os_thread_current());
+	}
+
+	void AsyncLog::wakeWriter()
+	{
+		apr_thread_mutex_lock(mWakeMutexp);
+		apr_thread_cond_signal(mWakeConditionp);
+		apr_thread_mutex_unlock(mWakeMutexp);
 	}
 }
 
@@ -1140,65 +1381,157 @@ namespace LLError
 
 	void Log::flush(std::ostringstream* out, const CallSite& site)
 	{
-		LogLock lock;
-		if (!lock.ok())
+		AsyncLog* async_log = NULL;
+		PendingMessage* pending = NULL;
 		{
-			return;
-		}
-		
-		Globals* g = Globals::getInstance();
-		SettingsConfigPtr s = Settings::getInstance()->getSettingsConfig();
+			LogLock lock;
+			if (!lock.ok())
+			{
+				return;
+			}
 
-		std::string message = out->str();
-		if (out == &g->messageStream)
-		{
-			g->messageStream.clear();
-			g->messageStream.str("");
-			g->messageStreamInUse = false;
-		}
-		else
-		{
-			delete out;
-		}
+			Globals* g = Globals::getInstance();
+			SettingsConfigPtr s = Settings::getInstance()->getSettingsConfig();
 
-		if (site.mLevel == LEVEL_ERROR)
-		{
-			writeToRecorders(site, "error", true, true, true, false, false);
-		}
-		
-		std::ostringstream message_stream;
+			std::string message = out->str();
+			if (out == &g->messageStream)
+			{
+				g->messageStream.clear();
+				g->messageStream.str("");
+				g->messageStreamInUse = false;
+			}
+			else
+			{
+				delete out;
+			}
 
-		if (site.mPrintOnce)
-		{
-			std::map<std::string, unsigned int>::iterator messageIter = s->mUniqueLogMessages.find(message);
-			if (messageIter != s->mUniqueLogMessages.end())
+			if (site.mLevel == LEVEL_ERROR)
 			{
-				messageIter->second++;
-				unsigned int num_messages = messageIter->second;
-				if (num_messages == 10 || num_messages == 50 || (num_messages % 100) == 0)
+				// everything logged before the error goes out first
+				if (gAsyncLogp)
 				{
-					message_stream << "ONCE (" << num_messages << "th time seen): ";
-				} 
-				else
+					gAsyncLogp->write();
+				}
+				writeToRecorders(site, "error", true, true, true, false, false);
+			}
+
+			std::ostringstream message_stream;
+
+			if (site.mPrintOnce)
+			{
+				std::map<std::string, unsigned int>::iterator messageIter = s->mUniqueLogMessages.find(message);
+				if (messageIter != s->mUniqueLogMessages.end())
+				{
+					messageIter->second++;
+					unsigned int num_messages = messageIter->second;
+					if (num_messages == 10 || num_messages == 50 || (num_messages % 100) == 0)
+					{
+						message_stream << "ONCE (" << num_messages << "th time seen): ";
+					} 
+					else
+					{
+						return;
+					}
+				}
+				else 
+				{
+					message_stream << "ONCE: ";
+					s->mUniqueLogMessages[message] = 1;
+				}
+			}
+			
+			message_stream << message;
+
+			if (!gAsyncLogp || site.mLevel == LEVEL_ERROR)
+			{
+				writeToRecorders(site, message_stream.str());
+
+				if (site.mLevel == LEVEL_ERROR  &&  s->mCrashFunction)
 				{
-					return;
+					s->mCrashFunction(message_stream.str());
 				}
+				return;
 			}
-			else 
+
+			pending = new PendingMessage;
+			pending->mSite = &site;
+			pending->mMessage = message_stream.str();
+			pending->mTime = s->mTimeFunction ? s->mTimeFunction() : std::string();
+
+			// pushed under the lock, so the ring keeps the order of the log
+			if (gAsyncLogp->tryPush(pending))
 			{
-				message_stream << "ONCE: ";
-				s->mUniqueLogMessages[message] = 1;
+				return;
 			}
+
+			if (gAsyncLogp->isWriterThread())
+			{
+				// the writer can't wait for itself to make room
+				delete pending;
+				writeToRecorders(site, message_stream.str());
+				return;
+			}
+
+			if (site.mLevel < LEVEL_WARN)
+			{
+				gAsyncLogp->drop(pending);
+				return;
+			}
+
+			async_log = gAsyncLogp;
+			// keeps setAsyncLogging() from stopping the writer under us
+			LLLockFree::fetchAdd(&gAsyncLogPushers, 1);
 		}
-		
-		message_stream << message;
-		
-		writeToRecorders(site, message_stream.str());
-		
-		if (site.mLevel == LEVEL_ERROR  &&  s->mCrashFunction)
+
+		// waiting for room in the ring must not hold up the other threads
+		// on the log lock, they would give up and drop their messages
+		async_log->push(pending);
+		LLLockFree::fetchAdd(&gAsyncLogPushers, (U32) -1);
+	}
+}
+
+namespace LLError
+{
+	void setAsyncLogging(bool async)
+	{
+		// loggers wait meanwhile, so nothing they log passes what is pending
+		LogLock lock(true);
+		if (async && !gAsyncLogp && gAPRPoolp)
 		{
-			s->mCrashFunction(message_stream.str());
+			gAsyncLogp = new AsyncLog();
 		}
+		else if (!async && gAsyncLogp)
+		{
+			// the warnings waiting for room go in while the writer still
+			// makes some, then the writer writes its last before it's gone
+			while (LLLockFree::load(&gAsyncLogPushers))
+			{
+				ms_sleep(1);
+			}
+			gAsyncLogp->stop();
+			delete gAsyncLogp;
+			gAsyncLogp = NULL;
+		}
+	}
+
+	bool isAsyncLogging()
+	{
+		return gAsyncLogp != NULL;
+	}
+
+	void flushAsyncLog()
+	{
+		LogLock lock;
+		if (lock.ok() && gAsyncLogp)
+		{
+			gAsyncLogp->write();
+		}
+	}
+
+	U32 droppedLogMessageCount()
+	{
+		LogLock lock;
+		return lock.ok() && gAsyncLogp ? gAsyncLogp->getDroppedCount() : 0;
 	}
 }
 
@@ -178,6 +178,18 @@ namespace LLError
 	LL_COMMON_API std::string logFileName();
 		// returns name of current logging file, empty string if none
 
+	LL_COMMON_API void setAsyncLogging(bool async);
+		// When on, a writer thread writes the messages to the recorders,
+		// threads that log only queue them.  Messages below LEVEL_WARN are
+		// dropped (and counted) if the writer falls behind, errors are
+		// written right away after what is pending.  Needs APR, turning it
+		// off writes what is pending.
+	LL_COMMON_API bool isAsyncLogging();
+	LL_COMMON_API void flushAsyncLog();
+		// Writes the pending messages on the calling thread, for crash
+		// handlers.
+	LL_COMMON_API U32 droppedLogMessageCount();
+
 
 	/*
 		Utilities for use by the unit tests of LLError itself.
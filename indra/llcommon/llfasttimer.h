@@ -29,6 +29,7 @@
 
 #include "llinstancetracker.h"
 #include "lltrace.h"
+#include "lltracetimerevents.h"
 #include "lltreeiterators.h"
 
 #define LL_FAST_TIMER_ON 1
@@ -355,6 +356,13 @@ LL_FORCE_INLINE BlockTimer::~BlockTimer()
 	// we are only tracking self time, so subtract our total time delta from parents
 	mParentTimerData.mChildTime += total_time;
 
+	// keep the block for timelines
+	TimerEventBuffer* timer_events = LLThreadLocalSingletonPointer<TimerEventBuffer>::getInstance();
+	if (timer_events && TimerEventBuffer::isRecording())
+	{
+		timer_events->record((U32) cur_timer_data->mTimeBlock->getIndex(), mStartTime, mStartTime + total_time);
+	}
+
 	//pop stack
 	*cur_timer_data = mParentTimerData;
 #endif
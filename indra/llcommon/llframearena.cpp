@@ -0,0 +1,158 @@
+/**
+ * @file llframearena.cpp
+ * @brief Per thread bump allocator for data that lives for a frame.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llframearena.h"
+
+#include "llthreadlocalstorage.h"
+#include "lltrace.h"
+
+// the first overflow chunk, and what blocks are rounded up to
+static const size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+static LLTrace::CountStatHandle<> sHeapAllocations("frame_arena_heap_allocations", "heap allocations made by the per frame arenas");
+
+static size_t round_up(size_t size, size_t alignment)
+{
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+
+LLFrameArena::LLFrameArena()
+:	mCurrent(0),
+	mHeapAllocations(0)
+{
+	memset(mBuffers, 0, sizeof(mBuffers));
+}
+
+LLFrameArena::~LLFrameArena()
+{
+	for (U32 i = 0; i < 2; ++i)
+	{
+		while (mBuffers[i].mChunks)
+		{
+			Chunk* next = mBuffers[i].mChunks->mNext;
+			ll_aligned_free_16(mBuffers[i].mChunks);
+			mBuffers[i].mChunks = next;
+		}
+		ll_aligned_free_16(mBuffers[i].mBlock);
+	}
+}
+
+//static
+LLFrameArena& LLFrameArena::getThreadArena()
+{
+	LLFrameArena* arena = LLThreadLocalSingletonPointer<LLFrameArena>::getInstance();
+	if (!arena)
+	{
+		// kept as long as the process, like the thread recorders
+		arena = new LLFrameArena;
+		LLThreadLocalSingletonPointer<LLFrameArena>::setInstance(arena);
+	}
+	return *arena;
+}
+
+void* LLFrameArena::allocateHeap(size_t size)
+{
+	void* memory = ll_aligned_malloc_16(size);
+	if (!memory)
+	{
+		LL_ERRS() << "Out of memory for " << (U32) size << " bytes of frame arena" << LL_ENDL;
+	}
+	++mHeapAllocations;
+	LLTrace::add(sHeapAllocations, 1);
+	return memory;
+}
+
+void* LLFrameArena::allocate(size_t size, size_t alignment)
+{
+	Buffer& buffer = mBuffers[mCurrent];
+	// never hand the same address out twice in a frame
+	size = llmax(size, (size_t) 1);
+	char* ptr = (char*) round_up((size_t) buffer.mPosition, alignment);
+	if (!buffer.mPosition || ptr > buffer.mEnd || size > (size_t) (buffer.mEnd - ptr))
+	{
+		ptr = (char*) round_up((size_t) overflow(buffer, size + alignment), alignment);
+	}
+	buffer.mFrameBytes += ptr + size - buffer.mPosition;
+	buffer.mPosition = ptr + size;
+	return ptr;
+}
+
+void LLFrameArena::deallocate(void* ptr, size_t size)
+{
+	// a container freed right after it grew, or a function's locals in
+	// reverse, the rest waits for the block to be reset
+	Buffer& buffer = mBuffers[mCurrent];
+	if (ptr && (char*) ptr + llmax(size, (size_t) 1) == buffer.mPosition)
+	{
+		buffer.mFrameBytes -= buffer.mPosition - (char*) ptr;
+		buffer.mPosition = (char*) ptr;
+	}
+}
+
+char* LLFrameArena::overflow(Buffer& buffer, size_t size)
+{
+	size_t chunk_size = llmax(round_up(size + sizeof(Chunk), 16), llmax(buffer.mSize, MIN_CHUNK_SIZE));
+	Chunk* chunk = (Chunk*) allocateHeap(chunk_size);
+	chunk->mNext = buffer.mChunks;
+	chunk->mSize = chunk_size;
+	buffer.mChunks = chunk;
+	buffer.mChunkBytes += chunk_size;
+
+	buffer.mPosition = (char*) chunk + round_up(sizeof(Chunk), 16);
+	buffer.mEnd = (char*) chunk + chunk_size;
+	return buffer.mPosition;
+}
+
+void LLFrameArena::reset(Buffer& buffer)
+{
+	if (buffer.mChunks)
+	{
+		// one block for all of it next time
+		size_t size = buffer.mSize + buffer.mChunkBytes;
+		while (buffer.mChunks)
+		{
+			Chunk* next = buffer.mChunks->mNext;
+			ll_aligned_free_16(buffer.mChunks);
+			buffer.mChunks = next;
+		}
+		buffer.mChunkBytes = 0;
+		ll_aligned_free_16(buffer.mBlock);
+		buffer.mBlock = NULL;
+		buffer.mSize = round_up(size, MIN_CHUNK_SIZE);
+		buffer.mBlock = (char*) allocateHeap(buffer.mSize);
+	}
+	buffer.mPosition = buffer.mBlock;
+	buffer.mEnd = buffer.mBlock + buffer.mSize;
+	buffer.mFrameBytes = 0;
+}
+
+void LLFrameArena::endFrame()
+{
+	mCurrent = 1 - mCurrent;
+	reset(mBuffers[mCurrent]);
+}
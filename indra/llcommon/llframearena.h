@@ -0,0 +1,169 @@
+/**
+ * @file llframearena.h
+ * @brief Per thread bump allocator for data that lives for a frame.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFRAMEARENA_H
+#define LL_LLFRAMEARENA_H
+
+#include "llmemory.h"
+
+#include <boost/noncopyable.hpp>
+#include <limits>
+#include <new>
+
+//
+// Memory for the containers a frame fills and throws away, light lists,
+// vertex buffer maps and the like.
+//
+// Allocating moves a pointer along a block, deallocating does nothing
+// unless it is the last allocation, and endFrame() takes the whole block
+// back at once.  There are two blocks, used on alternate frames, so what
+// was allocated during a frame is still there during the next one.
+//
+// A frame that needs more than the block gets overflow chunks from the
+// heap, and the next time that block is reset it's replaced by one as big
+// as everything it held, so once the frames look alike the arena makes no
+// heap allocations at all.  The ones it makes are counted by
+// getHeapAllocations() and the "frame_arena_heap_allocations" LLTrace
+// stat.
+//
+// Each thread has an arena of its own, and must call endFrame() on it
+// every frame if it uses it.  Nothing allocated from it may outlive the
+// next frame, keep those in ordinary containers.
+//
+class LL_COMMON_API LLFrameArena : private boost::noncopyable
+{
+public:
+	LLFrameArena();
+	~LLFrameArena();
+
+	// the calling thread's arena, made on first use
+	static LLFrameArena& getThreadArena();
+
+	// alignment must be a power of two
+	void* allocate(size_t size, size_t alignment = LL_DEFAULT_HEAP_ALIGN);
+	void deallocate(void* ptr, size_t size);
+
+	// resets the block of the frame before this one, and allocates from it
+	void endFrame();
+
+	// bytes taken from the arena this frame, padding included
+	size_t getFrameBytes() const { return mBuffers[mCurrent].mFrameBytes; }
+	size_t getCapacity() const { return mBuffers[0].mSize + mBuffers[1].mSize; }
+	U32 getHeapAllocations() const { return mHeapAllocations; }
+
+private:
+	// an overflow chunk, the memory follows
+	struct Chunk
+	{
+		Chunk* mNext;
+		size_t mSize;
+	};
+
+	struct Buffer
+	{
+		char* mBlock;
+		size_t mSize;
+		char* mPosition;
+		char* mEnd;
+		Chunk* mChunks;
+		size_t mChunkBytes;
+		size_t mFrameBytes;
+	};
+
+	void* allocateHeap(size_t size);
+	char* overflow(Buffer& buffer, size_t size);
+	void reset(Buffer& buffer);
+
+	Buffer mBuffers[2];
+	U32 mCurrent;
+	U32 mHeapAllocations;
+};
+
+
+//
+// An STL allocator for the frame arena of the calling thread, e.g.
+//
+//   typedef std::list<LLVector4, LLFrameAllocator<LLVector4> > light_list_t;
+//
+// Containers using it must be created and destroyed on the same thread,
+// within two frames.
+//
+template <typename T, size_t ALIGNMENT = 16>
+class LLFrameAllocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template <typename U>
+	struct rebind
+	{
+		typedef LLFrameAllocator<U, ALIGNMENT> other;
+	};
+
+	LLFrameAllocator() {}
+	LLFrameAllocator(const LLFrameAllocator&) {}
+	template <typename U>
+	LLFrameAllocator(const LLFrameAllocator<U, ALIGNMENT>&) {}
+
+	pointer address(reference value) const { return &value; }
+	const_pointer address(const_reference value) const { return &value; }
+
+	pointer allocate(size_type count, const void* = 0)
+	{
+		return static_cast<pointer>(LLFrameArena::getThreadArena().allocate(count * sizeof(T), ALIGNMENT));
+	}
+
+	void deallocate(pointer ptr, size_type count)
+	{
+		LLFrameArena::getThreadArena().deallocate(ptr, count * sizeof(T));
+	}
+
+	size_type max_size() const { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+	void construct(pointer ptr, const T& value) { new (static_cast<void*>(ptr)) T(value); }
+	void destroy(pointer ptr) { ptr->~T(); }
+};
+
+// all of them share the thread's arena
+template <typename T, typename U, size_t ALIGNMENT>
+inline bool operator==(const LLFrameAllocator<T, ALIGNMENT>&, const LLFrameAllocator<U, ALIGNMENT>&)
+{
+	return true;
+}
+
+template <typename T, typename U, size_t ALIGNMENT>
+inline bool operator!=(const LLFrameAllocator<T, ALIGNMENT>&, const LLFrameAllocator<U, ALIGNMENT>&)
+{
+	return false;
+}
+
+#endif // LL_LLFRAMEARENA_H
@@ -0,0 +1,577 @@
+/**
+ * @file llhitchrecorder.cpp
+ * @brief Rolling per-frame history written out when a frame takes too long.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llhitchrecorder.h"
+
+#include "lldate.h"
+#include "llerror.h"
+#include "llfasttimer.h"
+#include "llfile.h"
+#include "llqueuedthread.h"
+#include "llsdserialize.h"
+#include "lltrace.h"
+#include "lltracerecording.h"
+#include "lltracetimerevents.h"
+
+#include <algorithm>
+
+const std::string LLHitchRecorder::SNAPSHOT_EXTENSION = ".hitch";
+const std::string LLHitchRecorder::TRACE_EXTENSION = ".json";
+
+// hitches coming in a row only write the first snapshot
+static const F32 SNAPSHOT_INTERVAL = 30.f;
+
+// rows of the report per snapshot
+static const U32 REPORT_TIMERS = 10;
+static const U32 REPORT_COUNTS = 5;
+
+LLHitchRecorder::LLHitchRecorder()
+:	mHitchSeconds(0.f),
+	mHistorySeconds(10.f),
+	mHistoryLength(0.0),
+	mFrameStarted(false),
+	mSnapshotWritten(false),
+	mWriter(NULL)
+{
+}
+
+LLHitchRecorder::~LLHitchRecorder()
+{
+	stopWriterThread();
+}
+
+void LLHitchRecorder::addGauge(const std::string& name, const gauge_func_t& gauge)
+{
+	mGaugeNames.push_back(name);
+	mGauges.push_back(gauge);
+
+	// older frames don't have it
+	mFrames.clear();
+	mHistoryLength = 0.0;
+}
+
+bool LLHitchRecorder::endFrame()
+{
+	if (!mFrameStarted)
+	{
+		mFrameTimer.reset();
+		mFrameStarted = true;
+		return false;
+	}
+
+	F32 seconds = mFrameTimer.getElapsedTimeAndResetF32();
+
+	mFrames.push_back(Frame());
+	Frame& frame = mFrames.back();
+	frame.mTimers.swap(mSpareFrame.mTimers);
+	frame.mCounts.swap(mSpareFrame.mCounts);
+	frame.mGauges.swap(mSpareFrame.mGauges);
+	frame.mSeconds = seconds;
+	recordFrame(frame);
+	mHistoryLength += seconds;
+
+	while (mFrames.size() > 1 && mHistoryLength - mFrames.front().mSeconds >= mHistorySeconds)
+	{
+		Frame& oldest = mFrames.front();
+		mHistoryLength -= oldest.mSeconds;
+		mSpareFrame.mTimers.swap(oldest.mTimers);
+		mSpareFrame.mCounts.swap(oldest.mCounts);
+		mSpareFrame.mGauges.swap(oldest.mGauges);
+		mFrames.pop_front();
+	}
+
+	if (mHitchSeconds > 0.f
+		&& seconds > mHitchSeconds
+		&& (!mSnapshotWritten || mSnapshotTimer.getElapsedTimeF32() > SNAPSHOT_INTERVAL))
+	{
+		mSnapshotWritten = true;
+		mSnapshotTimer.reset();
+		LL_WARNS() << "Frame took " << seconds << " seconds" << LL_ENDL;
+		return writeSnapshot();
+	}
+	return false;
+}
+
+void LLHitchRecorder::recordFrame(Frame& frame)
+{
+	frame.mTimers.clear();
+	frame.mCounts.clear();
+	frame.mGauges.clear();
+
+	LLTrace::Recording& recording = LLTrace::get_frame_recording().getLastRecording();
+
+	for (LLTrace::BlockTimerStatHandle::instance_tracker_t::instance_iter it = LLTrace::BlockTimerStatHandle::instance_tracker_t::beginInstances(), end_it = LLTrace::BlockTimerStatHandle::instance_tracker_t::endInstances();
+		it != end_it;
+		++it)
+	{
+		LLTrace::BlockTimerStatHandle& timer = static_cast<LLTrace::BlockTimerStatHandle&>(*it);
+		S32 calls = recording.getSum(timer.callCount());
+		if (calls <= 0) continue;
+
+		TimerSample sample;
+		sample.mTimeBlock = (U32) timer.getIndex();
+		sample.mMicroseconds = (U32) recording.getSum(timer).valueInUnits<LLUnits::Microseconds>();
+		sample.mSelfMicroseconds = (U32) recording.getSum(timer.selfTime()).valueInUnits<LLUnits::Microseconds>();
+		sample.mCalls = (U32) calls;
+		frame.mTimers.push_back(sample);
+	}
+
+	for (LLTrace::StatType<LLTrace::CountAccumulator>::instance_tracker_t::instance_iter it = LLTrace::StatType<LLTrace::CountAccumulator>::instance_tracker_t::beginInstances(), end_it = LLTrace::StatType<LLTrace::CountAccumulator>::instance_tracker_t::endInstances();
+		it != end_it;
+		++it)
+	{
+		F64 value = recording.getSum(*it);
+		if (value == 0.0) continue;
+
+		CountSample sample;
+		sample.mCount = (U32) it->getIndex();
+		sample.mValue = (F32) value;
+		frame.mCounts.push_back(sample);
+	}
+
+	for (std::vector<gauge_func_t>::iterator it = mGauges.begin(); it != mGauges.end(); ++it)
+	{
+		frame.mGauges.push_back((F32) (*it)());
+	}
+}
+
+LLSD LLHitchRecorder::getSnapshot()
+{
+	// the frames only keep accumulator indices, the snapshot refers to
+	// timers and counts by their position in its own tables
+	std::vector<LLTrace::BlockTimerStatHandle*> timers(LLTrace::BlockTimerStatHandle::getNumIndices(), NULL);
+	for (LLTrace::BlockTimerStatHandle::instance_tracker_t::instance_iter it = LLTrace::BlockTimerStatHandle::instance_tracker_t::beginInstances(), end_it = LLTrace::BlockTimerStatHandle::instance_tracker_t::endInstances();
+		it != end_it;
+		++it)
+	{
+		if (it->getIndex() < timers.size())
+		{
+			timers[it->getIndex()] = static_cast<LLTrace::BlockTimerStatHandle*>(&*it);
+		}
+	}
+	std::vector<LLTrace::StatType<LLTrace::CountAccumulator>*> counts(LLTrace::StatType<LLTrace::CountAccumulator>::getNumIndices(), NULL);
+	for (LLTrace::StatType<LLTrace::CountAccumulator>::instance_tracker_t::instance_iter it = LLTrace::StatType<LLTrace::CountAccumulator>::instance_tracker_t::beginInstances(), end_it = LLTrace::StatType<LLTrace::CountAccumulator>::instance_tracker_t::endInstances();
+		it != end_it;
+		++it)
+	{
+		if (it->getIndex() < counts.size())
+		{
+			counts[it->getIndex()] = &*it;
+		}
+	}
+
+	std::vector<S32> timer_slots(timers.size(), -1);
+	std::vector<S32> count_slots(counts.size(), -1);
+
+	LLSD snapshot;
+	snapshot["Version"] = 1;
+	snapshot["Date"] = LLDate::now();
+	snapshot["HitchSeconds"] = (LLSD::Real) mHitchSeconds;
+	snapshot["Timers"] = LLSD::emptyArray();
+	snapshot["Counts"] = LLSD::emptyArray();
+	snapshot["Gauges"] = LLSD::emptyArray();
+	for (std::vector<std::string>::iterator it = mGaugeNames.begin(); it != mGaugeNames.end(); ++it)
+	{
+		snapshot["Gauges"].append(*it);
+	}
+
+	LLSD& frames = snapshot["Frames"];
+	frames = LLSD::emptyArray();
+	for (std::deque<Frame>::iterator frame_it = mFrames.begin(); frame_it != mFrames.end(); ++frame_it)
+	{
+		LLSD frame;
+		frame["Seconds"] = (LLSD::Real) frame_it->mSeconds;
+
+		// slot, microseconds, self microseconds, calls
+		LLSD& frame_timers = frame["Timers"];
+		frame_timers = LLSD::emptyArray();
+		for (std::vector<TimerSample>::iterator it = frame_it->mTimers.begin(); it != frame_it->mTimers.end(); ++it)
+		{
+			if (it->mTimeBlock >= timers.size() || !timers[it->mTimeBlock]) continue;
+
+			S32& slot = timer_slots[it->mTimeBlock];
+			if (slot < 0)
+			{
+				LLTrace::BlockTimerStatHandle* timer = timers[it->mTimeBlock];
+				LLTrace::BlockTimerStatHandle* parent = timer->getParent();
+				LLSD timer_sd;
+				timer_sd["Name"] = timer->getName();
+				timer_sd["Parent"] = (parent && parent != timer) ? parent->getName() : std::string();
+				slot = snapshot["Timers"].size();
+				snapshot["Timers"].append(timer_sd);
+			}
+			frame_timers.append(slot);
+			frame_timers.append((LLSD::Integer) it->mMicroseconds);
+			frame_timers.append((LLSD::Integer) it->mSelfMicroseconds);
+			frame_timers.append((LLSD::Integer) it->mCalls);
+		}
+
+		// slot, value
+		LLSD& frame_counts = frame["Counts"];
+		frame_counts = LLSD::emptyArray();
+		for (std::vector<CountSample>::iterator it = frame_it->mCounts.begin(); it != frame_it->mCounts.end(); ++it)
+		{
+			if (it->mCount >= counts.size() || !counts[it->mCount]) continue;
+
+			S32& slot = count_slots[it->mCount];
+			if (slot < 0)
+			{
+				slot = snapshot["Counts"].size();
+				snapshot["Counts"].append(counts[it->mCount]->getName());
+			}
+			frame_counts.append(slot);
+			frame_counts.append((LLSD::Real) it->mValue);
+		}
+
+		LLSD& frame_gauges = frame["Gauges"];
+		frame_gauges = LLSD::emptyArray();
+		for (std::vector<F32>::iterator it = frame_it->mGauges.begin(); it != frame_it->mGauges.end(); ++it)
+		{
+			frame_gauges.append((LLSD::Real) *it);
+		}
+
+		frames.append(frame);
+	}
+
+	return snapshot;
+}
+
+//----------------------------------------------------------------------------------------------
+// Writing of the snapshots
+//----------------------------------------------------------------------------------------------
+
+namespace
+{
+	// what the main thread copied at the hitch, anything may serialize it
+	struct Snapshot
+	{
+		std::string							mSnapshotFilename;
+		LLSD								mFrames;
+		std::string							mTraceFilename;		// empty when timer events aren't recorded
+		LLTrace::TimerEventBuffer::Trace	mTrace;
+
+		bool write() const
+		{
+			llofstream os(mSnapshotFilename.c_str(), std::ios::out | std::ios::binary);
+			if (!os.is_open())
+			{
+				LL_WARNS() << "Couldn't write hitch snapshot " << mSnapshotFilename << LL_ENDL;
+				return false;
+			}
+			LLSDSerialize::serialize(mFrames, os, LLSDSerialize::LLSD_BINARY);
+			os.close();
+			LL_INFOS() << "Wrote hitch snapshot " << mSnapshotFilename << LL_ENDL;
+
+			if (!mTraceFilename.empty())
+			{
+				llofstream trace_os(mTraceFilename.c_str());
+				if (!trace_os.is_open())
+				{
+					LL_WARNS() << "Couldn't write timer trace " << mTraceFilename << LL_ENDL;
+					return false;
+				}
+				LLTrace::TimerEventBuffer::writeChromeTrace(mTrace, trace_os);
+				trace_os.close();
+				LL_INFOS() << "Wrote timer trace " << mTraceFilename << LL_ENDL;
+			}
+			return true;
+		}
+	};
+}
+
+// one snapshot at a time, on the work scheduler if there is one
+class LLHitchRecorder::SnapshotWriter : public LLQueuedThread
+{
+public:
+	SnapshotWriter()
+	:	LLQueuedThread("Hitch Snapshots", true, false, 1),
+		mQueued(0)
+	{
+	}
+
+	// takes the snapshot
+	void write(Snapshot* snapshot)
+	{
+		mQueued++;
+		addRequest(new Request(generateHandle(), this, snapshot));
+	}
+
+	// waits up to 10 seconds for the queued snapshots
+	void waitForWrites()
+	{
+		LLTimer timer;
+		while (mQueued > 0 && timer.getElapsedTimeF32() < 10.f)
+		{
+			update(0);
+			ms_sleep(1);
+		}
+	}
+
+private:
+	class Request : public QueuedRequest
+	{
+	public:
+		Request(handle_t handle, SnapshotWriter* writer, Snapshot* snapshot)
+		:	QueuedRequest(handle, PRIORITY_LOW, FLAG_AUTO_COMPLETE),
+			mWriter(writer),
+			mSnapshot(snapshot)
+		{
+		}
+
+		/*virtual*/ bool processRequest()
+		{
+			mSnapshot->write();
+			return true;
+		}
+
+		/*virtual*/ void finishRequest(bool completed)
+		{
+			mWriter->mQueued--;
+		}
+
+	protected:
+		/*virtual*/ ~Request()
+		{
+			delete mSnapshot;
+		}
+
+	private:
+		SnapshotWriter* mWriter;
+		Snapshot* mSnapshot;
+	};
+
+	LLAtomicS32 mQueued;
+};
+
+void LLHitchRecorder::startWriterThread()
+{
+	if (!mWriter)
+	{
+		mWriter = new SnapshotWriter;
+	}
+}
+
+void LLHitchRecorder::stopWriterThread()
+{
+	if (mWriter)
+	{
+		mWriter->waitForWrites();
+		delete mWriter;
+		mWriter = NULL;
+	}
+}
+
+bool LLHitchRecorder::writeSnapshot()
+{
+	// only the copying is done here, on the main thread
+	Snapshot* snapshot = new Snapshot;
+	std::string filename = mSnapshotPrefix + LLDate::now().toHTTPDateString("%Y%m%d_%H%M%S");
+	snapshot->mSnapshotFilename = filename + SNAPSHOT_EXTENSION;
+	snapshot->mFrames = getSnapshot();
+	if (LLTrace::TimerEventBuffer::isRecording())
+	{
+		snapshot->mTraceFilename = filename + TRACE_EXTENSION;
+		LLTrace::TimerEventBuffer::copyTrace(snapshot->mTrace);
+	}
+
+	if (mWriter)
+	{
+		mWriter->write(snapshot);
+		return true;
+	}
+	bool written = snapshot->write();
+	delete snapshot;
+	return written;
+}
+
+//----------------------------------------------------------------------------------------------
+// Analysis of the snapshots
+//----------------------------------------------------------------------------------------------
+
+namespace
+{
+	// a value of the hitch frame against its average over the other frames
+	struct HitchValue
+	{
+		std::string	mName;
+		F64			mHitch;
+		F64			mAverage;
+
+		F64 getExcess() const { return mHitch - mAverage; }
+		bool operator<(const HitchValue& other) const { return getExcess() > other.getExcess(); }
+	};
+
+	// values of a snapshot table, from the flattened frame arrays
+	void get_hitch_values(const LLSD& snapshot, const std::string& table, S32 stride, S32 value_offset, F64 scale, std::vector<HitchValue>& values)
+	{
+		const LLSD& names = snapshot[table];
+		const LLSD& frames = snapshot["Frames"];
+		S32 num_frames = frames.size();
+
+		values.clear();
+		values.resize(names.size());
+		for (S32 i = 0; i < (S32) names.size(); ++i)
+		{
+			values[i].mName = names[i].isMap() ? names[i]["Name"].asString() : names[i].asString();
+			values[i].mHitch = 0.0;
+			values[i].mAverage = 0.0;
+		}
+
+		for (S32 frame = 0; frame < num_frames; ++frame)
+		{
+			const LLSD& samples = frames[frame][table];
+			for (S32 i = 0; i + stride <= (S32) samples.size(); i += stride)
+			{
+				S32 slot = samples[i].asInteger();
+				if (slot < 0 || slot >= (S32) values.size()) continue;
+
+				F64 value = samples[i + value_offset].asReal() * scale;
+				if (frame == num_frames - 1)
+				{
+					values[slot].mHitch += value;
+				}
+				else
+				{
+					values[slot].mAverage += value;
+				}
+			}
+		}
+
+		if (num_frames > 1)
+		{
+			for (std::vector<HitchValue>::iterator it = values.begin(); it != values.end(); ++it)
+			{
+				it->mAverage /= (F64) (num_frames - 1);
+			}
+		}
+		std::sort(values.begin(), values.end());
+	}
+
+	void write_hitch_value(std::ofstream& os, const std::string& snapshot_name, const char* kind, const HitchValue& value)
+	{
+		os << snapshot_name << ", " << kind << ", " << value.mName << ", "
+		   << value.mHitch << ", " << value.mAverage << ", " << value.getExcess() << "\n";
+	}
+}
+
+/*static*/
+void LLHitchRecorder::doAnalysisHitches(const std::vector<std::string>& snapshots, std::string output)
+{
+	if (snapshots.empty())
+	{
+		LL_INFOS() << "No hitch snapshots to analyze" << LL_ENDL;
+		return;
+	}
+
+	std::ofstream os(output.c_str());
+	if (!os.is_open())
+	{
+		LL_WARNS() << "Couldn't write hitch report " << output << LL_ENDL;
+		return;
+	}
+
+	// timer with the largest excess self time of each hitch
+	std::map<std::string, S32> worst_timer_hitches;
+	std::map<std::string, F64> worst_timer_excess;
+
+	os << "Snapshot, Kind, Name, Hitch, Average, Excess(Hitch-Average)\n";
+	for (std::vector<std::string>::const_iterator it = snapshots.begin(); it != snapshots.end(); ++it)
+	{
+		LLSD snapshot;
+		std::ifstream is(it->c_str(), std::ios::in | std::ios::binary);
+		if (!is.is_open()
+			|| !LLSDSerialize::deserialize(snapshot, is, LLSDSerialize::SIZE_UNLIMITED)
+			|| snapshot["Frames"].size() == 0)
+		{
+			LL_WARNS() << "Couldn't read hitch snapshot " << *it << LL_ENDL;
+			continue;
+		}
+
+		std::string snapshot_name = *it;
+		std::string::size_type slash = snapshot_name.find_last_of("/\\");
+		if (slash != std::string::npos)
+		{
+			snapshot_name = snapshot_name.substr(slash + 1);
+		}
+
+		// frame durations in ms
+		const LLSD& frames = snapshot["Frames"];
+		HitchValue frame_time;
+		frame_time.mName = "Frame (ms)";
+		frame_time.mHitch = frames[frames.size() - 1]["Seconds"].asReal() * 1000.0;
+		frame_time.mAverage = 0.0;
+		for (S32 i = 0; i < (S32) frames.size() - 1; ++i)
+		{
+			frame_time.mAverage += frames[i]["Seconds"].asReal() * 1000.0 / (F64) (frames.size() - 1);
+		}
+		write_hitch_value(os, snapshot_name, "Frame", frame_time);
+
+		// timers by self time in ms
+		std::vector<HitchValue> values;
+		get_hitch_values(snapshot, "Timers", 4, 2, 0.001, values);
+		for (U32 i = 0; i < values.size() && i < REPORT_TIMERS && values[i].getExcess() > 0.0; ++i)
+		{
+			write_hitch_value(os, snapshot_name, "Timer (ms)", values[i]);
+		}
+		if (!values.empty() && values[0].getExcess() > 0.0)
+		{
+			worst_timer_hitches[values[0].mName]++;
+			worst_timer_excess[values[0].mName] += values[0].getExcess();
+		}
+
+		get_hitch_values(snapshot, "Counts", 2, 1, 1.0, values);
+		for (U32 i = 0; i < values.size() && i < REPORT_COUNTS && values[i].getExcess() > 0.0; ++i)
+		{
+			write_hitch_value(os, snapshot_name, "Count", values[i]);
+		}
+
+		// every gauge, they are few
+		const LLSD& gauge_names = snapshot["Gauges"];
+		for (S32 gauge = 0; gauge < (S32) gauge_names.size(); ++gauge)
+		{
+			HitchValue value;
+			value.mName = gauge_names[gauge].asString();
+			value.mHitch = frames[frames.size() - 1]["Gauges"][gauge].asReal();
+			value.mAverage = 0.0;
+			for (S32 i = 0; i < (S32) frames.size() - 1; ++i)
+			{
+				value.mAverage += frames[i]["Gauges"][gauge].asReal() / (F64) (frames.size() - 1);
+			}
+			write_hitch_value(os, snapshot_name, "Gauge", value);
+		}
+	}
+
+	os << "\nWorst timer, Hitches, Total excess (ms)\n";
+	for (std::map<std::string, S32>::iterator it = worst_timer_hitches.begin(); it != worst_timer_hitches.end(); ++it)
+	{
+		os << it->first << ", " << it->second << ", " << worst_timer_excess[it->first] << "\n";
+	}
+
+	os.flush();
+	os.close();
+}
@@ -0,0 +1,168 @@
+/**
+ * @file llhitchrecorder.h
+ * @brief Rolling per-frame history written out when a frame takes too long.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLHITCHRECORDER_H
+#define LL_LLHITCHRECORDER_H
+
+#include "llsingleton.h"
+#include "llsd.h"
+#include "lltimer.h"
+
+#include <boost/function.hpp>
+#include <deque>
+#include <string>
+#include <vector>
+
+/**
+ * @class LLHitchRecorder
+ * @brief Flight recorder of the last seconds of frames.
+ *
+ * Keeps, for each frame of the last few seconds, its duration, the
+ * BlockTimers and LLTrace counts of the frame recording and the values of
+ * the registered gauges (queue depths and such).  When a frame takes longer
+ * than the hitch threshold, the history is written to a snapshot file so a
+ * freeze can be looked at after the fact, without having had the
+ * performance log turned on.
+ */
+class LL_COMMON_API LLHitchRecorder : public LLSingleton<LLHitchRecorder>
+{
+	friend class LLSingleton<LLHitchRecorder>;
+	LLHitchRecorder();
+	~LLHitchRecorder();
+
+public:
+	typedef boost::function<F64 ()> gauge_func_t;
+
+	/**
+	 * @brief Adds a value to sample at the end of every frame.
+	 * @param[in] name - Name of the value in snapshots.
+	 * @param[in] gauge - Returns the current value, called on the main thread.
+	 */
+	void addGauge(const std::string& name, const gauge_func_t& gauge);
+
+	/**
+	 * @brief Frames longer than this write a snapshot, 0 never writes any.
+	 */
+	void setHitchSeconds(F32 seconds) { mHitchSeconds = seconds; }
+	F32 getHitchSeconds() const { return mHitchSeconds; }
+
+	/**
+	 * @brief How far back the history goes.
+	 */
+	void setHistorySeconds(F32 seconds) { mHistorySeconds = llmax(seconds, 1.f); }
+
+	/**
+	 * @brief Path and start of the snapshot file names, the date and
+	 * SNAPSHOT_EXTENSION are appended.  The timer trace of the hitch goes
+	 * next to it, with TRACE_EXTENSION.
+	 */
+	void setSnapshotPrefix(const std::string& prefix) { mSnapshotPrefix = prefix; }
+
+	/**
+	 * @brief Until stopWriterThread(), snapshots are serialized and written
+	 * on a worker instead of by endFrame(), so writing them doesn't make
+	 * the hitch longer.
+	 */
+	void startWriterThread();
+
+	/**
+	 * @brief Waits for the snapshots still being written, then goes back to
+	 * writing them in endFrame().  Call before LLWorkScheduler::cleanupClass().
+	 */
+	void stopWriterThread();
+
+	/**
+	 * @brief Records the frame that just ended and, if it was a hitch,
+	 * writes a snapshot and the timer trace of the last frames.  Call once
+	 * per frame, after the frame recording moved to the next period.
+	 * @return Returns true if a snapshot was written or queued for writing.
+	 */
+	bool endFrame();
+
+	/**
+	 * @return Returns the history as snapshot LLSD, the last frame is the hitch.
+	 */
+	LLSD getSnapshot();
+
+	/**
+	 * @brief Summarizes hitch snapshots into a CSV report, for each snapshot
+	 * the timers, counts and gauges of the hitch frame that went furthest
+	 * above their average over the rest of the history, then the timers
+	 * that were worst most often.
+	 * @param[in] snapshots - Snapshot files to read.
+	 * @param[in] output - Report file to write.
+	 */
+	static void doAnalysisHitches(const std::vector<std::string>& snapshots, std::string output);
+
+	static const std::string SNAPSHOT_EXTENSION;
+	static const std::string TRACE_EXTENSION;
+
+private:
+	class SnapshotWriter;
+
+	struct TimerSample
+	{
+		U32	mTimeBlock;			// BlockTimerStatHandle index
+		U32	mMicroseconds;
+		U32	mSelfMicroseconds;
+		U32	mCalls;
+	};
+
+	struct CountSample
+	{
+		U32	mCount;				// StatType<CountAccumulator> index
+		F32	mValue;
+	};
+
+	struct Frame
+	{
+		F32							mSeconds;
+		std::vector<TimerSample>	mTimers;
+		std::vector<CountSample>	mCounts;
+		std::vector<F32>			mGauges;
+	};
+
+	void recordFrame(Frame& frame);
+	bool writeSnapshot();
+
+	F32							mHitchSeconds;
+	F32							mHistorySeconds;
+	F64							mHistoryLength;		// sum of the durations of mFrames
+	std::string					mSnapshotPrefix;
+
+	std::deque<Frame>			mFrames;
+	Frame						mSpareFrame;		// storage of the last dropped frame, reused
+	LLTimer						mFrameTimer;
+	bool						mFrameStarted;
+	LLTimer						mSnapshotTimer;
+	bool						mSnapshotWritten;
+	SnapshotWriter*				mWriter;			// NULL when endFrame() writes
+
+	std::vector<std::string>	mGaugeNames;
+	std::vector<gauge_func_t>	mGauges;
+};
+
+#endif // LL_LLHITCHRECORDER_H
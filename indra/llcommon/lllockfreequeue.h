@@ -0,0 +1,616 @@
+/**
+ * @file lllockfreequeue.h
+ * @brief Lock-free queues for handing work between threads.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLLOCKFREEQUEUE_H
+#define LL_LLLOCKFREEQUEUE_H
+
+#include <boost/noncopyable.hpp>
+
+#if LL_WINDOWS
+#include <intrin.h>
+#endif
+
+//
+// Atomic operations for the queues below.  The read-modify-write ones are
+// full barriers, loads acquire and stores release.
+//
+namespace LLLockFree
+{
+#if LL_WINDOWS
+	// intrinsics rather than windows.h, this gets included by llfasttimer.h
+	inline U32 fetchAdd(volatile U32* value, U32 add)
+	{
+		return (U32) _InterlockedExchangeAdd((volatile long*) value, (long) add);
+	}
+
+	inline bool compareAndSwap(volatile U32* value, U32 expected, U32 desired)
+	{
+		return (U32) _InterlockedCompareExchange((volatile long*) value, (long) desired, (long) expected) == expected;
+	}
+
+	template <typename T>
+	inline bool compareAndSwap(T* volatile* value, T* expected, T* desired)
+	{
+#ifdef _WIN64
+		return _InterlockedCompareExchangePointer((void* volatile*) value, (void*) desired, (void*) expected) == (void*) expected;
+#else
+		return (long) _InterlockedCompareExchange((volatile long*) value, (long) desired, (long) expected) == (long) expected;
+#endif
+	}
+
+	template <typename T>
+	inline T* exchange(T* volatile* value, T* desired)
+	{
+#ifdef _WIN64
+		return (T*) _InterlockedExchangePointer((void* volatile*) value, (void*) desired);
+#else
+		return (T*) _InterlockedExchange((volatile long*) value, (long) desired);
+#endif
+	}
+
+	// volatile accesses are acquire and release with MSVC
+	template <typename T>
+	inline T load(const volatile T* value)
+	{
+		T result = *value;
+		_ReadWriteBarrier();
+		return result;
+	}
+
+	template <typename T>
+	inline void store(volatile T* value, T desired)
+	{
+		_ReadWriteBarrier();
+		*value = desired;
+	}
+
+	// x86 keeps stores in order and loads in order, only the compiler mustn't
+	inline void storeFence() { _ReadWriteBarrier(); }
+	inline void loadFence() { _ReadWriteBarrier(); }
+#else
+	inline U32 fetchAdd(volatile U32* value, U32 add)
+	{
+		return __sync_fetch_and_add(value, add);
+	}
+
+	inline bool compareAndSwap(volatile U32* value, U32 expected, U32 desired)
+	{
+		return __sync_bool_compare_and_swap(value, expected, desired);
+	}
+
+	template <typename T>
+	inline bool compareAndSwap(T* volatile* value, T* expected, T* desired)
+	{
+		return __sync_bool_compare_and_swap(value, expected, desired);
+	}
+
+	template <typename T>
+	inline T* exchange(T* volatile* value, T* desired)
+	{
+		// __sync_lock_test_and_set() is only an acquire barrier
+		__sync_synchronize();
+		return __sync_lock_test_and_set(value, desired);
+	}
+
+	template <typename T>
+	inline T load(const volatile T* value)
+	{
+		return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+	}
+
+	template <typename T>
+	inline void store(volatile T* value, T desired)
+	{
+		__atomic_store_n(value, desired, __ATOMIC_RELEASE);
+	}
+
+	// stores before it become visible before the stores after it
+	inline void storeFence() { __atomic_thread_fence(__ATOMIC_RELEASE); }
+	// loads before it are done before the loads after it
+	inline void loadFence() { __atomic_thread_fence(__ATOMIC_ACQUIRE); }
+#endif
+
+	// keeps the counters the threads fight over on cache lines of their own
+	const size_t CACHE_LINE_SIZE = 64;
+}
+
+
+//
+// A bounded multi-producer multi-consumer FIFO ring (Dmitry Vyukov's).
+//
+// Each slot has a sequence number telling whether it's free for the push
+// or full for the pop of a given lap around the ring, so pushes and pops
+// only contend on their own position counter and never wait on one
+// another.  Elements are copied in and out, popped slots are reset to
+// ElementT() so they don't keep anything alive.
+//
+template <typename ElementT>
+class LLBoundedMPMCQueue : private boost::noncopyable
+{
+public:
+	typedef ElementT value_type;
+
+	// capacity is rounded up to a power of two
+	explicit LLBoundedMPMCQueue(U32 capacity = 1024);
+	~LLBoundedMPMCQueue();
+
+	// false if the queue is full
+	bool tryPush(const ElementT& element);
+
+	// false if the queue is empty
+	bool tryPop(ElementT& element);
+
+	U32 getCapacity() const { return mMask + 1; }
+
+	// only a snapshot while other threads push and pop
+	U32 size() const;
+
+private:
+	struct Slot
+	{
+		volatile U32 mSequence;
+		ElementT mElement;
+	};
+
+	Slot* mSlots;
+	U32 mMask;
+	char mPad0[LLLockFree::CACHE_LINE_SIZE];
+	volatile U32 mPushPosition;
+	char mPad1[LLLockFree::CACHE_LINE_SIZE];
+	volatile U32 mPopPosition;
+	char mPad2[LLLockFree::CACHE_LINE_SIZE];
+};
+
+
+//
+// An unbounded multi-producer multi-consumer FIFO of pointers.
+//
+// The queue is a list of segments of slots.  Pushes and pops claim slots by
+// incrementing a segment's push or pop index, a push that finds its segment
+// full appends a new one and a pop that finds its segment drained moves on
+// to the next.  A pop that claims a slot before its push stored the element
+// marks it taken, and that push retries on a later slot.
+//
+// Drained segments are kept on a retired list until no thread is left in
+// a push or pop that may still see them.  Threads count themselves in one
+// of two counters by the generation they entered in, and the generation
+// only moves on once nobody from the one before is left, so a segment
+// retired in a generation is freed two generations later, however many
+// threads keep overlapping.
+//
+// Pushed pointers must not be NULL.
+//
+template <typename ElementT>
+class LLLockFreeQueue : private boost::noncopyable
+{
+public:
+	typedef ElementT* value_type;
+
+	explicit LLLockFreeQueue(U32 segment_size = 1024);
+
+	// Elements still queued are not deleted.
+	~LLLockFreeQueue();
+
+	void push(ElementT* element);
+
+	// NULL if the queue is empty
+	ElementT* pop();
+
+	// only a snapshot while other threads push and pop
+	U32 size() const;
+
+	bool empty() const { return size() == 0; }
+
+private:
+	struct Segment
+	{
+		Segment(U32 size);
+		~Segment();
+
+		volatile U32 mPushIndex;
+		char mPad0[LLLockFree::CACHE_LINE_SIZE];
+		volatile U32 mPopIndex;
+		char mPad1[LLLockFree::CACHE_LINE_SIZE];
+		Segment* volatile mNext;
+		Segment* mNextRetired;
+		U32 mRetiredGeneration;
+		ElementT* volatile* mSlots;
+	};
+
+	// enter() returns the generation to leave()
+	U32 enter() const;
+	void leave(U32 generation) const { LLLockFree::fetchAdd(&mActiveThreads[generation & 1], (U32) -1); }
+	void retire(Segment* segment);
+
+	ElementT* getTakenMarker() const
+	{
+		return static_cast<ElementT*>(static_cast<void*>(const_cast<char*>(&mTakenMarker)));
+	}
+
+	const U32 mSegmentSize;
+	char mTakenMarker;
+	char mPad0[LLLockFree::CACHE_LINE_SIZE];
+	Segment* volatile mHead;
+	char mPad1[LLLockFree::CACHE_LINE_SIZE];
+	Segment* volatile mTail;
+	char mPad2[LLLockFree::CACHE_LINE_SIZE];
+	mutable volatile U32 mGeneration;
+	mutable volatile U32 mActiveThreads[2];	// in a push, pop or size(), by generation
+	Segment* volatile mRetired;
+};
+
+
+// LLBoundedMPMCQueue
+//-----------------------------------------------------------------------------
+
+
+template <typename ElementT>
+LLBoundedMPMCQueue<ElementT>::LLBoundedMPMCQueue(U32 capacity)
+:	mSlots(NULL),
+	mMask(1),
+	mPushPosition(0),
+	mPopPosition(0)
+{
+	while (mMask + 1 < capacity && mMask < 0x3FFFFFFF)
+	{
+		mMask = (mMask << 1) | 1;
+	}
+
+	mSlots = new Slot[mMask + 1];
+	for (U32 i = 0; i <= mMask; ++i)
+	{
+		mSlots[i].mSequence = i;
+	}
+}
+
+
+template <typename ElementT>
+LLBoundedMPMCQueue<ElementT>::~LLBoundedMPMCQueue()
+{
+	delete[] mSlots;
+}
+
+
+template <typename ElementT>
+bool LLBoundedMPMCQueue<ElementT>::tryPush(const ElementT& element)
+{
+	Slot* slot;
+	U32 position = LLLockFree::load(&mPushPosition);
+	while (true)
+	{
+		slot = &mSlots[position & mMask];
+		S32 lap = (S32) (LLLockFree::load(&slot->mSequence) - position);
+		if (lap == 0)
+		{
+			if (LLLockFree::compareAndSwap(&mPushPosition, position, position + 1))
+			{
+				break;
+			}
+		}
+		else if (lap < 0)
+		{
+			// still holds the element of the previous lap
+			return false;
+		}
+		position = LLLockFree::load(&mPushPosition);
+	}
+
+	slot->mElement = element;
+	LLLockFree::store(&slot->mSequence, position + 1);
+	return true;
+}
+
+
+template <typename ElementT>
+bool LLBoundedMPMCQueue<ElementT>::tryPop(ElementT& element)
+{
+	Slot* slot;
+	U32 position = LLLockFree::load(&mPopPosition);
+	while (true)
+	{
+		slot = &mSlots[position & mMask];
+		S32 lap = (S32) (LLLockFree::load(&slot->mSequence) - (position + 1));
+		if (lap == 0)
+		{
+			if (LLLockFree::compareAndSwap(&mPopPosition, position, position + 1))
+			{
+				break;
+			}
+		}
+		else if (lap < 0)
+		{
+			// not pushed yet
+			return false;
+		}
+		position = LLLockFree::load(&mPopPosition);
+	}
+
+	element = slot->mElement;
+	slot->mElement = ElementT();
+	LLLockFree::store(&slot->mSequence, position + mMask + 1);
+	return true;
+}
+
+
+template <typename ElementT>
+U32 LLBoundedMPMCQueue<ElementT>::size() const
+{
+	S32 count = (S32) (LLLockFree::load(&mPushPosition) - LLLockFree::load(&mPopPosition));
+	return count > 0 ? (U32) count : 0;
+}
+
+
+// LLLockFreeQueue
+//-----------------------------------------------------------------------------
+
+
+template <typename ElementT>
+LLLockFreeQueue<ElementT>::Segment::Segment(U32 size)
+:	mPushIndex(0),
+	mPopIndex(0),
+	mNext(NULL),
+	mNextRetired(NULL),
+	mRetiredGeneration(0),
+	mSlots(new ElementT* volatile[size])
+{
+	for (U32 i = 0; i < size; ++i)
+	{
+		mSlots[i] = NULL;
+	}
+}
+
+
+template <typename ElementT>
+LLLockFreeQueue<ElementT>::Segment::~Segment()
+{
+	delete[] mSlots;
+}
+
+
+template <typename ElementT>
+LLLockFreeQueue<ElementT>::LLLockFreeQueue(U32 segment_size)
+:	mSegmentSize(segment_size > 1 ? segment_size : 2),
+	mTakenMarker(0),
+	mHead(NULL),
+	mTail(NULL),
+	mGeneration(0),
+	mRetired(NULL)
+{
+	mActiveThreads[0] = mActiveThreads[1] = 0;
+	mHead = mTail = new Segment(mSegmentSize);
+}
+
+
+template <typename ElementT>
+LLLockFreeQueue<ElementT>::~LLLockFreeQueue()
+{
+	while (mHead)
+	{
+		Segment* next = mHead->mNext;
+		delete mHead;
+		mHead = next;
+	}
+	while (mRetired)
+	{
+		Segment* next = mRetired->mNextRetired;
+		delete mRetired;
+		mRetired = next;
+	}
+}
+
+
+template <typename ElementT>
+void LLLockFreeQueue<ElementT>::push(ElementT* element)
+{
+	llassert(element != NULL);
+
+	U32 generation = enter();
+	while (true)
+	{
+		Segment* tail = LLLockFree::load(&mTail);
+		U32 index = LLLockFree::fetchAdd(&tail->mPushIndex, 1);
+		if (index < mSegmentSize)
+		{
+			if (LLLockFree::compareAndSwap(&tail->mSlots[index], (ElementT*) NULL, element))
+			{
+				break;
+			}
+			// a pop got there first and took the slot
+			continue;
+		}
+
+		// full, append a segment or help whoever is appending one
+		if (tail != LLLockFree::load(&mTail))
+		{
+			continue;
+		}
+		Segment* next = LLLockFree::load(&tail->mNext);
+		if (next)
+		{
+			LLLockFree::compareAndSwap(&mTail, tail, next);
+			continue;
+		}
+
+		Segment* segment = new Segment(mSegmentSize);
+		segment->mSlots[0] = element;
+		segment->mPushIndex = 1;
+		if (LLLockFree::compareAndSwap(&tail->mNext, (Segment*) NULL, segment))
+		{
+			LLLockFree::compareAndSwap(&mTail, tail, segment);
+			break;
+		}
+		delete segment;
+	}
+	leave(generation);
+}
+
+
+template <typename ElementT>
+ElementT* LLLockFreeQueue<ElementT>::pop()
+{
+	ElementT* element = NULL;
+
+	U32 generation = enter();
+	while (true)
+	{
+		Segment* head = LLLockFree::load(&mHead);
+		if (LLLockFree::load(&head->mPopIndex) >= LLLockFree::load(&head->mPushIndex)
+			&& !LLLockFree::load(&head->mNext))
+		{
+			break;
+		}
+
+		U32 index = LLLockFree::fetchAdd(&head->mPopIndex, 1);
+		if (index < mSegmentSize)
+		{
+			element = LLLockFree::exchange(&head->mSlots[index], getTakenMarker());
+			if (element)
+			{
+				break;
+			}
+			// claimed before its push stored it, that push moves on
+			continue;
+		}
+
+		// drained, move on to the next segment
+		Segment* next = LLLockFree::load(&head->mNext);
+		if (!next)
+		{
+			break;
+		}
+		// the tail can lag behind, it mustn't be left on a retired segment
+		if (LLLockFree::load(&mTail) == head)
+		{
+			LLLockFree::compareAndSwap(&mTail, head, next);
+		}
+		if (LLLockFree::compareAndSwap(&mHead, head, next))
+		{
+			retire(head);
+		}
+	}
+	leave(generation);
+
+	return element;
+}
+
+
+template <typename ElementT>
+U32 LLLockFreeQueue<ElementT>::size() const
+{
+	U32 count = 0;
+
+	U32 generation = enter();
+	for (Segment* segment = LLLockFree::load(&mHead); segment; segment = LLLockFree::load(&segment->mNext))
+	{
+		U32 pushed = llmin(LLLockFree::load(&segment->mPushIndex), mSegmentSize);
+		U32 popped = llmin(LLLockFree::load(&segment->mPopIndex), mSegmentSize);
+		count += pushed > popped ? pushed - popped : 0;
+	}
+	leave(generation);
+
+	return count;
+}
+
+
+template <typename ElementT>
+U32 LLLockFreeQueue<ElementT>::enter() const
+{
+	while (true)
+	{
+		U32 generation = LLLockFree::load(&mGeneration);
+		LLLockFree::fetchAdd(&mActiveThreads[generation & 1], 1);
+		// counted in the generation that is current, or not at all
+		if (LLLockFree::load(&mGeneration) == generation)
+		{
+			return generation;
+		}
+		LLLockFree::fetchAdd(&mActiveThreads[generation & 1], (U32) -1);
+	}
+}
+
+
+// Called between enter() and leave() with a segment that is no longer the
+// head or the tail, so threads entering from now on can't get to it.  The
+// threads that still can entered in its retired generation or before.
+//
+// The generation moves on from G to G + 1 once the counter of G - 1 is
+// down to zero, and nobody can enter in G - 1 any more, so while it is G
+// every thread from G - 2 or before has left.
+template <typename ElementT>
+void LLLockFreeQueue<ElementT>::retire(Segment* segment)
+{
+	segment->mRetiredGeneration = LLLockFree::load(&mGeneration);
+	Segment* retired;
+	do
+	{
+		retired = LLLockFree::load(&mRetired);
+		segment->mNextRetired = retired;
+	}
+	while (!LLLockFree::compareAndSwap(&mRetired, retired, segment));
+
+	U32 generation = LLLockFree::load(&mGeneration);
+	if (!LLLockFree::load(&mActiveThreads[(generation + 1) & 1]))
+	{
+		LLLockFree::compareAndSwap(&mGeneration, generation, generation + 1);
+	}
+	generation = LLLockFree::load(&mGeneration);
+
+	Segment* list = LLLockFree::exchange(&mRetired, (Segment*) NULL);
+	Segment* kept = NULL;
+	Segment* last_kept = NULL;
+	while (list)
+	{
+		Segment* next = list->mNextRetired;
+		if (generation - list->mRetiredGeneration >= 2)
+		{
+			delete list;
+		}
+		else
+		{
+			// someone may still be looking, it goes back for a later retire()
+			list->mNextRetired = kept;
+			kept = list;
+			if (!last_kept)
+			{
+				last_kept = list;
+			}
+		}
+		list = next;
+	}
+
+	if (kept)
+	{
+		do
+		{
+			retired = LLLockFree::load(&mRetired);
+			last_kept->mNextRetired = retired;
+		}
+		while (!LLLockFree::compareAndSwap(&mRetired, retired, kept));
+	}
+}
+
+
+#endif
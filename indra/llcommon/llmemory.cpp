@@ -44,6 +44,7 @@
 #include "llsys.h"
 #include "llframetimer.h"
 #include "lltrace.h"
+#include "llthreadlocalstorage.h"
 //----------------------------------------------------------------------------
 
 //static
@@ -61,6 +62,37 @@ BOOL LLMemory::sEnableMemoryFailurePrevention = FALSE;
 LLPrivateMemoryPoolManager::mem_allocation_info_t LLPrivateMemoryPoolManager::sMemAllocationTracker;
 #endif
 
+//----------------------------------------------------------------------------
+// LLHeapAllocationCounter
+//----------------------------------------------------------------------------
+
+LLHeapAllocationCounter::LLHeapAllocationCounter()
+:	mOuter(LLThreadLocalSingletonPointer<LLHeapAllocationCounter>::getInstance()),
+	mAllocations(0)
+{
+	LLThreadLocalSingletonPointer<LLHeapAllocationCounter>::setInstance(this);
+}
+
+LLHeapAllocationCounter::~LLHeapAllocationCounter()
+{
+	if (mOuter)
+	{
+		mOuter->mAllocations += mAllocations;
+	}
+	LLThreadLocalSingletonPointer<LLHeapAllocationCounter>::setInstance(mOuter);
+}
+
+//static
+void LLHeapAllocationCounter::countAllocation()
+{
+	// only the innermost counter is bumped, it passes its count on when it goes
+	LLHeapAllocationCounter* counter = LLThreadLocalSingletonPointer<LLHeapAllocationCounter>::getInstance();
+	if (counter)
+	{
+		++counter->mAllocations;
+	}
+}
+
 void ll_assert_aligned_func(uintptr_t ptr,U32 alignment)
 {
 #if defined(LL_WINDOWS) && defined(LL_DEBUG_BUFFER_OVERRUN)
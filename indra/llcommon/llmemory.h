@@ -58,6 +58,30 @@ class LLMutex ;
 
 LL_COMMON_API void ll_assert_aligned_func(uintptr_t ptr,U32 alignment);
 
+//
+// Counts the heap allocations the calling thread makes while it is live.
+// The ll_aligned_malloc functions below report to it, and so does the
+// viewer's global operator new, which covers the STL containers and
+// MemTrackable types.  Counters nest, an inner one's allocations are
+// counted by the outer one too.
+//
+class LL_COMMON_API LLHeapAllocationCounter
+{
+public:
+	LLHeapAllocationCounter();
+	~LLHeapAllocationCounter();
+
+	U32 getAllocations() const { return mAllocations; }
+
+	// called by the allocation hooks, a thread local load when no counter
+	// is live
+	static void countAllocation();
+
+private:
+	LLHeapAllocationCounter* mOuter;
+	U32 mAllocations;
+};
+
 #ifdef SHOW_ASSERT
 #define ll_assert_aligned(ptr,alignment) ll_assert_aligned_func(reinterpret_cast<uintptr_t>(ptr),((U32)alignment))
 #else
@@ -106,6 +130,7 @@ template <typename T> T* LL_NEXT_ALIGNED_ADDRESS_64(T* address)
 #else
 	inline void* ll_aligned_malloc_fallback( size_t size, int align )
 	{
+		LLHeapAllocationCounter::countAllocation();
 	#if defined(LL_WINDOWS)
 		return _aligned_malloc(size, align);
 	#else
@@ -136,6 +161,7 @@ template <typename T> T* LL_NEXT_ALIGNED_ADDRESS_64(T* address)
 #if !LL_USE_TCMALLOC
 inline void* ll_aligned_malloc_16(size_t size) // returned hunk MUST be freed with ll_aligned_free_16().
 {
+	LLHeapAllocationCounter::countAllocation();
 #if defined(LL_WINDOWS)
 	return _aligned_malloc(size, 16);
 #elif defined(LL_DARWIN)
@@ -192,10 +218,12 @@ inline void* ll_aligned_realloc_16(void* ptr, size_t size, size_t old_size) // r
 inline void* ll_aligned_malloc_32(size_t size) // returned hunk MUST be freed with ll_aligned_free_32().
 {
 #if defined(LL_WINDOWS)
+	LLHeapAllocationCounter::countAllocation();
 	return _aligned_malloc(size, 32);
 #elif defined(LL_DARWIN)
 	return ll_aligned_malloc_fallback( size, 32 );
 #else
+	LLHeapAllocationCounter::countAllocation();
 	void *rtn;
 	if (LL_LIKELY(0 == posix_memalign(&rtn, 32, size)))
 		return rtn;
@@ -221,6 +249,7 @@ LL_FORCE_INLINE void* ll_aligned_malloc(size_t size)
 {
 	if (LL_DEFAULT_HEAP_ALIGN % ALIGNMENT == 0)
 	{
+		LLHeapAllocationCounter::countAllocation();
 		return malloc(size);
 	}
 	else if (ALIGNMENT == 16)
@@ -29,16 +29,23 @@
 #include "llstl.h"
 #include "lltimer.h"	// ms_sleep()
 #include "lltracethreadrecorder.h"
+#include "llworkscheduler.h"
+
+// requests a scheduler worker runs before it lets other queues have a turn
+const S32 SCHEDULED_REQUESTS_PER_RUN = 8;
 
 //============================================================================
 
 // MAIN THREAD
-LLQueuedThread::LLQueuedThread(const std::string& name, bool threaded, bool should_pause) :
+LLQueuedThread::LLQueuedThread(const std::string& name, bool threaded, bool should_pause, S32 scheduler_workers) :
 	LLThread(name),
 	mThreaded(threaded),
 	mIdleThread(TRUE),
 	mNextHandle(0),
-	mStarted(FALSE)
+	mStarted(FALSE),
+	mScheduler(NULL),
+	mMaxScheduled(0),
+	mNumScheduled(0)
 {
 	if (mThreaded)
 	{
@@ -47,7 +54,17 @@ LLQueuedThread::LLQueuedThread(const std::string& name, bool threaded, bool shou
 			pause() ; //call this before start the thread.
 		}
 
-		start();
+		if (scheduler_workers > 0 && LLWorkScheduler::getInstance())
+		{
+			// no thread of our own, but running as far as isPaused() and addRequest() are concerned
+			mScheduler = LLWorkScheduler::getInstance();
+			mMaxScheduled = llmin(scheduler_workers, mScheduler->getNumWorkers());
+			mStatus = RUNNING;
+		}
+		else
+		{
+			start();
+		}
 	}
 }
 
@@ -59,6 +76,10 @@ LLQueuedThread::~LLQueuedThread()
 		endThread();
 	}
 	shutdown();
+	if (mScheduler)
+	{
+		endThread();
+	}
 	// ~LLThread() will be called here
 }
 
@@ -67,7 +88,30 @@ void LLQueuedThread::shutdown()
 	setQuitting();
 
 	unpause(); // MAIN THREAD
-	if (mThreaded)
+	if (mScheduler)
+	{
+		// a worker aborts whatever is still queued, wait until none has us
+		scheduleRequests();
+		S32 timeout = 100;
+		for ( ; timeout>0; timeout--)
+		{
+			lockData();
+			bool idle = (mNumScheduled == 0);
+			unlockData();
+			if (idle)
+			{
+				break;
+			}
+			ms_sleep(100);
+			LLThread::yield();
+		}
+		if (timeout == 0)
+		{
+			LL_WARNS() << "~LLQueuedThread (" << mName << ") timed out!" << LL_ENDL;
+		}
+		mStatus = STOPPED;
+	}
+	else if (mThreaded)
 	{
 		S32 timeout = 100;
 		for ( ; timeout>0; timeout--)
@@ -114,7 +158,7 @@ S32 LLQueuedThread::update(F32 max_time_ms)
 {
 	if (!mStarted)
 	{
-		if (!mThreaded)
+		if (!mThreaded || mScheduler)
 		{
 			startThread();
 			mStarted = TRUE;
@@ -135,8 +179,13 @@ S32 LLQueuedThread::updateQueue(F32 max_time_ms)
 		pending = getPending();
 		if(pending > 0)
 		{
-		unpause();
-	}
+			unpause();
+			if (mScheduler)
+			{
+				// queues paused while scheduled aren't anymore
+				scheduleRequests();
+			}
+		}
 	}
 	else
 	{
@@ -155,13 +204,41 @@ void LLQueuedThread::incQueue()
 	// Something has been added to the queue
 	if (!isPaused())
 	{
-		if (mThreaded)
+		if (mScheduler)
+		{
+			scheduleRequests();
+		}
+		else if (mThreaded)
 		{
 			wake(); // Wake the thread up if necessary.
 		}
 	}
 }
 
+// Queues this in the scheduler once per queued request, as far as mMaxScheduled allows
+void LLQueuedThread::scheduleRequests()
+{
+	S32 num_new = 0;
+	U32 priority = 0;
+	lockData();
+	if (!isStopped() && !mRequestQueue.empty())
+	{
+		num_new = llmin(mMaxScheduled - mNumScheduled, (S32) mRequestQueue.size());
+		priority = (*mRequestQueue.begin())->getPriority();
+	}
+	if (num_new > 0)
+	{
+		mNumScheduled += num_new;
+		mIdleThread = FALSE;
+	}
+	unlockData();
+
+	for (S32 i = 0; i < num_new; ++i)
+	{
+		mScheduler->schedule(this, LLWorkScheduler::getLane(priority));
+	}
+}
+
 //virtual
 // May be called from any thread
 S32 LLQueuedThread::getPending()
@@ -464,7 +541,7 @@ S32 LLQueuedThread::processNextRequest()
 			req->setStatus(STATUS_QUEUED);
 			mRequestQueue.insert(req);
 			unlockData();
-			if (mThreaded && start_priority < PRIORITY_NORMAL)
+			if (mThreaded && !mScheduler && start_priority < PRIORITY_NORMAL)
 			{
 				ms_sleep(1); // sleep the thread a little
 			}
@@ -477,6 +554,39 @@ S32 LLQueuedThread::processNextRequest()
 	return pending;
 }
 
+// Runs on a SCHEDULER WORKER
+S32 LLQueuedThread::runScheduled()
+{
+	// paused queues are dropped, update() schedules them again once unpaused
+	if (!isPaused())
+	{
+		if (!isQuitting())
+		{
+			threadedUpdate();
+		}
+		for (S32 i = 0; i < SCHEDULED_REQUESTS_PER_RUN; ++i)
+		{
+			if (!processNextRequest())
+			{
+				break;
+			}
+		}
+	}
+
+	S32 lane = -1;
+	lockData();
+	if (!mRequestQueue.empty() && !isPaused())
+	{
+		lane = LLWorkScheduler::getLane((*mRequestQueue.begin())->getPriority());
+	}
+	else if (--mNumScheduled == 0)
+	{
+		mIdleThread = TRUE;
+	}
+	unlockData();
+	return lane;
+}
+
 // virtual
 bool LLQueuedThread::runCondition()
 {
@@ -37,9 +37,19 @@
 #include "llthread.h"
 #include "llsimplehash.h"
 
+class LLWorkScheduler;
+
 //============================================================================
 // Note: ~LLQueuedThread is O(N) N=# of queued threads, assumed to be small
 //   It is assumed that LLQueuedThreads are rarely created/destroyed.
+//
+// A threaded queue normally runs its requests on a thread of its own.  If it
+// is created with scheduler_workers and LLWorkScheduler::initClass() has been
+// called, it starts no thread and up to that many of the shared scheduler's
+// workers run its requests instead.  Subclasses whose requests may run
+// concurrently can allow more than one.  threadedUpdate() is then called
+// by whichever worker runs the queue, startThread() and endThread() on the
+// main thread, as for unthreaded queues.
 
 class LL_COMMON_API LLQueuedThread : public LLThread
 {
@@ -149,9 +159,13 @@ public:
 	static handle_t nullHandle() { return handle_t(0); }
 	
 public:
-	LLQueuedThread(const std::string& name, bool threaded = true, bool should_pause = false);
+	LLQueuedThread(const std::string& name, bool threaded = true, bool should_pause = false, S32 scheduler_workers = 0);
 	virtual ~LLQueuedThread();	
 	virtual void shutdown();
+
+	// Called by LLWorkScheduler workers, runs a few requests.  Returns the
+	// lane to queue this in again, or -1 if it has nothing more to do.
+	S32 runScheduled();
 	
 private:
 	// No copy constructor or copy assignment
@@ -169,6 +183,7 @@ protected:
 	bool addRequest(QueuedRequest* req);
 	S32  processNextRequest(void);
 	void incQueue();
+	void scheduleRequests();
 
 public:
 	bool waitForResult(handle_t handle, bool auto_complete = true);
@@ -199,6 +214,10 @@ protected:
 	BOOL mThreaded;  // if false, run on main thread and do updates during update()
 	BOOL mStarted;  // required when mThreaded is false to call startThread() from update()
 	LLAtomic32<BOOL> mIdleThread; // request queue is empty (or we are quitting) and the thread is idle
+
+	LLWorkScheduler* mScheduler;	// NULL when running on a thread of its own
+	S32 mMaxScheduled;				// times this may be queued in the scheduler or run by its workers
+	S32 mNumScheduled;				// protected by mDataLock
 	
 	typedef std::set<QueuedRequest*, queued_request_less> request_queue_t;
 	request_queue_t mRequestQueue;
@@ -29,6 +29,7 @@
 #include "linden_common.h"
 #include "llsdserialize.h"
 #include "llpointer.h"
+#include "llmemorystream.h"
 #include "llstreamtools.h" // for fullread
 
 #include <iostream>
@@ -1211,6 +1212,368 @@ bool LLSDBinaryParser::parseString(
 }
 
 
+/**
+ * LLSDBinaryView
+ */
+LLSDBinaryView::LLSDBinaryView()
+:	mValue(NULL),
+	mEnd(NULL),
+	mKey(NULL),
+	mInMap(false)
+{
+}
+
+LLSDBinaryView::LLSDBinaryView(const U8* data, S32 size)
+:	mValue(NULL),
+	mEnd(NULL),
+	mKey(NULL),
+	mInMap(false)
+{
+	if (!data || size <= 0)
+	{
+		return;
+	}
+
+	static const char deprecated_header[] = "<? LLSD/Binary ?>";
+	const S32 header_size = sizeof(deprecated_header)-1;
+	if (size > header_size && !memcmp(data, deprecated_header, header_size))
+	{ //header is followed by a newline
+		data += header_size+1;
+		size -= header_size+1;
+	}
+
+	mEnd = data+size;
+	if (skipValue(data))
+	{
+		mValue = data;
+	}
+}
+
+LLSDBinaryView::LLSDBinaryView(const U8* value, const U8* end, const U8* key, bool in_map)
+:	mValue(value),
+	mEnd(end),
+	mKey(key),
+	mInMap(in_map)
+{
+}
+
+bool LLSDBinaryView::readU32(const U8* p, U32& value) const
+{
+	if (!p || mEnd-p < (S32) sizeof(U32))
+	{
+		return false;
+	}
+
+	U32 value_nbo;
+	memcpy(&value_nbo, p, sizeof(U32));		 /*Flawfinder: ignore*/
+	value = ntohl(value_nbo);
+	return true;
+}
+
+// Returns the first byte past the value serialized at p, NULL if the value
+// is malformed or runs past the end of the buffer.
+const U8* LLSDBinaryView::skipValue(const U8* p) const
+{
+	if (!p || p >= mEnd)
+	{
+		return NULL;
+	}
+
+	U32 size = 0;
+	const U8* next = NULL;
+
+	switch (*p)
+	{
+	case '!':
+	case '0':
+	case '1':
+		next = p+1;
+		break;
+	case 'i':
+		next = p+1+sizeof(U32);
+		break;
+	case 'r':
+	case 'd':
+		next = p+1+sizeof(F64);
+		break;
+	case 'u':
+		next = p+1+UUID_BYTES;
+		break;
+	case 's':
+	case 'l':
+	case 'b':
+		if (!readU32(p+1, size))
+		{
+			return NULL;
+		}
+		next = p+1+sizeof(U32)+size;
+		break;
+	case '{':
+		if (!readU32(p+1, size))
+		{
+			return NULL;
+		}
+		next = p+1+sizeof(U32);
+		for (U32 i = 0; i < size; ++i)
+		{
+			U32 key_size = 0;
+			if (next >= mEnd || *next != 'k' || !readU32(next+1, key_size))
+			{ //only length prefixed keys are supported
+				return NULL;
+			}
+			next = skipValue(next+1+sizeof(U32)+key_size);
+			if (!next)
+			{
+				return NULL;
+			}
+		}
+		if (next >= mEnd || *next != '}')
+		{
+			return NULL;
+		}
+		++next;
+		break;
+	case '[':
+		if (!readU32(p+1, size))
+		{
+			return NULL;
+		}
+		next = p+1+sizeof(U32);
+		for (U32 i = 0; i < size; ++i)
+		{
+			next = skipValue(next);
+			if (!next)
+			{
+				return NULL;
+			}
+		}
+		if (next >= mEnd || *next != ']')
+		{
+			return NULL;
+		}
+		++next;
+		break;
+	default:
+		return NULL;
+	}
+
+	return (next > mEnd || next < p) ? NULL : next;
+}
+
+bool LLSDBinaryView::isDefined() const
+{
+	return mValue && *mValue != '!';
+}
+
+bool LLSDBinaryView::isMap() const
+{
+	return mValue && *mValue == '{';
+}
+
+bool LLSDBinaryView::isArray() const
+{
+	return mValue && *mValue == '[';
+}
+
+bool LLSDBinaryView::isBinary() const
+{
+	return mValue && *mValue == 'b';
+}
+
+S32 LLSDBinaryView::size() const
+{
+	U32 size = 0;
+	if (mValue)
+	{
+		switch (*mValue)
+		{
+		case '{':
+		case '[':
+		case 's':
+		case 'l':
+		case 'b':
+			readU32(mValue+1, size);
+			break;
+		default:
+			break;
+		}
+	}
+	return (S32) size;
+}
+
+LLSDBinaryView LLSDBinaryView::first() const
+{
+	if (!isMap() && !isArray())
+	{
+		return LLSDBinaryView();
+	}
+
+	const U8* p = mValue+1+sizeof(U32);
+	if (p >= mEnd || *p == '}' || *p == ']')
+	{ //empty container
+		return LLSDBinaryView();
+	}
+
+	if (isMap())
+	{
+		U32 key_size = 0;
+		readU32(p+1, key_size);
+		return LLSDBinaryView(p+1+sizeof(U32)+key_size, mEnd, p, true);
+	}
+	return LLSDBinaryView(p, mEnd, NULL, false);
+}
+
+LLSDBinaryView LLSDBinaryView::next() const
+{
+	const U8* p = skipValue(mValue);
+	if (!p || p >= mEnd || *p == '}' || *p == ']')
+	{
+		return LLSDBinaryView();
+	}
+
+	if (mInMap)
+	{
+		U32 key_size = 0;
+		if (*p != 'k' || !readU32(p+1, key_size))
+		{
+			return LLSDBinaryView();
+		}
+		return LLSDBinaryView(p+1+sizeof(U32)+key_size, mEnd, p, true);
+	}
+	return LLSDBinaryView(p, mEnd, NULL, false);
+}
+
+std::string LLSDBinaryView::key() const
+{
+	U32 key_size = 0;
+	if (!mKey || !readU32(mKey+1, key_size))
+	{
+		return LLStringUtil::null;
+	}
+	return std::string((const char*) mKey+1+sizeof(U32), key_size);
+}
+
+bool LLSDBinaryView::has(const std::string& key) const
+{
+	return get(key).mValue != NULL;
+}
+
+LLSDBinaryView LLSDBinaryView::get(const std::string& key) const
+{
+	if (!isMap())
+	{
+		return LLSDBinaryView();
+	}
+
+	for (LLSDBinaryView child = first(); child.mValue; child = child.next())
+	{
+		U32 key_size = 0;
+		readU32(child.mKey+1, key_size);
+		if (key_size == key.size() && !memcmp(child.mKey+1+sizeof(U32), key.data(), key_size))
+		{
+			return child;
+		}
+	}
+	return LLSDBinaryView();
+}
+
+LLSDBinaryView LLSDBinaryView::get(S32 index) const
+{
+	if (!isArray() || index < 0)
+	{
+		return LLSDBinaryView();
+	}
+
+	LLSDBinaryView child = first();
+	for (S32 i = 0; i < index && child.mValue; ++i)
+	{
+		child = child.next();
+	}
+	return child;
+}
+
+LLSD::Boolean LLSDBinaryView::asBoolean() const
+{
+	if (!mValue)
+	{
+		return false;
+	}
+
+	switch (*mValue)
+	{
+	case '1':
+		return true;
+	case 'i':
+		return asInteger() != 0;
+	case 'r':
+		return asReal() != 0.0;
+	default:
+		return false;
+	}
+}
+
+LLSD::Integer LLSDBinaryView::asInteger() const
+{
+	if (!mValue)
+	{
+		return 0;
+	}
+
+	switch (*mValue)
+	{
+	case '1':
+		return 1;
+	case 'i':
+	{
+		U32 value = 0;
+		readU32(mValue+1, value);
+		return (S32) value;
+	}
+	case 'r':
+		return (S32) asReal();
+	default:
+		return 0;
+	}
+}
+
+LLSD::Real LLSDBinaryView::asReal() const
+{
+	if (!mValue)
+	{
+		return 0.0;
+	}
+
+	switch (*mValue)
+	{
+	case '1':
+		return 1.0;
+	case 'i':
+		return (F64) asInteger();
+	case 'r':
+	{
+		F64 real_nbo;
+		memcpy(&real_nbo, mValue+1, sizeof(F64));		 /*Flawfinder: ignore*/
+		return ll_ntohd(real_nbo);
+	}
+	default:
+		return 0.0;
+	}
+}
+
+LLSD::String LLSDBinaryView::asString() const
+{
+	if (mValue && (*mValue == 's' || *mValue == 'l'))
+	{
+		return std::string((const char*) mValue+1+sizeof(U32), size());
+	}
+	return LLStringUtil::null;
+}
+
+const U8* LLSDBinaryView::binaryData() const
+{
+	return (isBinary() && size() > 0) ? mValue+1+sizeof(U32) : NULL;
+}
+
 /**
  * LLSDFormatter
  */
@@ -2126,36 +2489,92 @@ std::string zip_llsd(LLSD& data)
 // and deserializes from that copy using LLSDSerialize
 bool unzip_llsd(LLSD& data, std::istream& is, S32 size)
 {
-	U8* result = NULL;
-	U32 cur_size = 0;
-	z_stream strm;
-		
-	const U32 CHUNK = 65536;
+	if (size <= 0)
+	{
+		LL_WARNS() << "Unzip error: empty block" << LL_ENDL;
+		return false;
+	}
 
-	U8 *in = new U8[size];
-	is.read((char*) in, size); 
+	std::vector<U8> in(size);
+	is.read((char*) &in[0], size); 
 
-	U8 out[CHUNK];
+	std::vector<U8> result;
+	if (!unzip_llsd_bytes(result, &in[0], size))
+	{
+		return false;
+	}
+
+	//result now holds the decompressed LLSD block
+	{
+		S32 cur_size = result.size();
+		S32 offset = 0;
+
+		std::string deprecated_header("<? LLSD/Binary ?>");
+
+		if (cur_size > deprecated_header.size() &&
+			!memcmp(&result[0], deprecated_header.data(), deprecated_header.size()))
+		{
+			offset = deprecated_header.size()+1;
+		}
+		cur_size -= offset;
+
+		LLMemoryStream istr(&result[0]+offset, cur_size);
 		
+		if (!LLSDSerialize::fromBinary(data, istr, cur_size))
+		{
+			LL_WARNS() << "Failed to unzip LLSD block" << LL_ENDL;
+			return false;
+		}		
+	}
+
+	return true;
+}
+
+//inflate a zip_llsd block directly from memory, leaving the serialized LLSD in data
+bool unzip_llsd_bytes(std::vector<U8>& data, const U8* in, S32 size)
+{
+	data.clear();
+
+	if (!in || size <= 0)
+	{
+		LL_WARNS() << "Unzip error: empty block" << LL_ENDL;
+		return false;
+	}
+
+	z_stream strm;
 	strm.zalloc = Z_NULL;
 	strm.zfree = Z_NULL;
 	strm.opaque = Z_NULL;
 	strm.avail_in = size;
-	strm.next_in = in;
+	strm.next_in = const_cast<U8*>(in);
 
 	S32 ret = inflateInit(&strm);
-	
+	if (ret != Z_OK)
+	{
+		LL_WARNS() << "Unzip error: " << ret << LL_ENDL;
+		return false;
+	}
+
+	//LLSD blocks usually inflate to several times their compressed size
+	const U32 CHUNK = 65536;
+	data.resize(llmax((U32) size*4, CHUNK));
+	U32 cur_size = 0;
+
 	do
 	{
-		strm.avail_out = CHUNK;
-		strm.next_out = out;
+		if (cur_size == data.size())
+		{
+			data.resize(data.size()*2);
+		}
+
+		strm.avail_out = data.size()-cur_size;
+		strm.next_out = &data[cur_size];
 		ret = inflate(&strm, Z_NO_FLUSH);
 		if (ret == Z_STREAM_ERROR)
 		{
-			llwarns << "Unzip error: Z_STREAM_ERROR" << llendl;
+			LL_WARNS() << "Unzip error: Z_STREAM_ERROR" << LL_ENDL;
 			inflateEnd(&strm);
-			free(result);
-			delete [] in;
+			data.clear();
 			return false;
 		}
 		
@@ -2165,57 +2584,30 @@ bool unzip_llsd(LLSD& data, std::istream& is, S32 size)
 			ret = Z_DATA_ERROR;
 		case Z_DATA_ERROR:
 		case Z_MEM_ERROR:
-			llwarns << "Unzip error: " << ret << llendl;
+			LL_WARNS() << "Unzip error: " << ret << LL_ENDL;
 			inflateEnd(&strm);
-			free(result);
-			delete [] in;
+			data.clear();
 			return false;
 			break;
 		}
 
-		U32 have = CHUNK-strm.avail_out;
-
-		result = (U8*) realloc(result, cur_size + have);
-		memcpy(result+cur_size, out, have);
-		cur_size += have;
+		cur_size = data.size()-strm.avail_out;
 
 	} while (ret == Z_OK);
 
 	inflateEnd(&strm);
-	delete [] in;
 
 	if (ret != Z_STREAM_END)
 	{
-		llwarns << "Unzip error: !Z_STREAM_END" << llendl;
-		free(result);
+		LL_WARNS() << "Unzip error: !Z_STREAM_END" << LL_ENDL;
+		data.clear();
 		return false;
 	}
 
-	//result now points to the decompressed LLSD block
-	{
-		std::string res_str((char*) result, cur_size);
-
-		std::string deprecated_header("<? LLSD/Binary ?>");
-
-		if (res_str.substr(0, deprecated_header.size()) == deprecated_header)
-		{
-			res_str = res_str.substr(deprecated_header.size()+1, cur_size);
-		}
-		cur_size = res_str.size();
-
-		std::istringstream istr(res_str);
-		
-		if (!LLSDSerialize::fromBinary(data, istr, cur_size))
-		{
-			LL_WARNS() << "Failed to unzip LLSD block" << LL_ENDL;
-			free(result);
-			return false;
-		}		
-	}
-
-	free(result);
+	data.resize(cur_size);
 	return true;
 }
+
 //This unzip function will only work with a gzip header and trailer - while the contents
 //of the actual compressed data is the same for either format (gzip vs zlib ), the headers
 //and trailers are different for the formats.
@@ -814,8 +814,75 @@ public:
 	}
 };
 
+/** 
+ * @class LLSDBinaryView
+ * @brief Read-only view of a binary serialized LLSD value held in memory.
+ *
+ * The serialized form is walked in place rather than deserialized into an
+ * LLSD tree, so large binary members can be consumed without copying.
+ * The memory is NOT owned by a view. The caller must keep it valid for as
+ * long as the view, and any view obtained from it, is in use. A view of
+ * missing or malformed data is undefined.
+ */
+class LL_COMMON_API LLSDBinaryView
+{
+public:
+	LLSDBinaryView();
+
+	// View the value serialized at data, skipping an optional
+	// "<? LLSD/Binary ?>" header.
+	LLSDBinaryView(const U8* data, S32 size);
+
+	bool isDefined() const;
+	bool isMap() const;
+	bool isArray() const;
+	bool isBinary() const;
+
+	// Element count of a map or array, byte count of binary or string data.
+	S32 size() const;
+
+	// Map lookup, returns an undefined view when the key is missing.
+	bool has(const std::string& key) const;
+	LLSDBinaryView get(const std::string& key) const;
+	LLSDBinaryView operator[](const std::string& key) const { return get(key); }
+	LLSDBinaryView operator[](const char* key) const { return get(key); }
+
+	// Array lookup, returns an undefined view when out of range.
+	LLSDBinaryView get(S32 index) const;
+	LLSDBinaryView operator[](S32 index) const { return get(index); }
+
+	// Sequential access to the elements of a map or array.  next() returns
+	// an undefined view after the last element.
+	LLSDBinaryView first() const;
+	LLSDBinaryView next() const;
+	// Key of a map element.
+	std::string key() const;
+
+	LLSD::Boolean asBoolean() const;
+	LLSD::Integer asInteger() const;
+	LLSD::Real asReal() const;
+	LLSD::String asString() const;
+
+	// Pointer into the viewed memory, NULL unless this is non-empty binary.
+	// No alignment is guaranteed.
+	const U8* binaryData() const;
+
+private:
+	LLSDBinaryView(const U8* value, const U8* end, const U8* key, bool in_map);
+
+	const U8* skipValue(const U8* p) const;
+	bool readU32(const U8* p, U32& value) const;
+
+	const U8* mValue;	// type marker of the viewed value
+	const U8* mEnd;		// end of the serialized buffer
+	const U8* mKey;		// key marker when this is a map element
+	bool mInMap;
+};
+
 //dirty little zip functions -- yell at davep
 LL_COMMON_API std::string zip_llsd(LLSD& data);
 LL_COMMON_API bool unzip_llsd(LLSD& data, std::istream& is, S32 size);
+// inflate a zip_llsd block into its serialized bytes without deserializing it
+LL_COMMON_API bool unzip_llsd_bytes(std::vector<U8>& data, const U8* in, S32 size);
 LL_COMMON_API U8* unzip_llsdNavMesh( bool& valid, unsigned int& outsize,std::istream& is, S32 size);
 #endif // LL_LLSDSERIALIZE_H
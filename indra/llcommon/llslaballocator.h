@@ -0,0 +1,299 @@
+/**
+ * @file llslaballocator.h
+ * @brief Fixed size blocks carved from slabs, cached per thread.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSLABALLOCATOR_H
+#define LL_LLSLABALLOCATOR_H
+
+#include "llmemory.h"
+#include "lllockfreequeue.h"
+#include "llthreadlocalstorage.h"
+#include "lltimer.h"
+
+#include <boost/noncopyable.hpp>
+
+//
+// A pool of BLOCK_SIZE blocks for the objects created and destroyed by the
+// thousand every frame, faces, draw infos, particles, octree triangles.
+//
+// Blocks come from 64KB slabs and go back to a free list instead of the
+// heap.  Each thread keeps up to 2 * BATCH_BLOCKS free blocks of its own,
+// so allocate() and freeMem() only touch the shared lists, under a spin lock,
+// once every BATCH_BLOCKS calls, and then only to move a whole batch.  A
+// block may be freed by another thread than the one that allocated it.
+//
+// There is one pool per block size and alignment, which lives as long as
+// the process: slabs are never given back, since objects may still be
+// deleted by static destructors.  A thread that exits keeps the blocks of
+// its cache, at most 2 * BATCH_BLOCKS of them.
+//
+// See LLSlabAllocated below to opt a class in.
+//
+template <size_t BLOCK_SIZE, size_t ALIGNMENT = LL_DEFAULT_HEAP_ALIGN>
+class LLSlabPool : private boost::noncopyable
+{
+public:
+	enum
+	{
+		// room for the two free list links, then rounded to the alignment
+		BLOCK_STRIDE = ((BLOCK_SIZE > 2 * sizeof(void*) ? BLOCK_SIZE : 2 * sizeof(void*)) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT,
+		BATCH_BLOCKS = 32,
+		SLAB_BATCHES = (65536 / (BLOCK_STRIDE * BATCH_BLOCKS)) > 0 ? (65536 / (BLOCK_STRIDE * BATCH_BLOCKS)) : 1,
+		SLAB_BYTES = SLAB_BATCHES * BATCH_BLOCKS * BLOCK_STRIDE
+	};
+
+	static LLSlabPool& instance();
+
+	void* allocate();
+	void freeMem(void* block);
+
+	// only snapshots while other threads allocate
+	U32 getSlabCount() const { return LLLockFree::load(&mSlabCount); }
+	size_t getSlabBytes() const { return (size_t) getSlabCount() * SLAB_BYTES; }
+
+private:
+	LLSlabPool();
+
+	// a free block, the first of a batch also links the next batch
+	struct Block
+	{
+		Block* mNext;
+		Block* mNextBatch;
+	};
+
+	struct ThreadCache
+	{
+		Block* mHead;
+		U32 mCount;
+	};
+
+	static ThreadCache& getThreadCache();
+	void lock();
+	void unlock() { LLLockFree::store(&mLock, (U32) 0); }
+
+	Block* mBatches;
+	char* mSlabPosition;
+	char* mSlabEnd;
+	volatile U32 mSlabCount;
+	volatile U32 mLock;
+
+	static LLSlabPool* volatile sInstance;
+};
+
+template <size_t BLOCK_SIZE, size_t ALIGNMENT>
+LLSlabPool<BLOCK_SIZE, ALIGNMENT>* volatile LLSlabPool<BLOCK_SIZE, ALIGNMENT>::sInstance = NULL;
+
+template <size_t BLOCK_SIZE, size_t ALIGNMENT>
+LLSlabPool<BLOCK_SIZE, ALIGNMENT>::LLSlabPool()
+:	mBatches(NULL),
+	mSlabPosition(NULL),
+	mSlabEnd(NULL),
+	mSlabCount(0),
+	mLock(0)
+{
+}
+
+// no function static, the first objects may be created from two threads
+// at once
+//static
+template <size_t BLOCK_SIZE, size_t ALIGNMENT>
+LLSlabPool<BLOCK_SIZE, ALIGNMENT>& LLSlabPool<BLOCK_SIZE, ALIGNMENT>::instance()
+{
+	LLSlabPool* pool = LLLockFree::load(&sInstance);
+	if (!pool)
+	{
+		pool = new LLSlabPool;
+		if (!LLLockFree::compareAndSwap(&sInstance, (LLSlabPool*) NULL, pool))
+		{
+			delete pool;
+			pool = LLLockFree::load(&sInstance);
+		}
+	}
+	return *pool;
+}
+
+//static
+template <size_t BLOCK_SIZE, size_t ALIGNMENT>
+typename LLSlabPool<BLOCK_SIZE, ALIGNMENT>::ThreadCache& LLSlabPool<BLOCK_SIZE, ALIGNMENT>::getThreadCache()
+{
+	ThreadCache* cache = LLThreadLocalSingletonPointer<ThreadCache>::getInstance();
+	if (!cache)
+	{
+		cache = new ThreadCache;
+		cache->mHead = NULL;
+		cache->mCount = 0;
+		LLThreadLocalSingletonPointer<ThreadCache>::setInstance(cache);
+	}
+	return *cache;
+}
+
+template <size_t BLOCK_SIZE, size_t ALIGNMENT>
+void LLSlabPool<BLOCK_SIZE, ALIGNMENT>::lock()
+{
+	// held for a few pointer moves, hardly ever contended
+	while (!LLLockFree::compareAndSwap(&mLock, 0, 1))
+	{
+		ms_sleep(0);
+	}
+}
+
+template <size_t BLOCK_SIZE, size_t ALIGNMENT>
+void* LLSlabPool<BLOCK_SIZE, ALIGNMENT>::allocate()
+{
+	ThreadCache& cache = getThreadCache();
+	if (!cache.mHead)
+	{
+		char* carved = NULL;
+		lock();
+		Block* batch = mBatches;
+		if (batch)
+		{
+			mBatches = batch->mNextBatch;
+		}
+		else
+		{
+			if (mSlabPosition == mSlabEnd)
+			{
+				mSlabPosition = (char*) ll_aligned_malloc<ALIGNMENT>(SLAB_BYTES);
+				if (!mSlabPosition)
+				{
+					unlock();
+					LL_ERRS() << "Out of memory for a slab of " << (U32) BLOCK_SIZE << " byte blocks" << LL_ENDL;
+					return NULL;
+				}
+				mSlabEnd = mSlabPosition + SLAB_BYTES;
+				LLLockFree::store(&mSlabCount, mSlabCount + 1);
+			}
+			carved = mSlabPosition;
+			mSlabPosition += BATCH_BLOCKS * BLOCK_STRIDE;
+		}
+		unlock();
+
+		if (carved)
+		{
+			// linked outside the lock, nobody else has these yet
+			batch = (Block*) carved;
+			for (U32 i = 0; i < BATCH_BLOCKS - 1; ++i)
+			{
+				((Block*) (carved + i * BLOCK_STRIDE))->mNext = (Block*) (carved + (i + 1) * BLOCK_STRIDE);
+			}
+			((Block*) (carved + (BATCH_BLOCKS - 1) * BLOCK_STRIDE))->mNext = NULL;
+		}
+		cache.mHead = batch;
+		cache.mCount = BATCH_BLOCKS;
+	}
+
+	Block* block = cache.mHead;
+	cache.mHead = block->mNext;
+	--cache.mCount;
+	return block;
+}
+
+template <size_t BLOCK_SIZE, size_t ALIGNMENT>
+void LLSlabPool<BLOCK_SIZE, ALIGNMENT>::freeMem(void* ptr)
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	ThreadCache& cache = getThreadCache();
+	Block* block = (Block*) ptr;
+	block->mNext = cache.mHead;
+	cache.mHead = block;
+	if (++cache.mCount < 2 * BATCH_BLOCKS)
+	{
+		return;
+	}
+
+	// the most recently freed half stays, it is the warmest in the caches
+	Block* last = block;
+	for (U32 i = 1; i < BATCH_BLOCKS; ++i)
+	{
+		last = last->mNext;
+	}
+	Block* batch = last->mNext;
+	last->mNext = NULL;
+	cache.mCount = BATCH_BLOCKS;
+
+	lock();
+	batch->mNextBatch = mBatches;
+	mBatches = batch;
+	unlock();
+}
+
+
+//
+// Opts a class in, for classes that are not LLTrace::MemTrackable:
+//
+//   class LLFoo : public LLSlabAllocated<LLFoo, 16>
+//
+// LLTrace::MemTrackable classes call slab_new() and slab_delete() from
+// their own operator new and delete instead, so the blocks still count
+// towards their MemStatHandle.
+//
+// Only objects of exactly sizeof(T) come from the pool, a derived class
+// that adds members gets the heap as before.  Deleting through a base
+// class pointer then needs a virtual destructor, for the size to be right.
+//
+template <typename T, size_t ALIGNMENT>
+inline void* ll_slab_allocate(size_t size)
+{
+	if (size != sizeof(T))
+	{
+		return ll_aligned_malloc<ALIGNMENT>(size);
+	}
+	return LLSlabPool<sizeof(T), ALIGNMENT>::instance().allocate();
+}
+
+template <typename T, size_t ALIGNMENT>
+inline void ll_slab_free(void* ptr, size_t size)
+{
+	if (size != sizeof(T))
+	{
+		ll_aligned_free<ALIGNMENT>(ptr);
+	}
+	else
+	{
+		LLSlabPool<sizeof(T), ALIGNMENT>::instance().freeMem(ptr);
+	}
+}
+
+template <typename T, size_t ALIGNMENT = LL_DEFAULT_HEAP_ALIGN>
+class LLSlabAllocated
+{
+public:
+	void* operator new(size_t size)
+	{
+		return ll_slab_allocate<T, ALIGNMENT>(size);
+	}
+
+	void operator delete(void* ptr, size_t size)
+	{
+		ll_slab_free<T, ALIGNMENT>(ptr, size);
+	}
+};
+
+#endif // LL_LLSLABALLOCATOR_H
@@ -0,0 +1,230 @@
+/**
+ * @file llstringpool.cpp
+ * @brief Interned strings behind stable 32 bit handles.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llstringpool.h"
+
+#include "lltimer.h"
+
+static const U32 MIN_INDEX_SLOTS = 64;
+
+LLStringPool::LLStringPool()
+:	mIndex(NULL),
+	mCount(0),
+	mInterning(0),
+	mChunkPosition(NULL),
+	mChunkEnd(NULL),
+	mChunkBytes(0),
+	mIndexBytes(0)
+{
+	for (U32 i = 0; i < MAX_SEGMENTS; ++i)
+	{
+		mSegments[i] = NULL;
+	}
+}
+
+LLStringPool::~LLStringPool()
+{
+	for (U32 i = 0; i < MAX_SEGMENTS; ++i)
+	{
+		delete[] mSegments[i];
+	}
+	free(mIndex);
+	for (std::vector<Index*>::iterator it = mRetiredIndices.begin(); it != mRetiredIndices.end(); ++it)
+	{
+		free(*it);
+	}
+	for (std::vector<char*>::iterator it = mChunks.begin(); it != mChunks.end(); ++it)
+	{
+		delete[] *it;
+	}
+}
+
+// FNV-1a
+//static
+U32 LLStringPool::hashString(const char* str, U32 length)
+{
+	U32 hash = 2166136261u;
+	for (U32 i = 0; i < length; ++i)
+	{
+		hash = (hash ^ (U8) str[i]) * 16777619u;
+	}
+	return hash;
+}
+
+//static
+LLStringPool::Index* LLStringPool::allocateIndex(U32 slots)
+{
+	Index* index = (Index*) calloc(1, sizeof(Index) + (slots - 1) * sizeof(handle_t));
+	if (!index)
+	{
+		LL_ERRS() << "Out of memory for a string pool index of " << slots << " slots" << LL_ENDL;
+	}
+	index->mMask = slots - 1;
+	return index;
+}
+
+LLStringPool::handle_t LLStringPool::findInIndex(const Index* index, const char* str, U32 length, U32 hash) const
+{
+	for (U32 slot = hash & index->mMask; ; slot = (slot + 1) & index->mMask)
+	{
+		handle_t handle = LLLockFree::load(&index->mHandles[slot]);
+		if (!handle)
+		{
+			return 0;
+		}
+		const Entry& entry = getEntry(handle);
+		if (entry.mHash == hash && entry.mLength == length && !memcmp(entry.mString, str, length))
+		{
+			return handle;
+		}
+	}
+}
+
+void LLStringPool::addToIndex(Index* index, handle_t handle, U32 hash)
+{
+	U32 slot = hash & index->mMask;
+	while (index->mHandles[slot])
+	{
+		slot = (slot + 1) & index->mMask;
+	}
+	// releases the entry to the readers that find the handle
+	LLLockFree::store(&index->mHandles[slot], handle);
+}
+
+LLStringPool::Entry& LLStringPool::addEntry(handle_t handle)
+{
+	U32 position = handle - 1 + (1 << FIRST_SEGMENT_BITS);
+	U32 segment = 0;
+	while (position >> (segment + FIRST_SEGMENT_BITS + 1))
+	{
+		++segment;
+	}
+	Entry* entries = mSegments[segment];
+	if (!entries)
+	{
+		entries = new Entry[1 << (segment + FIRST_SEGMENT_BITS)];
+		LLLockFree::store(&mSegments[segment], entries);
+	}
+	return entries[position - (1 << (segment + FIRST_SEGMENT_BITS))];
+}
+
+char* LLStringPool::copyString(const char* str, U32 length)
+{
+	if ((size_t) (mChunkEnd - mChunkPosition) < (size_t) length + 1)
+	{
+		// what is left of the current chunk is given up
+		size_t chunk_size = llmax((size_t) CHUNK_SIZE, (size_t) length + 1);
+		mChunkPosition = new char[chunk_size];
+		mChunkEnd = mChunkPosition + chunk_size;
+		mChunks.push_back(mChunkPosition);
+		mChunkBytes += chunk_size;
+	}
+	char* copy = mChunkPosition;
+	memcpy(copy, str, length);
+	copy[length] = 0;
+	mChunkPosition += length + 1;
+	return copy;
+}
+
+LLStringPool::handle_t LLStringPool::find(const char* str, U32 length) const
+{
+	const Index* index = LLLockFree::load(&mIndex);
+	return index ? findInIndex(index, str, length, hashString(str, length)) : 0;
+}
+
+LLStringPool::handle_t LLStringPool::intern(const char* str, U32 length)
+{
+	if (!str)
+	{
+		return 0;
+	}
+
+	U32 hash = hashString(str, length);
+	Index* index = LLLockFree::load(&mIndex);
+	handle_t handle = index ? findInIndex(index, str, length, hash) : 0;
+	if (handle)
+	{
+		return handle;
+	}
+
+	// interning happens in bursts at startup, a short spin is enough
+	while (!LLLockFree::compareAndSwap(&mInterning, 0, 1))
+	{
+		ms_sleep(0);
+	}
+
+	// another thread may have added it meanwhile
+	index = mIndex;
+	handle = index ? findInIndex(index, str, length, hash) : 0;
+	if (!handle)
+	{
+		handle = mCount + 1;
+
+		// at most half full, the misses end on a free slot quickly
+		if (!index || handle * 2 > index->mMask + 1)
+		{
+			U32 slots = index ? (index->mMask + 1) * 2 : MIN_INDEX_SLOTS;
+			Index* new_index = allocateIndex(slots);
+			for (handle_t other = 1; other < handle; ++other)
+			{
+				addToIndex(new_index, other, getEntry(other).mHash);
+			}
+			// readers may still be probing the old index
+			if (index)
+			{
+				mRetiredIndices.push_back(index);
+			}
+			mIndexBytes += sizeof(Index) + (slots - 1) * sizeof(handle_t);
+			LLLockFree::store(&mIndex, new_index);
+			index = new_index;
+		}
+
+		Entry& entry = addEntry(handle);
+		entry.mString = copyString(str, length);
+		entry.mLength = length;
+		entry.mHash = hash;
+		addToIndex(index, handle, hash);
+		LLLockFree::store(&mCount, handle);
+	}
+
+	LLLockFree::store(&mInterning, (U32) 0);
+	return handle;
+}
+
+size_t LLStringPool::getMemoryUsage() const
+{
+	size_t entries = 0;
+	for (U32 i = 0; i < MAX_SEGMENTS; ++i)
+	{
+		if (mSegments[i])
+		{
+			entries += (size_t) 1 << (i + FIRST_SEGMENT_BITS);
+		}
+	}
+	return mChunkBytes + entries * sizeof(Entry) + mIndexBytes;
+}
@@ -0,0 +1,152 @@
+/**
+ * @file llstringpool.h
+ * @brief Interned strings behind stable 32 bit handles.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSTRINGPOOL_H
+#define LL_LLSTRINGPOOL_H
+
+#include "lllockfreequeue.h"
+
+#include <boost/noncopyable.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @class LLStringPool
+ * @brief Insert-only table of interned strings.
+ *
+ * Each distinct string is copied once into large arena chunks and gets a
+ * 32 bit handle, numbered from 1 in the order of insertion; 0 is never a
+ * handle.  Handles and the string pointers behind them stay valid until the
+ * pool is destroyed, so two names can be compared through their handles.
+ *
+ * Lookups don't lock and can run on any thread while another one interns:
+ * the index is an open addressing table that is only ever added to and is
+ * replaced by a bigger copy when it fills, the old copies are kept until
+ * the destructor.  Interning new strings is serialized by a spin lock
+ * rather than an LLMutex, since pools get filled by static initializers
+ * before APR is up.
+ */
+class LL_COMMON_API LLStringPool : boost::noncopyable
+{
+public:
+	typedef U32 handle_t;
+
+	LLStringPool();
+	~LLStringPool();
+
+	/**
+	 * @return Returns the handle of the string, adding it if it is new.
+	 * NULL strings get 0.
+	 */
+	handle_t intern(const char* str, U32 length);
+	handle_t intern(const char* str)			{ return str ? intern(str, (U32) strlen(str)) : 0; }
+	handle_t intern(const std::string& str)		{ return intern(str.data(), (U32) str.size()); }
+
+	/**
+	 * @return Returns the handle of the string, 0 if it was never interned.
+	 */
+	handle_t find(const char* str, U32 length) const;
+	handle_t find(const char* str) const		{ return str ? find(str, (U32) strlen(str)) : 0; }
+	handle_t find(const std::string& str) const	{ return find(str.data(), (U32) str.size()); }
+
+	/**
+	 * @return Returns the null terminated string of a handle, NULL for 0.
+	 */
+	const char* getString(handle_t handle) const
+	{
+		return handle ? getEntry(handle).mString : NULL;
+	}
+
+	U32 getLength(handle_t handle) const
+	{
+		return handle ? getEntry(handle).mLength : 0;
+	}
+
+	/**
+	 * @return Returns the number of strings, which is also the last handle.
+	 */
+	U32 size() const							{ return LLLockFree::load(&mCount); }
+
+	/**
+	 * @return Returns the bytes held by the strings, entries and index.
+	 */
+	size_t getMemoryUsage() const;
+
+private:
+	struct Entry
+	{
+		const char*	mString;
+		U32			mLength;
+		U32			mHash;
+	};
+
+	// handles of a power of 2 number of slots, 0 for free ones
+	struct Index
+	{
+		U32			mMask;
+		handle_t	mHandles[1];
+	};
+
+	enum
+	{
+		FIRST_SEGMENT_BITS = 8,		// entries of the first segment, each next one is twice bigger
+		MAX_SEGMENTS = 32 - FIRST_SEGMENT_BITS,
+		CHUNK_SIZE = 16384
+	};
+
+	const Entry& getEntry(handle_t handle) const
+	{
+		U32 position = handle - 1 + (1 << FIRST_SEGMENT_BITS);
+		U32 segment = 0;
+		while (position >> (segment + FIRST_SEGMENT_BITS + 1))
+		{
+			++segment;
+		}
+		const Entry* entries = LLLockFree::load(&mSegments[segment]);
+		return entries[position - (1 << (segment + FIRST_SEGMENT_BITS))];
+	}
+
+	static U32 hashString(const char* str, U32 length);
+	static Index* allocateIndex(U32 slots);
+	handle_t findInIndex(const Index* index, const char* str, U32 length, U32 hash) const;
+	void addToIndex(Index* index, handle_t handle, U32 hash);
+	Entry& addEntry(handle_t handle);
+	char* copyString(const char* str, U32 length);
+
+	Entry* volatile				mSegments[MAX_SEGMENTS];
+	Index* volatile				mIndex;
+	volatile U32				mCount;
+	volatile U32				mInterning;		// spin lock of the writers
+
+	std::vector<Index*>			mRetiredIndices;
+	std::vector<char*>			mChunks;
+	char*						mChunkPosition;
+	char*						mChunkEnd;
+	size_t						mChunkBytes;
+	size_t						mIndexBytes;
+};
+
+#endif // LL_LLSTRINGPOOL_H
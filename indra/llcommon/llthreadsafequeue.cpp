@@ -24,9 +24,8 @@
  */
 
 #include "linden_common.h"
-#include <apr_pools.h>
-#include <apr_queue.h>
 #include "llthreadsafequeue.h"
+#include "lltimer.h"
 
 
 
@@ -34,76 +33,89 @@
 //-----------------------------------------------------------------------------
 
 
-LLThreadSafeQueueImplementation::LLThreadSafeQueueImplementation(apr_pool_t * pool, unsigned int capacity):
-	mOwnsPool(pool == 0),
-	mPool(pool),
-	mQueue(0)
+LLThreadSafeQueueImplementation::LLThreadSafeQueueImplementation(unsigned int segmentSize):
+	mQueue(segmentSize),
+	mCondition(NULL),
+	mWaiting(0),
+	mInterrupted(0)
 {
-	if(mOwnsPool) {
-		apr_status_t status = apr_pool_create(&mPool, 0);
-		if(status != APR_SUCCESS) throw LLThreadSafeQueueError("failed to allocate pool");
-	} else {
-		; // No op.
-	}
-	
-	apr_status_t status = apr_queue_create(&mQueue, capacity, mPool);
-	if(status != APR_SUCCESS) throw LLThreadSafeQueueError("failed to allocate queue");
+	; // No op.
 }
 
 
 LLThreadSafeQueueImplementation::~LLThreadSafeQueueImplementation()
 {
-	if(mQueue != 0) {
-		if(apr_queue_size(mQueue) != 0) LL_WARNS() << 
-			"terminating queue which still contains " << apr_queue_size(mQueue) <<
-			" elements;" << "memory will be leaked" << LL_ENDL;
-		apr_queue_term(mQueue);
-	}
-	if(mOwnsPool && (mPool != 0)) apr_pool_destroy(mPool);
+	interrupt();
 }
 
 
 void LLThreadSafeQueueImplementation::pushFront(void * element)
 {
-	apr_status_t status = apr_queue_push(mQueue, element);
-	
-	if(status == APR_EINTR) {
-		throw LLThreadSafeQueueInterrupt();
-	} else if(status != APR_SUCCESS) {
-		throw LLThreadSafeQueueError("push failed");
-	} else {
-		; // Success.
+	if(LLLockFree::load(&mInterrupted)) throw LLThreadSafeQueueInterrupt();
+
+	mQueue.push(element);
+
+	// A popBack() about to wait counts itself before it looks at the queue
+	// again, so either it finds this element or it's counted here.
+	if(LLLockFree::fetchAdd(&mWaiting, 0) != 0) {
+		mCondition.lock();
+		mCondition.signal();
+		mCondition.unlock();
 	}
 }
 
 
 bool LLThreadSafeQueueImplementation::tryPushFront(void * element){
-	return apr_queue_trypush(mQueue, element) == APR_SUCCESS;
+	if(LLLockFree::load(&mInterrupted)) return false;
+
+	pushFront(element);
+	return true;
 }
 
 
 void * LLThreadSafeQueueImplementation::popBack(void)
 {
-	void * element;
-	apr_status_t status = apr_queue_pop(mQueue, &element);
-
-	if(status == APR_EINTR) {
-		throw LLThreadSafeQueueInterrupt();
-	} else if(status != APR_SUCCESS) {
-		throw LLThreadSafeQueueError("pop failed");
-	} else {
-		return element;
+	void * element = mQueue.pop();
+	if(element != 0) return element;
+
+	mCondition.lock();
+	LLLockFree::fetchAdd(&mWaiting, 1);
+	while(!LLLockFree::load(&mInterrupted)) {
+		element = mQueue.pop();
+		if(element != 0) break;
+		mCondition.wait();
 	}
+	LLLockFree::fetchAdd(&mWaiting, (U32) -1);
+	mCondition.unlock();
+
+	if(element == 0) throw LLThreadSafeQueueInterrupt();
+	return element;
 }
 
 
 bool LLThreadSafeQueueImplementation::tryPopBack(void *& element)
 {
-	return apr_queue_trypop(mQueue, &element) == APR_SUCCESS;
+	element = mQueue.pop();
+	return element != 0;
 }
 
 
 size_t LLThreadSafeQueueImplementation::size()
 {
-	return apr_queue_size(mQueue);
+	return mQueue.size();
+}
+
+
+void LLThreadSafeQueueImplementation::interrupt(void)
+{
+	LLLockFree::fetchAdd(&mInterrupted, 1);
+
+	while(true) {
+		mCondition.lock();
+		mCondition.broadcast();
+		bool waiting = LLLockFree::load(&mWaiting) != 0;
+		mCondition.unlock();
+		if(!waiting) break;
+		ms_sleep(1);
+	}
 }
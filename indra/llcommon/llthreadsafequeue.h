@@ -31,9 +31,8 @@
 #include <string>
 #include <stdexcept>
 
-
-struct apr_pool_t; // From apr_pools.h
-class LLThreadSafeQueueImplementation; // See below.
+#include "lllockfreequeue.h"
+#include "llmutex.h"
 
 
 //
@@ -66,51 +65,57 @@ public:
 };
 
 
-struct apr_queue_t; // From apr_queue.h
-
-
 //
 // Implementation details. 
 //
+// Pushes and pops go through a lock-free queue, the condition is only locked
+// when a popBack() has to wait or someone is waiting to be woken up.
+//
 class LL_COMMON_API LLThreadSafeQueueImplementation
 {
 public:
-	LLThreadSafeQueueImplementation(apr_pool_t * pool, unsigned int capacity);
+	LLThreadSafeQueueImplementation(unsigned int segmentSize);
 	~LLThreadSafeQueueImplementation();
 	void pushFront(void * element);
 	bool tryPushFront(void * element);
 	void * popBack(void);
 	bool tryPopBack(void *& element);
 	size_t size();
+
+	// Wakes up blocked popBack() calls with an interrupt error, later blocking
+	// calls are interrupted right away.  Returns once nobody is blocked.
+	void interrupt(void);
 	
 private:
-	bool mOwnsPool;
-	apr_pool_t * mPool;
-	apr_queue_t * mQueue;
+	LLLockFreeQueue<void> mQueue;
+	LLCondition mCondition;
+	volatile U32 mWaiting;
+	volatile U32 mInterrupted;
 };
 
 
 //
 // Implements a thread safe FIFO.
 //
+// The queue grows as needed, segmentSize elements at a time.
+//
 template<typename ElementT>
 class LLThreadSafeQueue
 {
 public:
 	typedef ElementT value_type;
 	
-	// If the pool is set to NULL one will be allocated and managed by this
-	// queue.
-	LLThreadSafeQueue(apr_pool_t * pool = 0, unsigned int capacity = 1024);
+	LLThreadSafeQueue(unsigned int segmentSize = 1024);
+
+	// Elements still queued are discarded.
+	~LLThreadSafeQueue();
 	
-	// Add an element to the front of queue (will block if the queue has
-	// reached capacity).
+	// Add an element to the front of queue.
 	//
-	// This call will raise an interrupt error if the queue is deleted while
-	// the caller is blocked.
+	// This call will raise an interrupt error if the queue is being deleted.
 	void pushFront(ElementT const & element);
 	
-	// Try to add an element to the front ofqueue without blocking. Returns
+	// Try to add an element to the front of queue without blocking. Returns
 	// true only if the element was actually added.
 	bool tryPushFront(ElementT const & element);
 	
@@ -139,13 +144,29 @@ private:
 
 
 template<typename ElementT>
-LLThreadSafeQueue<ElementT>::LLThreadSafeQueue(apr_pool_t * pool, unsigned int capacity):
-	mImplementation(pool, capacity)
+LLThreadSafeQueue<ElementT>::LLThreadSafeQueue(unsigned int segmentSize):
+	mImplementation(segmentSize)
 {
 	; // No op.
 }
 
 
+template<typename ElementT>
+LLThreadSafeQueue<ElementT>::~LLThreadSafeQueue()
+{
+	mImplementation.interrupt();
+
+	size_t discarded = 0;
+	void * storedElement;
+	while(mImplementation.tryPopBack(storedElement)) {
+		delete reinterpret_cast<ElementT *>(storedElement);
+		++discarded;
+	}
+	if(discarded != 0) LL_WARNS() << 
+		"terminating queue which still contained " << discarded << " elements" << LL_ENDL;
+}
+
+
 template<typename ElementT>
 void LLThreadSafeQueue<ElementT>::pushFront(ElementT const & element)
 {
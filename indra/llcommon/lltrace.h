@@ -36,6 +36,7 @@
 #include "llthreadlocalstorage.h"
 #include "lltimer.h"
 #include "llpointer.h"
+#include "llslaballocator.h"
 #include "llunits.h"
 
 #define LL_TRACE_ENABLED 1
@@ -421,6 +422,26 @@ public:
 		ll_aligned_free<CUSTOM_ALIGNMENT>(ptr);
 	}
 
+	// for operator new and delete of the hot classes that get their
+	// objects from an LLSlabPool, see llslaballocator.h
+	template<typename T>
+	static void* slab_new(size_t size)
+	{
+#if LL_TRACE_ENABLED
+		claim_alloc(sMemStat, size);
+#endif
+		return ll_slab_allocate<T, ALIGNMENT>(size);
+	}
+
+	template<typename T>
+	static void slab_delete(void* ptr, size_t size)
+	{
+#if LL_TRACE_ENABLED
+		disclaim_alloc(sMemStat, size);
+#endif
+		ll_slab_free<T, ALIGNMENT>(ptr, size);
+	}
+
 	void* operator new [](size_t size)
 	{
 #if LL_TRACE_ENABLED
@@ -40,7 +40,8 @@ static ThreadRecorder* sMasterThreadRecorder = NULL;
 ///////////////////////////////////////////////////////////////////////
 
 ThreadRecorder::ThreadRecorder()
-:	mParentRecorder(NULL)
+:	mTimerEvents(new TimerEventBuffer("Main", TimerEventBuffer::MAIN_THREAD_EVENTS)),
+	mParentRecorder(NULL)
 {
 	init();
 }
@@ -49,6 +50,7 @@ void ThreadRecorder::init()
 {
 #if LL_TRACE_ENABLED
 	LLThreadLocalSingletonPointer<BlockTimerStackRecord>::setInstance(&mBlockTimerStackRecord);
+	LLThreadLocalSingletonPointer<TimerEventBuffer>::setInstance(mTimerEvents);
 	//NB: the ordering of initialization in this function is very fragile due to a large number of implicit dependencies
 	set_thread_recorder(this);
 	BlockTimerStatHandle& root_time_block = BlockTimer::getRootTimeBlock();
@@ -88,8 +90,9 @@ void ThreadRecorder::init()
 }
 
 
-ThreadRecorder::ThreadRecorder( ThreadRecorder& parent )
-:	mParentRecorder(&parent)
+ThreadRecorder::ThreadRecorder( ThreadRecorder& parent, const std::string& thread_name )
+:	mTimerEvents(new TimerEventBuffer(thread_name, TimerEventBuffer::THREAD_EVENTS)),
+	mParentRecorder(&parent)
 {
 	init();
 	mParentRecorder->addChildRecorder(this);
@@ -100,6 +103,7 @@ ThreadRecorder::~ThreadRecorder()
 {
 #if LL_TRACE_ENABLED
 	LLThreadLocalSingletonPointer<BlockTimerStackRecord>::setInstance(NULL);
+	LLThreadLocalSingletonPointer<TimerEventBuffer>::setInstance(NULL);
 
 	disclaim_alloc(gTraceMemStat, this);
 	disclaim_alloc(gTraceMemStat, sizeof(BlockTimer));
@@ -123,6 +127,7 @@ ThreadRecorder::~ThreadRecorder()
 		mParentRecorder->removeChildRecorder(this);
 	}
 #endif
+	delete mTimerEvents;
 }
 
 TimeBlockTreeNode* ThreadRecorder::getTimeBlockTreeNode( S32 index )
@@ -252,6 +257,23 @@ void ThreadRecorder::addChildRecorder( class ThreadRecorder* child )
 #endif
 }
 
+void ThreadRecorder::copyTimerEvents( std::vector<TimerEventBuffer::ThreadEvents>& threads )
+{
+	threads.push_back(TimerEventBuffer::ThreadEvents());
+	mTimerEvents->copyEvents(threads.back());
+
+#if LL_TRACE_ENABLED
+	{ LLMutexLock lock(&mChildListMutex);
+		for (child_thread_recorder_list_t::iterator it = mChildThreadRecorders.begin(), end_it = mChildThreadRecorders.end();
+			it != end_it;
+			++it)
+		{
+			(*it)->copyTimerEvents(threads);
+		}
+	}
+#endif
+}
+
 // called by child thread
 void ThreadRecorder::removeChildRecorder( class ThreadRecorder* child )
 {	
@@ -32,6 +32,7 @@
 
 #include "llmutex.h"
 #include "lltraceaccumulators.h"
+#include "lltracetimerevents.h"
 #include "llthreadlocalstorage.h"
 
 namespace LLTrace
@@ -43,7 +44,7 @@ namespace LLTrace
 		typedef std::vector<ActiveRecording*> active_recording_list_t;
 	public:
 		ThreadRecorder();
-		explicit ThreadRecorder(ThreadRecorder& parent);
+		explicit ThreadRecorder(ThreadRecorder& parent, const std::string& thread_name = "Thread");
 
 		~ThreadRecorder();
 
@@ -60,6 +61,9 @@ namespace LLTrace
 
 		TimeBlockTreeNode* getTimeBlockTreeNode(S32 index);
 
+		// copies of the timer events of this thread and its child threads
+		void copyTimerEvents(std::vector<TimerEventBuffer::ThreadEvents>& threads);
+
 	protected:
 		void init();
 
@@ -77,6 +81,7 @@ namespace LLTrace
 		AccumulatorBufferGroup			mThreadRecordingBuffers;
 
 		BlockTimerStackRecord			mBlockTimerStackRecord;
+		TimerEventBuffer*				mTimerEvents;
 		active_recording_list_t			mActiveRecordings;
 
 		class BlockTimer*				mRootTimer;
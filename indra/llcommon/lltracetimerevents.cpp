@@ -0,0 +1,194 @@
+/**
+ * @file lltracetimerevents.cpp
+ * @brief Per-thread rings of the latest BlockTimer blocks, for timelines.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lltracetimerevents.h"
+
+#include "llfasttimer.h"
+#include "lltracethreadrecorder.h"
+
+namespace LLTrace
+{
+
+bool TimerEventBuffer::sRecording = true;
+
+static volatile U32 sNextThreadID = 1;
+
+// JSON string contents
+static void write_escaped(std::ostream& os, const std::string& text)
+{
+	for (std::string::const_iterator it = text.begin(); it != text.end(); ++it)
+	{
+		unsigned char c = *it;
+		if (c == '"' || c == '\\')
+		{
+			os << '\\' << c;
+		}
+		else if (c < 0x20)
+		{
+			os << llformat("\\u%04x", c);
+		}
+		else
+		{
+			os << c;
+		}
+	}
+}
+
+TimerEventBuffer::TimerEventBuffer(const std::string& thread_name, U32 capacity)
+:	mEvents(NULL),
+	mMask(1),
+	mStartedEvents(0),
+	mRecordedEvents(0),
+	mThreadName(thread_name),
+	mThreadID(LLLockFree::fetchAdd(&sNextThreadID, 1))
+{
+	while (mMask + 1 < capacity)
+	{
+		mMask = (mMask << 1) | 1;
+	}
+	mEvents = new Event[mMask + 1];
+}
+
+TimerEventBuffer::~TimerEventBuffer()
+{
+	delete[] mEvents;
+}
+
+void TimerEventBuffer::copyEvents(ThreadEvents& events) const
+{
+	events.mThreadName = mThreadName;
+	events.mThreadID = mThreadID;
+	events.mEvents.clear();
+
+	U32 capacity = mMask + 1;
+	U32 end = LLLockFree::load(&mRecordedEvents);
+	U32 count = llmin(end, capacity);
+	events.mEvents.reserve(count);
+	for (U32 index = end - count; index != end; ++index)
+	{
+		events.mEvents.push_back(mEvents[index & mMask]);
+	}
+
+	// the owning thread kept recording, the events it started overwriting
+	// meanwhile may be torn
+	LLLockFree::loadFence();
+	U32 started = LLLockFree::load(&mStartedEvents);
+	S32 overwritten = (S32) (started - (end - count)) - (S32) capacity;
+	if (overwritten > 0)
+	{
+		events.mEvents.erase(events.mEvents.begin(), events.mEvents.begin() + llmin(overwritten, (S32) count));
+	}
+}
+
+//static
+void TimerEventBuffer::copyTrace(Trace& trace)
+{
+	trace.mThreads.clear();
+	ThreadRecorder* master = get_master_thread_recorder();
+	if (master)
+	{
+		master->copyTimerEvents(trace.mThreads);
+	}
+
+	trace.mTimeBlockNames.assign(BlockTimerStatHandle::getNumIndices(), std::string());
+	for (BlockTimerStatHandle::instance_tracker_t::instance_iter it = BlockTimerStatHandle::instance_tracker_t::beginInstances(), end_it = BlockTimerStatHandle::instance_tracker_t::endInstances();
+		it != end_it;
+		++it)
+	{
+		if (it->getIndex() < trace.mTimeBlockNames.size())
+		{
+			trace.mTimeBlockNames[it->getIndex()] = it->getName();
+		}
+	}
+	trace.mCountsPerSecond = BlockTimer::countsPerSecond();
+}
+
+//static
+void TimerEventBuffer::writeChromeTrace(const Trace& trace, std::ostream& os)
+{
+	const std::vector<ThreadEvents>& threads = trace.mThreads;
+
+	// microseconds from the earliest start, events are in the order they ended
+	U64 first_time = ~(U64) 0;
+	for (std::vector<ThreadEvents>::const_iterator it = threads.begin(); it != threads.end(); ++it)
+	{
+		for (std::vector<Event>::const_iterator event_it = it->mEvents.begin(); event_it != it->mEvents.end(); ++event_it)
+		{
+			first_time = llmin(first_time, event_it->mStartTime);
+		}
+	}
+	F64 usec_per_count = 1000000.0 / (F64) trace.mCountsPerSecond;
+
+	os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first_event = true;
+	for (std::vector<ThreadEvents>::const_iterator it = threads.begin(); it != threads.end(); ++it)
+	{
+		os << (first_event ? "\n" : ",\n");
+		first_event = false;
+		os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << it->mThreadID << ",\"args\":{\"name\":\"";
+		write_escaped(os, it->mThreadName);
+		os << "\"}}";
+
+		for (std::vector<Event>::const_iterator event_it = it->mEvents.begin(); event_it != it->mEvents.end(); ++event_it)
+		{
+			bool named = event_it->mTimeBlock < trace.mTimeBlockNames.size() && !trace.mTimeBlockNames[event_it->mTimeBlock].empty();
+			os << ",\n{\"name\":\"";
+			write_escaped(os, named ? trace.mTimeBlockNames[event_it->mTimeBlock] : std::string("?"));
+			os << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << it->mThreadID
+			   << llformat(",\"ts\":%.3f,\"dur\":%.3f}",
+						   (F64) (event_it->mStartTime - first_time) * usec_per_count,
+						   (F64) ((U64) event_it->mDuration << DURATION_SHIFT) * usec_per_count);
+		}
+	}
+	os << "\n]}\n";
+}
+
+//static
+void TimerEventBuffer::writeChromeTrace(std::ostream& os)
+{
+	Trace trace;
+	copyTrace(trace);
+	writeChromeTrace(trace, os);
+}
+
+//static
+bool TimerEventBuffer::writeChromeTrace(const std::string& filename)
+{
+	llofstream os(filename.c_str());
+	if (!os.is_open())
+	{
+		LL_WARNS() << "Couldn't write timer trace " << filename << LL_ENDL;
+		return false;
+	}
+	writeChromeTrace(os);
+	os.close();
+	LL_INFOS() << "Wrote timer trace " << filename << LL_ENDL;
+	return true;
+}
+
+}
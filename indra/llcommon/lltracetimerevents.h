@@ -0,0 +1,130 @@
+/**
+ * @file lltracetimerevents.h
+ * @brief Per-thread rings of the latest BlockTimer blocks, for timelines.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTRACETIMEREVENTS_H
+#define LL_LLTRACETIMEREVENTS_H
+
+#include "stdtypes.h"
+#include "llpreprocessor.h"
+#include "lllockfreequeue.h"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace LLTrace
+{
+	// The latest blocks timed by BlockTimers on one thread, with their start
+	// and duration, so what every thread was doing around a hitch can be
+	// looked at on a timeline after the fact.
+	//
+	// Each thread with a ThreadRecorder owns one and is the only one to
+	// record into it, other threads only take copies.  Recording is cheap
+	// enough to leave on: a thread local lookup and a few stores per block.
+	class LL_COMMON_API TimerEventBuffer : private boost::noncopyable
+	{
+	public:
+		struct Event
+		{
+			U64		mStartTime;		// in BlockTimer clock counts
+			U32		mDuration;		// in clock counts >> DURATION_SHIFT, saturated
+			U32		mTimeBlock;		// BlockTimerStatHandle index
+		};
+
+		enum
+		{
+			DURATION_SHIFT = 6,
+			MAIN_THREAD_EVENTS = 65536,		// a few dozen frames
+			THREAD_EVENTS = 16384
+		};
+
+		struct ThreadEvents
+		{
+			std::string			mThreadName;
+			U32					mThreadID;
+			std::vector<Event>	mEvents;	// in the order they ended
+		};
+
+		TimerEventBuffer(const std::string& thread_name, U32 capacity);
+		~TimerEventBuffer();
+
+		LL_FORCE_INLINE void record(U32 time_block, U64 start_time, U64 end_time)
+		{
+			// copyEvents() may be reading on another thread, it tells the
+			// events being overwritten by the started count
+			U32 index = mRecordedEvents;
+			LLLockFree::store(&mStartedEvents, index + 1);
+			LLLockFree::storeFence();
+
+			Event& event = mEvents[index & mMask];
+			event.mStartTime = start_time;
+			U64 duration = (end_time - start_time) >> DURATION_SHIFT;
+			event.mDuration = duration < U32_MAX ? (U32) duration : U32_MAX;
+			event.mTimeBlock = time_block;
+
+			LLLockFree::store(&mRecordedEvents, index + 1);
+		}
+
+		// safe on any thread
+		void copyEvents(ThreadEvents& events) const;
+
+		// recording is on unless turned off
+		static void setRecording(bool recording) { sRecording = recording; }
+		static bool isRecording() { return sRecording; }
+
+		// the events of every thread with a ThreadRecorder and what is needed
+		// to write them out, so they can be written on another thread
+		struct Trace
+		{
+			std::vector<ThreadEvents>	mThreads;
+			std::vector<std::string>	mTimeBlockNames;	// by BlockTimerStatHandle index
+			U64							mCountsPerSecond;
+		};
+
+		// on the main thread, the time block names aren't safe elsewhere
+		static void copyTrace(Trace& trace);
+
+		// Chrome trace event format JSON of the events of every thread with a
+		// ThreadRecorder, chrome://tracing and Perfetto open it.  Formatting
+		// a copied trace is safe on any thread.
+		static void writeChromeTrace(const Trace& trace, std::ostream& os);
+		static void writeChromeTrace(std::ostream& os);
+		static bool writeChromeTrace(const std::string& filename);
+
+	private:
+		Event*				mEvents;
+		U32					mMask;
+		// only ever written by the owning thread
+		volatile U32		mStartedEvents;
+		volatile U32		mRecordedEvents;
+		const std::string	mThreadName;
+		const U32			mThreadID;
+
+		static bool			sRecording;
+	};
+}
+
+#endif // LL_LLTRACETIMEREVENTS_H
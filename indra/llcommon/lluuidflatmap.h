@@ -0,0 +1,479 @@
+/**
+ * @file lluuidflatmap.h
+ * @brief Open addressing hash map and set keyed by LLUUID.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLUUIDFLATMAP_H
+#define LL_LLUUIDFLATMAP_H
+
+#include "lluuid.h"
+#include "llmemory.h"
+
+#include <emmintrin.h>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#if LL_WINDOWS
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit of a non zero mask.
+inline U32 ll_uuid_table_first_bit(U32 mask)
+{
+#if LL_WINDOWS
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (U32) index;
+#else
+	return (U32) __builtin_ctz(mask);
+#endif
+}
+
+// Hash of a UUID.  Almost every UUID we see is random or a digest, so
+// folding its words together is as good a hash as any; the final mix is
+// only there for hand made ids such as 00000000-0000-0000-0000-000000000001.
+inline U32 ll_uuid_table_hash(const LLUUID& id)
+{
+	U32 words[4];
+	memcpy(words, id.mData, sizeof(words));
+	U32 hash = words[0] ^ words[1] ^ words[2] ^ words[3];
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+	return hash;
+}
+
+/**
+ * @class LLUUIDFlatTable
+ * @brief Storage shared by LLUUIDFlatMap and LLUUIDFlatSet.
+ *
+ * Values live in one array of slots next to an array of control bytes, one
+ * per slot: the low 7 bits of the key hash for a used slot, EMPTY or
+ * DELETED otherwise.  A lookup walks groups of 16 slots, comparing the 16
+ * control bytes of a group to the hash bits with one SSE2 compare and the
+ * 16 key bytes of the candidates with another, so most lookups touch one
+ * cache line of control bytes and one slot.
+ *
+ * Unlike std::map, inserting may move every value: iterators, pointers and
+ * references are only good until the next insertion.  Erasing only
+ * invalidates the erased element, so "erase(it++)" loops work.  Iteration
+ * order is unspecified.
+ */
+template <typename VALUE, typename KEY_OF>
+class LLUUIDFlatTable
+{
+public:
+	typedef LLUUID key_type;
+	typedef VALUE value_type;
+	typedef size_t size_type;
+
+	class const_iterator;
+
+	class iterator : public std::iterator<std::forward_iterator_tag, VALUE>
+	{
+		friend class LLUUIDFlatTable;
+		friend class const_iterator;
+	public:
+		iterator() : mTable(NULL), mIndex(0) {}
+
+		VALUE& operator*() const { return mTable->mSlots[mIndex]; }
+		VALUE* operator->() const { return &mTable->mSlots[mIndex]; }
+		iterator& operator++() { mIndex = mTable->nextUsed(mIndex + 1); return *this; }
+		iterator operator++(int) { iterator it(*this); ++*this; return it; }
+		bool operator==(const iterator& rhs) const { return mIndex == rhs.mIndex; }
+		bool operator!=(const iterator& rhs) const { return mIndex != rhs.mIndex; }
+
+	private:
+		iterator(LLUUIDFlatTable* table, size_t index) : mTable(table), mIndex(index) {}
+
+		LLUUIDFlatTable*	mTable;
+		size_t				mIndex;
+	};
+
+	class const_iterator : public std::iterator<std::forward_iterator_tag, const VALUE>
+	{
+		friend class LLUUIDFlatTable;
+	public:
+		const_iterator() : mTable(NULL), mIndex(0) {}
+		const_iterator(const iterator& it) : mTable(it.mTable), mIndex(it.mIndex) {}
+
+		const VALUE& operator*() const { return mTable->mSlots[mIndex]; }
+		const VALUE* operator->() const { return &mTable->mSlots[mIndex]; }
+		const_iterator& operator++() { mIndex = mTable->nextUsed(mIndex + 1); return *this; }
+		const_iterator operator++(int) { const_iterator it(*this); ++*this; return it; }
+		bool operator==(const const_iterator& rhs) const { return mIndex == rhs.mIndex; }
+		bool operator!=(const const_iterator& rhs) const { return mIndex != rhs.mIndex; }
+
+	private:
+		const_iterator(const LLUUIDFlatTable* table, size_t index) : mTable(table), mIndex(index) {}
+
+		const LLUUIDFlatTable*	mTable;
+		size_t					mIndex;
+	};
+
+	LLUUIDFlatTable()
+	:	mControl(NULL),
+		mSlots(NULL),
+		mCapacity(0),
+		mSize(0),
+		mGrowthLeft(0)
+	{
+	}
+
+	LLUUIDFlatTable(const LLUUIDFlatTable& other)
+	:	mControl(NULL),
+		mSlots(NULL),
+		mCapacity(0),
+		mSize(0),
+		mGrowthLeft(0)
+	{
+		if (other.mSize)
+		{
+			reserve(other.mSize);
+		}
+		for (const_iterator it = other.begin(); it != other.end(); ++it)
+		{
+			insert(*it);
+		}
+	}
+
+	~LLUUIDFlatTable()
+	{
+		destroyAll();
+	}
+
+	LLUUIDFlatTable& operator=(const LLUUIDFlatTable& other)
+	{
+		if (this != &other)
+		{
+			LLUUIDFlatTable copy(other);
+			swap(copy);
+		}
+		return *this;
+	}
+
+	void swap(LLUUIDFlatTable& other)
+	{
+		std::swap(mControl, other.mControl);
+		std::swap(mSlots, other.mSlots);
+		std::swap(mCapacity, other.mCapacity);
+		std::swap(mSize, other.mSize);
+		std::swap(mGrowthLeft, other.mGrowthLeft);
+	}
+
+	iterator begin() { return iterator(this, nextUsed(0)); }
+	iterator end() { return iterator(this, mCapacity); }
+	const_iterator begin() const { return const_iterator(this, nextUsed(0)); }
+	const_iterator end() const { return const_iterator(this, mCapacity); }
+
+	size_t size() const { return mSize; }
+	bool empty() const { return mSize == 0; }
+	size_t capacity() const { return mCapacity; }
+
+	// bytes allocated for slots and control bytes
+	size_t getMemoryUsage() const { return mCapacity * (sizeof(VALUE) + 1); }
+
+	iterator find(const LLUUID& key) { return iterator(this, findIndex(key)); }
+	const_iterator find(const LLUUID& key) const { return const_iterator(this, findIndex(key)); }
+	size_t count(const LLUUID& key) const { return findIndex(key) != mCapacity ? 1 : 0; }
+
+	std::pair<iterator, bool> insert(const VALUE& value)
+	{
+		const LLUUID& key = KEY_OF::get(value);
+		size_t index = findIndex(key);
+		if (index != mCapacity)
+		{
+			return std::make_pair(iterator(this, index), false);
+		}
+		index = prepareInsert(key);
+		new (&mSlots[index]) VALUE(value);
+		return std::make_pair(iterator(this, index), true);
+	}
+
+	void erase(iterator it)
+	{
+		eraseIndex(it.mIndex);
+	}
+
+	size_t erase(const LLUUID& key)
+	{
+		size_t index = findIndex(key);
+		if (index == mCapacity)
+		{
+			return 0;
+		}
+		eraseIndex(index);
+		return 1;
+	}
+
+	// frees the storage too, like std::map
+	void clear()
+	{
+		destroyAll();
+		mControl = NULL;
+		mSlots = NULL;
+		mCapacity = 0;
+		mSize = 0;
+		mGrowthLeft = 0;
+	}
+
+	// makes room for count values without growing
+	void reserve(size_t count)
+	{
+		size_t capacity = GROUP_SIZE;
+		while (capacity * MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR < count)
+		{
+			capacity *= 2;
+		}
+		if (capacity > mCapacity)
+		{
+			rehash(capacity);
+		}
+	}
+
+protected:
+	enum
+	{
+		GROUP_SIZE = 16,
+		MAX_LOAD_NUMERATOR = 7,		// grow past 7/8 full, leaves every group
+		MAX_LOAD_DENOMINATOR = 8	// probe sequence an empty slot to stop at
+	};
+
+	static const S8 EMPTY = (S8) 0x80;
+	static const S8 DELETED = (S8) 0xfe;
+
+	// slot of the key or mCapacity
+	size_t findIndex(const LLUUID& key) const
+	{
+		if (!mSize)
+		{
+			return mCapacity;
+		}
+		U32 hash = ll_uuid_table_hash(key);
+		const __m128i tag = _mm_set1_epi8((char) (hash & 0x7f));
+		const __m128i empty = _mm_set1_epi8(EMPTY);
+		const __m128i key_bytes = _mm_loadu_si128((const __m128i*) key.mData);
+		size_t group_mask = mCapacity / GROUP_SIZE - 1;
+		size_t group = (hash >> 7) & group_mask;
+		for (size_t step = 1; ; ++step)
+		{
+			const __m128i control = _mm_load_si128((const __m128i*) (mControl + group * GROUP_SIZE));
+			U32 matches = _mm_movemask_epi8(_mm_cmpeq_epi8(control, tag));
+			while (matches)
+			{
+				size_t index = group * GROUP_SIZE + ll_uuid_table_first_bit(matches);
+				const __m128i slot_key = _mm_loadu_si128((const __m128i*) KEY_OF::get(mSlots[index]).mData);
+				if (_mm_movemask_epi8(_mm_cmpeq_epi8(slot_key, key_bytes)) == 0xffff)
+				{
+					return index;
+				}
+				matches &= matches - 1;
+			}
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(control, empty)))
+			{
+				return mCapacity;
+			}
+			// triangular steps visit every group of a power of 2 count
+			group = (group + step) & group_mask;
+		}
+	}
+
+	// claims the control byte of a free slot for a key known to be missing,
+	// the caller constructs the value in it
+	size_t prepareInsert(const LLUUID& key)
+	{
+		U32 hash = ll_uuid_table_hash(key);
+		size_t index = mCapacity ? findFree(hash) : 0;
+		if (!mCapacity || (mControl[index] == EMPTY && !mGrowthLeft))
+		{
+			// out of EMPTY slots: reclaim the DELETED ones in place if that
+			// leaves a fair share of the table to fill, else double
+			rehash(mCapacity && mSize * 32 <= mCapacity * 25 ? mCapacity : llmax(mCapacity * 2, (size_t) GROUP_SIZE));
+			index = findFree(hash);
+		}
+		if (mControl[index] == EMPTY)
+		{
+			--mGrowthLeft;
+		}
+		mControl[index] = (S8) (hash & 0x7f);
+		++mSize;
+		return index;
+	}
+
+	// first EMPTY or DELETED slot of the probe sequence of the hash
+	size_t findFree(U32 hash) const
+	{
+		size_t group_mask = mCapacity / GROUP_SIZE - 1;
+		size_t group = (hash >> 7) & group_mask;
+		for (size_t step = 1; ; ++step)
+		{
+			// EMPTY and DELETED both have the high bit set
+			const __m128i control = _mm_load_si128((const __m128i*) (mControl + group * GROUP_SIZE));
+			U32 free_slots = _mm_movemask_epi8(control);
+			if (free_slots)
+			{
+				return group * GROUP_SIZE + ll_uuid_table_first_bit(free_slots);
+			}
+			group = (group + step) & group_mask;
+		}
+	}
+
+	void eraseIndex(size_t index)
+	{
+		mSlots[index].~VALUE();
+		--mSize;
+
+		// A group that still has an EMPTY slot was never full, so no probe
+		// sequence ever went past it and the slot can go back to EMPTY.
+		// Otherwise it stays DELETED to keep later groups reachable.
+		size_t group_start = index & ~(size_t) (GROUP_SIZE - 1);
+		const __m128i control = _mm_load_si128((const __m128i*) (mControl + group_start));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(EMPTY))))
+		{
+			mControl[index] = EMPTY;
+			++mGrowthLeft;
+		}
+		else
+		{
+			mControl[index] = DELETED;
+		}
+	}
+
+	// first used slot at or after index, or mCapacity
+	size_t nextUsed(size_t index) const
+	{
+		while (index < mCapacity)
+		{
+			size_t group_start = index & ~(size_t) (GROUP_SIZE - 1);
+			const __m128i control = _mm_load_si128((const __m128i*) (mControl + group_start));
+			U32 used = ~_mm_movemask_epi8(control) & (0xffff << (index - group_start)) & 0xffff;
+			if (used)
+			{
+				return group_start + ll_uuid_table_first_bit(used);
+			}
+			index = group_start + GROUP_SIZE;
+		}
+		return mCapacity;
+	}
+
+	void rehash(size_t capacity)
+	{
+		S8* old_control = mControl;
+		VALUE* old_slots = mSlots;
+		size_t old_capacity = mCapacity;
+
+		mControl = (S8*) ll_aligned_malloc_16(capacity);
+		mSlots = (VALUE*) ll_aligned_malloc_16(capacity * sizeof(VALUE));
+		memset(mControl, EMPTY, capacity);
+		mCapacity = capacity;
+		mGrowthLeft = capacity * MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR - mSize;
+
+		for (size_t index = 0; index < old_capacity; ++index)
+		{
+			if (old_control[index] >= 0)
+			{
+				U32 hash = ll_uuid_table_hash(KEY_OF::get(old_slots[index]));
+				size_t new_index = findFree(hash);
+				mControl[new_index] = (S8) (hash & 0x7f);
+				new (&mSlots[new_index]) VALUE(old_slots[index]);
+				old_slots[index].~VALUE();
+			}
+		}
+
+		if (old_control)
+		{
+			ll_aligned_free_16(old_control);
+			ll_aligned_free_16(old_slots);
+		}
+	}
+
+	void destroyAll()
+	{
+		for (size_t index = 0; index < mCapacity; ++index)
+		{
+			if (mControl[index] >= 0)
+			{
+				mSlots[index].~VALUE();
+			}
+		}
+		if (mControl)
+		{
+			ll_aligned_free_16(mControl);
+			ll_aligned_free_16(mSlots);
+		}
+	}
+
+	S8*		mControl;		// 16 byte aligned so groups load aligned
+	VALUE*	mSlots;
+	size_t	mCapacity;		// 0 or a power of 2 multiple of GROUP_SIZE
+	size_t	mSize;
+	size_t	mGrowthLeft;	// EMPTY slots left to use before growing
+};
+
+template <typename T>
+struct LLUUIDFlatMapKey
+{
+	static const LLUUID& get(const std::pair<const LLUUID, T>& value) { return value.first; }
+};
+
+struct LLUUIDFlatSetKey
+{
+	static const LLUUID& get(const LLUUID& value) { return value; }
+};
+
+/**
+ * @class LLUUIDFlatMap
+ * @brief Drop-in for std::map<LLUUID, T> lookup tables that don't need
+ * ordering or stable references, see LLUUIDFlatTable.
+ */
+template <typename T>
+class LLUUIDFlatMap : public LLUUIDFlatTable<std::pair<const LLUUID, T>, LLUUIDFlatMapKey<T> >
+{
+	typedef LLUUIDFlatTable<std::pair<const LLUUID, T>, LLUUIDFlatMapKey<T> > table_t;
+public:
+	typedef T mapped_type;
+
+	T& operator[](const LLUUID& key)
+	{
+		size_t index = table_t::findIndex(key);
+		if (index == table_t::mCapacity)
+		{
+			index = table_t::prepareInsert(key);
+			new (&table_t::mSlots[index]) typename table_t::value_type(key, T());
+		}
+		return table_t::mSlots[index].second;
+	}
+};
+
+/**
+ * @class LLUUIDFlatSet
+ * @brief Drop-in for uuid_set_t where ordering doesn't matter, see
+ * LLUUIDFlatTable.
+ */
+class LLUUIDFlatSet : public LLUUIDFlatTable<LLUUID, LLUUIDFlatSetKey>
+{
+};
+
+#endif // LL_LLUUIDFLATMAP_H
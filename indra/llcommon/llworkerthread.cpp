@@ -34,8 +34,8 @@
 //============================================================================
 // Run on MAIN thread
 
-LLWorkerThread::LLWorkerThread(const std::string& name, bool threaded, bool should_pause) :
-	LLQueuedThread(name, threaded, should_pause)
+LLWorkerThread::LLWorkerThread(const std::string& name, bool threaded, bool should_pause, S32 scheduler_workers) :
+	LLQueuedThread(name, threaded, should_pause, scheduler_workers)
 {
 	mDeleteMutex = new LLMutex(NULL);
 
@@ -84,7 +84,7 @@ private:
 	LLMutex* mDeleteMutex;
 	
 public:
-	LLWorkerThread(const std::string& name, bool threaded = true, bool should_pause = false);
+	LLWorkerThread(const std::string& name, bool threaded = true, bool should_pause = false, S32 scheduler_workers = 0);
 	~LLWorkerThread();
 
 	/*virtual*/ S32 update(F32 max_time_ms);
@@ -0,0 +1,231 @@
+/**
+ * @file llworkscheduler.cpp
+ * @brief Shared worker threads for the requests of LLQueuedThreads.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llworkscheduler.h"
+
+#include "llqueuedthread.h"
+#include "llstl.h"
+
+#if LL_WINDOWS
+#include "llwin32headerslean.h"
+#else
+#include <unistd.h>
+#endif
+
+// more workers than this only add contention on the deques
+const S32 MAX_WORKERS = 16;
+
+//static
+LLWorkScheduler* LLWorkScheduler::sInstance = NULL;
+
+//============================================================================
+// MAIN THREAD
+
+//static
+void LLWorkScheduler::initClass(S32 num_workers)
+{
+	llassert(sInstance == NULL);
+	if (num_workers <= 0)
+	{
+		num_workers = getNumCores() - 1;
+	}
+	sInstance = new LLWorkScheduler(llclamp(num_workers, 1, MAX_WORKERS));
+}
+
+// MAIN THREAD
+// Queues using the scheduler must have been shut down already.
+//static
+void LLWorkScheduler::cleanupClass()
+{
+	delete sInstance;
+	sInstance = NULL;
+}
+
+//static
+LLWorkScheduler::ELane LLWorkScheduler::getLane(U32 priority)
+{
+	if (priority >= LLQueuedThread::PRIORITY_HIGH)
+	{
+		return LANE_HIGH;
+	}
+	return priority >= LLQueuedThread::PRIORITY_NORMAL ? LANE_NORMAL : LANE_LOW;
+}
+
+//static
+S32 LLWorkScheduler::getNumCores()
+{
+#if LL_WINDOWS
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (S32) info.dwNumberOfProcessors;
+#else
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	return cores > 0 ? (S32) cores : 1;
+#endif
+}
+
+LLWorkScheduler::LLWorkScheduler(S32 num_workers)
+:	mWorkCondition(NULL),
+	mNumQueued(0),
+	mNumSleeping(0),
+	mNextWorker(0),
+	mQuitting(0)
+{
+	for (S32 i = 0; i < num_workers; ++i)
+	{
+		mWorkers.push_back(new Worker(this, i));
+	}
+	for (S32 i = 0; i < num_workers; ++i)
+	{
+		mWorkers[i]->start();
+	}
+	LL_INFOS() << "Work scheduler started " << num_workers << " workers" << LL_ENDL;
+}
+
+LLWorkScheduler::~LLWorkScheduler()
+{
+	mQuitting = 1;
+	mWorkCondition.lock();
+	mWorkCondition.broadcast();
+	mWorkCondition.unlock();
+
+	// stop them while they are still Workers: by the time ~LLThread() waits,
+	// one that hasn't reached run() yet would call LLThread's pure virtual
+	for (S32 i = 0; i < (S32) mWorkers.size(); ++i)
+	{
+		mWorkers[i]->shutdown();
+	}
+	for_each(mWorkers.begin(), mWorkers.end(), DeletePointer());
+	mWorkers.clear();
+}
+
+//============================================================================
+// ANY THREAD
+
+void LLWorkScheduler::schedule(LLQueuedThread* queue, ELane lane)
+{
+	push(queue, lane, mNextWorker++ % mWorkers.size());
+}
+
+void LLWorkScheduler::push(LLQueuedThread* queue, ELane lane, S32 worker)
+{
+	Worker* workerp = mWorkers[worker];
+	workerp->mMutex.lock();
+	workerp->mLanes[lane].push_back(queue);
+	workerp->mMutex.unlock();
+
+	// A worker going to sleep counts itself before it checks mNumQueued,
+	// so either it sees this queue or we see it sleeping.
+	mNumQueued++;
+	if (mNumSleeping.CurrentValue() > 0)
+	{
+		mWorkCondition.lock();
+		mWorkCondition.signal();
+		mWorkCondition.unlock();
+	}
+}
+
+//============================================================================
+// WORKER THREADS
+
+LLQueuedThread* LLWorkScheduler::take(S32 worker)
+{
+	S32 num_workers = mWorkers.size();
+	for (S32 lane = 0; lane < LANE_COUNT; ++lane)
+	{
+		// own deque first, oldest queue first
+		Worker* workerp = mWorkers[worker];
+		LLQueuedThread* queue = NULL;
+		workerp->mMutex.lock();
+		if (!workerp->mLanes[lane].empty())
+		{
+			queue = workerp->mLanes[lane].front();
+			workerp->mLanes[lane].pop_front();
+		}
+		workerp->mMutex.unlock();
+
+		// then steal the newest from the others
+		for (S32 i = 1; !queue && i < num_workers; ++i)
+		{
+			Worker* victimp = mWorkers[(worker + i) % num_workers];
+			victimp->mMutex.lock();
+			if (!victimp->mLanes[lane].empty())
+			{
+				queue = victimp->mLanes[lane].back();
+				victimp->mLanes[lane].pop_back();
+			}
+			victimp->mMutex.unlock();
+		}
+
+		if (queue)
+		{
+			mNumQueued--;
+			return queue;
+		}
+	}
+	return NULL;
+}
+
+void LLWorkScheduler::waitForWork()
+{
+	mWorkCondition.lock();
+	mNumSleeping++;
+	while ((S32) mNumQueued.CurrentValue() <= 0 && !mQuitting.CurrentValue())
+	{
+		mWorkCondition.wait();
+	}
+	mNumSleeping--;
+	mWorkCondition.unlock();
+}
+
+LLWorkScheduler::Worker::Worker(LLWorkScheduler* scheduler, S32 index)
+:	LLThread(llformat("Work scheduler %d", index)),
+	mMutex(NULL),
+	mScheduler(scheduler),
+	mIndex(index)
+{
+}
+
+//virtual
+void LLWorkScheduler::Worker::run()
+{
+	while (!isQuitting() && !mScheduler->mQuitting.CurrentValue())
+	{
+		LLQueuedThread* queue = mScheduler->take(mIndex);
+		if (!queue)
+		{
+			mScheduler->waitForWork();
+			continue;
+		}
+
+		S32 lane = queue->runScheduled();
+		if (lane >= 0)
+		{
+			mScheduler->push(queue, (ELane) lane, mIndex);
+		}
+	}
+}
@@ -0,0 +1,122 @@
+/**
+ * @file llworkscheduler.h
+ * @brief Shared worker threads for the requests of LLQueuedThreads.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLWORKSCHEDULER_H
+#define LL_LLWORKSCHEDULER_H
+
+#include <deque>
+#include <vector>
+
+#include "llapr.h"
+#include "llmutex.h"
+#include "llthread.h"
+
+class LLQueuedThread;
+
+//============================================================================
+// A pool of worker threads shared by the LLQueuedThreads that are created
+// with scheduler workers, instead of each of them running (and polling) a
+// thread of its own.
+//
+// A queue with pending requests is pushed onto the deque of a worker, in
+// the lane of its most urgent request.  Workers take queues from the front
+// of their own deque, most urgent lane first, steal from the back of the
+// other workers' deques when there is nothing in that lane of their own,
+// and sleep on a condition when there is nothing to run anywhere.  A worker
+// runs a few of the queue's requests and pushes the queue back onto its own
+// deque if there are more, so busy queues take turns.
+//
+// A queue is in the deques at most as many times as it allows workers, so
+// a queue that allows one still runs its requests one at a time and in
+// priority order, just like on its own thread.
+//
+// Threads: initClass() and cleanupClass() on the main thread, schedule()
+// on any thread.
+
+class LL_COMMON_API LLWorkScheduler
+{
+public:
+	// for queues whose requests may all run at once
+	enum { ALL_WORKERS = 0x7FFFFFFF };
+
+	enum ELane
+	{
+		LANE_HIGH,		// PRIORITY_HIGH and up
+		LANE_NORMAL,
+		LANE_LOW,		// below PRIORITY_NORMAL
+		LANE_COUNT
+	};
+
+	// 0 workers for one per core but the main thread's
+	static void initClass(S32 num_workers = 0);
+	static void cleanupClass();
+
+	// NULL unless initClass() was called
+	static LLWorkScheduler* getInstance() { return sInstance; }
+
+	static ELane getLane(U32 priority);
+
+	S32 getNumWorkers() const { return (S32) mWorkers.size(); }
+
+	// queue it to have runScheduled() called by a worker
+	void schedule(LLQueuedThread* queue, ELane lane);
+
+private:
+	class Worker : public LLThread
+	{
+	public:
+		Worker(LLWorkScheduler* scheduler, S32 index);
+
+		/*virtual*/ void run();
+
+		LLMutex mMutex;
+		std::deque<LLQueuedThread*> mLanes[LANE_COUNT];
+
+	private:
+		LLWorkScheduler* mScheduler;
+		S32 mIndex;
+	};
+
+	LLWorkScheduler(S32 num_workers);
+	~LLWorkScheduler();
+
+	void push(LLQueuedThread* queue, ELane lane, S32 worker);
+	LLQueuedThread* take(S32 worker);
+	void waitForWork();
+
+	static S32 getNumCores();
+
+	std::vector<Worker*> mWorkers;
+	LLCondition mWorkCondition;
+	LLAtomicS32 mNumQueued;			// in all deques
+	LLAtomicS32 mNumSleeping;		// workers waiting on mWorkCondition
+	LLAtomicU32 mNextWorker;		// deque for pushes from outside the workers
+	LLAtomicU32 mQuitting;
+
+	static LLWorkScheduler* sInstance;
+};
+
+#endif // LL_LLWORKSCHEDULER_H
@@ -0,0 +1,196 @@
+/**
+ * @file llasyncfile_test.cpp
+ * @brief Tests of the LLAsyncFile requests.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Boost.Coroutine first, see lleventcoro_test.cpp
+#include <boost/dcoroutine/coroutine.hpp>
+#include <boost/bind.hpp>
+
+#include "linden_common.h"
+
+#include "../llasyncfile.h"
+
+#include "../test/lltut.h"
+#include "../test/namedtempfile.h"
+#include "../lltimer.h"
+
+#include <errno.h>
+
+namespace tut
+{
+	struct asyncfile_test
+	{
+		std::vector<LLSD> mReplies;
+
+		bool onReply(const LLSD& reply)
+		{
+			mReplies.push_back(reply);
+			return false;
+		}
+
+		// ticks "mainloop" like the viewer frames until the replies came
+		void waitForReplies(size_t count)
+		{
+			LLEventPump& mainloop(LLEventPumps::instance().obtain("mainloop"));
+			for (S32 i = 0; i < 5000 && mReplies.size() < count; ++i)
+			{
+				ms_sleep(1);
+				mainloop.post(LLSD());
+			}
+			ensure_equals("replies", mReplies.size(), count);
+		}
+
+		// posts the request and waits for its reply
+		LLSD request(LLSD event)
+		{
+			LLEventStream reply_pump("asyncfile_test", true);
+			LLTempBoundListener connection(
+				reply_pump.listen("asyncfile_test", boost::bind(&asyncfile_test::onReply, this, _1)));
+			event["reply"] = reply_pump.getName();
+			mReplies.clear();
+			LLAsyncFile::getInstance();
+			LLEventPumps::instance().obtain(LLAsyncFile::PUMP_NAME).post(event);
+			waitForReplies(1);
+			return mReplies[0];
+		}
+
+		static LLSD::Binary toBinary(const std::string& text)
+		{
+			return LLSD::Binary(text.begin(), text.end());
+		}
+
+		static std::string toString(const LLSD& data)
+		{
+			const LLSD::Binary& binary = data.asBinary();
+			return std::string(binary.begin(), binary.end());
+		}
+	};
+
+	typedef test_group<asyncfile_test> asyncfile_t;
+	typedef asyncfile_t::object asyncfile_object_t;
+	tut::asyncfile_t tut_asyncfile("LLAsyncFile");
+
+	template<> template<>
+	void asyncfile_object_t::test<1>()
+	{
+		set_test_name("read and write");
+
+		NamedTempFile file("asyncfile_", "");
+
+		LLSD write;
+		write["op"] = "write";
+		write["path"] = file.getName();
+		write["data"] = toBinary("0123456789");
+		write["truncate"] = true;
+		write["sync"] = true;
+		LLSD result = request(write);
+		ensure_equals("write status", result["status"].asInteger(), 0);
+		ensure_equals("write size", result["size"].asInteger(), 10);
+
+		LLSD read;
+		read["op"] = "read";
+		read["path"] = file.getName();
+		result = request(read);
+		ensure_equals("read status", result["status"].asInteger(), 0);
+		ensure_equals("read all", toString(result["data"]), std::string("0123456789"));
+
+		// over the middle, then appended
+		LLSD overwrite;
+		overwrite["op"] = "write";
+		overwrite["path"] = file.getName();
+		overwrite["offset"] = 4;
+		overwrite["data"] = toBinary("ab");
+		ensure_equals("overwrite status", request(overwrite)["status"].asInteger(), 0);
+		LLSD append;
+		append["op"] = "write";
+		append["path"] = file.getName();
+		append["data"] = toBinary("XY");
+		ensure_equals("append status", request(append)["status"].asInteger(), 0);
+
+		read["offset"] = 2;
+		read["size"] = 6;
+		result = request(read);
+		ensure_equals("read part", toString(result["data"]), std::string("23ab67"));
+		read.erase("size");
+		read["offset"] = 0;
+		ensure_equals("read again", toString(request(read)["data"]), std::string("0123ab6789XY"));
+
+		// short reads say so and return what there was
+		read["offset"] = 10;
+		read["size"] = 5;
+		result = request(read);
+		ensure_equals("short read status", result["status"].asInteger(), ERANGE);
+		ensure_equals("short read", toString(result["data"]), std::string("XY"));
+
+		LLSD sync;
+		sync["op"] = "sync";
+		sync["path"] = file.getName();
+		ensure_equals("sync status", request(sync)["status"].asInteger(), 0);
+	}
+
+	template<> template<>
+	void asyncfile_object_t::test<2>()
+	{
+		set_test_name("errors and many requests");
+
+		LLSD read;
+		read["op"] = "read";
+		read["path"] = "no/such/directory/file";
+		LLSD result = request(read);
+		ensure("missing file", result["status"].asInteger() != 0);
+		ensure_equals("nothing read", result["size"].asInteger(), 0);
+
+		LLSD unknown;
+		unknown["op"] = "frobnicate";
+		unknown["path"] = "whatever";
+		ensure_equals("unknown op", request(unknown)["status"].asInteger(), EINVAL);
+
+		// all in flight at once, the replies come back in any order
+		NamedTempFile file("asyncfile_", "some file contents");
+		LLEventStream reply_pump("asyncfile_test", true);
+		LLTempBoundListener connection(
+			reply_pump.listen("asyncfile_test", boost::bind(&asyncfile_test::onReply, this, _1)));
+		mReplies.clear();
+		for (S32 i = 0; i < 20; ++i)
+		{
+			LLSD event(read);
+			event["path"] = file.getName();
+			event["offset"] = i % 5;
+			event["reqid"] = i;
+			event["reply"] = reply_pump.getName();
+			LLEventPumps::instance().obtain(LLAsyncFile::PUMP_NAME).post(event);
+		}
+		waitForReplies(20);
+		std::vector<bool> seen(20, false);
+		for (S32 i = 0; i < 20; ++i)
+		{
+			S32 reqid = mReplies[i]["reqid"].asInteger();
+			ensure("reqid", reqid >= 0 && reqid < 20 && !seen[reqid]);
+			seen[reqid] = true;
+			ensure_equals("contents", toString(mReplies[i]["data"]), std::string("some file contents").substr(reqid % 5));
+		}
+		ensure_equals("none pending", LLAsyncFile::getInstance()->getPending(), 0);
+	}
+}
@@ -768,6 +768,65 @@ namespace tut
 		ensure_message_contains(8, "big easy");
 		ensure_message_count(9);
 	}
+
+	template<> template<>
+		// messages handed to the writer thread arrive in order
+	void ErrorTestObject::test<17>()
+	{
+		LLError::setAsyncLogging(true);
+		ensure("async logging", LLError::isAsyncLogging());
+
+		for (int i = 0; i < 100; ++i)
+		{
+			LL_INFOS() << "queued " << i << LL_ENDL;
+		}
+		LLError::flushAsyncLog();
+		LLError::setAsyncLogging(false);
+		ensure("async logging off", !LLError::isAsyncLogging());
+
+		ensure_message_count(100);
+		for (int i = 0; i < 100; ++i)
+		{
+			std::ostringstream text;
+			text << "queued " << i;
+			ensure_message_contains(i, text.str());
+		}
+	}
+
+	template<> template<>
+		// errors go out after what is queued, recorders change meanwhile
+	void ErrorTestObject::test<18>()
+	{
+		LLError::setAsyncLogging(true);
+
+		LLError::RecorderPtr other(new TestRecorder());
+		for (int i = 0; i < 50; ++i)
+		{
+			LL_INFOS() << "queued " << i << LL_ENDL;
+			if (i % 10 == 0)
+			{
+				LLError::addRecorder(other);
+			}
+			else if (i % 10 == 5)
+			{
+				LLError::removeRecorder(other);
+			}
+		}
+		LL_ERRS() << "error after the queue" << LL_ENDL;
+		ensure("fatal called", fatalWasCalled);
+
+		LLError::setAsyncLogging(false);
+
+		ensure_message_count(52);
+		for (int i = 0; i < 50; ++i)
+		{
+			std::ostringstream text;
+			text << "queued " << i;
+			ensure_message_contains(i, text.str());
+		}
+		ensure_message_contains(50, "error");
+		ensure_message_contains(51, "error after the queue");
+	}
 }
 
 /* Tests left:
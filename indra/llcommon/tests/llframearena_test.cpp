@@ -0,0 +1,168 @@
+/**
+ * @file llframearena_test.cpp
+ * @brief Tests of LLFrameArena and LLFrameAllocator.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llframearena.h"
+
+#include "../test/lltut.h"
+
+#include <list>
+#include <map>
+#include <vector>
+
+namespace tut
+{
+	struct framearena_test
+	{
+	};
+
+	typedef test_group<framearena_test> framearena_t;
+	typedef framearena_t::object framearena_object_t;
+	tut::framearena_t tut_framearena("LLFrameArena");
+
+	template<> template<>
+	void framearena_object_t::test<1>()
+	{
+		set_test_name("blocks and frames");
+
+		LLFrameArena arena;
+		char* first = (char*) arena.allocate(10);
+		char* second = (char*) arena.allocate(100, 64);
+		ensure("first", first != NULL);
+		ensure("after the first", second >= first + 10);
+		ensure("aligned", ((uintptr_t) second & 63) == 0);
+		ensure("bytes", arena.getFrameBytes() >= 110);
+
+		// the last one goes back, the others stay
+		arena.deallocate(second, 100);
+		ensure("same again", arena.allocate(100, 64) == second);
+		arena.deallocate(first, 10);
+		ensure("not the last", arena.allocate(1) != first);
+
+		// the frame before stays valid for a frame
+		memset(first, 'a', 10);
+		arena.endFrame();
+		char* other = (char*) arena.allocate(10);
+		ensure("other block", other != first);
+		memset(other, 'b', 10);
+		ensure_equals("kept", first[9], 'a');
+
+		// once the blocks are there, they come back every other frame
+		arena.endFrame();
+		char* reset = (char*) arena.allocate(10);
+		arena.endFrame();
+		arena.endFrame();
+		ensure("block reused", arena.allocate(10) == reset);
+	}
+
+	template<> template<>
+	void framearena_object_t::test<2>()
+	{
+		set_test_name("no heap allocations once warm");
+
+		LLFrameArena arena;
+		for (U32 frame = 0; frame < 10; ++frame)
+		{
+			// more than the first chunk, every frame
+			for (U32 i = 0; i < 100; ++i)
+			{
+				arena.allocate(4000);
+			}
+			if (frame == 4)
+			{
+				U32 warm = arena.getHeapAllocations();
+				ensure("grown", arena.getCapacity() >= 2 * 400000);
+				for (U32 rest = frame; rest < 9; ++rest)
+				{
+					arena.endFrame();
+					for (U32 i = 0; i < 100; ++i)
+					{
+						arena.allocate(4000);
+					}
+				}
+				ensure_equals("steady", arena.getHeapAllocations(), warm);
+				break;
+			}
+			arena.endFrame();
+		}
+	}
+
+	template<> template<>
+	void framearena_object_t::test<3>()
+	{
+		set_test_name("containers");
+
+		LLFrameArena& arena = LLFrameArena::getThreadArena();
+		ensure("one per thread", &arena == &LLFrameArena::getThreadArena());
+
+		{
+			std::vector<U32, LLFrameAllocator<U32> > numbers;
+			for (U32 i = 0; i < 1000; ++i)
+			{
+				numbers.push_back(i);
+			}
+			ensure_equals("vector", numbers[999], (U32) 999);
+
+			std::list<F32, LLFrameAllocator<F32> > values;
+			values.push_back(1.f);
+			values.push_back(2.f);
+			values.pop_front();
+			ensure_equals("list", values.front(), 2.f);
+
+			typedef std::map<U32, std::string, std::less<U32>, LLFrameAllocator<std::pair<const U32, std::string> > > name_map_t;
+			name_map_t names;
+			names[3] = "three";
+			names[1] = "one";
+			ensure_equals("map", names.begin()->second, std::string("one"));
+			ensure("from the arena", arena.getFrameBytes() >= 1000 * sizeof(U32));
+		}
+		arena.endFrame();
+		arena.endFrame();
+		ensure_equals("reset", arena.getFrameBytes(), (size_t) 0);
+	}
+
+	template<> template<>
+	void framearena_object_t::test<4>()
+	{
+		set_test_name("heap allocation counter");
+
+		LLFrameArena arena;
+		LLHeapAllocationCounter outer;
+		void* block = ll_aligned_malloc_16(64);
+		ensure_equals("aligned malloc", outer.getAllocations(), (U32) 1);
+		ll_aligned_free_16(block);
+		{
+			LLHeapAllocationCounter inner;
+			// the first allocation overflows into a heap chunk
+			arena.allocate(10);
+			arena.allocate(10);
+			ensure_equals("arena chunk", inner.getAllocations(), arena.getHeapAllocations());
+			ensure_equals("innermost only", outer.getAllocations(), (U32) 1);
+		}
+		ensure_equals("passed on", outer.getAllocations(), (U32) 1 + arena.getHeapAllocations());
+	}
+}
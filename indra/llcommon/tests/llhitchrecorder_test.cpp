@@ -0,0 +1,127 @@
+/**
+ * @file llhitchrecorder_test.cpp
+ * @brief Tests of the hitch snapshot analysis.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llhitchrecorder.h"
+
+#include "../llsdserialize.h"
+#include "../test/lltut.h"
+#include "../test/namedtempfile.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace tut
+{
+	struct hitchrecorder
+	{
+		// a frame of the snapshot format, timers are slot, microseconds,
+		// self microseconds, calls and counts are slot, value
+		LLSD makeFrame(F64 seconds, S32 render_self_us, S32 decode_self_us, F64 packets, F64 fetches)
+		{
+			LLSD frame;
+			frame["Seconds"] = seconds;
+			frame["Timers"].append(0);
+			frame["Timers"].append(render_self_us + decode_self_us);
+			frame["Timers"].append(render_self_us);
+			frame["Timers"].append(1);
+			frame["Timers"].append(1);
+			frame["Timers"].append(decode_self_us);
+			frame["Timers"].append(decode_self_us);
+			frame["Timers"].append(3);
+			frame["Counts"].append(0);
+			frame["Counts"].append(packets);
+			frame["Gauges"].append(fetches);
+			return frame;
+		}
+
+		LLSD makeSnapshot(S32 hitch_decode_us)
+		{
+			LLSD snapshot;
+			snapshot["Version"] = 1;
+			LLSD render;
+			render["Name"] = "Render";
+			render["Parent"] = "Frame";
+			snapshot["Timers"].append(render);
+			LLSD decode;
+			decode["Name"] = "Image Decode";
+			decode["Parent"] = "Render";
+			snapshot["Timers"].append(decode);
+			snapshot["Counts"].append("Packets In");
+			snapshot["Gauges"].append("Texture Fetches");
+			for (S32 i = 0; i < 4; ++i)
+			{
+				snapshot["Frames"].append(makeFrame(0.02, 10000, 2000, 10.0, 5.0));
+			}
+			snapshot["Frames"].append(makeFrame(0.3, 12000, hitch_decode_us, 10.0, 40.0));
+			return snapshot;
+		}
+
+		std::string toBinary(const LLSD& sd)
+		{
+			std::ostringstream os;
+			LLSDSerialize::serialize(sd, os, LLSDSerialize::LLSD_BINARY);
+			return os.str();
+		}
+
+		std::string readFile(const std::string& filename)
+		{
+			std::ifstream is(filename.c_str());
+			std::ostringstream contents;
+			contents << is.rdbuf();
+			return contents.str();
+		}
+	};
+
+	typedef test_group<hitchrecorder> hitchrecorder_t;
+	typedef hitchrecorder_t::object hitchrecorder_object_t;
+	tut::hitchrecorder_t tut_hitchrecorder("LLHitchRecorder");
+
+	template<> template<>
+	void hitchrecorder_object_t::test<1>()
+	{
+		set_test_name("hitch analysis");
+
+		NamedTempFile first("hitch_", toBinary(makeSnapshot(250000)));
+		NamedTempFile second("hitch_", toBinary(makeSnapshot(90000)));
+		NamedTempFile unreadable("hitch_", "not a snapshot");
+		NamedTempFile report("hitch_report", "");
+
+		std::vector<std::string> snapshots;
+		snapshots.push_back(first.getName());
+		snapshots.push_back(second.getName());
+		snapshots.push_back(unreadable.getName());
+		LLHitchRecorder::doAnalysisHitches(snapshots, report.getName());
+
+		std::string contents = readFile(report.getName());
+		ensure("frame row", contents.find("Frame, Frame (ms), 300, 20, 280") != std::string::npos);
+		ensure("decode ahead of render", contents.find("Image Decode, 250, 2, 248") < contents.find("Render, 12, 10, 2"));
+		ensure("unchanged count left out", contents.find("Packets In") == std::string::npos);
+		ensure("gauge row", contents.find("Gauge, Texture Fetches, 40, 5, 35") != std::string::npos);
+		ensure("summary", contents.find("Image Decode, 2, 336") != std::string::npos);
+	}
+}
@@ -0,0 +1,324 @@
+/**
+ * @file lllockfreequeue_test.cpp
+ * @brief Tests and contention benchmark of the lock-free queues.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lllockfreequeue.h"
+#include "../llthreadsafequeue.h"
+
+#include "../test/lltut.h"
+#include "../llthread.h"
+#include "../lltimer.h"
+
+#include <deque>
+#include <vector>
+
+// The queues behind a common interface for the threaded runs, pop()
+// returns NULL when there's nothing to pop.  size is the segment size or
+// the capacity.
+class LockFreeAdapter
+{
+public:
+	LockFreeAdapter(U32 size) : mQueue(size) {}
+	static const char* getName() { return "LLLockFreeQueue"; }
+	void push(U32* element) { mQueue.push(element); }
+	U32* pop() { return mQueue.pop(); }
+private:
+	LLLockFreeQueue<U32> mQueue;
+};
+
+class BoundedAdapter
+{
+public:
+	BoundedAdapter(U32 size) : mQueue(size) {}
+	static const char* getName() { return "LLBoundedMPMCQueue"; }
+	void push(U32* element)
+	{
+		while (!mQueue.tryPush(element))
+		{
+			LLThread::yield();
+		}
+	}
+	U32* pop()
+	{
+		U32* element = NULL;
+		mQueue.tryPop(element);
+		return element;
+	}
+private:
+	LLBoundedMPMCQueue<U32*> mQueue;
+};
+
+class LockedAdapter
+{
+public:
+	LockedAdapter(U32 size) : mMutex(NULL) {}
+	static const char* getName() { return "LLMutex and std::deque"; }
+	void push(U32* element)
+	{
+		LLMutexLock lock(&mMutex);
+		mQueue.push_back(element);
+	}
+	U32* pop()
+	{
+		LLMutexLock lock(&mMutex);
+		if (mQueue.empty())
+		{
+			return NULL;
+		}
+		U32* element = mQueue.front();
+		mQueue.pop_front();
+		return element;
+	}
+private:
+	LLMutex mMutex;
+	std::deque<U32*> mQueue;
+};
+
+template <typename QueueT>
+class ProducerThread : public LLThread
+{
+public:
+	ProducerThread(QueueT& queue, U32* elements, U32 count)
+	:	LLThread("Producer"),
+		mQueue(queue),
+		mElements(elements),
+		mCount(count)
+	{
+	}
+
+	/*virtual*/ void run()
+	{
+		for (U32 i = 0; i < mCount; ++i)
+		{
+			mQueue.push(&mElements[i]);
+		}
+	}
+
+private:
+	QueueT& mQueue;
+	U32* mElements;
+	U32 mCount;
+};
+
+template <typename QueueT>
+class ConsumerThread : public LLThread
+{
+public:
+	ConsumerThread(QueueT& queue, volatile U32& popped, U32 total)
+	:	LLThread("Consumer"),
+		mQueue(queue),
+		mPopped(popped),
+		mTotal(total)
+	{
+	}
+
+	/*virtual*/ void run()
+	{
+		while (LLLockFree::load(&mPopped) < mTotal)
+		{
+			U32* element = mQueue.pop();
+			if (!element)
+			{
+				LLThread::yield();
+				continue;
+			}
+			// each element counts how often it came out
+			++*element;
+			LLLockFree::fetchAdd(&mPopped, 1);
+		}
+	}
+
+private:
+	QueueT& mQueue;
+	volatile U32& mPopped;
+	U32 mTotal;
+};
+
+namespace tut
+{
+	struct lockfreequeue_test
+	{
+		// Runs the producers and as many consumers, checks that every element
+		// came out once and returns elements per second.
+		template <typename QueueT>
+		F64 runThreads(U32 num_threads, U32 queue_size, U32 elements_per_producer)
+		{
+			QueueT queue(queue_size);
+			U32 total = num_threads * elements_per_producer;
+			std::vector<U32> elements(total, 0);
+			volatile U32 popped = 0;
+
+			std::vector<LLThread*> threads;
+			for (U32 i = 0; i < num_threads; ++i)
+			{
+				threads.push_back(new ProducerThread<QueueT>(queue, &elements[i * elements_per_producer], elements_per_producer));
+				threads.push_back(new ConsumerThread<QueueT>(queue, popped, total));
+			}
+
+			LLTimer timer;
+			for (U32 i = 0; i < threads.size(); ++i)
+			{
+				threads[i]->start();
+			}
+			for (U32 i = 0; i < threads.size(); ++i)
+			{
+				while (!threads[i]->isStopped())
+				{
+					ms_sleep(1);
+				}
+			}
+			F64 seconds = timer.getElapsedTimeF64();
+
+			for (U32 i = 0; i < threads.size(); ++i)
+			{
+				delete threads[i];
+			}
+
+			ensure_equals(std::string(QueueT::getName()) + " popped", (U32) popped, total);
+			for (U32 i = 0; i < total; ++i)
+			{
+				if (elements[i] != 1)
+				{
+					ensure_equals(std::string(QueueT::getName()) + " element popped once", elements[i], (U32) 1);
+				}
+			}
+			return seconds > 0.0 ? total / seconds : 0.0;
+		}
+	};
+
+	typedef test_group<lockfreequeue_test> lockfreequeue_t;
+	typedef lockfreequeue_t::object lockfreequeue_object_t;
+	tut::lockfreequeue_t tut_lockfreequeue("LLLockFreeQueue");
+
+	template<> template<>
+	void lockfreequeue_object_t::test<1>()
+	{
+		set_test_name("LLBoundedMPMCQueue");
+
+		LLBoundedMPMCQueue<S32> queue(5);
+		ensure_equals("rounded capacity", queue.getCapacity(), (U32) 8);
+
+		S32 element = 0;
+		ensure("empty", !queue.tryPop(element));
+		for (S32 lap = 0; lap < 3; ++lap)
+		{
+			for (S32 i = 0; i < 8; ++i)
+			{
+				ensure("push", queue.tryPush(lap * 8 + i));
+			}
+			ensure("full", !queue.tryPush(-1));
+			ensure_equals("size", queue.size(), (U32) 8);
+			for (S32 i = 0; i < 8; ++i)
+			{
+				ensure("pop", queue.tryPop(element));
+				ensure_equals("in order", element, lap * 8 + i);
+			}
+			ensure("drained", !queue.tryPop(element));
+		}
+	}
+
+	template<> template<>
+	void lockfreequeue_object_t::test<2>()
+	{
+		set_test_name("LLLockFreeQueue");
+
+		LLLockFreeQueue<S32> queue(4);
+		ensure("empty", queue.pop() == NULL);
+
+		// enough for a few segments, popping some on the way
+		S32 elements[22];
+		S32 next_pop = 0;
+		for (S32 i = 0; i < 22; ++i)
+		{
+			elements[i] = i;
+			queue.push(&elements[i]);
+			if (i % 3 == 2)
+			{
+				ensure_equals("interleaved", *queue.pop(), next_pop++);
+			}
+		}
+		ensure_equals("size", queue.size(), (U32) (22 - next_pop));
+		while (S32* element = queue.pop())
+		{
+			ensure_equals("in order", *element, next_pop++);
+		}
+		ensure_equals("all popped", next_pop, 22);
+		ensure("empty again", queue.empty());
+
+		queue.push(&elements[0]);
+		ensure_equals("reused", queue.pop(), &elements[0]);
+	}
+
+	template<> template<>
+	void lockfreequeue_object_t::test<3>()
+	{
+		set_test_name("LLThreadSafeQueue");
+
+		LLThreadSafeQueue<std::string>* queue = new LLThreadSafeQueue<std::string>(2);
+		std::string element;
+		ensure("empty", !queue->tryPopBack(element));
+
+		queue->pushFront("one");
+		ensure("try push", queue->tryPushFront("two"));
+		queue->pushFront("three");
+		ensure_equals("size", queue->size(), (size_t) 3);
+		ensure_equals("pop", queue->popBack(), std::string("one"));
+		ensure("try pop", queue->tryPopBack(element));
+		ensure_equals("in order", element, std::string("two"));
+
+		// the rest is discarded
+		delete queue;
+	}
+
+	template<> template<>
+	void lockfreequeue_object_t::test<4>()
+	{
+		set_test_name("threads");
+
+		// small segments, for lots of them to be retired while others pop
+		runThreads<LockFreeAdapter>(4, 8, 2000);
+		runThreads<BoundedAdapter>(4, 64, 2000);
+		runThreads<LockedAdapter>(4, 0, 2000);
+	}
+
+	template<> template<>
+	void lockfreequeue_object_t::test<5>()
+	{
+		set_test_name("contention");
+
+		for (U32 num_threads = 1; num_threads <= 16; num_threads *= 2)
+		{
+			F64 lock_free = runThreads<LockFreeAdapter>(num_threads, 1024, 20000);
+			F64 bounded = runThreads<BoundedAdapter>(num_threads, 1024, 20000);
+			F64 locked = runThreads<LockedAdapter>(num_threads, 0, 20000);
+			LL_INFOS() << num_threads << " producers and consumers, elements per second: "
+					   << LockFreeAdapter::getName() << " " << (S32) lock_free << ", "
+					   << BoundedAdapter::getName() << " " << (S32) bounded << ", "
+					   << LockedAdapter::getName() << " " << (S32) locked << LL_ENDL;
+		}
+	}
+}
@@ -50,6 +50,8 @@ typedef U32 uint32_t;
 #include "boost/lambda/bind.hpp"
 namespace lambda = boost::lambda;
 
+#include <set>
+
 #include "../llsd.h"
 #include "../llsdserialize.h"
 #include "llsdutil.h"
@@ -1505,6 +1507,148 @@ namespace tut
 		ensureBinaryAndXML("map", test);
 	}
 
+	/**
+	 * @class TestLLSDBinaryView
+	 * @brief Reading binary serialized LLSD in place.
+	 */
+	struct TestLLSDBinaryView
+	{
+		TestLLSDBinaryView() {}
+
+		std::string serialize(const LLSD& sd)
+		{
+			std::ostringstream str;
+			LLSDSerialize::toBinary(sd, str);
+			return str.str();
+		}
+
+		LLSD makeFace()
+		{
+			LLSD face;
+			face["Count"] = 42;
+			face["Scale"] = -2.5;
+			face["Name"] = "face";
+			face["Flag"] = true;
+			std::vector<U8> bin;
+			for (U8 i = 0; i < 7; ++i)
+			{
+				bin.push_back(i*3);
+			}
+			face["Data"] = bin;
+			face["Domain"]["Min"].append(-1.0);
+			face["Domain"]["Min"].append(0.5);
+			face["Domain"]["Max"].append(2);
+			face["Empty"] = LLSD::emptyArray();
+			return face;
+		}
+	};
+
+	typedef tut::test_group<TestLLSDBinaryView> TestLLSDBinaryViewGroup;
+	typedef TestLLSDBinaryViewGroup::object TestLLSDBinaryViewObject;
+	TestLLSDBinaryViewGroup gTestLLSDBinaryViewGroup(
+		"llsd binary view");
+
+	template<> template<> 
+	void TestLLSDBinaryViewObject::test<1>()
+	{
+		LLSD faces;
+		faces.append(makeFace());
+		faces.append(LLSD::emptyMap());
+		std::string buf = serialize(faces);
+
+		LLSDBinaryView view((const U8*) buf.data(), buf.size());
+		ensure("array", view.isArray());
+		ensure_equals("array size", view.size(), 2);
+
+		LLSDBinaryView face = view[0];
+		ensure("map", face.isMap());
+		ensure_equals("map size", face.size(), faces[0].size());
+		ensure_equals("integer", face["Count"].asInteger(), 42);
+		ensure_equals("real", face["Scale"].asReal(), -2.5);
+		ensure_equals("string", face["Name"].asString(), std::string("face"));
+		ensure("boolean", face["Flag"].asBoolean());
+		ensure("has", face.has("Empty"));
+		ensure("missing key", !face.has("Missing"));
+		ensure("missing value", !face["Missing"].isDefined());
+		ensure("empty array has no elements", !face["Empty"].first().isDefined());
+
+		LLSDBinaryView data = face["Data"];
+		ensure("binary", data.isBinary());
+		ensure_equals("binary size", data.size(), 7);
+		std::vector<U8> expected = faces[0]["Data"].asBinary();
+		ensure_memory_matches("binary data", data.binaryData(), data.size(), &expected[0], expected.size());
+
+		LLSDBinaryView domain = face["Domain"];
+		ensure_equals("nested real", domain["Min"][1].asReal(), 0.5);
+		ensure_equals("integer as real", domain["Max"][0].asReal(), 2.0);
+		ensure("index out of range", !domain["Max"][1].isDefined());
+
+		ensure("empty map", view[1].isMap());
+		ensure_equals("empty map size", view[1].size(), 0);
+		ensure("past the end", !view[2].isDefined());
+	}
+
+	template<> template<> 
+	void TestLLSDBinaryViewObject::test<2>()
+	{
+		LLSD face = makeFace();
+		std::string buf = serialize(face);
+
+		// walk every key in order
+		std::set<std::string> keys;
+		for (LLSDBinaryView child = LLSDBinaryView((const U8*) buf.data(), buf.size()).first();
+			 child.isDefined();
+			 child = child.next())
+		{
+			keys.insert(child.key());
+		}
+
+		ensure_equals("all keys visited", keys.size(), face.size());
+		for (LLSD::map_const_iterator iter = face.beginMap(); iter != face.endMap(); ++iter)
+		{
+			ensure(iter->first, keys.count(iter->first) == 1);
+		}
+	}
+
+	template<> template<> 
+	void TestLLSDBinaryViewObject::test<3>()
+	{
+		// truncated and corrupt data are rejected rather than overrun
+		std::string buf = serialize(makeFace());
+		for (size_t len = 0; len < buf.size(); ++len)
+		{
+			LLSDBinaryView view((const U8*) buf.data(), len);
+			ensure("truncated data is undefined", !view.isDefined());
+		}
+
+		std::string bad = buf;
+		bad[0] = 'Q';
+		ensure("bad type is undefined", !LLSDBinaryView((const U8*) bad.data(), bad.size()).isDefined());
+	}
+
+	template<> template<> 
+	void TestLLSDBinaryViewObject::test<4>()
+	{
+		// zipped blocks inflate to the same serialized bytes
+		LLSD face = makeFace();
+		std::string zipped = zip_llsd(face);
+		ensure("zip_llsd", !zipped.empty());
+
+		std::vector<U8> bytes;
+		ensure("unzip_llsd_bytes", unzip_llsd_bytes(bytes, (const U8*) zipped.data(), zipped.size()));
+
+		LLSDBinaryView view(&bytes[0], bytes.size());
+		ensure_equals("unzipped integer", view["Count"].asInteger(), 42);
+		ensure_equals("unzipped string", view["Name"].asString(), std::string("face"));
+
+		std::istringstream istr(zipped);
+		LLSD unzipped;
+		ensure("unzip_llsd", unzip_llsd(unzipped, istr, zipped.size()));
+		ensure_equals("unzip_llsd round trip", unzipped["Count"].asInteger(), 42);
+
+		ensure("corrupt block", !unzip_llsd_bytes(bytes, (const U8*) zipped.data(), zipped.size()/2));
+	}
+
     struct TestPythonCompatible
     {
         TestPythonCompatible():
@@ -0,0 +1,196 @@
+/**
+ * @file llslaballocator_test.cpp
+ * @brief Tests of LLSlabPool and LLSlabAllocated.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llslaballocator.h"
+
+#include "../test/lltut.h"
+#include "../llthread.h"
+#include "../lltimer.h"
+
+#include <set>
+#include <vector>
+
+namespace tut
+{
+	typedef LLSlabPool<40, 16> test_pool_t;
+
+	class SlabObject : public LLSlabAllocated<SlabObject, 16>
+	{
+	public:
+		SlabObject(U32 value) : mValue(value) {}
+		virtual ~SlabObject() {}
+
+		U32 mValue;
+	};
+
+	// too big for the SlabObject blocks
+	class BigSlabObject : public SlabObject
+	{
+	public:
+		BigSlabObject(U32 value) : SlabObject(value) { memset(mPadding, 0xff, sizeof(mPadding)); }
+
+		U8 mPadding[256];
+	};
+
+	// allocates, writes, checks and frees in rounds, some of the blocks
+	// going to the other threads' caches through the shared list
+	class SlabWorker : public LLThread
+	{
+	public:
+		SlabWorker(U32 id)
+		:	LLThread("SlabWorker"),
+			mID(id),
+			mCorrupted(0)
+		{
+		}
+
+		virtual void run()
+		{
+			std::vector<U32*> blocks;
+			for (U32 round = 0; round < 200; ++round)
+			{
+				for (U32 i = 0; i < 100; ++i)
+				{
+					U32* block = (U32*) test_pool_t::instance().allocate();
+					block[0] = mID;
+					block[1] = round;
+					block[2] = i;
+					blocks.push_back(block);
+				}
+				for (U32 i = 0; i < blocks.size(); ++i)
+				{
+					if (blocks[i][0] != mID || blocks[i][1] != round || blocks[i][2] != i)
+					{
+						++mCorrupted;
+					}
+					test_pool_t::instance().freeMem(blocks[i]);
+				}
+				blocks.clear();
+			}
+		}
+
+		U32 mID;
+		U32 mCorrupted;
+	};
+
+	struct slaballocator_test
+	{
+	};
+
+	typedef test_group<slaballocator_test> slaballocator_t;
+	typedef slaballocator_t::object slaballocator_object_t;
+	tut::slaballocator_t tut_slaballocator("LLSlabAllocator");
+
+	template<> template<>
+	void slaballocator_object_t::test<1>()
+	{
+		set_test_name("blocks");
+
+		ensure_equals("stride", (U32) test_pool_t::BLOCK_STRIDE, (U32) 48);
+		ensure_equals("tiny stride", (U32) LLSlabPool<1, 8>::BLOCK_STRIDE, (U32) (2 * sizeof(void*)));
+
+		test_pool_t& pool = test_pool_t::instance();
+		ensure("one pool", &pool == &test_pool_t::instance());
+
+		std::vector<void*> blocks;
+		std::set<void*> unique;
+		for (U32 i = 0; i < 5000; ++i)
+		{
+			void* block = pool.allocate();
+			ensure("aligned", ((uintptr_t) block & 15) == 0);
+			ensure("unique", unique.insert(block).second);
+			memset(block, 0xaa, 40);
+			blocks.push_back(block);
+		}
+		U32 slabs = pool.getSlabCount();
+		ensure("enough slabs", (size_t) slabs * test_pool_t::SLAB_BYTES >= 5000 * test_pool_t::BLOCK_STRIDE);
+		ensure_equals("slab bytes", pool.getSlabBytes(), (size_t) slabs * test_pool_t::SLAB_BYTES);
+
+		// freed blocks are used again before any new slab
+		for (U32 i = 0; i < blocks.size(); ++i)
+		{
+			pool.freeMem(blocks[i]);
+		}
+		pool.freeMem(NULL);
+		for (U32 i = 0; i < blocks.size(); ++i)
+		{
+			void* block = pool.allocate();
+			ensure("reused", unique.count(block) == 1);
+			blocks[i] = block;
+		}
+		ensure_equals("no new slabs", pool.getSlabCount(), slabs);
+		for (U32 i = 0; i < blocks.size(); ++i)
+		{
+			pool.freeMem(blocks[i]);
+		}
+	}
+
+	template<> template<>
+	void slaballocator_object_t::test<2>()
+	{
+		set_test_name("threads");
+
+		std::vector<SlabWorker*> workers;
+		for (U32 i = 0; i < 4; ++i)
+		{
+			workers.push_back(new SlabWorker(i));
+			workers.back()->start();
+		}
+		for (U32 i = 0; i < workers.size(); ++i)
+		{
+			while (!workers[i]->isStopped())
+			{
+				ms_sleep(1);
+			}
+			ensure_equals("corrupted", workers[i]->mCorrupted, (U32) 0);
+			delete workers[i];
+		}
+	}
+
+	template<> template<>
+	void slaballocator_object_t::test<3>()
+	{
+		set_test_name("LLSlabAllocated");
+
+		typedef LLSlabPool<sizeof(SlabObject), 16> object_pool_t;
+		SlabObject* object = new SlabObject(7);
+		ensure("aligned", ((uintptr_t) object & 15) == 0);
+		ensure("from the pool", object_pool_t::instance().getSlabCount() > 0);
+		delete object;
+
+		// the freed block is the next one out
+		SlabObject* again = new SlabObject(8);
+		ensure("same block", again == object);
+
+		// derived classes that don't fit go to the heap, and back there
+		SlabObject* big = new BigSlabObject(9);
+		ensure_equals("big value", big->mValue, (U32) 9);
+		delete big;
+		delete again;
+	}
+}
@@ -0,0 +1,176 @@
+/**
+ * @file llstringpool_test.cpp
+ * @brief Tests of LLStringPool.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llstringpool.h"
+#include "../llstringtable.h"
+
+#include "../test/lltut.h"
+#include "../llformat.h"
+#include "../llthread.h"
+#include "../lltimer.h"
+
+#include <vector>
+
+namespace tut
+{
+	// looks the names up over and over while the main thread interns more
+	class StringPoolReader : public LLThread
+	{
+	public:
+		StringPoolReader(LLStringPool& pool, const std::vector<std::string>& names)
+		:	LLThread("StringPoolReader"),
+			mPool(pool),
+			mNames(names),
+			mMismatches(0)
+		{
+		}
+
+		virtual void run()
+		{
+			for (U32 pass = 0; pass < 20; ++pass)
+			{
+				for (U32 i = 0; i < mNames.size(); ++i)
+				{
+					LLStringPool::handle_t handle = mPool.find(mNames[i]);
+					if (handle && (handle != i + 1 || mNames[i] != mPool.getString(handle)))
+					{
+						++mMismatches;
+					}
+				}
+			}
+		}
+
+		LLStringPool& mPool;
+		const std::vector<std::string>& mNames;
+		U32 mMismatches;
+	};
+
+	struct stringpool_test
+	{
+	};
+
+	typedef test_group<stringpool_test> stringpool_t;
+	typedef stringpool_t::object stringpool_object_t;
+	tut::stringpool_t tut_stringpool("LLStringPool");
+
+	template<> template<>
+	void stringpool_object_t::test<1>()
+	{
+		set_test_name("intern and find");
+
+		LLStringPool pool;
+		ensure_equals("empty", pool.size(), (U32) 0);
+		ensure_equals("not found in empty", pool.find("AgentData"), (LLStringPool::handle_t) 0);
+		ensure_equals("NULL", pool.intern((const char*) NULL), (LLStringPool::handle_t) 0);
+		ensure("NULL string", pool.getString(0) == NULL);
+
+		LLStringPool::handle_t agent_data = pool.intern("AgentData");
+		LLStringPool::handle_t agent_id = pool.intern(std::string("AgentID"));
+		ensure_equals("first handle", agent_data, (LLStringPool::handle_t) 1);
+		ensure_equals("second handle", agent_id, (LLStringPool::handle_t) 2);
+		ensure_equals("same handle", pool.intern("AgentData"), agent_data);
+		ensure_equals("found", pool.find(std::string("AgentID")), agent_id);
+		ensure_equals("prefix not found", pool.find("Agent"), (LLStringPool::handle_t) 0);
+		ensure_equals("string", std::string(pool.getString(agent_id)), std::string("AgentID"));
+		ensure_equals("length", pool.getLength(agent_data), (U32) 9);
+
+		// embedded nulls and the empty string are strings too
+		LLStringPool::handle_t empty = pool.intern("");
+		ensure("empty handle", empty != 0);
+		ensure_equals("empty string", std::string(pool.getString(empty)), std::string());
+		LLStringPool::handle_t with_null = pool.intern("a\0b", 3);
+		ensure("embedded null", with_null != pool.intern("a"));
+
+		// enough to grow the index and entries several times, the first
+		// strings don't move
+		const char* first = pool.getString(agent_data);
+		for (U32 i = 0; i < 20000; ++i)
+		{
+			std::string name = llformat("Name%u", i);
+			LLStringPool::handle_t handle = pool.intern(name);
+			ensure_equals("sequential", handle, (LLStringPool::handle_t) (i + 6));
+		}
+		ensure_equals("size", pool.size(), (U32) 20005);
+		ensure("stable", pool.getString(agent_data) == first);
+		for (U32 i = 0; i < 20000; ++i)
+		{
+			ensure_equals("found again", pool.find(llformat("Name%u", i)), (LLStringPool::handle_t) (i + 6));
+		}
+		ensure("memory", pool.getMemoryUsage() > 20000 * 5);
+	}
+
+	template<> template<>
+	void stringpool_object_t::test<2>()
+	{
+		set_test_name("concurrent lookups");
+
+		std::vector<std::string> names;
+		for (U32 i = 0; i < 5000; ++i)
+		{
+			names.push_back(llformat("Block%u", i));
+		}
+
+		LLStringPool pool;
+		StringPoolReader reader(pool, names);
+		reader.start();
+		for (U32 i = 0; i < names.size(); ++i)
+		{
+			pool.intern(names[i]);
+		}
+		while (!reader.isStopped())
+		{
+			ms_sleep(1);
+		}
+		ensure_equals("mismatches", reader.mMismatches, (U32) 0);
+		ensure_equals("size", pool.size(), (U32) names.size());
+	}
+
+	template<> template<>
+	void stringpool_object_t::test<3>()
+	{
+		set_test_name("LLStringTable");
+
+		LLStringTable table(64);
+		char* name = table.addString("Skeleton");
+		ensure_equals("added", std::string(name), std::string("Skeleton"));
+		ensure("same pointer", table.addString(std::string("Skeleton")) == name);
+		ensure("checked", table.checkString("Skeleton") == name);
+		ensure_equals("count", table.checkStringEntry("Skeleton")->mCount, 2);
+		ensure_equals("unique", table.mUniqueEntries, 1);
+
+		table.removeString("Skeleton");
+		ensure("still there", table.checkString("Skeleton") == name);
+		table.removeString("Skeleton");
+		ensure("removed", table.checkString("Skeleton") == NULL);
+		ensure_equals("no unique", table.mUniqueEntries, 0);
+		ensure("same pointer again", table.addString("Skeleton") == name);
+
+		std::string long_name(MAX_STRINGS_LENGTH * 2, 'x');
+		ensure_equals("truncated", strlen(table.addString(long_name)), (size_t) MAX_STRINGS_LENGTH - 1);
+	}
+}
@@ -0,0 +1,85 @@
+/**
+ * @file lltracetimerevents_test.cpp
+ * @brief Tests of the per-thread timer event rings.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lltracetimerevents.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct tracetimerevents
+	{
+	};
+
+	typedef test_group<tracetimerevents> tracetimerevents_t;
+	typedef tracetimerevents_t::object tracetimerevents_object_t;
+	tut::tracetimerevents_t tut_tracetimerevents("LLTraceTimerEvents");
+
+	template<> template<>
+	void tracetimerevents_object_t::test<1>()
+	{
+		set_test_name("latest events");
+
+		LLTrace::TimerEventBuffer buffer("Test", 3);
+		LLTrace::TimerEventBuffer::ThreadEvents events;
+		buffer.copyEvents(events);
+		ensure_equals("thread name", events.mThreadName, std::string("Test"));
+		ensure("no events", events.mEvents.empty());
+
+		buffer.record(7, 1000, 1000 + (5 << LLTrace::TimerEventBuffer::DURATION_SHIFT));
+		buffer.copyEvents(events);
+		ensure_equals("one event", events.mEvents.size(), (size_t) 1);
+		ensure_equals("start", events.mEvents[0].mStartTime, (U64) 1000);
+		ensure_equals("duration", events.mEvents[0].mDuration, (U32) 5);
+		ensure_equals("time block", events.mEvents[0].mTimeBlock, (U32) 7);
+
+		// capacity rounds up to 4, the oldest are overwritten
+		for (U32 i = 0; i < 10; ++i)
+		{
+			buffer.record(i, i * 100, i * 100 + 10);
+		}
+		buffer.copyEvents(events);
+		ensure_equals("latest events", events.mEvents.size(), (size_t) 4);
+		for (U32 i = 0; i < 4; ++i)
+		{
+			ensure_equals("in order", events.mEvents[i].mTimeBlock, 6 + i);
+		}
+	}
+
+	template<> template<>
+	void tracetimerevents_object_t::test<2>()
+	{
+		set_test_name("saturated duration");
+
+		LLTrace::TimerEventBuffer buffer("Test", 4);
+		buffer.record(1, 0, ~(U64) 0);
+		LLTrace::TimerEventBuffer::ThreadEvents events;
+		buffer.copyEvents(events);
+		ensure_equals("saturated", events.mEvents[0].mDuration, (U32) U32_MAX);
+	}
+}
@@ -0,0 +1,253 @@
+/**
+ * @file lluuidflatmap_test.cpp
+ * @brief Tests and lookup benchmark of LLUUIDFlatMap.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lluuidflatmap.h"
+
+#include "../test/lltut.h"
+#include "../lltimer.h"
+
+#include <boost/unordered_map.hpp>
+#include <map>
+#include <vector>
+
+// elements of the benchmark tables, about an inventory worth
+static const U32 BENCHMARK_ELEMENTS = 100000;
+static const U32 BENCHMARK_LOOKUPS = 1000000;
+
+// The containers behind a common interface for the benchmark, with an
+// estimate of their heap use: node containers pay a malloc header and
+// their links for every element.
+struct StdMapAdapter
+{
+	typedef std::map<LLUUID, S32> map_t;
+	static const char* getName() { return "std::map"; }
+	static size_t getMemoryUsage(const map_t& map)
+	{
+		return map.size() * (sizeof(map_t::value_type) + 4 * sizeof(void*) + 2 * sizeof(void*));
+	}
+};
+
+struct UnorderedMapAdapter
+{
+	typedef boost::unordered_map<LLUUID, S32, FSUUIDHash> map_t;
+	static const char* getName() { return "boost::unordered_map"; }
+	static size_t getMemoryUsage(const map_t& map)
+	{
+		return map.size() * (sizeof(map_t::value_type) + 2 * sizeof(void*) + 2 * sizeof(void*))
+			+ map.bucket_count() * sizeof(void*);
+	}
+};
+
+struct FlatMapAdapter
+{
+	typedef LLUUIDFlatMap<S32> map_t;
+	static const char* getName() { return "LLUUIDFlatMap"; }
+	static size_t getMemoryUsage(const map_t& map)
+	{
+		return map.getMemoryUsage();
+	}
+};
+
+namespace tut
+{
+	struct uuidflatmap_test
+	{
+		std::vector<LLUUID> mIDs;
+
+		uuidflatmap_test()
+		{
+			mIDs.resize(BENCHMARK_ELEMENTS);
+			for (U32 i = 0; i < BENCHMARK_ELEMENTS; ++i)
+			{
+				mIDs[i].generate();
+			}
+		}
+
+		template <class ADAPTER>
+		void runBenchmark()
+		{
+			typename ADAPTER::map_t map;
+
+			LLTimer timer;
+			for (U32 i = 0; i < BENCHMARK_ELEMENTS; ++i)
+			{
+				map[mIDs[i]] = (S32) i;
+			}
+			F64 insert_seconds = timer.getElapsedTimeF64();
+
+			// hits in a scattered order, then as many misses
+			S32 sum = 0;
+			timer.reset();
+			for (U32 i = 0; i < BENCHMARK_LOOKUPS; ++i)
+			{
+				typename ADAPTER::map_t::const_iterator it = map.find(mIDs[(i * 7919) % BENCHMARK_ELEMENTS]);
+				if (it != map.end())
+				{
+					sum += it->second;
+				}
+			}
+			F64 hit_seconds = timer.getElapsedTimeF64();
+
+			LLUUID missing;
+			timer.reset();
+			for (U32 i = 0; i < BENCHMARK_LOOKUPS; ++i)
+			{
+				missing.mData[i & 15] ^= (U8) i;
+				if (map.find(missing) != map.end())
+				{
+					++sum;
+				}
+			}
+			F64 miss_seconds = timer.getElapsedTimeF64();
+
+			ensure_equals(std::string(ADAPTER::getName()) + " size", map.size(), (size_t) BENCHMARK_ELEMENTS);
+			LL_INFOS() << ADAPTER::getName() << ": "
+					   << (S32) (BENCHMARK_ELEMENTS / llmax(insert_seconds, 0.000001)) << " inserts/s, "
+					   << (S32) (BENCHMARK_LOOKUPS / llmax(hit_seconds, 0.000001)) << " hits/s, "
+					   << (S32) (BENCHMARK_LOOKUPS / llmax(miss_seconds, 0.000001)) << " misses/s, about "
+					   << ADAPTER::getMemoryUsage(map) / 1024 << " KB (checksum " << sum << ")" << LL_ENDL;
+		}
+	};
+
+	typedef test_group<uuidflatmap_test> uuidflatmap_t;
+	typedef uuidflatmap_t::object uuidflatmap_object_t;
+	tut::uuidflatmap_t tut_uuidflatmap("LLUUIDFlatMap");
+
+	template<> template<>
+	void uuidflatmap_object_t::test<1>()
+	{
+		set_test_name("insert, find, erase");
+
+		LLUUIDFlatMap<S32> map;
+		ensure("empty", map.empty());
+		ensure("find in empty", map.find(mIDs[0]) == map.end());
+		ensure_equals("erase from empty", map.erase(mIDs[0]), (size_t) 0);
+
+		// enough to grow a few times
+		for (S32 i = 0; i < 1000; ++i)
+		{
+			ensure("inserted", map.insert(std::make_pair(mIDs[i], i)).second);
+		}
+		ensure("not inserted twice", !map.insert(std::make_pair(mIDs[0], -1)).second);
+		ensure_equals("size", map.size(), (size_t) 1000);
+		for (S32 i = 0; i < 1000; ++i)
+		{
+			LLUUIDFlatMap<S32>::iterator it = map.find(mIDs[i]);
+			ensure("found", it != map.end());
+			ensure_equals("value", it->second, i);
+		}
+		ensure("missing", map.find(mIDs[1000]) == map.end());
+		ensure_equals("null missing", map.count(LLUUID::null), (size_t) 0);
+
+		for (S32 i = 0; i < 1000; i += 2)
+		{
+			ensure_equals("erased", map.erase(mIDs[i]), (size_t) 1);
+		}
+		ensure_equals("size after erase", map.size(), (size_t) 500);
+		for (S32 i = 0; i < 1000; ++i)
+		{
+			ensure_equals("count after erase", map.count(mIDs[i]), (size_t) (i & 1));
+		}
+
+		map[LLUUID::null] = 7;
+		map[LLUUID::null] += 1;
+		ensure_equals("operator[]", map[LLUUID::null], 8);
+	}
+
+	template<> template<>
+	void uuidflatmap_object_t::test<2>()
+	{
+		set_test_name("iteration and churn");
+
+		LLUUIDFlatMap<S32> map;
+		for (S32 i = 0; i < 200; ++i)
+		{
+			map[mIDs[i]] = i;
+		}
+
+		// erasing while iterating only invalidates the erased element
+		for (LLUUIDFlatMap<S32>::iterator it = map.begin(); it != map.end(); )
+		{
+			if (it->second % 3 == 0)
+			{
+				map.erase(it++);
+			}
+			else
+			{
+				++it;
+			}
+		}
+		std::vector<bool> seen(200, false);
+		for (LLUUIDFlatMap<S32>::const_iterator it = map.begin(); it != map.end(); ++it)
+		{
+			ensure("visited once", !seen[it->second]);
+			seen[it->second] = true;
+		}
+		for (S32 i = 0; i < 200; ++i)
+		{
+			ensure_equals("visited", (bool) seen[i], i % 3 != 0);
+		}
+
+		// inserting and erasing at a steady size reuses the deleted slots
+		// instead of growing
+		size_t capacity = map.capacity();
+		for (U32 i = 200; i < BENCHMARK_ELEMENTS; ++i)
+		{
+			map[mIDs[i]] = (S32) i;
+			map.erase(mIDs[i - 100]);
+		}
+		ensure_equals("steady capacity", map.capacity(), capacity);
+		for (U32 i = BENCHMARK_ELEMENTS - 100; i < BENCHMARK_ELEMENTS; ++i)
+		{
+			ensure("kept", map.find(mIDs[i]) != map.end());
+		}
+
+		LLUUIDFlatMap<S32> copy(map);
+		ensure_equals("copy size", copy.size(), map.size());
+		ensure_equals("copy value", copy[mIDs[BENCHMARK_ELEMENTS - 1]], (S32) (BENCHMARK_ELEMENTS - 1));
+
+		map.clear();
+		ensure("cleared", map.empty() && map.begin() == map.end());
+		ensure("copy kept", !copy.empty());
+
+		LLUUIDFlatSet set;
+		ensure("set insert", set.insert(mIDs[0]).second);
+		ensure("set duplicate", !set.insert(mIDs[0]).second);
+		ensure_equals("set count", set.count(mIDs[0]), (size_t) 1);
+	}
+
+	template<> template<>
+	void uuidflatmap_object_t::test<3>()
+	{
+		set_test_name("benchmark");
+
+		runBenchmark<StdMapAdapter>();
+		runBenchmark<UnorderedMapAdapter>();
+		runBenchmark<FlatMapAdapter>();
+	}
+}
@@ -0,0 +1,258 @@
+/**
+ * @file llworkscheduler_test.cpp
+ * @brief Tests of LLWorkScheduler and the LLQueuedThreads that use it.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llworkscheduler.h"
+#include "../llqueuedthread.h"
+
+#include "../test/lltut.h"
+#include "../lltimer.h"
+
+// what the requests of a queue did, kept apart from the queue so it can be
+// checked after the queue is gone
+struct RequestCounts
+{
+	RequestCounts()
+	:	mMutex(NULL),
+		mRunning(0),
+		mMaxRunning(0),
+		mCompleted(0),
+		mAborted(0)
+	{
+	}
+
+	S32 getCompleted()
+	{
+		LLMutexLock lock(&mMutex);
+		return mCompleted;
+	}
+
+	LLMutex mMutex;
+	S32 mRunning;
+	S32 mMaxRunning;
+	S32 mCompleted;
+	S32 mAborted;
+};
+
+class TestQueue : public LLQueuedThread
+{
+public:
+	TestQueue(const std::string& name, S32 scheduler_workers, bool should_pause = false)
+	:	LLQueuedThread(name, true, should_pause, scheduler_workers)
+	{
+	}
+
+	bool isScheduled() const { return mScheduler != NULL; }
+
+	// a request that takes sleep_ms
+	void add(RequestCounts* counts, U32 sleep_ms, U32 priority = PRIORITY_NORMAL)
+	{
+		addRequest(new Request(generateHandle(), priority, counts, sleep_ms));
+	}
+
+private:
+	class Request : public QueuedRequest
+	{
+	public:
+		Request(handle_t handle, U32 priority, RequestCounts* counts, U32 sleep_ms)
+		:	QueuedRequest(handle, priority, FLAG_AUTO_COMPLETE),
+			mCounts(counts),
+			mSleepMs(sleep_ms)
+		{
+		}
+
+		/*virtual*/ bool processRequest()
+		{
+			mCounts->mMutex.lock();
+			mCounts->mMaxRunning = llmax(mCounts->mMaxRunning, ++mCounts->mRunning);
+			mCounts->mMutex.unlock();
+
+			ms_sleep(mSleepMs);
+
+			mCounts->mMutex.lock();
+			--mCounts->mRunning;
+			mCounts->mMutex.unlock();
+			return true;
+		}
+
+		/*virtual*/ void finishRequest(bool completed)
+		{
+			LLMutexLock lock(&mCounts->mMutex);
+			++(completed ? mCounts->mCompleted : mCounts->mAborted);
+		}
+
+	private:
+		RequestCounts* mCounts;
+		U32 mSleepMs;
+	};
+};
+
+// waits up to 10 seconds for the queues to complete num requests each,
+// updating them as the main loop does
+static bool wait_for_completed(TestQueue** queues, RequestCounts* counts, S32 num_queues, S32 num)
+{
+	LLTimer timer;
+	while (timer.getElapsedTimeF32() < 10.f)
+	{
+		bool done = true;
+		for (S32 i = 0; i < num_queues; ++i)
+		{
+			queues[i]->update(0);
+			done = done && counts[i].getCompleted() >= num;
+		}
+		if (done)
+		{
+			return true;
+		}
+		ms_sleep(1);
+	}
+	return false;
+}
+
+namespace tut
+{
+	struct workscheduler_test
+	{
+		workscheduler_test()
+		{
+			LLWorkScheduler::initClass(4);
+		}
+
+		~workscheduler_test()
+		{
+			LLWorkScheduler::cleanupClass();
+		}
+	};
+
+	typedef test_group<workscheduler_test> workscheduler_t;
+	typedef workscheduler_t::object workscheduler_object_t;
+	tut::workscheduler_t tut_workscheduler("LLWorkScheduler");
+
+	template<> template<>
+	void workscheduler_object_t::test<1>()
+	{
+		set_test_name("lanes");
+
+		ensure_equals("immediate", LLWorkScheduler::getLane(LLQueuedThread::PRIORITY_IMMEDIATE), LLWorkScheduler::LANE_HIGH);
+		ensure_equals("high", LLWorkScheduler::getLane(LLQueuedThread::PRIORITY_HIGH), LLWorkScheduler::LANE_HIGH);
+		ensure_equals("normal", LLWorkScheduler::getLane(LLQueuedThread::PRIORITY_NORMAL + 5), LLWorkScheduler::LANE_NORMAL);
+		ensure_equals("low", LLWorkScheduler::getLane(LLQueuedThread::PRIORITY_LOW), LLWorkScheduler::LANE_LOW);
+		ensure_equals("workers", LLWorkScheduler::getInstance()->getNumWorkers(), 4);
+	}
+
+	template<> template<>
+	void workscheduler_object_t::test<2>()
+	{
+		set_test_name("several queues and their limits");
+
+		// one at a time, two at a time, and as many as there are workers
+		const S32 NUM_QUEUES = 3;
+		const S32 NUM_REQUESTS = 12;
+		RequestCounts counts[NUM_QUEUES];
+		TestQueue* queues[NUM_QUEUES];
+		queues[0] = new TestQueue("serial", 1);
+		queues[1] = new TestQueue("pair", 2);
+		queues[2] = new TestQueue("parallel", LLWorkScheduler::ALL_WORKERS);
+
+		for (S32 i = 0; i < NUM_REQUESTS; ++i)
+		{
+			for (S32 q = 0; q < NUM_QUEUES; ++q)
+			{
+				queues[q]->add(&counts[q], 10, i % 2 ? LLQueuedThread::PRIORITY_HIGH : LLQueuedThread::PRIORITY_LOW);
+			}
+		}
+		ensure("completed", wait_for_completed(queues, counts, NUM_QUEUES, NUM_REQUESTS));
+
+		for (S32 q = 0; q < NUM_QUEUES; ++q)
+		{
+			ensure("no thread of its own", queues[q]->isScheduled());
+			ensure_equals("none aborted", counts[q].mAborted, 0);
+			ensure_equals("all completed", counts[q].mCompleted, NUM_REQUESTS);
+			delete queues[q];
+		}
+		ensure_equals("serial", counts[0].mMaxRunning, 1);
+		ensure("pair", counts[1].mMaxRunning <= 2);
+		ensure("parallel", counts[2].mMaxRunning > 1 && counts[2].mMaxRunning <= 4);
+	}
+
+	template<> template<>
+	void workscheduler_object_t::test<3>()
+	{
+		set_test_name("pause and unpause");
+
+		RequestCounts counts;
+		TestQueue* queue = new TestQueue("paused", 1, true);
+		for (S32 i = 0; i < 5; ++i)
+		{
+			queue->add(&counts, 1);
+		}
+
+		// requests added while paused aren't scheduled
+		ms_sleep(100);
+		ensure_equals("nothing while paused", counts.getCompleted(), 0);
+		ensure_equals("all pending", queue->getPending(), 5);
+
+		// update() unpauses a queue with pending requests and schedules it
+		ensure("completed", wait_for_completed(&queue, &counts, 1, 5));
+
+		// and again once it paused itself for having nothing to do
+		queue->pause();
+		queue->add(&counts, 1);
+		ms_sleep(50);
+		ensure_equals("paused again", counts.getCompleted(), 5);
+		ensure("completed again", wait_for_completed(&queue, &counts, 1, 6));
+		delete queue;
+	}
+
+	template<> template<>
+	void workscheduler_object_t::test<4>()
+	{
+		set_test_name("shutdown with queued requests");
+
+		RequestCounts counts;
+		TestQueue* queue = new TestQueue("shutdown", 1);
+		for (S32 i = 0; i < 20; ++i)
+		{
+			queue->add(&counts, 50);
+		}
+		LLTimer timer;
+		while (timer.getElapsedTimeF32() < 10.f)
+		{
+			LLMutexLock lock(&counts.mMutex);
+			if (counts.mRunning > 0)
+			{
+				break;
+			}
+		}
+
+		// the request in progress finishes, the worker aborts the rest
+		delete queue;
+		ensure_equals("none running", counts.mRunning, 0);
+		ensure_equals("every request finished", counts.mCompleted + counts.mAborted, 20);
+		ensure("some aborted", counts.mAborted > 0);
+	}
+}
@@ -39,6 +39,8 @@
 
 #include "lltimer.h"
 #include "llthread.h"
+#include "llfasttimer.h"
+#include "lltracethreadrecorder.h"
 
 
 namespace
@@ -46,6 +48,9 @@ namespace
 
 static const char * const LOG_CORE("CoreHttp");
 
+static LLTrace::BlockTimerStatHandle FTM_HTTP_POLICY("HTTP Policy");
+static LLTrace::BlockTimerStatHandle FTM_HTTP_TRANSPORT("HTTP Transport");
+
 } // end anonymous namespace
 
 
@@ -290,6 +295,11 @@ void HttpService::threadRun(LLCoreInt::HttpThread * thread)
 	boost::this_thread::disable_interruption di;
 
 	LLThread::registerThreadID();
+
+	// Time blocks of this thread show up in timer traces along
+	// with those of the LLThreads.
+	LLTrace::ThreadRecorder * master_recorder(LLTrace::get_master_thread_recorder());
+	LLTrace::ThreadRecorder * recorder(master_recorder ? new LLTrace::ThreadRecorder(*master_recorder, "HTTP") : NULL);
 	
 	ELoopSpeed loop(REQUEST_SLEEP);
 	while (! mExitRequested)
@@ -297,11 +307,18 @@ void HttpService::threadRun(LLCoreInt::HttpThread * thread)
 		loop = processRequestQueue(loop);
 
 		// Process ready queue issuing new requests as needed
-		ELoopSpeed new_loop = mPolicy->processReadyQueue();
+		ELoopSpeed new_loop;
+		{
+			LL_RECORD_BLOCK_TIME(FTM_HTTP_POLICY);
+			new_loop = mPolicy->processReadyQueue();
+		}
 		loop = (std::min)(loop, new_loop);
 		
 		// Give libcurl some cycles
-		new_loop = mTransport->processTransport();
+		{
+			LL_RECORD_BLOCK_TIME(FTM_HTTP_TRANSPORT);
+			new_loop = mTransport->processTransport();
+		}
 		loop = (std::min)(loop, new_loop);
 		
 		// Determine whether to spin, sleep briefly or sleep for next request
@@ -312,6 +329,7 @@ void HttpService::threadRun(LLCoreInt::HttpThread * thread)
 	}
 
 	shutdown();
+	delete recorder;
 	sState = STOPPED;
 }
 
@@ -202,6 +202,18 @@ public:
 	// Construct using createFromFile (used by tools)
 	//LLImageRaw(const std::string& filename, bool j2c_lowest_mip_only = false);
 
+	// decodes, scaling and the texture cache make these by the thousand,
+	// the objects come from a slab pool, their data still from the heap
+	void* operator new(size_t size)
+	{
+		return slab_new<LLImageRaw>(size);
+	}
+
+	void operator delete(void* ptr, size_t size)
+	{
+		slab_delete<LLImageRaw>(ptr, size);
+	}
+
 	/*virtual*/ void deleteData();
 	/*virtual*/ U8* allocateData(S32 size = -1);
 	/*virtual*/ U8* reallocateData(S32 size);
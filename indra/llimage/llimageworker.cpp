@@ -28,12 +28,13 @@
 
 #include "llimageworker.h"
 #include "llimagedxt.h"
+#include "llworkscheduler.h"
 
 //----------------------------------------------------------------------------
 
 // MAIN THREAD
 LLImageDecodeThread::LLImageDecodeThread(bool threaded)
-	: LLQueuedThread("imagedecode", threaded)
+	: LLQueuedThread("imagedecode", threaded, false, LLWorkScheduler::ALL_WORKERS)	// images decode independently
 {
 	mCreationMutex = new LLMutex(getAPRPool());
 }
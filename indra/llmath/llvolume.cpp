@@ -2378,17 +2378,43 @@ bool LLVolumeFace::VertexData::compareNormal(const LLVolumeFace::VertexData& rhs
 
 bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 {
-	//input stream is now pointing at a zlib compressed block of LLSD
-	//decompress block
-	LLSD mdl;
-	if (!unzip_llsd(mdl, is, size))
+	if (size <= 0)
+	{
+		return false;
+	}
+
+	std::vector<U8> buffer(size);
+	is.read((char*) &buffer[0], size);
+
+	return unpackVolumeFaces(&buffer[0], size);
+}
+
+// read count quantization domain components from an LLSD array of reals
+static void load_mesh_domain(const LLSDBinaryView& domain, F32* out, S32 count)
+{
+	LLSDBinaryView value = domain.first();
+	for (S32 i = 0; i < count; ++i)
+	{
+		out[i] = (F32) value.asReal();
+		value = value.next();
+	}
+}
+
+bool LLVolume::unpackVolumeFaces(const U8* data, S32 size)
+{
+	//data points at a zlib compressed block of LLSD
+	//decompress block, then read faces straight out of the serialized LLSD
+	std::vector<U8> buffer;
+	if (!unzip_llsd_bytes(buffer, data, size))
 	{
 		LL_DEBUGS("MeshStreaming") << "Failed to unzip LLSD blob for LoD, will probably fetch from sim again." << LL_ENDL;
 		return false;
 	}
+
+	LLSDBinaryView mdl(&buffer[0], buffer.size());
 	
 	{
-		U32 face_count = mdl.size();
+		U32 face_count = mdl.isArray() ? mdl.size() : 0;
 
 		if (face_count == 0)
 		{ //no faces unpacked, treat as failed decode
@@ -2398,11 +2424,12 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 
 		mVolumeFaces.resize(face_count);
 
-		for (U32 i = 0; i < face_count; ++i)
+		LLSDBinaryView face_sd = mdl.first();
+		for (U32 i = 0; i < face_count; ++i, face_sd = face_sd.next())
 		{
 			LLVolumeFace& face = mVolumeFaces[i];
 
-			if (mdl[i].has("NoGeometry"))
+			if (face_sd.has("NoGeometry"))
 			{ //face has no geometry, continue
 				face.resizeIndices(3);
 				face.resizeVertices(1);
@@ -2413,28 +2440,22 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 				continue;
 			}
 
-			LLSD::Binary pos = mdl[i]["Position"];
-			LLSD::Binary norm = mdl[i]["Normal"];
-			LLSD::Binary tc = mdl[i]["TexCoord0"];
-			LLSD::Binary idx = mdl[i]["TriangleList"];
-
-			
+			//binary members are read in place, and are not necessarily aligned
+			LLSDBinaryView pos = face_sd["Position"];
+			LLSDBinaryView norm = face_sd["Normal"];
+			LLSDBinaryView tc = face_sd["TexCoord0"];
+			LLSDBinaryView idx = face_sd["TriangleList"];
 
 			//copy out indices
 			face.resizeIndices(idx.size()/2);
 			
-			if (idx.empty() || face.mNumIndices < 3)
+			if (!idx.binaryData() || face.mNumIndices < 3)
 			{ //why is there an empty index list?
 				LL_WARNS() <<"Empty face present!" << LL_ENDL;
 				continue;
 			}
 
-			U16* indices = (U16*) &(idx[0]);
-			U32 count = idx.size()/2;
-			for (U32 j = 0; j < count; ++j)
-			{
-				face.mIndices[j] = indices[j];
-			}
+			memcpy(face.mIndices, idx.binaryData(), sizeof(U16)*face.mNumIndices);
 
 			//copy out vertices
 			U32 num_verts = pos.size()/(3*2);
@@ -2445,14 +2466,16 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 			LLVector2 min_tc; 
 			LLVector2 max_tc; 
 		
-			minp.setValue(mdl[i]["PositionDomain"]["Min"]);
-			maxp.setValue(mdl[i]["PositionDomain"]["Max"]);
+			LLSDBinaryView pos_domain = face_sd["PositionDomain"];
+			load_mesh_domain(pos_domain["Min"], minp.mV, 3);
+			load_mesh_domain(pos_domain["Max"], maxp.mV, 3);
 			LLVector4a min_pos, max_pos;
 			min_pos.load3(minp.mV);
 			max_pos.load3(maxp.mV);
 
-			min_tc.setValue(mdl[i]["TexCoord0Domain"]["Min"]);
-			max_tc.setValue(mdl[i]["TexCoord0Domain"]["Max"]);
+			LLSDBinaryView tc_domain = face_sd["TexCoord0Domain"];
+			load_mesh_domain(tc_domain["Min"], min_tc.mV, 2);
+			load_mesh_domain(tc_domain["Max"], max_tc.mV, 2);
 
 			LLVector4a pos_range;
 			pos_range.setSub(max_pos, min_pos);
@@ -2466,32 +2489,37 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 			LLVector4a* norm_out = face.mNormals;
 			LLVector4a* tc_out = (LLVector4a*) face.mTexCoords;
 
+			if (num_verts)
 			{
-				U16* v = (U16*) &(pos[0]);
+				const U8* src = pos.binaryData();
 				for (U32 j = 0; j < num_verts; ++j)
 				{
+					U16 v[3];
+					memcpy(v, src, sizeof(v));
 					pos_out->set((F32) v[0], (F32) v[1], (F32) v[2]);
 					pos_out->div(65535.f);
 					pos_out->mul(pos_range);
 					pos_out->add(min_pos);
 					pos_out++;
-					v += 3;
+					src += sizeof(v);
 				}
 
 			}
 
 			{
-				if (!norm.empty())
+				if (norm.size() >= num_verts*3*2 && norm.binaryData())
 				{
-					U16* n = (U16*) &(norm[0]);
+					const U8* src = norm.binaryData();
 					for (U32 j = 0; j < num_verts; ++j)
 					{
+						U16 n[3];
+						memcpy(n, src, sizeof(n));
 						norm_out->set((F32) n[0], (F32) n[1], (F32) n[2]);
 						norm_out->div(65535.f);
 						norm_out->mul(2.f);
 						norm_out->sub(1.f);
 						norm_out++;
-						n += 3;
+						src += sizeof(n);
 					}
 				}
 				else
@@ -2501,21 +2529,24 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 			}
 
 			{
-				if (!tc.empty())
+				if (tc.size() >= num_verts*2*2 && tc.binaryData())
 				{
-					U16* t = (U16*) &(tc[0]);
+					const U8* src = tc.binaryData();
 					for (U32 j = 0; j < num_verts; j+=2)
 					{
+						U16 t[4];
 						if (j < num_verts-1)
 						{
+							memcpy(t, src, sizeof(t));
 							tc_out->set((F32) t[0], (F32) t[1], (F32) t[2], (F32) t[3]);
 						}
 						else
 						{
+							memcpy(t, src, sizeof(U16)*2);
 							tc_out->set((F32) t[0], (F32) t[1], 0.f, 0.f);
 						}
 
-						t += 4;
+						src += sizeof(t);
 
 						tc_out->div(65535.f);
 						tc_out->mul(tc_range);
@@ -2530,16 +2561,18 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 				}
 			}
 
-			if (mdl[i].has("Weights"))
+			LLSDBinaryView weights_sd = face_sd["Weights"];
+			if (weights_sd.isDefined())
 			{
 				face.allocateWeights(num_verts);
 
-				LLSD::Binary weights = mdl[i]["Weights"];
+				const U8* weights = weights_sd.binaryData();
+				U32 weights_size = weights ? weights_sd.size() : 0;
 
 				U32 idx = 0;
 
 				U32 cur_vertex = 0;
-				while (idx < weights.size() && cur_vertex < num_verts)
+				while (idx < weights_size && cur_vertex < num_verts)
 				{
 					const U8 END_INFLUENCES = 0xFF;
 					U8 joint = weights[idx++];
@@ -2547,7 +2580,7 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 					U32 cur_influence = 0;
 					LLVector4 wght(0,0,0,0);
 
-					while (joint != END_INFLUENCES && idx < weights.size())
+					while (joint != END_INFLUENCES && idx+1 < weights_size)
 					{
 						U16 influence = weights[idx++];
 						influence |= ((U16) weights[idx++] << 8);
@@ -2555,7 +2588,7 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 						F32 w = llclamp((F32) influence / 65535.f, 0.f, 0.99999f);
 						wght.mV[cur_influence++] = (F32) joint + w;
 
-						if (cur_influence >= 4)
+						if (cur_influence >= 4 || idx >= weights_size)
 						{
 							joint = END_INFLUENCES;
 						}
@@ -2570,7 +2603,7 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 					cur_vertex++;
 				}
 
-				if (cur_vertex != num_verts || idx != weights.size())
+				if (cur_vertex != num_verts || idx != weights_size)
 				{
 					LL_WARNS() << "Vertex weight count does not match vertex count!" << LL_ENDL;
 				}
@@ -2677,7 +2710,180 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 	
 	mSculptLevel = 0;  // success!
 
-	cacheOptimize();
+	return true;
+}
+
+//header for each face written by packDecodedFaces, arrays follow
+struct LLDecodedFaceHeader
+{
+	enum
+	{
+		HAS_WEIGHTS = 0x1,
+		OPTIMIZED = 0x2
+	};
+
+	S32 mNumVertices;
+	S32 mNumIndices;
+	U32 mFlags;
+	U32 mPad;
+	F32 mExtents[8];
+	F32 mTexCoordExtents[4];
+};
+
+static inline S32 decoded_vertex_bytes(S32 num_verts)
+{ //positions and normals followed by texture coordinates padded for QWORD reads, as in resizeVertices
+	return sizeof(LLVector4a)*2*num_verts + (((num_verts*sizeof(LLVector2)) + 0xF) & ~0xF);
+}
+
+static inline S32 decoded_index_bytes(S32 num_indices)
+{
+	return ((num_indices*sizeof(U16)) + 0xF) & ~0xF;
+}
+
+void LLVolume::packDecodedFaces(std::vector<U8>& data) const
+{
+	const S32 block_header_size = 16;
+
+	S32 size = block_header_size;
+	for (U32 i = 0; i < mVolumeFaces.size(); ++i)
+	{
+		const LLVolumeFace& face = mVolumeFaces[i];
+		size += sizeof(LLDecodedFaceHeader);
+		size += decoded_vertex_bytes(face.mNumVertices);
+		size += decoded_index_bytes(face.mNumIndices);
+		if (face.mWeights)
+		{
+			size += sizeof(LLVector4a)*face.mNumVertices;
+		}
+	}
+
+	data.clear();
+	data.resize(size, 0);
+
+	U8* out = &data[0];
+	U32 num_faces = mVolumeFaces.size();
+	memcpy(out, &num_faces, sizeof(U32));
+	out += block_header_size;
+
+	for (U32 i = 0; i < mVolumeFaces.size(); ++i)
+	{
+		const LLVolumeFace& face = mVolumeFaces[i];
+
+		LLDecodedFaceHeader header;
+		memset(&header, 0, sizeof(header));
+		header.mNumVertices = face.mNumVertices;
+		header.mNumIndices = face.mNumIndices;
+		header.mFlags = (face.mWeights ? LLDecodedFaceHeader::HAS_WEIGHTS : 0) |
+						(face.mOptimized ? LLDecodedFaceHeader::OPTIMIZED : 0);
+		memcpy(header.mExtents, face.mExtents[0].getF32ptr(), sizeof(F32)*4);
+		memcpy(header.mExtents+4, face.mExtents[1].getF32ptr(), sizeof(F32)*4);
+		memcpy(header.mTexCoordExtents, face.mTexCoordExtents, sizeof(header.mTexCoordExtents));
+		memcpy(out, &header, sizeof(header));
+		out += sizeof(header);
+
+		if (face.mNumVertices)
+		{ //normals and texture coordinates share the position allocation
+			memcpy(out, face.mPositions, sizeof(LLVector4a)*2*face.mNumVertices + sizeof(LLVector2)*face.mNumVertices);
+		}
+		out += decoded_vertex_bytes(face.mNumVertices);
+
+		if (face.mNumIndices)
+		{
+			memcpy(out, face.mIndices, sizeof(U16)*face.mNumIndices);
+		}
+		out += decoded_index_bytes(face.mNumIndices);
+
+		if (face.mWeights)
+		{
+			memcpy(out, face.mWeights, sizeof(LLVector4a)*face.mNumVertices);
+			out += sizeof(LLVector4a)*face.mNumVertices;
+		}
+	}
+
+	llassert(out == &data[0]+size);
+}
+
+bool LLVolume::unpackDecodedFaces(const U8* data, S32 size)
+{
+	const S32 block_header_size = 16;
+
+	if (!data || size < block_header_size)
+	{
+		return false;
+	}
+
+	const U8* end = data+size;
+	U32 num_faces = 0;
+	memcpy(&num_faces, data, sizeof(U32));
+	data += block_header_size;
+
+	if (num_faces == 0 || num_faces > (U32) (size/sizeof(LLDecodedFaceHeader)))
+	{
+		return false;
+	}
+
+	mVolumeFaces.clear();
+	mVolumeFaces.resize(num_faces);
+
+	for (U32 i = 0; i < num_faces; ++i)
+	{
+		LLVolumeFace& face = mVolumeFaces[i];
+
+		LLDecodedFaceHeader header;
+		if (end-data < (S32) sizeof(header))
+		{
+			mVolumeFaces.clear();
+			return false;
+		}
+		memcpy(&header, data, sizeof(header));
+		data += sizeof(header);
+
+		bool has_weights = (header.mFlags & LLDecodedFaceHeader::HAS_WEIGHTS) != 0;
+		if (header.mNumVertices < 0 || header.mNumVertices > 65536 ||
+			header.mNumIndices < 0 || header.mNumIndices % 3 != 0 ||
+			end-data < decoded_vertex_bytes(header.mNumVertices) + decoded_index_bytes(header.mNumIndices) +
+						(has_weights ? (S32) sizeof(LLVector4a)*header.mNumVertices : 0))
+		{
+			mVolumeFaces.clear();
+			return false;
+		}
+
+		face.resizeVertices(header.mNumVertices);
+		if (header.mNumVertices)
+		{
+			memcpy(face.mPositions, data, sizeof(LLVector4a)*2*header.mNumVertices + sizeof(LLVector2)*header.mNumVertices);
+		}
+		data += decoded_vertex_bytes(header.mNumVertices);
+
+		face.resizeIndices(header.mNumIndices);
+		if (header.mNumIndices)
+		{
+			memcpy(face.mIndices, data, sizeof(U16)*header.mNumIndices);
+			for (S32 j = 0; j < header.mNumIndices; ++j)
+			{
+				if (face.mIndices[j] >= header.mNumVertices)
+				{ //never hand out of range indices to the renderer
+					mVolumeFaces.clear();
+					return false;
+				}
+			}
+		}
+		data += decoded_index_bytes(header.mNumIndices);
+
+		if (has_weights)
+		{
+			face.allocateWeights(header.mNumVertices);
+			memcpy(face.mWeights, data, sizeof(LLVector4a)*header.mNumVertices);
+			data += sizeof(LLVector4a)*header.mNumVertices;
+		}
+
+		face.mExtents[0].loadua(header.mExtents);
+		face.mExtents[1].loadua(header.mExtents+4);
+		memcpy(face.mTexCoordExtents, header.mTexCoordExtents, sizeof(header.mTexCoordExtents));
+		face.mOptimized = (header.mFlags & LLDecodedFaceHeader::OPTIMIZED) ? TRUE : FALSE;
+	}
+
+	mSculptLevel = 0;  // success!
 
 	return true;
 }
@@ -2710,11 +2916,11 @@ void LLVolume::copyVolumeFaces(const LLVolume* volume)
 	mSculptLevel = 0;
 }
 
-void LLVolume::cacheOptimize()
+void LLVolume::cacheOptimize(F32 overdraw_threshold)
 {
 	for (S32 i = 0; i < mVolumeFaces.size(); ++i)
 	{
-		mVolumeFaces[i].cacheOptimize();
+		mVolumeFaces[i].cacheOptimize(overdraw_threshold);
 	}
 }
 
@@ -4869,400 +5075,419 @@ void LLVolumeFace::optimize(F32 angle_cutoff)
 
 }
 
-class LLVCacheTriangleData;
+// Vertex cache optimization according to Forsyth method:
+// http://home.comcast.net/~tom_forsyth/papers/fast_vert_cache_opt.html
+//
+// Vertex to triangle adjacency lives in flat arrays (one run of triangle
+// indices per vertex) and vertex scores come from lookup tables, so emitting
+// a triangle only touches the vertices in the simulated LRU cache.
 
-class LLVCacheVertexData
-{
-public:
-	S32 mIdx;
-	S32 mCacheTag;
-	F64 mScore;
-	U32 mActiveTriangles;
-	std::vector<LLVCacheTriangleData*> mTriangles;
+const F32 FindVertexScore_CacheDecayPower = 1.5f;
+const F32 FindVertexScore_LastTriScore = 0.75f;
+const F32 FindVertexScore_ValenceBoostScale = 2.0f;
+const F32 FindVertexScore_ValenceBoostPower = 0.5f;
+const U32 MaxSizeVertexCache = 32;
+const U32 MaxValenceScoreTable = 32;
 
-	LLVCacheVertexData()
-	{
-		mCacheTag = -1;
-		mScore = 0.0;
-		mActiveTriangles = 0;
-		mIdx = -1;
-	}
-};
+//size of the FIFO cache used for ACMR/ATVR measurement and overdraw clustering
+const U32 StatsSizeVertexCache = 16;
 
-class LLVCacheTriangleData
+class LLVCacheScoreTable
 {
 public:
-	bool mActive;
-	F64 mScore;
-	LLVCacheVertexData* mVertex[3];
-
-	LLVCacheTriangleData()
+	LLVCacheScoreTable()
 	{
-		mActive = true;
-		mScore = 0.0;
-		mVertex[0] = mVertex[1] = mVertex[2] = NULL;
-	}
+		const F32 scaler = 1.f/(MaxSizeVertexCache-3);
 
-	void complete()
-	{
-		mActive = false;
-		for (S32 i = 0; i < 3; ++i)
+		for (U32 i = 0; i < MaxSizeVertexCache; ++i)
 		{
-			if (mVertex[i])
-			{
-				llassert(mVertex[i]->mActiveTriangles > 0);
-				mVertex[i]->mActiveTriangles--;
+			if (i < 3)
+			{ //vertex was in the last triangle
+				mCacheScore[i] = FindVertexScore_LastTriScore;
+			}
+			else
+			{ //more points for being higher in the cache
+				mCacheScore[i] = powf(1.f-((i-3)*scaler), FindVertexScore_CacheDecayPower);
 			}
 		}
-	}
 
-	bool operator<(const LLVCacheTriangleData& rhs) const
-	{ //highest score first
-		return rhs.mScore < mScore;
+		mValenceScore[0] = 0.f;
+		for (U32 i = 1; i < MaxValenceScoreTable; ++i)
+		{ //bonus points for having low valence
+			mValenceScore[i] = FindVertexScore_ValenceBoostScale * powf((F32) i, -FindVertexScore_ValenceBoostPower);
+		}
 	}
-};
 
-const F64 FindVertexScore_CacheDecayPower = 1.5;
-const F64 FindVertexScore_LastTriScore = 0.75;
-const F64 FindVertexScore_ValenceBoostScale = 2.0;
-const F64 FindVertexScore_ValenceBoostPower = 0.5;
-const U32 MaxSizeVertexCache = 32;
-const F64 FindVertexScore_Scaler = 1.0/(MaxSizeVertexCache-3);
+	F32 getScore(S32 cache_idx, U32 active_triangles) const
+	{
+		if (active_triangles == 0)
+		{ //vertex has no triangles left to emit
+			return -1.f;
+		}
 
-F64 find_vertex_score(LLVCacheVertexData& data)
-{
-	F64 score = -1.0;
+		F32 score = cache_idx < 0 ? 0.f : mCacheScore[cache_idx];
 
-	if (data.mActiveTriangles >= 0)
-	{ 
-		score = 0.0;
+		if (active_triangles < MaxValenceScoreTable)
+		{
+			score += mValenceScore[active_triangles];
+		}
+		else
+		{
+			score += FindVertexScore_ValenceBoostScale * powf((F32) active_triangles, -FindVertexScore_ValenceBoostPower);
+		}
 
-	S32 cache_idx = data.mCacheTag;
+		return score;
+	}
+
+private:
+	F32 mCacheScore[MaxSizeVertexCache];
+	F32 mValenceScore[MaxValenceScoreTable];
+};
 
-	if (cache_idx < 0)
+static const LLVCacheScoreTable sVCacheScores;
+
+//push a vertex through a simulated FIFO cache, returns 1 on a cache miss
+static inline U32 vcache_fifo_add(std::vector<U32>& timestamps, U32& time, U32 cache_size, U16 idx)
+{
+	if (time - timestamps[idx] > cache_size)
 	{
-		//not in cache
+		timestamps[idx] = time++;
+		return 1;
 	}
-	else
-	{
-		if (cache_idx < 3)
-		{ //vertex was in the last triangle
-			score = FindVertexScore_LastTriScore;
-		}
-		else
-		{ //more points for being higher in the cache
-				score = 1.0-((cache_idx-3)*FindVertexScore_Scaler);
-				score = pow(score, FindVertexScore_CacheDecayPower);
-		}
+	return 0;
+}
+
+void LLVolumeFace::cacheOptimize(F32 overdraw_threshold)
+{
+	llassert(!mOptimized);
+	mOptimized = TRUE;
+
+	if (mNumVertices < 3 || mNumIndices < 3)
+	{ //nothing to do
+		return;
 	}
 
-	//bonus points for having low valence
-		F64 valence_boost = pow((F64)data.mActiveTriangles, -FindVertexScore_ValenceBoostPower);
-	score += FindVertexScore_ValenceBoostScale * valence_boost;
+	//optimize for post-TnL cache
+	optimizeVertexCache();
+
+	if (overdraw_threshold >= 1.f)
+	{ //trade some of the cache efficiency for less overdraw
+		optimizeOverdraw(overdraw_threshold);
 	}
 
-	return score;
+	//optimize for pre-TnL cache
+	optimizeVertexFetch();
 }
 
-class LLVCacheFIFO
+void LLVolumeFace::optimizeVertexCache()
 {
-public:
-	LLVCacheVertexData* mCache[MaxSizeVertexCache];
-	U32 mMisses;
+	const U32 num_verts = mNumVertices;
+	const U32 num_tris = mNumIndices/3;
+
+	//per vertex runs of adjacent triangles, live triangles are kept at the front of each run
+	std::vector<U32> tri_offset(num_verts+1, 0);
+	std::vector<U32> active_tris(num_verts, 0);
+	std::vector<U32> adjacency(num_tris*3);
 
-	LLVCacheFIFO()
+	for (U32 i = 0; i < num_tris*3; ++i)
 	{
-		mMisses = 0;
-		for (U32 i = 0; i < MaxSizeVertexCache; ++i)
-		{
-			mCache[i] = NULL;
-		}
+		active_tris[mIndices[i]]++;
 	}
 
-	void addVertex(LLVCacheVertexData* data)
+	for (U32 i = 0; i < num_verts; ++i)
 	{
-		if (data->mCacheTag == -1)
-		{
-			mMisses++;
-
-			S32 end = MaxSizeVertexCache-1;
-
-			if (mCache[end])
-			{
-				mCache[end]->mCacheTag = -1;
-			}
-
-			for (S32 i = end; i > 0; --i)
-			{
-				mCache[i] = mCache[i-1];
-				if (mCache[i])
-				{
-					mCache[i]->mCacheTag = i;
-				}
-			}
+		tri_offset[i+1] = tri_offset[i]+active_tris[i];
+		active_tris[i] = 0;
+	}
 
-			mCache[0] = data;
-			data->mCacheTag = 0;
-		}
+	for (U32 i = 0; i < num_tris*3; ++i)
+	{
+		U16 idx = mIndices[i];
+		adjacency[tri_offset[idx]+active_tris[idx]++] = i/3;
 	}
-};
 
-class LLVCacheLRU
-{
-public:
-	LLVCacheVertexData* mCache[MaxSizeVertexCache+3];
+	//initialize score values (nothing in cache yet)
+	std::vector<S32> cache_idx(num_verts, -1);
+	std::vector<F32> vertex_score(num_verts);
+	for (U32 i = 0; i < num_verts; ++i)
+	{
+		vertex_score[i] = sVCacheScores.getScore(-1, active_tris[i]);
+	}
 
-	LLVCacheTriangleData* mBestTriangle;
-	
-	U32 mMisses;
+	std::vector<F32> tri_score(num_tris);
+	std::vector<U8> emitted(num_tris, 0);
 
-	LLVCacheLRU()
+	S32 best_tri = -1;
+	F32 best_score = -1.f;
+	for (U32 i = 0; i < num_tris; ++i)
 	{
-		for (U32 i = 0; i < MaxSizeVertexCache+3; ++i)
+		const U16* idx = mIndices+i*3;
+		tri_score[i] = vertex_score[idx[0]]+vertex_score[idx[1]]+vertex_score[idx[2]];
+		if (tri_score[i] > best_score)
 		{
-			mCache[i] = NULL;
+			best_score = tri_score[i];
+			best_tri = i;
 		}
-
-		mBestTriangle = NULL;
-		mMisses = 0;
 	}
 
-	void addVertex(LLVCacheVertexData* data)
+	//LRU cache, with room for the 3 vertices that fall off when a triangle is added
+	U32 cache[MaxSizeVertexCache+3];
+	U32 new_cache[MaxSizeVertexCache+3];
+	U32 cache_count = 0;
+
+	std::vector<U16> new_indices(mIndices, mIndices+mNumIndices);
+	U32 out = 0;
+	U32 dead_end_cursor = 0;
+
+	while (best_tri >= 0)
 	{
-		S32 end = MaxSizeVertexCache+2;
-		if (data->mCacheTag != -1)
-		{ //just moving a vertex to the front of the cache
-			end = data->mCacheTag;
-		}
-		else
-		{
-			mMisses++;
-			if (mCache[end])
-			{ //adding a new vertex, vertex at end of cache falls off
-				mCache[end]->mCacheTag = -1;
-			}
-		}
+		const U16* tri = mIndices+best_tri*3;
+		emitted[best_tri] = 1;
 
-		for (S32 i = end; i > 0; --i)
-		{ //adjust cache pointers and tags
-			mCache[i] = mCache[i-1];
+		U32 new_count = 0;
+		for (U32 i = 0; i < 3; ++i)
+		{
+			U16 idx = tri[i];
+			new_indices[out++] = idx;
 
-			if (mCache[i])
+			//retire triangle from this vertex's live run
+			U32* tris = &adjacency[tri_offset[idx]];
+			U32 count = active_tris[idx];
+			for (U32 j = 0; j < count; ++j)
 			{
-				mCache[i]->mCacheTag = i;			
+				if (tris[j] == (U32) best_tri)
+				{
+					tris[j] = tris[count-1];
+					tris[count-1] = best_tri;
+					break;
+				}
 			}
-		}
+			active_tris[idx]--;
 
-		mCache[0] = data;
-		mCache[0]->mCacheTag = 0;
-	}
-
-	void addTriangle(LLVCacheTriangleData* data)
-	{
-		addVertex(data->mVertex[0]);
-		addVertex(data->mVertex[1]);
-		addVertex(data->mVertex[2]);
-	}
+			bool cached = false;
+			for (U32 j = 0; j < new_count; ++j)
+			{
+				cached = cached || new_cache[j] == idx;
+			}
 
-	void updateScores()
-	{
-		LLVCacheVertexData** data_iter = mCache+MaxSizeVertexCache;
-		LLVCacheVertexData** end_data = mCache+MaxSizeVertexCache+3;
+			if (!cached)
+			{ //triangle vertices go to the front of the cache
+				new_cache[new_count++] = idx;
+			}
+		}
 
-		while(data_iter != end_data)
+		for (U32 i = 0; i < cache_count; ++i)
 		{
-			LLVCacheVertexData* data = *data_iter++;
-			//trailing 3 vertices aren't actually in the cache for scoring purposes
-			if (data)
+			U32 idx = cache[i];
+			if (idx != tri[0] && idx != tri[1] && idx != tri[2])
 			{
-				data->mCacheTag = -1;
+				new_cache[new_count++] = idx;
 			}
 		}
 
-		data_iter = mCache;
-		end_data = mCache+MaxSizeVertexCache;
+		//update scores of vertices that moved in (or fell out of) the cache
+		for (U32 i = 0; i < new_count; ++i)
+		{
+			U32 idx = new_cache[i];
+			S32 pos = i < MaxSizeVertexCache ? (S32) i : -1;
+			cache_idx[idx] = pos;
+
+			F32 score = sVCacheScores.getScore(pos, active_tris[idx]);
+			F32 delta = score-vertex_score[idx];
+			vertex_score[idx] = score;
 
-		while (data_iter != end_data)
-		{ //update scores of vertices in cache
-			LLVCacheVertexData* data = *data_iter++;
-			if (data)
+			const U32* tris = &adjacency[tri_offset[idx]];
+			for (U32 j = 0; j < active_tris[idx]; ++j)
 			{
-				data->mScore = find_vertex_score(*data);
+				tri_score[tris[j]] += delta;
 			}
 		}
 
-		mBestTriangle = NULL;
-		//update triangle scores
-		data_iter = mCache;
-		end_data = mCache+MaxSizeVertexCache+3;
+		cache_count = llmin(new_count, MaxSizeVertexCache);
+		memcpy(cache, new_cache, sizeof(U32)*cache_count);
 
-		while (data_iter != end_data)
+		//best candidate is a live triangle touching the cache
+		best_tri = -1;
+		best_score = -1.f;
+		for (U32 i = 0; i < cache_count; ++i)
 		{
-			LLVCacheVertexData* data = *data_iter++;
-			if (data)
+			U32 idx = cache[i];
+			const U32* tris = &adjacency[tri_offset[idx]];
+			for (U32 j = 0; j < active_tris[idx]; ++j)
 			{
-				for (std::vector<LLVCacheTriangleData*>::iterator iter = data->mTriangles.begin(), end_iter = data->mTriangles.end(); iter != end_iter; ++iter)
+				if (tri_score[tris[j]] > best_score)
 				{
-					LLVCacheTriangleData* tri = *iter;
-					if (tri->mActive)
-					{
-						tri->mScore = tri->mVertex[0]->mScore;
-						tri->mScore += tri->mVertex[1]->mScore;
-						tri->mScore += tri->mVertex[2]->mScore;
-
-						if (!mBestTriangle || mBestTriangle->mScore < tri->mScore)
-						{
-							mBestTriangle = tri;
-						}
-					}
+					best_score = tri_score[tris[j]];
+					best_tri = tris[j];
 				}
 			}
 		}
 
-		//knock trailing 3 vertices off the cache
-		data_iter = mCache+MaxSizeVertexCache;
-		end_data = mCache+MaxSizeVertexCache+3;
-		while (data_iter != end_data)
-		{
-			LLVCacheVertexData* data = *data_iter;
-			if (data)
+		if (best_tri < 0)
+		{ //dead end, resume at the next triangle that hasn't been emitted
+			while (dead_end_cursor < num_tris && emitted[dead_end_cursor])
 			{
-				llassert(data->mCacheTag == -1);
-				*data_iter = NULL;
+				++dead_end_cursor;
+			}
+
+			if (dead_end_cursor < num_tris)
+			{
+				best_tri = dead_end_cursor;
 			}
-			++data_iter;
 		}
 	}
-};
-
 
-void LLVolumeFace::cacheOptimize()
-{ //optimize for vertex cache according to Forsyth method: 
-  // http://home.comcast.net/~tom_forsyth/papers/fast_vert_cache_opt.html
-	
-	llassert(!mOptimized);
-	mOptimized = TRUE;
+	llassert(out == num_tris*3);
+	memcpy(mIndices, &new_indices[0], sizeof(U16)*mNumIndices);
+}
 
-	LLVCacheLRU cache;
-	
-	if (mNumVertices < 3)
-	{ //nothing to do
+void LLVolumeFace::optimizeOverdraw(F32 threshold)
+{ //sort clusters of triangles so outer, outward facing parts of the mesh draw first.
+  //see Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+	const U32 num_tris = mNumIndices/3;
+	if (num_tris < 2)
+	{
 		return;
 	}
 
-	//mapping of vertices to triangles and indices
-	std::vector<LLVCacheVertexData> vertex_data;
-
-	//mapping of triangles do vertices
-	std::vector<LLVCacheTriangleData> triangle_data;
-
-	triangle_data.resize(mNumIndices/3);
-	vertex_data.resize(mNumVertices);
+	std::vector<U32> timestamps(mNumVertices, 0);
+	U32 time = StatsSizeVertexCache+1;
 
-	for (U32 i = 0; i < mNumIndices; i++)
-	{ //populate vertex data and triangle data arrays
-		U16 idx = mIndices[i];
-		U32 tri_idx = i/3;
+	//hard cluster boundaries are where the cache-optimized order starts over with a cold cache
+	std::vector<U32> hard_clusters;
+	for (U32 i = 0; i < num_tris; ++i)
+	{
+		const U16* tri = mIndices+i*3;
+		U32 misses = vcache_fifo_add(timestamps, time, StatsSizeVertexCache, tri[0]);
+		misses += vcache_fifo_add(timestamps, time, StatsSizeVertexCache, tri[1]);
+		misses += vcache_fifo_add(timestamps, time, StatsSizeVertexCache, tri[2]);
 
-		vertex_data[idx].mTriangles.push_back(&(triangle_data[tri_idx]));
-		vertex_data[idx].mIdx = idx;
-		triangle_data[tri_idx].mVertex[i%3] = &(vertex_data[idx]);
+		if (i == 0 || misses == 3)
+		{
+			hard_clusters.push_back(i);
+		}
 	}
+	hard_clusters.push_back(num_tris);
 
-	/*F32 pre_acmr = 1.f;
-	//measure cache misses from before rebuild
+	//soft boundaries split hard clusters wherever restarting the cache keeps ACMR within threshold
+	std::vector<U32> clusters;
+	for (U32 c = 0; c+1 < hard_clusters.size(); ++c)
 	{
-		LLVCacheFIFO test_cache;
-		for (U32 i = 0; i < mNumIndices; ++i)
+		U32 start = hard_clusters[c];
+		U32 end = hard_clusters[c+1];
+
+		time += StatsSizeVertexCache+1;
+		U32 cluster_misses = 0;
+		for (U32 i = start*3; i < end*3; ++i)
 		{
-			test_cache.addVertex(&vertex_data[mIndices[i]]);
+			cluster_misses += vcache_fifo_add(timestamps, time, StatsSizeVertexCache, mIndices[i]);
 		}
 
-		for (U32 i = 0; i < mNumVertices; i++)
+		F32 cluster_threshold = threshold*cluster_misses/(end-start);
+
+		clusters.push_back(start);
+		time += StatsSizeVertexCache+1;
+
+		U32 running_misses = 0;
+		U32 running_tris = 0;
+		for (U32 i = start; i < end; ++i)
 		{
-			vertex_data[i].mCacheTag = -1;
+			const U16* tri = mIndices+i*3;
+			running_misses += vcache_fifo_add(timestamps, time, StatsSizeVertexCache, tri[0]);
+			running_misses += vcache_fifo_add(timestamps, time, StatsSizeVertexCache, tri[1]);
+			running_misses += vcache_fifo_add(timestamps, time, StatsSizeVertexCache, tri[2]);
+			running_tris++;
+
+			if (i+1 < end && (F32) running_misses <= cluster_threshold*running_tris)
+			{ //target reached, start a new cluster on the next triangle
+				clusters.push_back(i+1);
+				time += StatsSizeVertexCache+1;
+				running_misses = 0;
+				running_tris = 0;
+			}
 		}
+		//trailing triangles that never reached the target stay a cluster of their own,
+		//the cluster before them already met it and isn't grown any further
+	}
+	clusters.push_back(num_tris);
 
-		pre_acmr = (F32) test_cache.mMisses/(mNumIndices/3);
-	}*/
+	LLVector4a mesh_center;
+	mesh_center.clear();
+	for (S32 i = 0; i < mNumVertices; ++i)
+	{
+		mesh_center.add(mPositions[i]);
+	}
+	mesh_center.mul(1.f/mNumVertices);
 
-	for (U32 i = 0; i < mNumVertices; i++)
-	{ //initialize score values (no cache -- might try a fifo cache here)
-		LLVCacheVertexData& data = vertex_data[i];
+	//sort key is how far each cluster's area weighted center lies along its area weighted normal
+	std::vector<std::pair<F32, U32> > sort_data;
+	sort_data.reserve(clusters.size()-1);
 
-		data.mScore = find_vertex_score(data);
-		data.mActiveTriangles = data.mTriangles.size();
+	for (U32 c = 0; c+1 < clusters.size(); ++c)
+	{
+		LLVector4a center;
+		LLVector4a normal;
+		center.clear();
+		normal.clear();
+		F32 area_sum = 0.f;
 
-		for (U32 j = 0; j < data.mActiveTriangles; ++j)
+		for (U32 i = clusters[c]*3; i < clusters[c+1]*3; i += 3)
 		{
-			data.mTriangles[j]->mScore += data.mScore;
-		}
-	}
+			const LLVector4a& v0 = mPositions[mIndices[i]];
+			const LLVector4a& v1 = mPositions[mIndices[i+1]];
+			const LLVector4a& v2 = mPositions[mIndices[i+2]];
 
-	//sort triangle data by score
-	std::sort(triangle_data.begin(), triangle_data.end());
+			LLVector4a e0;
+			LLVector4a e1;
+			e0.setSub(v1, v0);
+			e1.setSub(v2, v0);
 
-	std::vector<U16> new_indices;
+			LLVector4a n;
+			n.setCross3(e0, e1);
+			F32 area = n.getLength3().getF32();
 
-	LLVCacheTriangleData* tri;
+			LLVector4a tri_center;
+			tri_center.setAdd(v0, v1);
+			tri_center.add(v2);
+			tri_center.mul(area/3.f);
 
-	//prime pump by adding first triangle to cache;
-	tri = &(triangle_data[0]);
-	cache.addTriangle(tri);
-	new_indices.push_back(tri->mVertex[0]->mIdx);
-	new_indices.push_back(tri->mVertex[1]->mIdx);
-	new_indices.push_back(tri->mVertex[2]->mIdx);
-	tri->complete();
+			center.add(tri_center);
+			normal.add(n);
+			area_sum += area;
+		}
 
-	U32 breaks = 0;
-	for (U32 i = 1; i < mNumIndices/3; ++i)
-	{
-		cache.updateScores();
-		tri = cache.mBestTriangle;
-		if (!tri)
+		F32 dp = 0.f;
+		F32 normal_length = normal.getLength3().getF32();
+		if (area_sum > 0.f && normal_length > 0.f)
 		{
-			breaks++;
-			for (U32 j = 0; j < triangle_data.size(); ++j)
-			{
-				if (triangle_data[j].mActive)
-				{
-					tri = &(triangle_data[j]);
-					break;
-				}
-			}
-		}	
-		
-		cache.addTriangle(tri);
-		new_indices.push_back(tri->mVertex[0]->mIdx);
-		new_indices.push_back(tri->mVertex[1]->mIdx);
-		new_indices.push_back(tri->mVertex[2]->mIdx);
-		tri->complete();
-	}
+			center.mul(1.f/area_sum);
+			center.sub(mesh_center);
+			normal.mul(1.f/normal_length);
+			dp = center.dot3(normal).getF32();
+		}
 
-	for (U32 i = 0; i < mNumIndices; ++i)
-	{
-		mIndices[i] = new_indices[i];
+		sort_data.push_back(std::make_pair(-dp, c));
 	}
 
-	/*F32 post_acmr = 1.f;
-	//measure cache misses from after rebuild
+	std::stable_sort(sort_data.begin(), sort_data.end());
+
+	std::vector<U16> new_indices(mIndices, mIndices+mNumIndices);
+	U32 out = 0;
+	for (U32 i = 0; i < sort_data.size(); ++i)
 	{
-		LLVCacheFIFO test_cache;
-		for (U32 i = 0; i < mNumVertices; i++)
+		U32 c = sort_data[i].second;
+		for (U32 j = clusters[c]*3; j < clusters[c+1]*3; ++j)
 		{
-			vertex_data[i].mCacheTag = -1;
+			new_indices[out++] = mIndices[j];
 		}
+	}
 
-		for (U32 i = 0; i < mNumIndices; ++i)
-		{
-			test_cache.addVertex(&vertex_data[mIndices[i]]);
-		}
-		
-		post_acmr = (F32) test_cache.mMisses/(mNumIndices/3);
-	}*/
+	llassert(out == num_tris*3);
+	memcpy(mIndices, &new_indices[0], sizeof(U16)*mNumIndices);
+}
 
-	//optimize for pre-TnL cache
-	
+void LLVolumeFace::optimizeVertexFetch()
+{
 	//allocate space for new buffer
 	S32 num_verts = mNumVertices;
 	S32 size = ((num_verts*sizeof(LLVector2)) + 0xF) & ~0xF;
@@ -5292,22 +5517,29 @@ void LLVolumeFace::cacheOptimize()
 		U16 idx = mIndices[i];
 		if (new_idx[idx] == -1)
 		{ //this vertex hasn't been added yet
-			new_idx[idx] = cur_idx;
+			new_idx[idx] = cur_idx++;
+		}
+	}
 
-			//copy vertex data
-			pos[cur_idx] = mPositions[idx];
-			norm[cur_idx] = mNormals[idx];
-			tc[cur_idx] = mTexCoords[idx];
-			if (mWeights)
-			{
-				wght[cur_idx] = mWeights[idx];
-			}
-			if (mTangents)
-			{
-				binorm[cur_idx] = mTangents[idx];
-			}
+	for (S32 i = 0; i < num_verts; ++i)
+	{
+		if (new_idx[i] == -1)
+		{ //keep unreferenced vertices at the end of the buffer
+			new_idx[i] = cur_idx++;
+		}
 
-			cur_idx++;
+		//copy vertex data
+		S32 dst = new_idx[i];
+		pos[dst] = mPositions[i];
+		norm[dst] = mNormals[i];
+		tc[dst] = mTexCoords[i];
+		if (mWeights)
+		{
+			wght[dst] = mWeights[i];
+		}
+		if (mTangents)
+		{
+			binorm[dst] = mTangents[i];
 		}
 	}
 
@@ -5326,10 +5558,38 @@ void LLVolumeFace::cacheOptimize()
 	mTexCoords = tc;
 	mWeights = wght;
 	mTangents = binorm;
+}
+
+void LLVolumeFace::getVertexCacheStats(U32 cache_size, F32& acmr, F32& atvr) const
+{ //average cache miss ratio per triangle and transformed vertex ratio for a FIFO cache of cache_size
+	acmr = 0.f;
+	atvr = 0.f;
+
+	if (mNumVertices == 0 || mNumIndices < 3)
+	{
+		return;
+	}
+
+	std::vector<U32> timestamps(mNumVertices, 0);
+	U32 time = cache_size+1;
+	U32 misses = 0;
 
-	//std::string result = llformat("ACMR pre/post: %.3f/%.3f  --  %d triangles %d breaks", pre_acmr, post_acmr, mNumIndices/3, breaks);
-	//LL_INFOS() << result << LL_ENDL;
+	for (U32 i = 0; i < mNumIndices; ++i)
+	{
+		misses += vcache_fifo_add(timestamps, time, cache_size, mIndices[i]);
+	}
+
+	U32 referenced = 0;
+	for (S32 i = 0; i < mNumVertices; ++i)
+	{
+		if (timestamps[i] != 0)
+		{
+			referenced++;
+		}
+	}
 
+	acmr = (F32) misses/(mNumIndices/3);
+	atvr = (F32) misses/referenced;
 }
 
 void LLVolumeFace::createOctree(F32 scaler, const LLVector4a& center, const LLVector4a& size)
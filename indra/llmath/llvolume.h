@@ -895,7 +895,15 @@ public:
 	};
 
 	void optimize(F32 angle_cutoff = 2.f);
-	void cacheOptimize();
+
+	// Reorder triangles for the post-transform vertex cache and vertices for fetch locality.
+	// An overdraw_threshold >= 1 also sorts triangle clusters to reduce overdraw, allowing
+	// ACMR to grow by up to that factor.
+	void cacheOptimize(F32 overdraw_threshold = 0.f);
+
+	// Average cache miss ratio (misses per triangle) and average transformed vertex ratio
+	// (misses per referenced vertex) of the current index order for a FIFO cache of cache_size.
+	void getVertexCacheStats(U32 cache_size, F32& acmr, F32& atvr) const;
 
 	void createOctree(F32 scaler = 0.25f, const LLVector4a& center = LLVector4a(0,0,0), const LLVector4a& size = LLVector4a(0.5f,0.5f,0.5f));
 
@@ -955,6 +963,10 @@ public:
 	BOOL mOptimized;
 
 private:
+	void optimizeVertexCache();
+	void optimizeOverdraw(F32 threshold);
+	void optimizeVertexFetch();
+
 	BOOL createUnCutCubeCap(LLVolume* volume, BOOL partial_build = FALSE);
 	BOOL createCap(LLVolume* volume, BOOL partial_build = FALSE);
 	BOOL createSide(LLVolume* volume, BOOL partial_build = FALSE);
@@ -1048,7 +1060,7 @@ public:
 	void copyVolumeFaces(const LLVolume* volume);
 	void copyFacesTo(std::vector<LLVolumeFace> &faces) const;
 	void copyFacesFrom(const std::vector<LLVolumeFace> &faces);
-	void cacheOptimize();
+	void cacheOptimize(F32 overdraw_threshold = 0.f);
 
 private:
 	void sculptGenerateMapVertices(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components, const U8* sculpt_data, U8 sculpt_type);
@@ -1062,6 +1074,15 @@ protected:
 	void createVolumeFaces();
 public:
 	virtual bool unpackVolumeFaces(std::istream& is, S32 size);
+	// unpack faces from a zlib compressed LLSD block held in memory
+	bool unpackVolumeFaces(const U8* data, S32 size);
+
+	// Faces as they are held in memory, for caching decoded meshes.
+	// Arrays are 16 byte aligned relative to the start of the block,
+	// bump DECODED_FACES_VERSION when the layout changes.
+	enum { DECODED_FACES_VERSION = 1 };
+	void packDecodedFaces(std::vector<U8>& data) const;
+	bool unpackDecodedFaces(const U8* data, S32 size);
 
 	virtual void setMeshAssetLoaded(BOOL loaded);
 	virtual BOOL isMeshAssetLoaded();
@@ -29,6 +29,7 @@
 
 #include "linden_common.h"
 #include "llmemory.h"
+#include "llslaballocator.h"
 
 #include "lloctree.h"
 #include "llvolume.h"
@@ -37,14 +38,15 @@
 class LLVolumeTriangle : public LLRefCount
 {
 public:
+	// one per triangle of every octree, from a slab pool
 	void* operator new(size_t size)
 	{
-		return ll_aligned_malloc_16(size);
+		return ll_slab_allocate<LLVolumeTriangle, 16>(size);
 	}
 
-	void operator delete(void* ptr)
+	void operator delete(void* ptr, size_t size)
 	{
-		ll_aligned_free_16(ptr);
+		ll_slab_free<LLVolumeTriangle, 16>(ptr, size);
 	}
 
 	LLVolumeTriangle()
@@ -0,0 +1,443 @@
+/**
+ * @file llvolume_test.cpp
+ * @brief LLVolumeFace cache optimization and decoded face packing test cases.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llvolume.h"
+#include "../lloctree.h"
+
+#include <algorithm>
+
+// globals normally provided by llrender and newview
+BOOL gDebugGL = FALSE;
+BOOL gIsInSecondLife = FALSE;
+U32 gOctreeMaxCapacity = 128;
+F32 gOctreeMinSize = 0.01f;
+
+namespace
+{
+	const S32 GRID_SIZE = 64;
+
+	// triangles as sorted lists of positions, independent of vertex and triangle order
+	typedef std::vector<std::vector<F32> > triangle_list_t;
+
+	void build_shuffled_grid(LLVolumeFace& face)
+	{
+		face.resizeVertices((GRID_SIZE+1)*(GRID_SIZE+1));
+		for (S32 y = 0; y <= GRID_SIZE; ++y)
+		{
+			for (S32 x = 0; x <= GRID_SIZE; ++x)
+			{
+				S32 i = y*(GRID_SIZE+1)+x;
+				face.mPositions[i].set((F32) x, (F32) y, 0.f, 1.f);
+				face.mNormals[i].set(0.f, 0.f, 1.f, 0.f);
+				face.mTexCoords[i].set((F32) x/GRID_SIZE, (F32) y/GRID_SIZE);
+			}
+		}
+
+		std::vector<U16> indices;
+		for (S32 y = 0; y < GRID_SIZE; ++y)
+		{
+			for (S32 x = 0; x < GRID_SIZE; ++x)
+			{
+				U16 a = y*(GRID_SIZE+1)+x;
+				U16 b = a+1;
+				U16 c = a+GRID_SIZE+1;
+				U16 d = c+1;
+				indices.push_back(a); indices.push_back(b); indices.push_back(d);
+				indices.push_back(a); indices.push_back(d); indices.push_back(c);
+			}
+		}
+
+		// deterministic scramble of the triangle order
+		U32 num_tris = indices.size()/3;
+		U32 seed = 12345;
+		for (U32 i = num_tris-1; i > 0; --i)
+		{
+			seed = seed*1103515245+12345;
+			U32 j = (seed >> 8) % (i+1);
+			for (U32 k = 0; k < 3; ++k)
+			{
+				std::swap(indices[i*3+k], indices[j*3+k]);
+			}
+		}
+
+		face.resizeIndices(indices.size());
+		std::copy(indices.begin(), indices.end(), face.mIndices);
+	}
+
+	// one sphere inside another, the inner one hidden from every side,
+	// with the inner sphere's triangles first
+	void build_nested_spheres(LLVolumeFace& face)
+	{
+		const S32 RINGS = 16;
+		const S32 SEGMENTS = 32;
+		const S32 SPHERE_VERTS = (RINGS+1)*(SEGMENTS+1);
+		const F32 radius[] = { 0.5f, 1.f };
+
+		face.resizeVertices(SPHERE_VERTS*2);
+		std::vector<U16> indices;
+		for (S32 sphere = 0; sphere < 2; ++sphere)
+		{
+			for (S32 r = 0; r <= RINGS; ++r)
+			{
+				F32 theta = F_PI*r/RINGS;
+				for (S32 s = 0; s <= SEGMENTS; ++s)
+				{
+					F32 phi = F_TWO_PI*s/SEGMENTS;
+					S32 i = sphere*SPHERE_VERTS+r*(SEGMENTS+1)+s;
+					LLVector4a normal(sinf(theta)*cosf(phi), sinf(theta)*sinf(phi), cosf(theta));
+					face.mNormals[i] = normal;
+					face.mPositions[i].setMul(normal, radius[sphere]);
+					face.mTexCoords[i].set((F32) s/SEGMENTS, (F32) r/RINGS);
+				}
+			}
+
+			// wound to face outward
+			for (S32 r = 0; r < RINGS; ++r)
+			{
+				for (S32 s = 0; s < SEGMENTS; ++s)
+				{
+					U16 a = sphere*SPHERE_VERTS+r*(SEGMENTS+1)+s;
+					U16 b = a+SEGMENTS+1;
+					U16 c = b+1;
+					U16 d = a+1;
+					indices.push_back(a); indices.push_back(b); indices.push_back(c);
+					indices.push_back(a); indices.push_back(c); indices.push_back(d);
+				}
+			}
+		}
+
+		face.resizeIndices(indices.size());
+		std::copy(indices.begin(), indices.end(), face.mIndices);
+	}
+
+	// Shaded fragments per covered pixel, drawing the triangles in index
+	// order with back face culling and a depth test, averaged over views
+	// along the six axes.
+	F32 get_overdraw(const LLVolumeFace& face)
+	{
+		const S32 RESOLUTION = 64;
+		const F32 EXTENT = 1.1f;
+
+		U32 shaded = 0;
+		U32 covered = 0;
+		for (S32 view = 0; view < 6; ++view)
+		{
+			// towards the viewer, and the two axes of the image
+			S32 axis = view/2;
+			F32 sign = view%2 ? -1.f : 1.f;
+
+			std::vector<F32> depth(RESOLUTION*RESOLUTION, -FLT_MAX);
+			for (S32 i = 0; i < face.mNumIndices; i += 3)
+			{
+				F32 x[3], y[3], z[3];
+				for (S32 j = 0; j < 3; ++j)
+				{
+					const F32* pos = face.mPositions[face.mIndices[i+j]].getF32ptr();
+					z[j] = pos[axis]*sign;
+					x[j] = (pos[(axis+1)%3]*sign/EXTENT*0.5f+0.5f)*RESOLUTION;
+					y[j] = (pos[(axis+2)%3]/EXTENT*0.5f+0.5f)*RESOLUTION;
+				}
+
+				// the axes are right handed, or mirrored along with the view
+				F32 area = (x[1]-x[0])*(y[2]-y[0])-(x[2]-x[0])*(y[1]-y[0]);
+				if (area <= 0.f)
+				{
+					continue;
+				}
+
+				S32 min_x = llmax((S32) floorf(llmin(x[0], x[1], x[2])), 0);
+				S32 max_x = llmin((S32) ceilf(llmax(x[0], x[1], x[2])), RESOLUTION-1);
+				S32 min_y = llmax((S32) floorf(llmin(y[0], y[1], y[2])), 0);
+				S32 max_y = llmin((S32) ceilf(llmax(y[0], y[1], y[2])), RESOLUTION-1);
+				for (S32 py = min_y; py <= max_y; ++py)
+				{
+					for (S32 px = min_x; px <= max_x; ++px)
+					{
+						F32 cx = px+0.5f;
+						F32 cy = py+0.5f;
+						F32 w0 = (x[2]-x[1])*(cy-y[1])-(cx-x[1])*(y[2]-y[1]);
+						F32 w1 = (x[0]-x[2])*(cy-y[2])-(cx-x[2])*(y[0]-y[2]);
+						F32 w2 = area-w0-w1;
+						if (w0 < 0.f || w1 < 0.f || w2 < 0.f)
+						{
+							continue;
+						}
+
+						F32 pz = (w0*z[0]+w1*z[1]+w2*z[2])/area;
+						F32& pixel = depth[py*RESOLUTION+px];
+						if (pz > pixel)
+						{
+							covered += pixel == -FLT_MAX ? 1 : 0;
+							pixel = pz;
+							shaded++;
+						}
+					}
+				}
+			}
+		}
+
+		return covered ? (F32) shaded/covered : 0.f;
+	}
+
+	triangle_list_t get_triangles(const LLVolumeFace& face)
+	{
+		triangle_list_t tris;
+		for (S32 i = 0; i < face.mNumIndices; i += 3)
+		{
+			std::vector<F32> tri;
+			for (S32 j = 0; j < 3; ++j)
+			{
+				const F32* pos = face.mPositions[face.mIndices[i+j]].getF32ptr();
+				tri.insert(tri.end(), pos, pos+3);
+			}
+
+			// rotate so the smallest corner comes first, winding is preserved
+			std::vector<F32> best = tri;
+			for (S32 r = 1; r < 3; ++r)
+			{
+				std::vector<F32> rot(9);
+				for (S32 j = 0; j < 9; ++j)
+				{
+					rot[j] = tri[(j+r*3)%9];
+				}
+				if (rot < best)
+				{
+					best = rot;
+				}
+			}
+			tris.push_back(best);
+		}
+		std::sort(tris.begin(), tris.end());
+		return tris;
+	}
+}
+
+namespace tut
+{
+	struct LLVolumeFaceData
+	{
+	};
+
+	typedef test_group<LLVolumeFaceData> factory;
+	typedef factory::object object;
+}
+
+namespace
+{
+	tut::factory llvolume_test_factory("LLVolumeFace");
+}
+
+namespace tut
+{
+	template<> template<>
+	void object::test<1>()
+	{
+		//
+		// test vertex cache optimization of a scrambled grid
+		//
+		LLVolumeFace face;
+		build_shuffled_grid(face);
+
+		triangle_list_t before = get_triangles(face);
+		F32 acmr_before, atvr_before;
+		face.getVertexCacheStats(16, acmr_before, atvr_before);
+
+		face.cacheOptimize();
+
+		F32 acmr_after, atvr_after;
+		face.getVertexCacheStats(16, acmr_after, atvr_after);
+
+		ensure("cacheOptimize preserves triangles", before == get_triangles(face));
+		ensure("cacheOptimize reduces ACMR", acmr_after < acmr_before);
+		ensure("cacheOptimize ACMR near optimal", acmr_after < 0.8f);
+		ensure("cacheOptimize ATVR near optimal", atvr_after < 1.5f);
+		ensure("cacheOptimize marks face optimized", face.mOptimized);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		//
+		// test overdraw optimization stays within its ACMR threshold
+		//
+		LLVolumeFace reference;
+		build_shuffled_grid(reference);
+		reference.cacheOptimize();
+
+		F32 acmr_reference, atvr_reference;
+		reference.getVertexCacheStats(16, acmr_reference, atvr_reference);
+
+		LLVolumeFace face;
+		build_shuffled_grid(face);
+		triangle_list_t before = get_triangles(face);
+
+		face.cacheOptimize(1.05f);
+
+		F32 acmr, atvr;
+		face.getVertexCacheStats(16, acmr, atvr);
+
+		ensure("overdraw optimization preserves triangles", before == get_triangles(face));
+		ensure("overdraw optimization ACMR bounded", acmr < acmr_reference*1.15f);
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		//
+		// test vertex fetch remapping orders vertices by first use
+		//
+		LLVolumeFace face;
+		build_shuffled_grid(face);
+		face.cacheOptimize();
+
+		U16 next = 0;
+		bool ordered = true;
+		for (S32 i = 0; i < face.mNumIndices; ++i)
+		{
+			if (face.mIndices[i] > next)
+			{
+				ordered = false;
+			}
+			else if (face.mIndices[i] == next)
+			{
+				next++;
+			}
+		}
+
+		ensure("vertices in first use order", ordered);
+		ensure_equals("all vertices referenced", (S32) next, face.mNumVertices);
+	}
+
+	template<> template<>
+	void object::test<4>()
+	{
+		//
+		// test decoded faces survive a pack/unpack round trip
+		//
+		std::vector<LLVolumeFace> faces(3);
+		build_shuffled_grid(faces[0]);
+		faces[0].cacheOptimize();
+		faces[0].mExtents[0].set(0.f, 0.f, 0.f);
+		faces[0].mExtents[1].set((F32) GRID_SIZE, (F32) GRID_SIZE, 0.f);
+
+		build_shuffled_grid(faces[1]);
+		faces[1].allocateWeights(faces[1].mNumVertices);
+		for (S32 i = 0; i < faces[1].mNumVertices; ++i)
+		{
+			faces[1].mWeights[i].set(1.5f, 2.25f, (F32) (i%7), 0.f);
+		}
+		faces[1].mTexCoordExtents[0].set(0.f, 0.f);
+		faces[1].mTexCoordExtents[1].set(1.f, 1.f);
+		// faces[2] left empty, as unpackVolumeFaces does for empty index lists
+
+		LLVolumeParams params;
+		LLPointer<LLVolume> volume = new LLVolume(params, 1.f);
+		volume->copyFacesFrom(faces);
+
+		std::vector<U8> data;
+		volume->packDecodedFaces(data);
+		ensure_equals("packed size is 16 byte aligned", data.size()%16, (size_t) 0);
+
+		LLPointer<LLVolume> unpacked = new LLVolume(params, 1.f);
+		ensure("unpackDecodedFaces", unpacked->unpackDecodedFaces(&data[0], data.size()));
+		ensure_equals("face count", unpacked->getNumVolumeFaces(), 3);
+
+		for (S32 f = 0; f < 3; ++f)
+		{
+			const LLVolumeFace& src = faces[f];
+			const LLVolumeFace& dst = unpacked->getVolumeFace(f);
+			ensure_equals("vertex count", dst.mNumVertices, src.mNumVertices);
+			ensure_equals("index count", dst.mNumIndices, src.mNumIndices);
+			ensure_equals("optimized", dst.mOptimized, src.mOptimized);
+			ensure("weights", (dst.mWeights != NULL) == (src.mWeights != NULL));
+			if (src.mNumVertices)
+			{
+				ensure_memory_matches("positions", dst.mPositions, sizeof(LLVector4a)*src.mNumVertices, src.mPositions, sizeof(LLVector4a)*src.mNumVertices);
+				ensure_memory_matches("normals", dst.mNormals, sizeof(LLVector4a)*src.mNumVertices, src.mNormals, sizeof(LLVector4a)*src.mNumVertices);
+				ensure_memory_matches("texture coordinates", dst.mTexCoords, sizeof(LLVector2)*src.mNumVertices, src.mTexCoords, sizeof(LLVector2)*src.mNumVertices);
+				ensure_memory_matches("indices", dst.mIndices, sizeof(U16)*src.mNumIndices, src.mIndices, sizeof(U16)*src.mNumIndices);
+				ensure_memory_matches("extents", dst.mExtents, sizeof(LLVector4a)*2, src.mExtents, sizeof(LLVector4a)*2);
+				ensure_memory_matches("texture coordinate extents", dst.mTexCoordExtents, sizeof(LLVector2)*2, src.mTexCoordExtents, sizeof(LLVector2)*2);
+			}
+			if (src.mWeights)
+			{
+				ensure_memory_matches("weight data", dst.mWeights, sizeof(LLVector4a)*src.mNumVertices, src.mWeights, sizeof(LLVector4a)*src.mNumVertices);
+			}
+		}
+
+		// truncated or corrupt blocks are rejected
+		LLPointer<LLVolume> bad = new LLVolume(params, 1.f);
+		ensure("truncated block", !bad->unpackDecodedFaces(&data[0], data.size()-16));
+		ensure("empty block", !bad->unpackDecodedFaces(&data[0], 8));
+
+		std::vector<U8> corrupt = data;
+		U16 out_of_range = 0xFFFF;
+		S32 tc_bytes = (sizeof(LLVector2)*faces[0].mNumVertices + 0xF) & ~0xF;
+		S32 index_offset = 16 + 64 + sizeof(LLVector4a)*2*faces[0].mNumVertices + tc_bytes;
+		memcpy(&corrupt[index_offset], &out_of_range, sizeof(U16));
+		ensure("out of range index", !bad->unpackDecodedFaces(&corrupt[0], corrupt.size()));
+		ensure_equals("failed unpack leaves no faces", bad->getNumVolumeFaces(), 0);
+	}
+
+	template<> template<>
+	void object::test<5>()
+	{
+		//
+		// test overdraw optimization draws the outside of a mesh first
+		//
+		LLVolumeFace original;
+		build_nested_spheres(original);
+		F32 acmr_original, atvr_original;
+		original.getVertexCacheStats(16, acmr_original, atvr_original);
+		F32 overdraw_original = get_overdraw(original);
+
+		LLVolumeFace cache_only;
+		build_nested_spheres(cache_only);
+		cache_only.cacheOptimize();
+		F32 acmr_cache_only, atvr_cache_only;
+		cache_only.getVertexCacheStats(16, acmr_cache_only, atvr_cache_only);
+		F32 overdraw_cache_only = get_overdraw(cache_only);
+
+		LLVolumeFace face;
+		build_nested_spheres(face);
+		triangle_list_t before = get_triangles(face);
+		face.cacheOptimize(1.05f);
+		F32 acmr, atvr;
+		face.getVertexCacheStats(16, acmr, atvr);
+		F32 overdraw = get_overdraw(face);
+
+		ensure("overdraw optimization preserves triangles", before == get_triangles(face));
+		ensure("inner sphere drawn first has overdraw", overdraw_original > 1.2f);
+		ensure("overdraw optimization reduces overdraw", overdraw < overdraw_original && overdraw < overdraw_cache_only);
+		ensure("overdraw optimization near no overdraw", overdraw < 1.1f);
+		ensure("overdraw optimization reduces ACMR", acmr < acmr_original);
+		ensure("overdraw optimization ACMR bounded", acmr < acmr_cache_only*1.15f);
+	}
+}
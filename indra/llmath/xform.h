@@ -162,6 +162,15 @@ public:
 
 	void update();
 	void updateMatrix(BOOL update_bounds = TRUE);
+
+	// for callers that computed the world transform themselves (see
+	// LLJointHierarchy), same result as update() followed by updateMatrix(FALSE)
+	void setWorldTransform(const LLVector3& pos, const LLQuaternion& rot)
+	{
+		mWorldPosition = pos;
+		mWorldRotation = rot;
+		mWorldMatrix.initAll(mScale, mWorldRotation, mWorldPosition);
+	}
 	void getMinMax(LLVector3& min,LLVector3& max) const;
 
 protected:
@@ -62,7 +62,6 @@
 #include "llstoredmessage.h"
 
 const U32 MESSAGE_MAX_STRINGS_LENGTH = 64;
-const U32 MESSAGE_NUMBER_OF_HASH_BUCKETS = 8192;
 
 const S32 MESSAGE_MAX_PER_FRAME = 400;
 
@@ -72,11 +71,15 @@ public:
 	LLMessageStringTable();
 	~LLMessageStringTable();
 
+	// Message, block and variable names are compared by these pointers.
 	char *getString(const char *str);
 
-	U32	 mUsed;
-	BOOL mEmpty[MESSAGE_NUMBER_OF_HASH_BUCKETS];
-	char mString[MESSAGE_NUMBER_OF_HASH_BUCKETS][MESSAGE_MAX_STRINGS_LENGTH];	/* Flawfinder: ignore */
+	// The names by handle, from 1 to getPool().size() in the order they
+	// were first seen.
+	const LLStringPool& getPool() const { return mPool; }
+
+private:
+	LLStringPool mPool;
 };
 
 
@@ -2053,6 +2053,8 @@ bool LLModel::loadModel(std::istream& is)
 
 	if (unpackVolumeFaces(is, header[nm[lod]]["size"].asInteger()))
 	{
+		cacheOptimize();
+
 		if (has_skin)
 		{ 
 			//build out mSkinWeight from face info
@@ -111,6 +111,7 @@ LLFontFreetype::LLFontFreetype()
 	mFTFace(NULL),
 	mRenderGlyphCount(0),
 	mAddGlyphCount(0),
+	mGlyphGeneration(0),
 	mStyle(0),
 	mPointSize(0)
 {
@@ -478,6 +479,7 @@ void LLFontFreetype::insertGlyphInfo(llwchar wch, LLFontGlyphInfo* gi) const
 	{
 		delete iter->second;
 		iter->second = gi;
+		mGlyphGeneration++;
 	}
 	else
 	{
@@ -531,6 +533,7 @@ void LLFontFreetype::resetBitmapCache()
 		delete it->second;
 	}
 	mCharGlyphInfoMap.clear();
+	mGlyphGeneration++;
 	disclaimMem(mFontBitmapCachep);
 	mFontBitmapCachep->reset();
 
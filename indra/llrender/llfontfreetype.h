@@ -128,6 +128,9 @@ public:
 
 	LLFontGlyphInfo* getGlyphInfo(llwchar wch) const;
 
+	// changes whenever glyph infos handed out before may have been deleted
+	U32 getGlyphGeneration() const { return mGlyphGeneration; }
+
 	void reset(F32 vert_dpi, F32 horz_dpi);
 
 	void destroyGL();
@@ -171,6 +174,7 @@ private:
 
 	mutable S32 mRenderGlyphCount;
 	mutable S32 mAddGlyphCount;
+	mutable U32 mGlyphGeneration;
 };
 
 #endif // LL_FONTFREETYPE_H
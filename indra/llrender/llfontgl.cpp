@@ -70,7 +70,11 @@ const F32 PIXEL_CORRECTION_DISTANCE = 0.01f;
 const F32 PAD_UVY = 0.5f; // half of vertical padding between glyphs in the glyph texture
 const F32 DROP_SHADOW_SOFT_STRENGTH = 0.3f;
 
+const S32 MAX_GLYPH_RUN_LENGTH = 128;	// longer strings are mostly wrapped text and rarely repeat
+const U32 MAX_GLYPH_RUNS = 1024;		// per generation of the run cache
+
 LLFontGL::LLFontGL()
+:	mGlyphRunGeneration(0)
 {
 }
 
@@ -98,6 +102,85 @@ BOOL LLFontGL::loadFace(const std::string& filename, F32 point_size, F32 vert_dp
 	return mFontFreetype->loadFace(filename, point_size, vert_dpi, horz_dpi, components, is_fallback);
 }
 
+const LLFontGL::glyph_run_t* LLFontGL::getGlyphRun(const llwchar* wchars, S32 max_chars) const
+{
+	S32 length = 0;
+	const S32 max_length = llmin(max_chars, MAX_GLYPH_RUN_LENGTH + 1);
+	while (length < max_length && wchars[length])
+	{
+		length++;
+	}
+	if (length == 0 || length > MAX_GLYPH_RUN_LENGTH)
+	{
+		return NULL;
+	}
+
+	if (mGlyphRunGeneration != mFontFreetype->getGlyphGeneration())
+	{
+		// glyph infos were deleted, nothing cached can be trusted
+		mGlyphRuns.clear();
+		mOldGlyphRuns.clear();
+		mGlyphRunGeneration = mFontFreetype->getGlyphGeneration();
+	}
+
+	mGlyphRunKey.assign(wchars, length);
+	glyph_run_map_t::iterator iter = mGlyphRuns.find(mGlyphRunKey);
+	if (iter != mGlyphRuns.end())
+	{
+		return &iter->second;
+	}
+
+	if (mGlyphRuns.size() >= MAX_GLYPH_RUNS)
+	{
+		// runs not used since the cache last filled up are dropped
+		mOldGlyphRuns.swap(mGlyphRuns);
+		mGlyphRuns.clear();
+	}
+
+	glyph_run_t& run = mGlyphRuns[mGlyphRunKey];
+
+	iter = mOldGlyphRuns.find(mGlyphRunKey);
+	if (iter != mOldGlyphRuns.end())
+	{
+		run.swap(iter->second);
+		mOldGlyphRuns.erase(iter);
+		return &run;
+	}
+
+	const LLFontBitmapCache* font_bitmap_cache = mFontFreetype->getFontBitmapCache();
+	F32 inv_width = 1.f / font_bitmap_cache->getBitmapWidth();
+	F32 inv_height = 1.f / font_bitmap_cache->getBitmapHeight();
+
+	run.resize(length);
+	for (S32 i = 0; i < length; i++)
+	{
+		const LLFontGlyphInfo* fgi = mFontFreetype->getGlyphInfo(wchars[i]);
+		if (!fgi)
+		{
+			mGlyphRuns.erase(mGlyphRunKey);
+			return NULL;
+		}
+		run[i].mGlyph = fgi;
+		run[i].mUVRect = LLRectf((fgi->mXBitmapOffset) * inv_width,
+								 (fgi->mYBitmapOffset + fgi->mHeight + PAD_UVY) * inv_height,
+								 (fgi->mXBitmapOffset + fgi->mWidth) * inv_width,
+								 (fgi->mYBitmapOffset - PAD_UVY) * inv_height);
+	}
+	for (S32 i = 0; i < length; i++)
+	{
+		run[i].mKerning = i + 1 < length ? mFontFreetype->getXKerning(run[i].mGlyph, run[i + 1].mGlyph) : 0.f;
+	}
+
+	if (mGlyphRunGeneration != mFontFreetype->getGlyphGeneration())
+	{
+		// adding glyphs replaced one we already looked up
+		mGlyphRuns.clear();
+		return NULL;
+	}
+
+	return &run;
+}
+
 static LLTrace::BlockTimerStatHandle FTM_RENDER_FONTS("Fonts");
 
 S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, const LLRect& rect, const LLColor4 &color, HAlign halign, VAlign valign, U8 style, 
@@ -255,7 +338,17 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 
 	const LLFontGlyphInfo* next_glyph = NULL;
 
-	const S32 GLYPH_BATCH_SIZE = 30;
+	// NULL if the string has embedded nulls or is too long to cache
+	const glyph_run_t* run = getGlyphRun(wstr.c_str() + begin_offset, length);
+	if (run && (S32)run->size() != length)
+	{
+		run = NULL;
+	}
+
+	// quads are only flushed when switching bitmap pages or when the batch
+	// fills up, a glyph takes up to 6 quads with a soft drop shadow
+	const S32 GLYPH_BATCH_SIZE = 256;
+	const S32 MAX_QUADS_PER_GLYPH = 6;
 	LLVector3 vertices[GLYPH_BATCH_SIZE * 4];
 	LLVector2 uvs[GLYPH_BATCH_SIZE * 4];
 	LLColor4U colors[GLYPH_BATCH_SIZE * 4];
@@ -268,7 +361,8 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 	{
 		llwchar wch = wstr[i];
 
-		const LLFontGlyphInfo* fgi = next_glyph;
+		const RunGlyph* run_glyph = run ? &(*run)[i - begin_offset] : NULL;
+		const LLFontGlyphInfo* fgi = run_glyph ? run_glyph->mGlyph : next_glyph;
 		next_glyph = NULL;
 		if(!fgi)
 		{
@@ -308,7 +402,7 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 
 		// Draw the text at the appropriate location
 		//Specify vertices and texture coordinates
-		LLRectf uv_rect((fgi->mXBitmapOffset) * inv_width,
+		LLRectf uv_rect = run_glyph ? run_glyph->mUVRect : LLRectf((fgi->mXBitmapOffset) * inv_width,
 				(fgi->mYBitmapOffset + fgi->mHeight + PAD_UVY) * inv_height,
 				(fgi->mXBitmapOffset + fgi->mWidth) * inv_width,
 				(fgi->mYBitmapOffset - PAD_UVY) * inv_height);
@@ -318,7 +412,7 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 				    (F32)llround(cur_render_x + (F32)fgi->mXBearing) + (F32)fgi->mWidth,
 				    (F32)llround(cur_render_y + (F32)fgi->mYBearing) - (F32)fgi->mHeight);
 		
-		if (glyph_count >= GLYPH_BATCH_SIZE)
+		if (glyph_count > GLYPH_BATCH_SIZE - MAX_QUADS_PER_GLYPH)
 		{
 			gGL.begin(LLRender::QUADS);
 			{
@@ -338,9 +432,16 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 		llwchar next_char = wstr[i+1];
 		if (next_char && (next_char < LAST_CHARACTER))
 		{
-			// Kern this puppy.
-			next_glyph = mFontFreetype->getGlyphInfo(next_char);
-			cur_x += mFontFreetype->getXKerning(fgi, next_glyph);
+			if (run_glyph && i + 1 < begin_offset + length)
+			{
+				cur_x += run_glyph->mKerning;
+			}
+			else
+			{
+				// Kern this puppy.
+				next_glyph = mFontFreetype->getGlyphInfo(next_char);
+				cur_x += mFontFreetype->getXKerning(fgi, next_glyph);
+			}
 		}
 
 		// Round after kerning.
@@ -489,12 +590,15 @@ F32 LLFontGL::getWidthF32(const llwchar* wchars, S32 begin_offset, S32 max_chars
 
 	const LLFontGlyphInfo* next_glyph = NULL;
 
+	const glyph_run_t* run = getGlyphRun(wchars + begin_offset, max_chars);
+
 	F32 width_padding = 0.f;
 	for (S32 i = begin_offset; i < max_index && wchars[i] != 0; i++)
 	{
 		llwchar wch = wchars[i];
 
-		const LLFontGlyphInfo* fgi = next_glyph;
+		const RunGlyph* run_glyph = run ? &(*run)[i - begin_offset] : NULL;
+		const LLFontGlyphInfo* fgi = run_glyph ? run_glyph->mGlyph : next_glyph;
 		next_glyph = NULL;
 		if(!fgi)
 		{
@@ -517,9 +621,16 @@ F32 LLFontGL::getWidthF32(const llwchar* wchars, S32 begin_offset, S32 max_chars
 			&& next_char 
 			&& (next_char < LAST_CHARACTER))
 		{
-			// Kern this puppy.
-			next_glyph = mFontFreetype->getGlyphInfo(next_char);
-			cur_x += mFontFreetype->getXKerning(fgi, next_glyph);
+			if (run_glyph)
+			{
+				cur_x += run_glyph->mKerning;
+			}
+			else
+			{
+				// Kern this puppy.
+				next_glyph = mFontFreetype->getGlyphInfo(next_char);
+				cur_x += mFontFreetype->getXKerning(fgi, next_glyph);
+			}
 		}
 		// Round after kerning.
 		cur_x = (F32)llround(cur_x);
@@ -552,7 +663,9 @@ S32 LLFontGL::maxDrawableChars(const llwchar* wchars, F32 max_pixels, S32 max_ch
 	F32 scaled_max_pixels =	max_pixels * sScaleX;
 	F32 width_padding = 0.f;
 	
-	LLFontGlyphInfo* next_glyph = NULL;
+	const LLFontGlyphInfo* next_glyph = NULL;
+
+	const glyph_run_t* run = getGlyphRun(wchars, max_chars);
 
 	S32 i;
 	for (i=0; (i < max_chars); i++)
@@ -596,7 +709,8 @@ S32 LLFontGL::maxDrawableChars(const llwchar* wchars, F32 max_pixels, S32 max_ch
 			}
 		}
 		
-		LLFontGlyphInfo* fgi = next_glyph;
+		const RunGlyph* run_glyph = run ? &(*run)[i] : NULL;
+		const LLFontGlyphInfo* fgi = run_glyph ? run_glyph->mGlyph : next_glyph;
 		next_glyph = NULL;
 		if(!fgi)
 		{
@@ -624,9 +738,16 @@ S32 LLFontGL::maxDrawableChars(const llwchar* wchars, F32 max_pixels, S32 max_ch
 
 		if (((i+1) < max_chars) && wchars[i+1])
 		{
-			// Kern this puppy.
-			next_glyph = mFontFreetype->getGlyphInfo(wchars[i+1]);
-			cur_x += mFontFreetype->getXKerning(fgi, next_glyph);
+			if (run_glyph)
+			{
+				cur_x += run_glyph->mKerning;
+			}
+			else
+			{
+				// Kern this puppy.
+				next_glyph = mFontFreetype->getGlyphInfo(wchars[i+1]);
+				cur_x += mFontFreetype->getXKerning(fgi, next_glyph);
+			}
 		}
 
 		// Round after kerning.
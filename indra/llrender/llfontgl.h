@@ -33,12 +33,16 @@
 #include "llimagegl.h"
 #include "llpointer.h"
 #include "llrect.h"
+#include "llstring.h"
 #include "v2math.h"
 
+#include <boost/unordered_map.hpp>
+
 class LLColor4;
 // Key used to request a font.
 class LLFontDescriptor;
 class LLFontFreetype;
+struct LLFontGlyphInfo;
 
 // Structure used to store previously requested fonts.
 class LLFontRegistry;
@@ -212,6 +216,27 @@ private:
 	LLFontDescriptor mFontDescriptor;
 	LLPointer<LLFontFreetype> mFontFreetype;
 
+	// Glyph lookups and kerning of strings drawn or measured recently, so
+	// name tags, menus and labels don't go through the freetype glyph map
+	// and kerning tables character by character every frame.
+	struct RunGlyph
+	{
+		const LLFontGlyphInfo*	mGlyph;
+		F32						mKerning;	// against the next glyph of the run
+		LLRectf					mUVRect;	// in the glyph's bitmap cache page
+	};
+	typedef std::vector<RunGlyph> glyph_run_t;
+	typedef boost::unordered_map<LLWString, glyph_run_t> glyph_run_map_t;
+
+	// run for wchars up to the null terminator or max_chars, NULL for strings
+	// that are empty or too long to be worth caching
+	const glyph_run_t* getGlyphRun(const llwchar* wchars, S32 max_chars) const;
+
+	mutable glyph_run_map_t mGlyphRuns;
+	mutable glyph_run_map_t mOldGlyphRuns;		// previous generation, moved back into mGlyphRuns when used
+	mutable U32 mGlyphRunGeneration;			// glyph generation of mFontFreetype the runs were built for
+	mutable LLWString mGlyphRunKey;				// reused to look up runs without allocating
+
 	void renderQuad(LLVector3* vertex_out, LLVector2* uv_out, LLColor4U* colors_out, const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4U& color, F32 slant_amt) const;
 	void drawGlyph(S32& glyph_count, LLVector3* vertex_out, LLVector2* uv_out, LLColor4U* colors_out, const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4U& color, U8 style, ShadowType shadow, F32 drop_shadow_fade) const;
 
@@ -163,6 +163,9 @@ LLFolderView::LLFolderView(const Params& p)
 	mShowSelectionContext(FALSE),
 	mShowSingleSelection(FALSE),
 	mArrangeGeneration(0),
+	mArrangeDeferred(false),
+	mArrangeWindowTop(0),
+	mArrangeWindowHeight(0),
 	mSignalSelectCallback(0),
 	mMinWidth(0),
 	mDragAndDropThisFrame(FALSE),
@@ -304,6 +307,11 @@ S32 LLFolderView::arrange( S32* unused_width, S32* unused_height )
 	mMinWidth = 0;
 	S32 target_height;
 
+	LLRect visible_rect = getVisibleRect();
+	mArrangeWindowTop = getRect().getHeight() - visible_rect.mTop;
+	mArrangeWindowHeight = visible_rect.getHeight();
+	mArrangeDeferred = false;
+
 	LLFolderViewFolder::arrange(&mMinWidth, &target_height);
 
 	LLRect scroll_rect = (mScrollContainer ? mScrollContainer->getContentWindowRect() : LLRect());
@@ -1561,6 +1569,17 @@ void LLFolderView::scrollToShowItem(LLFolderViewItem* item, const LLRect& constr
 	}
 }
 
+bool LLFolderView::getArrangeWindow(S32& top, S32& bottom) const
+{
+	if (!mScrollContainer || mArrangeWindowHeight <= 0)
+	{
+		return false;
+	}
+	top = mArrangeWindowTop - mArrangeWindowHeight;
+	bottom = mArrangeWindowTop + 2 * mArrangeWindowHeight;
+	return true;
+}
+
 LLRect LLFolderView::getVisibleRect()
 {
 	S32 visible_height = (mScrollContainer ? mScrollContainer->getRect().getHeight() : 0);
@@ -1673,6 +1692,15 @@ void LLFolderView::update()
   if ( is_visible )
   {
     sanitizeSelection();
+    // subfolders skipped by the last arrange() must be laid out before
+    // scrolling brings them into view
+    LLRect visible_rect = getVisibleRect();
+    if (mArrangeDeferred
+        && (visible_rect.getHeight() != mArrangeWindowHeight
+            || llabs(getRect().getHeight() - visible_rect.mTop - mArrangeWindowTop) > mArrangeWindowHeight / 2))
+    {
+      arrangeAll();
+    }
     if( needsArrange() )
     {
       S32 height = 0;
@@ -133,6 +133,13 @@ public:
 	void arrangeAll() { mArrangeGeneration++; }
 	S32 getArrangeGeneration() { return mArrangeGeneration; }
 
+	// Rows, measured down from the top of the root, that the current
+	// arrange() lays out exactly: the scroll window plus one window height
+	// either side.  Returns false when there is no window to go by.
+	bool getArrangeWindow(S32& top, S32& bottom) const;
+	// A subfolder outside the window kept its last layout this arrange()
+	void deferArrange() { mArrangeDeferred = true; }
+
 	// applies filters to control visibility of items
 	virtual void filter( LLFolderViewFilter& filter);
 
@@ -291,6 +298,9 @@ protected:
 	std::string						mSearchString;
 	LLFrameTimer					mMultiSelectionFadeTimer;
 	S32								mArrangeGeneration;
+	bool							mArrangeDeferred;
+	S32								mArrangeWindowTop;
+	S32								mArrangeWindowHeight;
 
 	signal_t						mSelectSignal;
 	signal_t						mReshapeSignal;
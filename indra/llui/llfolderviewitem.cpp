@@ -951,7 +951,9 @@ LLFolderViewFolder::LLFolderViewFolder( const LLFolderViewItem::Params& p ):
 	mTargetHeight(0.f),
 	mAutoOpenCountdown(0.f),
 	mLastArrangeGeneration( -1 ),
-	mLastCalculatedWidth(0)
+	mLastCalculatedWidth(0),
+	mArrangeTop(0),
+	mArrangedChildrenValid(false)
 {
 }
 
@@ -1057,6 +1059,15 @@ S32 LLFolderViewFolder::arrange( S32* width, S32* height )
 			// Add sizes of children
 			S32 parent_item_height = getRect().getHeight();
 
+			// rows of the root, measured down from its top, that arrange()
+			// must keep exact; subfolders entirely outside keep their last layout
+			LLFolderView* root = getRoot();
+			S32 window_top = 0;
+			S32 window_bottom = 0;
+			bool use_window = root->getArrangeWindow(window_top, window_bottom);
+
+			mArrangedChildren.clear();
+
 			for(folders_t::iterator fit = mFolders.begin(); fit != mFolders.end(); ++fit)
 			{
 				LLFolderViewFolder* folderp = (*fit);
@@ -1068,11 +1079,27 @@ S32 LLFolderViewFolder::arrange( S32* width, S32* height )
 					S32 child_height = 0;
 					S32 child_top = parent_item_height - llround(running_height);
 
-					target_height += folderp->arrange( &child_width, &child_height );
+					folderp->mArrangeTop = mArrangeTop + llround(running_height);
+					if (use_window && folderp->canDeferArrange()
+						&& (folderp->mArrangeTop + folderp->getRect().getHeight() < window_top
+							|| folderp->mArrangeTop > window_bottom))
+					{
+						// off screen and nothing inside asked for a rearrange: reuse
+						// its height and width, it gets arranged once scrolled to
+						child_height = folderp->getRect().getHeight();
+						child_width = llmax(child_width, folderp->mLastCalculatedWidth);
+						target_height += llround(folderp->mTargetHeight);
+						root->deferArrange();
+					}
+					else
+					{
+						target_height += folderp->arrange( &child_width, &child_height );
+					}
 
 					running_height += (F32)child_height;
 					*width = llmax(*width, child_width);
 					folderp->setOrigin( 0, child_top - folderp->getRect().getHeight() );
+					mArrangedChildren.push_back(folderp);
 				}
 			}
 			for(items_t::iterator iit = mItems.begin();
@@ -1094,8 +1121,12 @@ S32 LLFolderViewFolder::arrange( S32* width, S32* height )
 					running_height += (F32)child_height;
 					*width = llmax(*width, child_width);
 					itemp->setOrigin( 0, child_top - itemp->getRect().getHeight() );
+					mArrangedChildren.push_back(itemp);
 				}
 			}
+
+			// anything else parented to us has to go through LLView::draw()
+			mArrangedChildrenValid = ((size_t) getChildCount() == mItems.size() + mFolders.size());
 		}
 
 		mTargetHeight = target_height;
@@ -1160,6 +1191,13 @@ BOOL LLFolderViewFolder::needsArrange()
 	return mLastArrangeGeneration < getRoot()->getArrangeGeneration();
 }
 
+// True when this folder was arranged before, nothing in it has requested a
+// rearrange since, and it isn't animating, so its last height still holds
+bool LLFolderViewFolder::canDeferArrange() const
+{
+	return mLastArrangeGeneration >= 0 && mCurHeight == mTargetHeight;
+}
+
 // Passes selection information on to children and record selection
 // information if necessary.
 BOOL LLFolderViewFolder::setSelection(LLFolderViewItem* selection, BOOL openitem,
@@ -1555,6 +1593,8 @@ void LLFolderViewFolder::extractItem( LLFolderViewItem* item )
 	getViewModelItem()->removeChild(item->getViewModelItem());
 	//because an item is going away regardless of filter status, force rearrange
 	requestArrange();
+	mArrangedChildren.clear();
+	mArrangedChildrenValid = false;
 	removeChild(item);
 }
 
@@ -1928,12 +1968,55 @@ void LLFolderViewFolder::draw()
 	// draw children if root folder, or any other folder that is open or animating to closed state
 	if( getRoot() == this || (isOpen() || mCurHeight != mTargetHeight ))
 	{
-		LLView::draw();
+		if (mArrangedChildrenValid)
+		{
+			drawArrangedChildren();
+		}
+		else
+		{
+			LLView::draw();
+		}
 	}
 
 	mExpanderHighlighted = FALSE;
 }
 
+// Orders children by the bottom edge arrange() gave them, top first
+static bool arranged_child_above(const LLFolderViewItem* child, S32 bottom)
+{
+	return child->getRect().mBottom >= bottom;
+}
+
+// Draws only the rows overlapping the scroll window, so the cost of drawing a
+// large open folder doesn't depend on how many children it has.
+void LLFolderViewFolder::drawArrangedChildren()
+{
+	LLFolderView* root = getRoot();
+	LLRect visible_rect = root->getVisibleRect();
+	LLRect local_visible_rect;
+	if (!visible_rect.isValid() || visible_rect.getHeight() <= 0
+		|| !root->localRectToOtherView(visible_rect, &local_visible_rect, this))
+	{
+		LLView::draw();
+		return;
+	}
+
+	// skip rows entirely above the window
+	size_t first = std::lower_bound(mArrangedChildren.begin(), mArrangedChildren.end(),
+									local_visible_rect.mTop, arranged_child_above) - mArrangedChildren.begin();
+	// indexed, a child removed while drawing clears the list
+	for (size_t i = first; i < mArrangedChildren.size(); ++i)
+	{
+		LLFolderViewItem* childp = mArrangedChildren[i];
+		if (childp->getRect().mTop <= local_visible_rect.mBottom)
+		{
+			// this and all following rows are below the window
+			break;
+		}
+		drawChild(childp);
+	}
+}
+
 // this does prefix traversal, as folders are listed above their contents
 LLFolderViewItem* LLFolderViewFolder::getNextFromChild( LLFolderViewItem* item, BOOL include_children )
 {
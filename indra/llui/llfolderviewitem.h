@@ -304,6 +304,7 @@ protected:
 
 	void updateLabelRotation();
 	virtual bool isCollapsed() { return FALSE; }
+	void drawArrangedChildren();
 
 public:
 	typedef std::list<LLFolderViewItem*> items_t;
@@ -320,8 +321,18 @@ protected:
 	F32			mAutoOpenCountdown;
 	S32			mLastArrangeGeneration;
 	S32			mLastCalculatedWidth;
+	// distance from the top of the root to the top of this folder, set by
+	// the parent before each arrange()
+	S32			mArrangeTop;
 	bool		mNeedsSort;
 
+	// Visible children in the order the last arrange() stacked them, top
+	// down, so draw() can binary search the rows inside the scroll window
+	// instead of visiting every child.  Invalid while it may hold children
+	// that were removed or when the folder has children that aren't rows.
+	std::vector<LLFolderViewItem*> mArrangedChildren;
+	bool		mArrangedChildrenValid;
+
 public:
 	typedef enum e_recurse_type
 	{
@@ -345,6 +356,7 @@ public:
 	virtual S32 arrange( S32* width, S32* height );
 
 	BOOL needsArrange();
+	bool canDeferArrange() const;
 
 	bool descendantsPassedFilter(S32 filter_generation = -1);
 
@@ -81,6 +81,8 @@ public:
 	// +-------------------------------------------------------------------+
 	virtual bool 				check(const LLFolderViewModelItem* item) = 0;
 	virtual bool				checkFolder(const LLFolderViewModelItem* folder) const = 0;
+	// false if nothing below the folder can pass, so its children can fail unchecked
+	virtual bool				checkDescendants(const LLFolderViewModelItem* folder) { return true; }
 
 	virtual void 				setEmptyLookupMessage(const std::string& message) = 0;
 	virtual std::string			getEmptyLookupMessage() const = 0;
@@ -42,6 +42,8 @@
 #include "llstring.h"
 #include "llsdparam.h"
 #include "llsdutil.h"
+#include "llformat.h"
+#include "llframetimer.h"
 
 #include <algorithm>
 #include <boost/regex.hpp>
@@ -50,6 +52,9 @@
 
 const std::string NOTIFICATION_PERSIST_VERSION = "0.93";
 
+// sources quiet for longer are forgotten, so rate limit periods can't be longer
+const F64 MAX_RATE_LIMIT_PERIOD = 300.0;
+
 void NotificationPriorityValues::declareValues()
 {
 	declare("low", NOTIFICATION_PRIORITY_LOW);
@@ -407,6 +412,7 @@ void LLNotificationForm::setIgnored(bool ignored)
 
 LLNotificationTemplate::LLNotificationTemplate(const LLNotificationTemplate::Params& p)
 :	mName(p.name),
+	mNameID(0),
 	mType(p.type),
 	mMessage(p.value),
 	mFooter(p.footer.value),
@@ -425,7 +431,9 @@ LLNotificationTemplate::LLNotificationTemplate(const LLNotificationTemplate::Par
 	mLogToChat(p.log_to_chat),
 	mLogToIM(p.log_to_im),
 	mShowToast(p.show_toast),
-    mSoundName("")
+    mSoundName(""),
+	mRateLimitCount(p.rate_limit.count),
+	mRateLimitPeriod(p.rate_limit.isProvided() ? p.rate_limit.period : 0.f)
 {
 	if (p.sound.isProvided()
 		&& LLUI::sSettingGroups["config"]->controlExists(p.sound))
@@ -796,7 +804,7 @@ void LLNotification::setResponseFunctor(const LLNotificationResponderPtr& respon
 
 bool LLNotification::isEquivalentTo(LLNotificationPtr that) const
 {
-	if (this->mTemplatep->mName != that->mTemplatep->mName) 
+	if (this->mTemplatep->mNameID != that->mTemplatep->mNameID) 
 	{
 		return false; // must have the same template name or forget it
 	}
@@ -1017,6 +1025,14 @@ bool LLNotificationChannelBase::updateItem(const LLSD& payload, LLNotificationPt
 	LLNotificationSet::iterator foundItem = mItems.find(pNotification);
 	bool wasFound = (foundItem != mItems.end());
 	bool passesFilter = mFilter ? mFilter(pNotification) : true;
+	if (passesFilter)
+	{
+		mPassedCount++;
+	}
+	else
+	{
+		mFailedCount++;
+	}
 	
 	// first, we offer the result of the filter test to the simple
 	// signals for pass/fail. One of these is guaranteed to be called.
@@ -1171,7 +1187,9 @@ std::string LLNotificationChannel::summarize()
 {
 	std::string s("Channel '");
 	s += mName;
-	s += "'\n  ";
+	s += "'";
+	s += llformat(" passed %u failed %u", mPassedCount, mFailedCount);
+	s += "\n  ";
 	for (LLNotificationChannel::Iterator it = begin(); it != end(); ++it)
 	{
 		s += (*it)->summarize();
@@ -1244,8 +1262,9 @@ bool LLNotifications::uniqueFilter(LLNotificationPtr pNotif)
 	}
 
 	// checks against existing unique notifications
-	for (LLNotificationMap::iterator existing_it = mUniqueNotifications.find(pNotif->getName());
-		existing_it != mUniqueNotifications.end();
+	for (UniqueNotificationMap::iterator existing_it = mUniqueNotifications.lower_bound(pNotif->mTemplatep->mNameID),
+			end_it = mUniqueNotifications.upper_bound(pNotif->mTemplatep->mNameID);
+		existing_it != end_it;
 		++existing_it)
 	{
 		LLNotificationPtr existing_notification = existing_it->second;
@@ -1278,11 +1297,11 @@ bool LLNotifications::uniqueHandler(const LLSD& payload)
 		{
 			// not a duplicate according to uniqueness criteria, so we keep it
 			// and store it for future uniqueness checks
-			mUniqueNotifications.insert(std::make_pair(pNotif->getName(), pNotif));
+			mUniqueNotifications.insert(std::make_pair(pNotif->mTemplatep->mNameID, pNotif));
 		}
 		else if (cmd == "delete")
 		{
-			mUniqueNotifications.erase(pNotif->getName());
+			mUniqueNotifications.erase(pNotif->mTemplatep->mNameID);
 		}
 	}
 
@@ -1306,8 +1325,9 @@ bool LLNotifications::failedUniquenessTest(const LLSD& payload)
 		// Update the existing unique notification with the data from this particular instance...
 		// This guarantees that duplicate notifications will be collapsed to the one
 		// most recently triggered
-		for (LLNotificationMap::iterator existing_it = mUniqueNotifications.find(pNotif->getName());
-			existing_it != mUniqueNotifications.end();
+		for (UniqueNotificationMap::iterator existing_it = mUniqueNotifications.lower_bound(pNotif->mTemplatep->mNameID),
+				end_it = mUniqueNotifications.upper_bound(pNotif->mTemplatep->mNameID);
+			existing_it != end_it;
 			++existing_it)
 		{
 			LLNotificationPtr existing_notification = existing_it->second;
@@ -1557,9 +1577,13 @@ bool LLNotifications::loadTemplates()
 				replaceFormText(notification.form_ref.form, "$ignoretext", notification.form_ref.form_template.ignore_text);
 			}
 		}
-		mTemplates[notification.name] = LLNotificationTemplatePtr(new LLNotificationTemplate(notification));
+		LLNotificationTemplatePtr templatep(new LLNotificationTemplate(notification));
+		templatep->mNameID = internTemplateName(templatep->mName);
+		mTemplates[notification.name] = templatep;
 	}
 
+	matchVisibilityRules();
+
 	LL_INFOS() << "...done" << LL_ENDL;
 
 	return true;
@@ -1589,9 +1613,57 @@ bool LLNotifications::loadVisibilityRules()
 		mVisibilityRules.push_back(LLNotificationVisibilityRulePtr(new LLNotificationVisibilityRule(rule)));
 	}
 
+	matchVisibilityRules();
+
 	return true;
 }
 
+U32 LLNotifications::internTemplateName(const std::string& name)
+{
+	TemplateNameIDMap::iterator it = mTemplateNameIDs.find(name);
+	if (it == mTemplateNameIDs.end())
+	{
+		U32 name_id = mTemplateNameIDs.size() + 1;
+		it = mTemplateNameIDs.insert(std::make_pair(name, name_id)).first;
+	}
+	return it->second;
+}
+
+// Rules only look at the type, tags and name of the template, so which rule
+// applies to a notification is decided per template up front rather than
+// by going through the rules for every notification.
+void LLNotifications::matchVisibilityRules()
+{
+	for (TemplateMap::iterator template_it = mTemplates.begin(); template_it != mTemplates.end(); ++template_it)
+	{
+		LLNotificationTemplate& notification_template = *template_it->second;
+		notification_template.mVisibilityRule.reset();
+
+		for (VisibilityRuleList::iterator it = mVisibilityRules.begin(); it != mVisibilityRules.end(); ++it)
+		{
+			// An empty type/tag/name string will match any notification, so only do the comparison when the string is non-empty in the rule.
+			const LLNotificationVisibilityRule& rule = **it;
+			if (!rule.mType.empty() && rule.mType != notification_template.mType)
+			{
+				continue;
+			}
+			if (!rule.mTag.empty()
+				&& std::find(notification_template.mTags.begin(), notification_template.mTags.end(), rule.mTag) == notification_template.mTags.end())
+			{
+				continue;
+			}
+			if (!rule.mName.empty() && rule.mName != notification_template.mName)
+			{
+				continue;
+			}
+
+			// the rule matches, don't evaluate subsequent rules
+			notification_template.mVisibilityRule = *it;
+			break;
+		}
+	}
+}
+
 // Add a simple notification (from XUI)
 void LLNotifications::addFromCallback(const LLSD& name)
 {
@@ -1646,6 +1718,13 @@ void LLNotifications::add(const LLNotificationPtr pNotif)
 		LL_ERRS() << "Notification added a second time to the master notification channel." << LL_ENDL;
 	}
 
+	if (isRateLimited(pNotif))
+	{
+		// never seen by any channel, so nobody has to be told
+		pNotif->cancel();
+		return;
+	}
+
 	updateItem(LLSD().with("sigtype", "add").with("id", pNotif->id()), pNotif);
 }
 
@@ -1747,54 +1826,22 @@ bool LLNotifications::isVisibleByRules(LLNotificationPtr n)
 		return true;
 	}
 	
-	VisibilityRuleList::iterator it;
-	
-	for(it = mVisibilityRules.begin(); it != mVisibilityRules.end(); it++)
+	LLNotificationVisibilityRulePtr rule = n->mTemplatep ? n->mTemplatep->mVisibilityRule : LLNotificationVisibilityRulePtr();
+	if (rule)
 	{
-		// An empty type/tag/name string will match any notification, so only do the comparison when the string is non-empty in the rule.
 		LL_DEBUGS() 
 			<< "notification \"" << n->getName() << "\" " 
-			<< "testing against " << ((*it)->mVisible?"show":"hide") << " rule, "
-			<< "name = \"" << (*it)->mName << "\" "
-			<< "tag = \"" << (*it)->mTag << "\" "
-			<< "type = \"" << (*it)->mType << "\" "
+			<< "matches " << (rule->mVisible?"show":"hide") << " rule, "
+			<< "name = \"" << rule->mName << "\" "
+			<< "tag = \"" << rule->mTag << "\" "
+			<< "type = \"" << rule->mType << "\" "
 			<< LL_ENDL;
 
-		if(!(*it)->mType.empty())
-		{
-			if((*it)->mType != n->getType())
-			{
-				// Type doesn't match, so skip this rule.
-				continue;
-			}
-		}
-		
-		if(!(*it)->mTag.empty())
-		{
-			// check this notification's tag(s) against it->mTag and continue if no match is found.
-			if(!n->matchesTag((*it)->mTag))
-			{
-				// This rule's non-empty tag didn't match one of the notification's tags.  Skip this rule.
-				continue;
-			}
-		}
-
-		if(!(*it)->mName.empty())
-		{
-			// check this notification's name against the notification's name and continue if no match is found.
-			if((*it)->mName != n->getName())
-			{
-				// This rule's non-empty name didn't match the notification.  Skip this rule.
-				continue;
-			}
-		}
-		
-		// If we got here, the rule matches.  Don't evaluate subsequent rules.
-		if(!(*it)->mVisible)
+		if(!rule->mVisible)
 		{
 			// This notification is being hidden.
 			
-			if((*it)->mResponse.empty())
+			if(rule->mResponse.empty())
 			{
 				// Response property is empty.  Cancel this notification.
 				LL_DEBUGS() << "cancelling notification " << n->getName() << LL_ENDL;
@@ -1806,7 +1853,7 @@ bool LLNotifications::isVisibleByRules(LLNotificationPtr n)
 				// Response property is not empty.  Return the specified response.
 				LLSD response = n->getResponseTemplate(LLNotification::WITHOUT_DEFAULT_BUTTON);
 				// TODO: verify that the response template has an item with the correct name
-				response[(*it)->mResponse] = true;
+				response[rule->mResponse] = true;
 
 				LL_DEBUGS() << "responding to notification " << n->getName() << " with response = " << response << LL_ENDL;
 				
@@ -1815,16 +1862,82 @@ bool LLNotifications::isVisibleByRules(LLNotificationPtr n)
 
 			return false;
 		}
-		
-		// If we got here, exit the loop and return true.
-		break;
 	}
 	
 	LL_DEBUGS() << "allowing notification " << n->getName() << LL_ENDL;
 
 	return true;
 }
-			
+
+void LLNotifications::setSourceRateLimit(const LLUUID& source_id, U32 count, F32 period)
+{
+	RateLimit& limit = mSourceRateLimits[source_id];
+	limit.mCount = count;
+	limit.mPeriod = period;
+}
+
+void LLNotifications::clearSourceRateLimit(const LLUUID& source_id)
+{
+	mSourceRateLimits.erase(source_id);
+}
+
+bool LLNotifications::isRateLimited(LLNotificationPtr pNotification)
+{
+	if (!pNotification->mTemplatep || pNotification->mTemplatep->mRateLimitPeriod <= 0.f)
+	{
+		return false;
+	}
+
+	const LLSD& payload = pNotification->getPayload();
+	LLUUID source_id = payload.has("object_id") ? payload["object_id"].asUUID() : payload["from_id"].asUUID();
+	if (source_id.isNull())
+	{
+		return false;
+	}
+
+	U32 count = pNotification->mTemplatep->mRateLimitCount;
+	F32 period = pNotification->mTemplatep->mRateLimitPeriod;
+	source_rate_limit_map_t::const_iterator limit_it = mSourceRateLimits.find(source_id);
+	if (limit_it != mSourceRateLimits.end())
+	{
+		count = limit_it->second.mCount;
+		period = limit_it->second.mPeriod;
+	}
+
+	F64 now = LLFrameTimer::getTotalSeconds();
+	source_rate_map_t::iterator rate_it = mSourceRates.find(source_id);
+	if (rate_it == mSourceRates.end())
+	{
+		// forget the sources that have been quiet for a while before adding one
+		for (source_rate_map_t::iterator it = mSourceRates.begin(); it != mSourceRates.end(); )
+		{
+			source_rate_map_t::iterator cur_it = it++;
+			if (now - cur_it->second.mPeriodStart > MAX_RATE_LIMIT_PERIOD)
+			{
+				mSourceRates.erase(cur_it);
+			}
+		}
+
+		SourceRate rate;
+		rate.mPeriodStart = now;
+		rate.mCount = 0;
+		rate_it = mSourceRates.insert(std::make_pair(source_id, rate)).first;
+	}
+	else if (now - rate_it->second.mPeriodStart >= period)
+	{
+		rate_it->second.mPeriodStart = now;
+		rate_it->second.mCount = 0;
+	}
+
+	if (rate_it->second.mCount >= count)
+	{
+		LL_DEBUGS() << "dropping notification " << pNotification->getName() << " from " << source_id
+					<< ", more than " << count << " in " << period << " seconds" << LL_ENDL;
+		return true;
+	}
+	rate_it->second.mCount++;
+	return false;
+}
 
 // ---
 // END OF LLNotifications implementation
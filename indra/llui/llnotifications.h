@@ -731,7 +731,9 @@ class LLNotificationChannelBase :
 public:
 	LLNotificationChannelBase(LLNotificationFilter filter) 
 	:	mFilter(filter), 
-		mItems() 
+		mItems(),
+		mPassedCount(0),
+		mFailedCount(0)
 	{}
 	virtual ~LLNotificationChannelBase() {}
 	// you can also connect to a Channel, so you can be notified of
@@ -778,6 +780,10 @@ public:
 	bool updateItem(const LLSD& payload);
 	const LLNotificationFilter& getFilter() { return mFilter; }
 
+	// how many updates passed and failed the filter so far
+	U32 getPassedCount() const { return mPassedCount; }
+	U32 getFailedCount() const { return mFailedCount; }
+
 protected:
     LLBoundListener connectChangedImpl(const LLEventListener& slot);
     LLBoundListener connectAtFrontChangedImpl(const LLEventListener& slot);
@@ -802,6 +808,8 @@ protected:
 
 	bool updateItem(const LLSD& payload, LLNotificationPtr pNotification);
 	LLNotificationFilter mFilter;
+	U32 mPassedCount;
+	U32 mFailedCount;
 };
 
 // The type of the pointers that we're going to manage in the NotificationQueue system
@@ -958,6 +966,11 @@ public:
 	bool getIgnoreAllNotifications();
 
 	bool isVisibleByRules(LLNotificationPtr pNotification);
+
+	// Overrides the rate limit of templates that have one for notifications
+	// coming from source_id, a count of 0 drops all of them.
+	void setSourceRateLimit(const LLUUID& source_id, U32 count, F32 period);
+	void clearSourceRateLimit(const LLUUID& source_id);
 	
 private:
 	// we're a singleton, so we don't have a public constructor
@@ -966,6 +979,10 @@ private:
 	
 	void loadPersistentNotifications();
 
+	U32 internTemplateName(const std::string& name);
+	void matchVisibilityRules();
+	bool isRateLimited(LLNotificationPtr pNotification);
+
 	bool expirationFilter(LLNotificationPtr pNotification);
 	bool expirationHandler(const LLSD& payload);
 	bool uniqueFilter(LLNotificationPtr pNotification);
@@ -976,11 +993,30 @@ private:
 	
 	TemplateMap mTemplates;
 
+	typedef std::map<std::string, U32> TemplateNameIDMap;
+	TemplateNameIDMap mTemplateNameIDs;
+
 	VisibilityRuleList mVisibilityRules;
 
+	struct RateLimit
+	{
+		U32 mCount;
+		F32 mPeriod;
+	};
+	struct SourceRate
+	{
+		F64 mPeriodStart;
+		U32 mCount;
+	};
+	typedef std::map<LLUUID, RateLimit> source_rate_limit_map_t;
+	typedef std::map<LLUUID, SourceRate> source_rate_map_t;
+	source_rate_limit_map_t mSourceRateLimits;
+	source_rate_map_t mSourceRates;
+
 	std::string mFileName;
 	
-	LLNotificationMap mUniqueNotifications;
+	typedef std::multimap<U32, LLNotificationPtr> UniqueNotificationMap;
+	UniqueNotificationMap mUniqueNotifications;		// by template name id
 	
 	typedef std::map<std::string, std::string> GlobalStringMap;
 	GlobalStringMap mGlobalStrings;
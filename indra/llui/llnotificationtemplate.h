@@ -159,6 +159,18 @@ struct LLNotificationTemplate
 		{}
 	};
 
+	// at most count notifications from the same object in period seconds
+	struct RateLimit : public LLInitParam::Block<RateLimit>
+	{
+		Mandatory<U32>	count;
+		Mandatory<F32>	period;
+
+		RateLimit()
+		:	count("count"),
+			period("period")
+		{}
+	};
+
 	struct Footer : public LLInitParam::Block<Footer>
 	{
 		Mandatory<std::string> value;
@@ -187,6 +199,7 @@ struct LLNotificationTemplate
 		Optional<S32>					expire_option;
 		Optional<URL>					url;
 		Optional<UniquenessConstraint>	unique;
+		Optional<RateLimit>				rate_limit;
 		Optional<FormRef>				form_ref;
 		Optional<ENotificationPriority, 
 			NotificationPriorityValues> priority;
@@ -211,6 +224,7 @@ struct LLNotificationTemplate
 			expire_option("expireOption", -1),
 			url("url"),
 			unique("unique"),
+			rate_limit("rate_limit"),
 			form_ref(""),
 			tags("tag"),
 			footer("footer")
@@ -236,6 +250,9 @@ struct LLNotificationTemplate
     // Ideally, the key should follow variable naming rules 
     // (no spaces or punctuation).
     std::string mName;
+	// The name interned by LLNotifications, stays the same when templates
+	// are reloaded, so names can be compared and looked up as integers.
+	U32 mNameID;
     // The type of the notification
     // used to control which queue it's stored in
     std::string mType;
@@ -303,6 +320,14 @@ struct LLNotificationTemplate
 	std::string mSoundName;
 	// List of tags that rules can match against.
 	std::list<std::string> mTags;
+	// The first visibility rule matching the type, tags and name, null if
+	// none does.  Set by LLNotifications whenever templates or rules load.
+	LLNotificationVisibilityRulePtr mVisibilityRule;
+	// If the period is nonzero, notifications beyond the count within the
+	// period that come from the same object (the "object_id" or else the
+	// "from_id" of the payload) are dropped.
+	U32 mRateLimitCount;
+	F32 mRateLimitPeriod;
 
 	// inject these notifications into chat/IM streams
 	bool mLogToChat;
@@ -30,6 +30,7 @@
 #include "llscrolllistctrl.h"
 
 #include <algorithm>
+#include <set>
 
 #include "llstl.h"
 #include "llboost.h"
@@ -113,6 +114,51 @@ struct SortScrollListItem
 	const sort_order_t& mSortOrders;
 };
 
+// Sorts the rows of a list in virtual mode by sort keys fetched up front,
+// one list of keys per sort column indexed by provider row.  Rows added
+// with addRow() have no keys and go first.
+struct SortVirtualRow
+{
+	typedef std::vector<std::pair<S32, BOOL> > sort_order_t;
+	typedef std::vector<std::vector<std::string> > sort_keys_t;
+
+	SortVirtualRow(const sort_order_t& sort_orders, const sort_keys_t& sort_keys)
+	:	mSortOrders(sort_orders),
+		mSortKeys(sort_keys)
+	{}
+
+	bool operator()(const LLScrollListItem* i1, const LLScrollListItem* i2)
+	{
+		S32 row1 = i1->getVirtualRow();
+		S32 row2 = i2->getVirtualRow();
+		if (row1 < 0 || row2 < 0)
+		{
+			return row1 < 0 && row2 >= 0;
+		}
+
+		// same precedence as SortScrollListItem, last sort column first
+		for (S32 i = (S32)mSortOrders.size() - 1; i >= 0; --i)
+		{
+			const std::vector<std::string>& keys = mSortKeys[i];
+			if (keys.empty())
+			{
+				continue;
+			}
+
+			S32 order = mSortOrders[i].second ? 1 : -1;
+			S32 sort_result = order * LLStringUtil::compareDict(keys[row1], keys[row2]);
+			if (sort_result != 0)
+			{
+				return sort_result < 0;
+			}
+		}
+		return false;
+	}
+
+	const sort_order_t& mSortOrders;
+	const sort_keys_t& mSortKeys;
+};
+
 //---------------------------------------------------------------------------
 // LLScrollListCtrl
 //---------------------------------------------------------------------------
@@ -176,6 +222,9 @@ LLScrollListCtrl::LLScrollListCtrl(const LLScrollListCtrl::Params& p)
 	mHighlightedItem(-1),
 	mBorder(NULL),
 	mSortCallback(NULL),
+	mDataProvider(NULL),
+	mNumVirtualRows(0),
+	mNumFetchedRows(0),
 	mPopupMenu(NULL),
 	mCommentTextView(NULL),
 	mNumDynamicWidthColumns(0),
@@ -353,6 +402,7 @@ void LLScrollListCtrl::clearRows()
 	std::for_each(mItemList.begin(), mItemList.end(), DeletePointer());
 	mItemList.clear();
 	//mItemCount = 0;
+	mNumFetchedRows = 0;
 
 	// Scroll the bar back up to the top.
 	mScrollbar->setDocParams(0, 0);
@@ -363,6 +413,96 @@ void LLScrollListCtrl::clearRows()
 	mDirty = false; 
 }
 
+void LLScrollListCtrl::setDataProvider(LLScrollListDataProvider* provider)
+{
+	clearRows();
+	mDataProvider = provider;
+	mNumVirtualRows = 0;
+}
+
+void LLScrollListCtrl::refreshFromDataProvider()
+{
+	if (!mDataProvider)
+	{
+		return;
+	}
+
+	// rows may have moved, keep the selection by value
+	std::set<std::string> selected_values;
+	for (item_list::const_iterator iter = mItemList.begin(); iter != mItemList.end(); ++iter)
+	{
+		if ((*iter)->getSelected())
+		{
+			selected_values.insert((*iter)->getValue().asString());
+		}
+	}
+	S32 scroll_lines = mScrollLines;
+
+	clearRows();
+
+	mNumVirtualRows = llmin(mDataProvider->getRowCount(), mMaxItemCount);
+	LLScrollListItem::Params item_p;
+	for (S32 row = 0; row < mNumVirtualRows; ++row)
+	{
+		item_p.value(mDataProvider->getRowValue(row));
+		item_p.enabled(mDataProvider->getRowEnabled(row));
+
+		LLScrollListItem* itemp = new LLScrollListItem(item_p);
+		itemp->mVirtualList = this;
+		itemp->mVirtualRow = row;
+		if (!selected_values.empty()
+			&& selected_values.find(itemp->getValue().asString()) != selected_values.end())
+		{
+			itemp->setSelected(TRUE);
+			mLastSelected = itemp;
+		}
+		mItemList.push_back(itemp);
+	}
+
+	setNeedsSort();
+	updateLineHeight();
+	updateLayout();
+	setScrollPos(scroll_lines);
+}
+
+void LLScrollListCtrl::fetchRowCells(LLScrollListItem* item)
+{
+	// set first, building the cells looks at them
+	item->mCellsFetched = true;
+
+	LLScrollListItem::Params row_params;
+	row_params.value(item->getValue());
+	mDataProvider->getRowCells(item->getVirtualRow(), row_params);
+	setRowCells(item, row_params);
+
+	updateLineHeightInsert(item);
+	mNumFetchedRows++;
+}
+
+// Drops the cells of all virtual rows outside first_line to last_line
+void LLScrollListCtrl::releaseRowCells(S32 first_line, S32 last_line)
+{
+	mNumFetchedRows = 0;
+	S32 line = 0;
+	for (item_list::iterator iter = mItemList.begin(); iter != mItemList.end(); ++iter, ++line)
+	{
+		LLScrollListItem* itemp = *iter;
+		if (!itemp->mVirtualList || !itemp->mCellsFetched)
+		{
+			continue;
+		}
+
+		if (line < first_line || line > last_line)
+		{
+			itemp->releaseCells();
+		}
+		else
+		{
+			mNumFetchedRows++;
+		}
+	}
+}
+
 
 LLScrollListItem* LLScrollListCtrl::getFirstSelected() const
 {
@@ -624,6 +764,9 @@ S32 LLScrollListCtrl::calcMaxContentWidth()
 			item_list::iterator iter;
 			for (iter = mItemList.begin(); iter != mItemList.end(); iter++)
 			{
+				// rows of a virtual list that were never shown don't count
+				if ((*iter)->needsCells()) continue;
+
 				LLScrollListCell* cellp = (*iter)->getColumn(column->mIndex);
 				if (!cellp) continue;
 
@@ -680,6 +823,8 @@ void LLScrollListCtrl::updateLineHeight()
 	for (iter = mItemList.begin(); iter != mItemList.end(); iter++)
 	{
 		LLScrollListItem *itemp = *iter;
+		if (itemp->needsCells()) continue;
+
 		S32 num_cols = itemp->getNumColumns();
 		S32 i = 0;
 		for (const LLScrollListCell* cell = itemp->getColumn(i); i < num_cols; cell = itemp->getColumn(++i))
@@ -687,6 +832,13 @@ void LLScrollListCtrl::updateLineHeight()
 			mLineHeight = llmax( mLineHeight, cell->getHeight() + SCROLL_LIST_ROW_PAD );
 		}
 	}
+
+	// without a line height a page would be the whole list, take the first
+	// row of a virtual list as typical
+	if (!mLineHeight && !mItemList.empty() && mItemList.front()->needsCells())
+	{
+		fetchRowCells(mItemList.front());
+	}
 }
 
 // when the only change to line height is from an insert, we needn't scan the entire list
@@ -763,6 +915,9 @@ void LLScrollListCtrl::updateColumns(bool force_update)
 		for (iter = mItemList.begin(); iter != mItemList.end(); iter++)
 		{
 			LLScrollListItem *itemp = *iter;
+			// cells fetched later get the current widths
+			if (itemp->needsCells()) continue;
+
 			S32 num_cols = itemp->getNumColumns();
 			S32 i = 0;
 			for (LLScrollListCell* cell = itemp->getColumn(i); i < num_cols; cell = itemp->getColumn(++i))
@@ -1526,6 +1681,13 @@ void LLScrollListCtrl::drawItems()
 				cur_y -= mLineHeight;
 			}
 		}
+
+		// let go of the cells of rows scrolled out of view once they add up
+		const S32 MIN_FETCHED_ROWS = 64;
+		if (mDataProvider && mNumFetchedRows > 4 * (last_line - first_line + 1) + MIN_FETCHED_ROWS)
+		{
+			releaseRowCells(first_line, last_line);
+		}
 	}
 }
 
@@ -1989,22 +2151,18 @@ LLScrollListItem* LLScrollListCtrl::hitItem( S32 x, S32 y )
 	// allow for partial line at bottom
 	S32 num_page_lines = getLinesPerPage();
 
-	S32 line = 0;
-	item_list::iterator iter;
-	for(iter = mItemList.begin(); iter != mItemList.end(); iter++)
+	// only the lines on the page can be hit
+	S32 last_line = llmin((S32)mItemList.size(), mScrollLines + num_page_lines);
+	for (S32 line = llmax(mScrollLines, 0); line < last_line; line++)
 	{
-		LLScrollListItem* item  = *iter;
-		if( mScrollLines <= line && line < mScrollLines + num_page_lines )
+		LLScrollListItem* item  = mItemList[line];
+		if( item->getEnabled() && item_rect.pointInRect( x, y ) )
 		{
-			if( item->getEnabled() && item_rect.pointInRect( x, y ) )
-			{
-				hit_item = item;
-				break;
-			}
-
-			item_rect.translate(0, -mLineHeight);
+			hit_item = item;
+			break;
 		}
-		line++;
+
+		item_rect.translate(0, -mLineHeight);
 	}
 
 	return hit_item;
@@ -2487,22 +2645,64 @@ void LLScrollListCtrl::updateSort() const
 {
 	if (hasSortOrder() && !isSorted())
 	{
-		// do stable sort to preserve any previous sorts
-		std::stable_sort(
-			mItemList.begin(), 
-			mItemList.end(), 
-			SortScrollListItem(mSortColumns,mSortCallback));
+		if (mDataProvider && !mSortCallback)
+		{
+			sortVirtualRows(mSortColumns);
+		}
+		else
+		{
+			// do stable sort to preserve any previous sorts
+			std::stable_sort(
+				mItemList.begin(), 
+				mItemList.end(), 
+				SortScrollListItem(mSortColumns,mSortCallback));
+		}
 
 		mSorted = true;
 	}
 }
 
+// Custom sort callbacks compare items, so they still sort by cells
+void LLScrollListCtrl::sortVirtualRows(const std::vector<sort_column_t>& sort_orders) const
+{
+	SortVirtualRow::sort_keys_t sort_keys(sort_orders.size());
+	for (U32 i = 0; i < sort_orders.size(); ++i)
+	{
+		S32 column_idx = sort_orders[i].first;
+		if (column_idx < 0 || column_idx >= (S32)mColumnsIndexed.size() || !mColumnsIndexed[column_idx])
+		{
+			continue;
+		}
+		const std::string& column_name = mColumnsIndexed[column_idx]->mName;
+
+		std::vector<std::string>& keys = sort_keys[i];
+		keys.resize(mNumVirtualRows);
+		for (item_list::const_iterator iter = mItemList.begin(); iter != mItemList.end(); ++iter)
+		{
+			S32 row = (*iter)->getVirtualRow();
+			if (row >= 0)
+			{
+				keys[row] = mDataProvider->getSortKey(row, column_name);
+			}
+		}
+	}
+
+	// do stable sort to preserve any previous sorts
+	std::stable_sort(mItemList.begin(), mItemList.end(), SortVirtualRow(sort_orders, sort_keys));
+}
+
 // for one-shot sorts, does not save sort column/order
 void LLScrollListCtrl::sortOnce(S32 column, BOOL ascending)
 {
 	std::vector<std::pair<S32, BOOL> > sort_column;
 	sort_column.push_back(std::make_pair(column, ascending));
 
+	if (mDataProvider && !mSortCallback)
+	{
+		sortVirtualRows(sort_column);
+		return;
+	}
+
 	// do stable sort to preserve any previous sorts
 	std::stable_sort(
 		mItemList.begin(), 
@@ -2877,6 +3077,16 @@ LLScrollListItem* LLScrollListCtrl::addRow(LLScrollListItem *new_item, const LLS
 {
 	LL_RECORD_BLOCK_TIME(FTM_ADD_SCROLLLIST_ELEMENT);
 	if (!item_p.validateBlock() || !new_item) return NULL;
+
+	setRowCells(new_item, item_p);
+
+	addItem(new_item, pos);
+	return new_item;
+}
+
+// Creates the cells of an item from its params, adding missing columns
+void LLScrollListCtrl::setRowCells(LLScrollListItem* new_item, const LLScrollListItem::Params& item_p)
+{
 	new_item->setNumColumns(mColumns.size());
 
 	// Add any columns we don't already have
@@ -2976,9 +3186,6 @@ LLScrollListItem* LLScrollListCtrl::addRow(LLScrollListItem *new_item, const LLS
 			new_item->setColumn(column_idx, new LLScrollListSpacer(cell_p));
 		}
 	}
-
-	addItem(new_item, pos);
-	return new_item;
 }
 
 LLScrollListItem* LLScrollListCtrl::addSimpleElement(const std::string& value, EAddPosition pos, const LLSD& id)
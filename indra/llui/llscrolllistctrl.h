@@ -50,6 +50,32 @@ class LLScrollListCell;
 class LLTextBox;
 class LLContextMenu;
 
+//---------------------------------------------------------------------------
+// LLScrollListDataProvider
+//
+// Source of the rows of an LLScrollListCtrl in virtual mode.  The list keeps
+// a light item per row, holding just the row's value, and asks for the cells
+// of a row only when the row is drawn or looked at.  Sorting uses the sort
+// keys instead of building and comparing cells.
+//---------------------------------------------------------------------------
+class LLScrollListDataProvider
+{
+public:
+	virtual ~LLScrollListDataProvider() {}
+
+	virtual S32		getRowCount() const = 0;
+
+	// what getValue() returns for the row's item, usually an id
+	virtual LLSD	getRowValue(S32 row) const = 0;
+	virtual bool	getRowEnabled(S32 row) const { return true; }
+
+	// fills in the columns of the row, same as for LLScrollListCtrl::addRow()
+	virtual void	getRowCells(S32 row, LLScrollListItem::Params& row_params) const = 0;
+
+	// compared with LLStringUtil::compareDict(), like cell values are
+	virtual std::string getSortKey(S32 row, const std::string& column) const = 0;
+};
+
 class LLScrollListCtrl : public LLUICtrl, public LLEditMenuHandler, 
 	public LLCtrlListInterface, public LLCtrlScrollInterface
 {
@@ -136,6 +162,7 @@ public:
 
 protected:
 	friend class LLUICtrlFactory;
+	friend class LLScrollListItem;
 
 	LLScrollListCtrl(const Params&);
 
@@ -173,6 +200,14 @@ public:
 	virtual void clearRows(); // clears all elements
 	virtual void sortByColumn(const std::string& name, BOOL ascending);
 
+	// Virtual mode: the rows come from provider, which isn't owned by the
+	// list and must be unset before it goes away.  Setting or unsetting a
+	// provider clears the list, call refreshFromDataProvider() to load the
+	// rows and again whenever they change.  Selection is kept by value.
+	void			setDataProvider(LLScrollListDataProvider* provider);
+	LLScrollListDataProvider* getDataProvider() const { return mDataProvider; }
+	void			refreshFromDataProvider();
+
 	// These functions take and return an array of arrays of elements, as above
 	virtual void	setValue(const LLSD& value );
 	virtual LLSD	getValue() const;
@@ -419,6 +454,10 @@ private:
 	void			selectPrevItem(BOOL extend_selection);
 	void			selectNextItem(BOOL extend_selection);
 	void			drawItems();
+
+	void			setRowCells(LLScrollListItem* item, const LLScrollListItem::Params& item_p);
+	void			fetchRowCells(LLScrollListItem* item);
+	void			releaseRowCells(S32 first_line, S32 last_line);
 	
 	void            updateLineHeightInsert(LLScrollListItem* item);
 	void			reportInvalidInput();
@@ -511,7 +550,13 @@ private:
 	typedef std::pair<S32, BOOL> sort_column_t;
 	std::vector<sort_column_t>	mSortColumns;
 
+	void			sortVirtualRows(const std::vector<sort_column_t>& sort_orders) const;
+
 	sort_signal_t*	mSortCallback;
+
+	LLScrollListDataProvider* mDataProvider;
+	S32				mNumVirtualRows;	// row count of the provider at the last refresh
+	S32				mNumFetchedRows;	// rows that may have cells, an upper bound
 }; // end class LLScrollListCtrl
 
 #endif  // LL_SCROLLLISTCTRL_H
@@ -30,6 +30,7 @@
 #include "llscrolllistitem.h"
 
 #include "llrect.h"
+#include "llscrolllistctrl.h"
 #include "llui.h"
 
 
@@ -42,7 +43,10 @@ LLScrollListItem::LLScrollListItem( const Params& p )
 	mHighlighted(FALSE),
 	mEnabled(p.enabled),
 	mUserdata(p.userdata),
-	mItemValue(p.value)
+	mItemValue(p.value),
+	mVirtualList(NULL),
+	mVirtualRow(-1),
+	mCellsFetched(false)
 {
 }
 
@@ -60,6 +64,11 @@ void LLScrollListItem::addColumn(const LLScrollListCell::Params& p)
 
 void LLScrollListItem::setNumColumns(S32 columns)
 {
+	if (needsCells())
+	{
+		fetchCells();
+	}
+
 	S32 prev_columns = mColumns.size();
 	if (columns < prev_columns)
 	{
@@ -76,6 +85,11 @@ void LLScrollListItem::setNumColumns(S32 columns)
 
 void LLScrollListItem::setColumn( S32 column, LLScrollListCell *cell )
 {
+	if (needsCells())
+	{
+		fetchCells();
+	}
+
 	if (column < (S32)mColumns.size())
 	{
 		delete mColumns[column];
@@ -90,11 +104,21 @@ void LLScrollListItem::setColumn( S32 column, LLScrollListCell *cell )
 
 S32 LLScrollListItem::getNumColumns() const
 {
+	if (needsCells())
+	{
+		fetchCells();
+	}
+
 	return mColumns.size();
 }
 
 LLScrollListCell* LLScrollListItem::getColumn(const S32 i) const
 {
+	if (needsCells())
+	{
+		fetchCells();
+	}
+
 	if (0 <= i && i < (S32)mColumns.size())
 	{
 		return mColumns[i];
@@ -102,6 +126,19 @@ LLScrollListCell* LLScrollListItem::getColumn(const S32 i) const
 	return NULL;
 }
 
+void LLScrollListItem::fetchCells() const
+{
+	// cells are a cache of the provider's row, fetching them doesn't change the item
+	mVirtualList->fetchRowCells(const_cast<LLScrollListItem*>(this));
+}
+
+void LLScrollListItem::releaseCells()
+{
+	std::for_each(mColumns.begin(), mColumns.end(), DeletePointer());
+	mColumns.clear();
+	mCellsFetched = false;
+}
+
 std::string LLScrollListItem::getContentsCSV() const
 {
 	std::string ret;
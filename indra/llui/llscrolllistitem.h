@@ -105,6 +105,9 @@ public:
 
 	LLScrollListCell *getColumn(const S32 i) const;
 
+	// row of the list's data provider, -1 unless the list is in virtual mode
+	S32		getVirtualRow() const			{ return mVirtualRow; }
+
 	std::string getContentsCSV() const;
 
 	virtual void draw(const LLRect& rect, const LLColor4& fg_color, const LLColor4& bg_color, const LLColor4& highlight_color, S32 column_padding);
@@ -113,6 +116,12 @@ protected:
 	LLScrollListItem( const Params& );
 
 private:
+	// Rows of a list in virtual mode start out without cells, the list
+	// fetches them from its data provider the first time they're needed.
+	bool	needsCells() const				{ return mVirtualList && !mCellsFetched; }
+	void	fetchCells() const;
+	void	releaseCells();
+
 	BOOL	mSelected;
 	BOOL	mHighlighted;
 	BOOL	mEnabled;
@@ -120,6 +129,10 @@ private:
 	LLSD	mItemValue;
 	std::vector<LLScrollListCell *> mColumns;
 	LLRect  mRectangle;
+
+	LLScrollListCtrl* mVirtualList;
+	S32		mVirtualRow;
+	bool	mCellsFetched;
 };
 
 #endif
@@ -195,6 +195,10 @@ LLTextBase::LLTextBase(const LLTextBase::Params &p)
 	mTextSelectedColor(p.text_selected_color),
 	mSelectedBGColor(p.bg_selected_color),
 	mReflowIndex(S32_MAX),
+	mReflowEditsOnly(false),
+	mReflowEditEnd(0),
+	mReflowEditDelta(0),
+	mReflowWidth(0),
 	mCursorPos( 0 ),
 	mScrollNeeded(FALSE),
 	mDesiredXPixel(-1),
@@ -824,13 +828,22 @@ S32 LLTextBase::insertStringNoUndo(S32 pos, const LLWString &wstr, LLTextBase::s
 
 	getViewModel()->getEditableDisplay().insert(pos, wstr);
 
-	if ( truncate() )
+	bool truncated = truncate();
+	if (truncated)
 	{
 		insert_len = getLength() - old_len;
 	}
 
 	onValueChange(pos, pos + insert_len);
-	needsReflow(pos);
+	if (truncated)
+	{
+		// the removal was recorded before the insert, can't track both
+		needsReflow(pos);
+	}
+	else
+	{
+		needsReflowForEdit(pos, 0, insert_len);
+	}
 
 	return insert_len;
 }
@@ -890,7 +903,7 @@ S32 LLTextBase::removeStringNoUndo(S32 pos, S32 length)
 	createDefaultSegment();
 
 	onValueChange(pos, pos);
-	needsReflow(pos);
+	needsReflowForEdit(pos, length, 0);
 
 	return -length;	// This will be wrong if someone calls removeStringNoUndo with an excessive length
 }
@@ -906,7 +919,7 @@ S32 LLTextBase::overwriteCharNoUndo(S32 pos, llwchar wc)
 	getViewModel()->getEditableDisplay()[pos] = wc;
 
 	onValueChange(pos, pos + 1);
-	needsReflow(pos);
+	needsReflowForEdit(pos, 1, 1);
 
 	return 1;
 }
@@ -1143,6 +1156,7 @@ void LLTextBase::reshape(S32 width, S32 height, BOOL called_from_parent)
 {
 	if (width != getRect().getWidth() || height != getRect().getHeight())
 	{
+		S32 old_width = mVisibleTextRect.getWidth();
 		bool scrolled_to_bottom = mScroller ? mScroller->isAtBottom() : false;
 
 		LLUICtrl::reshape( width, height, called_from_parent );
@@ -1161,7 +1175,7 @@ void LLTextBase::reshape(S32 width, S32 height, BOOL called_from_parent)
 		// up-to-date mVisibleTextRect
 		updateRects();
 		
-		needsReflow();
+		needsReflowForResize(old_width);
 	}
 }
 
@@ -1446,6 +1460,34 @@ S32 LLTextBase::getLeftOffset(S32 width)
 }
 
 
+// Continues the layout with lines of the previous one, starting with the
+// paragraph that now begins at line_start_index.  Returns false if no
+// paragraph of the old layout began there.
+bool LLTextBase::appendOldLines(const line_list_t& old_lines, S32 line_start_index, S32 index_delta, S32 cur_top, S32 line_num)
+{
+	line_list_t::const_iterator iter = std::upper_bound(old_lines.begin(), old_lines.end(), line_start_index - index_delta, line_end_compare());
+	if (iter == old_lines.begin() || iter == old_lines.end()
+		|| iter->mDocIndexStart != line_start_index - index_delta
+		|| (iter - 1)->mLineNum == iter->mLineNum)
+	{
+		return false;
+	}
+
+	S32 top_delta = cur_top - iter->mRect.mTop;
+	S32 line_num_delta = line_num - iter->mLineNum;
+	mLineInfoList.reserve(mLineInfoList.size() + (old_lines.end() - iter));
+	for (; iter != old_lines.end(); ++iter)
+	{
+		line_info line = *iter;
+		line.mDocIndexStart += index_delta;
+		line.mDocIndexEnd += index_delta;
+		line.mRect.translate(0, top_delta);
+		line.mLineNum += line_num_delta;
+		mLineInfoList.push_back(line);
+	}
+	return true;
+}
+
 static LLTrace::BlockTimerStatHandle FTM_TEXT_REFLOW ("Text Reflow");
 void LLTextBase::reflow()
 {
@@ -1498,6 +1540,17 @@ void LLTextBase::reflow()
 		S32 start_index = mReflowIndex;
 		mReflowIndex = S32_MAX;
 
+		const S32 text_available_width = mVisibleTextRect.getWidth() - mHPad;  // reserve room for margin
+
+		// lines after the edited text can be moved instead of laid out again,
+		// provided they were laid out for the same width
+		bool reuse_lines = mReflowEditsOnly && text_available_width == mReflowWidth;
+		S32 edit_end = mReflowEditEnd;
+		S32 edit_delta = mReflowEditDelta;
+		mReflowEditsOnly = false;
+		mReflowWidth = text_available_width;
+		line_list_t old_lines;
+
 		// shrink document to minimum size (visible portion of text widget)
 		// to force inlined widgets with follows set to shrink
 		if (mWordWrap)
@@ -1510,7 +1563,6 @@ void LLTextBase::reflow()
 		segment_set_t::iterator seg_iter = mSegments.begin();
 		S32 seg_offset = 0;
 		S32 line_start_index = 0;
-		const S32 text_available_width = mVisibleTextRect.getWidth() - mHPad;  // reserve room for margin
 		S32 remaining_pixels = text_available_width;
 		S32 line_count = 0;
 
@@ -1523,6 +1575,10 @@ void LLTextBase::reflow()
 			line_count = iter->mLineNum;
 			cur_top = iter->mRect.mTop;
 			getSegmentAndOffset(iter->mDocIndexStart, &seg_iter, &seg_offset);
+			if (reuse_lines)
+			{
+				old_lines.assign(iter, mLineInfoList.end());
+			}
 			mLineInfoList.erase(iter, mLineInfoList.end());
 		}
 
@@ -1606,6 +1662,12 @@ void LLTextBase::reflow()
 			if (force_newline) 
 			{
 				line_count++;
+
+				if (!old_lines.empty() && line_start_index >= edit_end
+					&& appendOldLines(old_lines, line_start_index, edit_delta, cur_top, line_count))
+				{
+					break;
+				}
 			}
 		}
 
@@ -2176,6 +2238,50 @@ void LLTextBase::needsReflow(S32 index)
 {
 	LL_DEBUGS() << "reflow on object " << (void*)this << " index = " << mReflowIndex << ", new index = " << index << LL_ENDL;
 	mReflowIndex = llmin(mReflowIndex, index);
+	mReflowEditsOnly = false;
+}
+
+// Text from pos to pos + old_len was replaced by new_len characters.  As long
+// as nothing but edits happens before the next reflow, everything after the
+// edits only moves and reflow() can stop at the first paragraph boundary it
+// shares with the old layout.
+void LLTextBase::needsReflowForEdit(S32 pos, S32 old_len, S32 new_len)
+{
+	bool edits_only = mReflowIndex == S32_MAX || mReflowEditsOnly;
+	needsReflow(pos);
+	if (!edits_only)
+	{
+		return;
+	}
+
+	S32 delta = new_len - old_len;
+	if (!mReflowEditsOnly)
+	{
+		mReflowEditEnd = pos + new_len;
+		mReflowEditDelta = delta;
+	}
+	else
+	{
+		// an edit past the previous ones extends the range, otherwise the
+		// previous end just moves along with the text
+		mReflowEditEnd = mReflowEditEnd >= pos + old_len ? mReflowEditEnd + delta : pos + new_len;
+		mReflowEditDelta += delta;
+	}
+	mReflowEditsOnly = true;
+}
+
+// Line breaks only depend on the width, when just the height changed
+// relaying out the last line is enough to update the document rect.
+void LLTextBase::needsReflowForResize(S32 old_width)
+{
+	if (mVisibleTextRect.getWidth() != old_width)
+	{
+		needsReflow();
+	}
+	else
+	{
+		needsReflow(llmax(0, getLength() - 1));
+	}
 }
 
 void LLTextBase::appendLineBreakSegment(const LLStyle::Params& style_params)
@@ -2873,7 +2979,7 @@ void LLTextBase::updateRects()
 	}
 	if (mVisibleTextRect != old_text_rect)
 	{
-		needsReflow();
+		needsReflowForResize(old_text_rect.getWidth());
 	}
 
 	// update mTextBoundingRect after mVisibleTextRect took scrolls into account
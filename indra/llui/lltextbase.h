@@ -572,6 +572,9 @@ protected:
 	std::pair<S32, S32>				getVisibleLines(bool fully_visible = false);
 	S32								getLeftOffset(S32 width);
 	void							reflow();
+	void							needsReflowForEdit(S32 pos, S32 old_len, S32 new_len);
+	void							needsReflowForResize(S32 old_width);
+	bool							appendOldLines(const line_list_t& old_lines, S32 line_start_index, S32 index_delta, S32 cur_top, S32 line_num);
 
 	// cursor
 	void							updateCursorXPos();
@@ -672,6 +675,10 @@ protected:
 
 	// transient state
 	S32							mReflowIndex;		// index at which to start reflow.  S32_MAX indicates no reflow needed.
+	bool						mReflowEditsOnly;	// only text edits since last reflow, lines after mReflowEditEnd can be reused
+	S32							mReflowEditEnd;		// end of the edited text in current document positions
+	S32							mReflowEditDelta;	// number of characters the edits added (negative if removed)
+	S32							mReflowWidth;		// text width lines were last laid out for
 	bool						mScrollNeeded;		// need to change scroll region because of change to cursor position
 	S32							mScrollIndex;		// index of first character to keep visible in scroll region
 
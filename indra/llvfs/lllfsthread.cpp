@@ -64,7 +64,7 @@ void LLLFSThread::cleanupClass()
 //----------------------------------------------------------------------------
 
 LLLFSThread::LLLFSThread(bool threaded) :
-	LLQueuedThread("LFS", threaded),
+	LLQueuedThread("LFS", threaded, false, 1),	// one at a time, the requests share mLocalAPRFilePoolp
 	mPriorityCounter(PRIORITY_LOWBITS)
 {
 	if(!mLocalAPRFilePoolp)
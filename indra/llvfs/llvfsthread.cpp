@@ -65,7 +65,7 @@ void LLVFSThread::cleanupClass()
 //----------------------------------------------------------------------------
 
 LLVFSThread::LLVFSThread(bool threaded) :
-	LLQueuedThread("VFS", threaded)
+	LLQueuedThread("VFS", threaded, false, 1)	// one at a time and in order, as on a thread of its own
 {
 }
 
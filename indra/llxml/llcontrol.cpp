@@ -43,6 +43,9 @@
 #include "llrect.h"
 #include "llxmltree.h"
 #include "llsdserialize.h"
+#include "llfile.h"
+#include "llmemorystream.h"
+#include "llmd5.h"
 
 #if LL_RELEASE_WITH_DEBUG_INFO || LL_DEBUG
 #define CONTROL_ERRS LL_ERRS("ControlErrors")
@@ -327,8 +330,15 @@ LLSD LLControlVariable::getSaveValue() const
 
 LLPointer<LLControlVariable> LLControlGroup::getControl(const std::string& name)
 {
-	ctrl_name_table_t::iterator iter = mNameTable.find(name);
-	return iter == mNameTable.end() ? LLPointer<LLControlVariable>() : iter->second;
+	LLStringPool::handle_t handle = getControlNames().find(name);
+	return LLPointer<LLControlVariable>(handle < mHandleTable.size() ? mHandleTable[handle] : NULL);
+}
+
+//static
+LLStringPool& LLControlGroup::getControlNames()
+{
+	static LLStringPool sControlNames;
+	return sControlNames;
 }
 
 
@@ -357,6 +367,7 @@ LLControlGroup::~LLControlGroup()
 
 void LLControlGroup::cleanup()
 {
+	mHandleTable.clear();
 	mNameTable.clear();
 }
 
@@ -399,6 +410,12 @@ LLControlVariable* LLControlGroup::declareControl(const std::string& name, eCont
 	// if not, create the control and add it to the name table
 	LLControlVariable* control = new LLControlVariable(name, type, initial_val, comment, persist, hidefromsettingseditor);
 	mNameTable[name] = control;	
+	LLStringPool::handle_t handle = getControlNames().intern(name);
+	if (handle >= mHandleTable.size())
+	{
+		mHandleTable.resize(handle + 1, NULL);
+	}
+	mHandleTable[handle] = control;
 	return control;
 }
 
@@ -867,6 +884,11 @@ U32 LLControlGroup::loadFromFile(const std::string& filename, bool set_default_v
 		return loadFromFileLegacy(filename, TRUE, TYPE_STRING);
 	}
 
+	return loadFromLLSD(settings, filename, set_default_values, save_values);
+}
+
+U32 LLControlGroup::loadFromLLSD(const LLSD& settings, const std::string& filename, bool set_default_values, bool save_values)
+{
 	U32	validitems = 0;
 	bool hidefromsettingseditor = false;
 	
@@ -980,6 +1002,164 @@ U32 LLControlGroup::loadFromFile(const std::string& filename, bool set_default_v
 	return validitems;
 }
 
+// Snapshot files are a header naming the source file as it was when the
+// snapshot was taken, followed by the parsed file as binary LLSD.
+const U32 SETTINGS_SNAPSHOT_MAGIC = 0x53434c4c;	// "LLCS"
+const U32 SETTINGS_SNAPSHOT_VERSION = 1;
+
+struct LLSettingsSnapshotHeader
+{
+	U32 mMagic;
+	U32 mVersion;
+	U64 mSourceSize;
+	U64 mSourceTime;
+	U32 mSourceNameLength;	// followed by the source file name
+	U32 mDataSize;			// bytes of binary LLSD after the name
+};
+
+U32 LLControlGroup::loadDefaultsFromFile(const std::string& filename, const std::string& snapshot_filename)
+{
+	LLSD settings;
+	if (readSnapshot(snapshot_filename, filename, settings))
+	{
+		return loadFromLLSD(settings, filename, true, true);
+	}
+
+	llifstream infile;
+	infile.open(filename);
+	if(!infile.is_open())
+	{
+		LL_WARNS("Settings") << "Cannot find file " << filename << " to load." << LL_ENDL;
+		return 0;
+	}
+
+	if (LLSDParser::PARSE_FAILURE == LLSDSerialize::fromXML(settings, infile))
+	{
+		infile.close();
+		LL_WARNS("Settings") << "Unable to parse LLSD control file " << filename << ". Trying Legacy Method." << LL_ENDL;
+		return loadFromFileLegacy(filename, TRUE, TYPE_STRING);
+	}
+	infile.close();
+
+	writeSnapshot(snapshot_filename, filename, settings);
+
+	return loadFromLLSD(settings, filename, true, true);
+}
+
+//static
+std::string LLControlGroup::getSnapshotName(const std::string& filename)
+{
+	std::string base_name = filename.substr(filename.find_last_of("/\\") + 1);
+	base_name = base_name.substr(0, base_name.find_last_of('.'));
+
+	char digest[33];
+	LLMD5((const unsigned char*) filename.c_str()).hex_digest(digest);
+	return llformat("defaults_%s_%.8s.bin", base_name.c_str(), digest);
+}
+
+bool LLControlGroup::readSnapshot(const std::string& snapshot_filename, const std::string& source_filename, LLSD& settings)
+{
+	llstat source_stat;
+	if (snapshot_filename.empty() || LLFile::stat(source_filename, &source_stat))
+	{
+		return false;
+	}
+
+	LLFILE* fp = LLFile::fopen(snapshot_filename, "rb");
+	if (!fp)
+	{
+		return false;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	S32 size = (S32) ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	// one read for the whole file, then parse from memory
+	std::vector<U8> buffer(llmax(size, 0));
+	bool success = size > (S32) sizeof(LLSettingsSnapshotHeader) &&
+				   fread(&buffer[0], 1, size, fp) == (size_t) size;
+	fclose(fp);
+
+	if (success)
+	{
+		LLSettingsSnapshotHeader header;
+		memcpy(&header, &buffer[0], sizeof(header));
+
+		S32 name_offset = sizeof(header);
+		S32 data_offset = name_offset + header.mSourceNameLength;
+		success = header.mMagic == SETTINGS_SNAPSHOT_MAGIC &&
+				  header.mVersion == SETTINGS_SNAPSHOT_VERSION &&
+				  header.mSourceSize == (U64) source_stat.st_size &&
+				  header.mSourceTime == (U64) source_stat.st_mtime &&
+				  header.mSourceNameLength == source_filename.size() &&
+				  (S64) data_offset + header.mDataSize == size &&
+				  !memcmp(&buffer[name_offset], source_filename.data(), header.mSourceNameLength);
+
+		if (success)
+		{
+			LLMemoryStream data(&buffer[data_offset], header.mDataSize);
+			success = LLSDSerialize::fromBinary(settings, data, header.mDataSize) != LLSDParser::PARSE_FAILURE &&
+					  settings.isMap();
+		}
+	}
+
+	if (!success)
+	{
+		LL_INFOS("Settings") << "Settings snapshot " << snapshot_filename << " is out of date, reparsing " << source_filename << LL_ENDL;
+		settings.clear();
+	}
+	return success;
+}
+
+void LLControlGroup::writeSnapshot(const std::string& snapshot_filename, const std::string& source_filename, const LLSD& settings)
+{
+	llstat source_stat;
+	if (snapshot_filename.empty() || LLFile::stat(source_filename, &source_stat))
+	{
+		return;
+	}
+
+	std::ostringstream data;
+	LLSDSerialize::toBinary(settings, data);
+	const std::string& data_str = data.str();
+
+	LLSettingsSnapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	header.mMagic = SETTINGS_SNAPSHOT_MAGIC;
+	header.mVersion = SETTINGS_SNAPSHOT_VERSION;
+	header.mSourceSize = source_stat.st_size;
+	header.mSourceTime = source_stat.st_mtime;
+	header.mSourceNameLength = source_filename.size();
+	header.mDataSize = data_str.size();
+
+	// write under a temporary name so another viewer never reads half a file
+	std::string tmp_filename = snapshot_filename + ".tmp";
+	LLFILE* fp = LLFile::fopen(tmp_filename, "wb");
+	if (!fp)
+	{
+		return;
+	}
+
+	bool success = fwrite(&header, 1, sizeof(header), fp) == sizeof(header) &&
+				   fwrite(source_filename.data(), 1, source_filename.size(), fp) == source_filename.size() &&
+				   fwrite(data_str.data(), 1, data_str.size(), fp) == data_str.size();
+	fclose(fp);
+
+	if (success)
+	{
+		// rename doesn't replace an existing file on every platform
+		LLFile::remove(snapshot_filename);
+		success = LLFile::rename(tmp_filename, snapshot_filename) == 0;
+	}
+
+	if (!success)
+	{
+		LL_WARNS("Settings") << "Unable to write settings snapshot " << snapshot_filename << LL_ENDL;
+		LLFile::remove(tmp_filename);
+	}
+}
+
 void LLControlGroup::resetToDefaults()
 {
 	ctrl_name_table_t::iterator control_iter;
@@ -33,6 +33,7 @@
 #include "llrect.h"
 #include "llrefcount.h"
 #include "llinstancetracker.h"
+#include "llstringpool.h"
 
 #include "llcontrolgroupreader.h"
 
@@ -190,6 +191,11 @@ class LLControlGroup : public LLInstanceTracker<LLControlGroup, std::string>
 protected:
 	typedef std::map<std::string, LLControlVariablePtr > ctrl_name_table_t;
 	ctrl_name_table_t mNameTable;
+	// Same controls for getControl(), which runs every frame for many of
+	// them, by handle of their name in getControlNames().  mNameTable keeps
+	// them alive and in order.
+	typedef std::vector<LLControlVariable*> ctrl_handle_table_t;
+	ctrl_handle_table_t mHandleTable;
 	std::string mTypeString[TYPE_COUNT];
 
 public:
@@ -204,6 +210,9 @@ public:
 
 	LLControlVariablePtr getControl(const std::string& name);
 
+	// Names of the controls of all groups.
+	static LLStringPool& getControlNames();
+
 	struct ApplyFunctor
 	{
 		virtual ~ApplyFunctor() {};
@@ -299,7 +308,19 @@ public:
 	U32	loadFromFileLegacy(const std::string& filename, BOOL require_declaration = TRUE, eControlType declare_as = TYPE_STRING);
  	U32 saveToFile(const std::string& filename, BOOL nondefault_only);
  	U32	loadFromFile(const std::string& filename, bool default_values = false, bool save_values = true);
+	// Same as loadFromFile(filename, true) but reads a binary snapshot of
+	// the file from snapshot_filename when there is an up to date one, and
+	// writes one after parsing the XML otherwise.
+	U32	loadDefaultsFromFile(const std::string& filename, const std::string& snapshot_filename);
+	// Name for the snapshot of filename, unique to its full path, since
+	// files in different groups or directories may share a name.
+	static std::string getSnapshotName(const std::string& filename);
 	void	resetToDefaults();
+
+private:
+	U32	loadFromLLSD(const LLSD& settings, const std::string& filename, bool default_values, bool save_values);
+	bool	readSnapshot(const std::string& snapshot_filename, const std::string& source_filename, LLSD& settings);
+	void	writeSnapshot(const std::string& snapshot_filename, const std::string& source_filename, const LLSD& settings);
 };
 
 
@@ -40,11 +40,12 @@
 // LLXmlTree
 
 // static
-LLStdStringTable LLXmlTree::sAttributeKeys(1024);
+LLStringPool LLXmlTree::sAttributeKeys;
+// static
+LLStringPool LLXmlTree::sNodeNames;
 
 LLXmlTree::LLXmlTree()
-	: mRoot( NULL ),
-	  mNodeNames(512)
+	: mRoot( NULL )
 {
 }
 
@@ -57,7 +58,6 @@ void LLXmlTree::cleanup()
 {
 	delete mRoot;
 	mRoot = NULL;
-	mNodeNames.cleanup();
 }
 
 
@@ -128,21 +128,21 @@ void LLXmlTreeNode::dump( const std::string& prefix )
 	{
 		LLStdStringHandle key = iter->first;
 		const std::string* value = iter->second;
-		LL_CONT << prefix << " " << key << "=" << (value->empty() ? "NULL" : *value);
+		LL_CONT << prefix << " " << LLXmlTree::sAttributeKeys.getString(key) << "=" << (value->empty() ? "NULL" : *value);
 	}
 	LL_CONT << LL_ENDL;
 } 
 
 BOOL LLXmlTreeNode::hasAttribute(const std::string& name)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	attribute_map_t::iterator iter = mAttributes.find(canonical_name);
 	return (iter == mAttributes.end()) ? false : true;
 }
 
 void LLXmlTreeNode::addAttribute(const std::string& name, const std::string& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.intern( name );
 	const std::string *newstr = new std::string(value);
 	mAttributes[canonical_name] = newstr; // insert + copy
 }
@@ -162,7 +162,7 @@ LLXmlTreeNode*	LLXmlTreeNode::getNextChild()
 
 LLXmlTreeNode* LLXmlTreeNode::getChildByName(const std::string& name)
 {
-	LLStdStringHandle tableptr = mTree->mNodeNames.checkString(name);
+	LLStdStringHandle tableptr = LLXmlTree::sNodeNames.find(name);
 	mChildMapIter = mChildMap.lower_bound(tableptr);
 	mChildMapEndIter = mChildMap.upper_bound(tableptr);
 	return getNextNamedChild();
@@ -187,7 +187,7 @@ void LLXmlTreeNode::addChild(LLXmlTreeNode* child)
 	mChildList.push_back( child );
 
 	// Add a name mapping to this node
-	LLStdStringHandle tableptr = mTree->mNodeNames.insert(child->mName);
+	LLStdStringHandle tableptr = LLXmlTree::sNodeNames.intern(child->mName);
 	mChildMap.insert( child_map_t::value_type(tableptr, child));
 	
 	child->mParent = this;
@@ -310,103 +310,103 @@ BOOL LLXmlTreeNode::getFastAttributeString(LLStdStringHandle canonical_name, std
 
 BOOL LLXmlTreeNode::getAttributeBOOL(const std::string& name, BOOL& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeBOOL(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeU8(const std::string& name, U8& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeU8(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeS8(const std::string& name, S8& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeS8(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeS16(const std::string& name, S16& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeS16(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeU16(const std::string& name, U16& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeU16(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeU32(const std::string& name, U32& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeU32(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeS32(const std::string& name, S32& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeS32(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeF32(const std::string& name, F32& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeF32(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeF64(const std::string& name, F64& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeF64(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeColor(const std::string& name, LLColor4& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeColor(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeColor4(const std::string& name, LLColor4& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeColor4(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeColor4U(const std::string& name, LLColor4U& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeColor4U(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeVector3(const std::string& name, LLVector3& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeVector3(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeVector3d(const std::string& name, LLVector3d& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeVector3d(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeQuat(const std::string& name, LLQuaternion& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeQuat(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeUUID(const std::string& name, LLUUID& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeUUID(canonical_name, value);
 }
 
 BOOL LLXmlTreeNode::getAttributeString(const std::string& name, std::string& value)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
+	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.find( name );
 	return getFastAttributeString(canonical_name, value);
 }
 
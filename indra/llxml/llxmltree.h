@@ -64,18 +64,18 @@ public:
 
 	static LLStdStringHandle addAttributeString( const std::string& name)
 	{
-		return sAttributeKeys.addString( name );
+		return sAttributeKeys.intern( name );
 	}
 	
 public:
 	// global
-	static LLStdStringTable sAttributeKeys;
+	static LLStringPool sAttributeKeys;
 	
 protected:
 	LLXmlTreeNode* mRoot;
 
-	// local
-	LLStdStringTable mNodeNames;	
+	// global too, the same few tags come back in every file
+	static LLStringPool sNodeNames;
 };
 
 //////////////////////////////////////////////////////////////
@@ -80,13 +80,24 @@ namespace tut
 		}
 		void writeSettingsFile(const LLSD& config)
 		{
-			llofstream file(mTestConfigFile);
+			writeSettingsFile(config, mTestConfigFile);
+		}
+		void writeSettingsFile(const LLSD& config, const std::string& filename)
+		{
+			llofstream file(filename);
 			if (file.is_open())
 			{
 				LLSDSerialize::toPrettyXML(config, file);
 			}
 			file.close();
 		}
+		std::string readFile(const std::string& filename)
+		{
+			llifstream file(filename, std::ios::binary);
+			std::ostringstream contents;
+			contents << file.rdbuf();
+			return contents.str();
+		}
 		static bool handleListenerTest()
 		{
 			control_group::mListenerFired = true;
@@ -156,4 +167,70 @@ namespace tut
 		ensure("listener fired on changed setting", mListenerFired);	   
 	}
 
+	//binary snapshot of default settings
+	template<> template<>
+	void control_group_t::test<5>()
+	{
+		std::string snapshot_file = mTestConfigDir + "settings.bin";
+		int results = mCG->loadDefaultsFromFile(mTestConfigFile, snapshot_file);
+		ensure("number of settings", (results == 1));
+		ensure("snapshot written", LLFile::isfile(snapshot_file));
+
+		LLControlGroup test_cg("foo4");
+		results = test_cg.loadDefaultsFromFile(mTestConfigFile, snapshot_file);
+		ensure("number of settings from snapshot", (results == 1));
+		ensure_equals("value from snapshot", test_cg.getU32("TestSetting"), 12);
+		ensure_equals("comment from snapshot", test_cg.getControl("TestSetting")->getComment(), std::string("Dummy setting used for testing"));
+
+		// a changed source file makes the snapshot stale
+		LLSD config;
+		config["TestSetting"]["Comment"] = "Dummy setting used for testing";
+		config["TestSetting"]["Persist"] = 1;
+		config["TestSetting"]["Type"] = "U32";
+		config["TestSetting"]["Value"] = 123456;
+		config["OtherSetting"]["Comment"] = "Another dummy setting";
+		config["OtherSetting"]["Persist"] = 0;
+		config["OtherSetting"]["Type"] = "String";
+		config["OtherSetting"]["Value"] = "bar";
+		writeSettingsFile(config);
+
+		LLControlGroup changed_cg("foo5");
+		results = changed_cg.loadDefaultsFromFile(mTestConfigFile, snapshot_file);
+		ensure("number of settings after change", (results == 2));
+		ensure_equals("value after change", changed_cg.getU32("TestSetting"), 123456);
+		ensure_equals("new setting after change", changed_cg.getString("OtherSetting"), std::string("bar"));
+	}
+
+	//snapshots of two default files with the same name
+	template<> template<>
+	void control_group_t::test<6>()
+	{
+		std::string install_dir = mTestConfigDir + "install/";
+		std::string install_file = install_dir + "settings.xml";
+		LLFile::mkdir(install_dir);
+		LLSD config;
+		config["InstallSetting"]["Comment"] = "Dummy setting of the install";
+		config["InstallSetting"]["Persist"] = 1;
+		config["InstallSetting"]["Type"] = "U32";
+		config["InstallSetting"]["Value"] = 34;
+		writeSettingsFile(config, install_file);
+
+		std::string snapshot_file = mTestConfigDir + LLControlGroup::getSnapshotName(mTestConfigFile);
+		std::string install_snapshot_file = mTestConfigDir + LLControlGroup::getSnapshotName(install_file);
+		ensure("snapshot names differ", snapshot_file != install_snapshot_file);
+
+		ensure("number of settings", mCG->loadDefaultsFromFile(mTestConfigFile, snapshot_file) == 1);
+		std::string snapshot = readFile(snapshot_file);
+		ensure("number of install settings", mCG->loadDefaultsFromFile(install_file, install_snapshot_file) == 1);
+		ensure("install snapshot written", LLFile::isfile(install_snapshot_file));
+		ensure("first snapshot kept", readFile(snapshot_file) == snapshot);
+
+		// both load from their snapshots
+		LLControlGroup test_cg("foo6");
+		ensure("number of settings again", test_cg.loadDefaultsFromFile(mTestConfigFile, snapshot_file) == 1);
+		ensure("number of install settings again", test_cg.loadDefaultsFromFile(install_file, install_snapshot_file) == 1);
+		ensure("snapshot not rewritten", readFile(snapshot_file) == snapshot);
+		ensure_equals("value from snapshot", test_cg.getU32("TestSetting"), 12);
+		ensure_equals("install value from snapshot", test_cg.getU32("InstallSetting"), 34);
+	}
 }
@@ -52,6 +52,8 @@
 #include "llmarketplacenotifications.h"
 #include "llmd5.h"
 #include "llmeshrepository.h"
+#include "llframearena.h"
+#include "llhitchrecorder.h"
 #include "llpumpio.h"
 #include "llmimetypes.h"
 #include "llslurl.h"
@@ -95,6 +97,7 @@
 #include "lllogininstance.h"
 #include "llprogressview.h"
 #include "llvocache.h"
+#include "llmeshdiskcache.h"
 #include "llvopartgroup.h"
 #include "llweb.h"
 #include "llupdaterservice.h"
@@ -125,6 +128,7 @@
 #include "llleap.h"
 #include "stringize.h"
 #include "llcoros.h"
+#include "llasyncfile.h"
 
 // Third party library includes
 #include <boost/bind.hpp>
@@ -145,6 +149,7 @@
 #include "llviewerkeyboard.h"
 #include "lllfsthread.h"
 #include "llworkerthread.h"
+#include "llworkscheduler.h"
 #include "lltexturecache.h"
 #include "lltexturefetch.h"
 #include "llimageworker.h"
@@ -803,6 +808,10 @@ bool LLAppViewer::init()
 
     mAlloc.setProfilingEnabled(gSavedSettings.getBOOL("MemProfiling"));
 
+	// Hand log messages to a writer thread so logging on the main thread
+	// doesn't wait on the log file.
+	LLError::setAsyncLogging(gSavedSettings.getBOOL("AsyncLogging"));
+
 	// Initialize the non-LLCurl libcurl library.  Should be called
 	// before consumers (LLTextureFetch).
 	mAppCoreHttp.init();
@@ -1272,6 +1281,32 @@ static LLTrace::BlockTimerStatHandle FTM_AGENT_UPDATE("Update");
 // externally visible timers
 LLTrace::BlockTimerStatHandle FTM_FRAME("Frame");
 
+// queue depths kept by the hitch recorder
+static F64 get_texture_fetch_requests()
+{
+	return LLAppViewer::getTextureFetch() ? LLAppViewer::getTextureFetch()->getNumRequests() : 0;
+}
+
+static F64 get_queued_thread_pending(LLQueuedThread* thread)
+{
+	return thread ? thread->getPending() : 0;
+}
+
+static F64 get_mesh_header_requests()
+{
+	return LLMeshRepoThread::sActiveHeaderRequests;
+}
+
+static F64 get_mesh_lod_requests()
+{
+	return LLMeshRepoThread::sActiveLODRequests;
+}
+
+static F64 get_mesh_pending_requests()
+{
+	return gMeshRepo.mPendingRequests.size();
+}
+
 bool LLAppViewer::mainLoop()
 {
 #ifdef LL_DARWIN
@@ -1298,6 +1333,17 @@ bool LLAppViewer::mainLoop()
 		
 		joystick = LLViewerJoystick::getInstance();
 		joystick->setNeedsReset(true);
+
+		LLHitchRecorder& hitch_recorder = LLHitchRecorder::instance();
+		hitch_recorder.setHistorySeconds(gSavedSettings.getF32("HitchHistorySeconds"));
+		hitch_recorder.setSnapshotPrefix(gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "hitch_"));
+		hitch_recorder.startWriterThread();
+		hitch_recorder.addGauge("Texture Fetches", boost::bind(&get_texture_fetch_requests));
+		hitch_recorder.addGauge("Texture Cache Requests", boost::bind(&get_queued_thread_pending, getTextureCache()));
+		hitch_recorder.addGauge("Image Decodes", boost::bind(&get_queued_thread_pending, getImageDecodeThread()));
+		hitch_recorder.addGauge("Mesh Header Requests", boost::bind(&get_mesh_header_requests));
+		hitch_recorder.addGauge("Mesh LOD Requests", boost::bind(&get_mesh_lod_requests));
+		hitch_recorder.addGauge("Mesh Pending Requests", boost::bind(&get_mesh_pending_requests));
 		
 #ifdef LL_DARWIN
 		// Ensure that this section of code never gets called again on OS X.
@@ -1334,6 +1380,17 @@ bool LLAppViewer::mainLoop()
 		LLTrace::get_frame_recording().nextPeriod();
 		LLTrace::BlockTimer::logStats();
 
+		// frames of the session only, logging in hitches by design
+		if (LLStartUp::getStartupState() == STATE_STARTED)
+		{
+			static LLCachedControl<F32> hitch_snapshot_seconds(gSavedSettings, "HitchSnapshotSeconds", 0.f);
+			LLHitchRecorder::instance().setHitchSeconds(hitch_snapshot_seconds);
+			LLHitchRecorder::instance().endFrame();
+		}
+
+		// the transient containers of the frame before last go
+		LLFrameArena::getThreadArena().endFrame();
+
 		LLTrace::get_thread_recorder()->pullFromChildren();
 
 		//clear call stack records
@@ -2089,6 +2146,26 @@ bool LLAppViewer::cleanup()
 			gDirUtilp->getExpandedFilename(LL_PATH_LOGS, report_name));
 	}	
 
+	// the snapshots of the last hitches are written before the analysis
+	LLHitchRecorder::instance().stopWriterThread();
+
+	if (gSavedSettings.getBOOL("AnalyzeHitches"))
+	{
+		LL_INFOS() << "Analyzing hitches" << LL_ENDL;
+
+		std::string logdir = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "");
+		std::vector<std::string> snapshots;
+		std::string snapshot_name;
+		LLDirIterator iter(logdir, "hitch_*" + LLHitchRecorder::SNAPSHOT_EXTENSION);
+		while (iter.next(snapshot_name))
+		{
+			snapshots.push_back(gDirUtilp->add(logdir, snapshot_name));
+		}
+		std::sort(snapshots.begin(), snapshots.end());
+
+		LLHitchRecorder::doAnalysisHitches(snapshots, gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "hitch_report.csv"));
+	}
+
 	LLMetricPerformanceTesterBasic::cleanClass() ;
 
 	LL_INFOS() << "Cleaning up Media and Textures" << LL_ENDL;
@@ -2105,6 +2182,12 @@ bool LLAppViewer::cleanup()
 	LLImage::cleanupClass();
 	LLVFSThread::cleanupClass();
 	LLLFSThread::cleanupClass();
+	// after every queue that uses it
+	LLWorkScheduler::cleanupClass();
+	if (LLAsyncFile::instanceExists())
+	{
+		LLAsyncFile::deleteSingleton();
+	}
 
 #ifndef LL_RELEASE_FOR_DOWNLOAD
 	LL_INFOS() << "Auditing VFS" << LL_ENDL;
@@ -2196,6 +2279,9 @@ bool LLAppViewer::initThreads()
 
 	LLImage::initClass(gSavedSettings.getBOOL("TextureNewByteRange"),gSavedSettings.getS32("TextureReverseByteRange"));
 
+	// Shared by the file threads, the image decode thread and the texture cache
+	LLWorkScheduler::initClass(gSavedSettings.getS32("WorkSchedulerThreads"));
+
 	LLVFSThread::initClass(enable_threads && false);
 	LLLFSThread::initClass(enable_threads && false);
 
@@ -2361,7 +2447,20 @@ bool LLAppViewer::loadSettingsFromDirectory(const std::string& location_key,
 				full_settings_path = gDirUtilp->getExpandedFilename((ELLPath)path_index, file.file_name());
 			}
 
-			if(settings_group->loadFromFile(full_settings_path, set_defaults, file.persistent))
+			U32 loaded = 0;
+			if (set_defaults)
+			{
+				// the install's defaults rarely change, keep them parsed in user_settings
+				std::string snapshot_path = gDirUtilp->getExpandedFilename(LL_PATH_USER_SETTINGS,
+					LLControlGroup::getSnapshotName(full_settings_path));
+				loaded = settings_group->loadDefaultsFromFile(full_settings_path, snapshot_path);
+			}
+			else
+			{
+				loaded = settings_group->loadFromFile(full_settings_path, set_defaults, file.persistent);
+			}
+
+			if(loaded)
 			{	// success!
 				LL_INFOS("Settings") << "Loaded settings file " << full_settings_path << LL_ENDL;
 			}
@@ -2698,6 +2797,7 @@ bool LLAppViewer::initConfiguration()
 	}
 
 	LLFastTimerView::sAnalyzePerformance = gSavedSettings.getBOOL("AnalyzePerformance");
+	LLTrace::TimerEventBuffer::setRecording(gSavedSettings.getBOOL("TimerTraceRecording"));
 	gAgentPilot.setReplaySession(gSavedSettings.getBOOL("ReplaySession"));
 
 	if (gSavedSettings.getBOOL("DebugSession"))
@@ -3705,6 +3805,9 @@ void LLAppViewer::handleViewerCrash()
 	//print out recorded call stacks if there are any.
 	LLError::LLCallStacks::print();
 
+	// write out what the log writer thread hasn't written yet
+	LLError::flushAsyncLog();
+
 	LLAppViewer* pApp = LLAppViewer::instance();
 	if (pApp->beingDebugged())
 	{
@@ -4340,6 +4443,7 @@ bool LLAppViewer::initCache()
 	BOOL read_only = mSecondInstance ? TRUE : FALSE;
 	LLAppViewer::getTextureCache()->setReadOnly(read_only) ;
 	LLVOCache::getInstance()->setReadOnly(read_only);
+	LLMeshDiskCache::getInstance()->setReadOnly(read_only);
 
 	bool texture_cache_mismatch = false;
 	if (gSavedSettings.getS32("LocalCacheVersion") != LLAppViewer::getTextureCacheVersion()) 
@@ -4419,6 +4523,8 @@ bool LLAppViewer::initCache()
 
 	LLVOCache::getInstance()->initCache(LL_PATH_CACHE, gSavedSettings.getU32("CacheNumberOfRegionsForObjects"), getObjectCacheVersion()) ;
 
+	LLMeshDiskCache::getInstance()->initCache(LL_PATH_CACHE, gSavedSettings.getU32("MeshDiskCacheSize"));
+
 	LLSplashScreen::update(LLTrans::getString("StartupInitializingVFS"));
 	
 	// Init the VFS
@@ -4583,6 +4689,7 @@ void LLAppViewer::purgeCache()
 	LL_INFOS("AppCache") << "Purging Cache and Texture Cache..." << LL_ENDL;
 	LLAppViewer::getTextureCache()->purgeCache(LL_PATH_CACHE);
 	LLVOCache::getInstance()->removeCache(LL_PATH_CACHE);
+	LLMeshDiskCache::getInstance()->removeCache(LL_PATH_CACHE);
 	gDirUtilp->deleteFilesInDir(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, ""), "*.*");
 }
 
@@ -4592,6 +4699,7 @@ void LLAppViewer::purgeCacheImmediate()
 	LL_INFOS("AppCache") << "Purging Object Cache and Texture Cache immediately..." << LL_ENDL;
 	LLAppViewer::getTextureCache()->purgeCache(LL_PATH_CACHE, false);
 	LLVOCache::getInstance()->removeCache(LL_PATH_CACHE, true);
+	LLMeshDiskCache::getInstance()->removeCache(LL_PATH_CACHE);
 }
 
 std::string LLAppViewer::getSecondLifeTitle() const
@@ -5669,6 +5777,13 @@ void LLAppViewer::pingMainloopTimeout(const std::string& state, F32 secs)
 	}
 }
 
+void LLAppViewer::writeTimerTrace()
+{
+	std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS,
+		"timer_trace_" + LLDate::now().toHTTPDateString("%Y%m%d_%H%M%S") + ".json");
+	LLTrace::TimerEventBuffer::writeChromeTrace(filename);
+}
+
 void LLAppViewer::handleLoginComplete()
 {
 	gLoggedInTime.start();
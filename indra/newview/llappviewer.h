@@ -161,6 +161,9 @@ public:
 	void resumeMainloopTimeout(const std::string& state = "", F32 secs = -1.0f);
 	void pingMainloopTimeout(const std::string& state, F32 secs = -1.0f);
 
+	// Chrome trace JSON of the latest timed blocks of every thread, in the logs folder.
+	void writeTimerTrace();
+
 	// Handle the 'login completed' event.
 	// *NOTE:Mani Fix this for login abstraction!!
 	void handleLoginComplete();
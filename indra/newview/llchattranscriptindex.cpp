@@ -0,0 +1,307 @@
+/**
+ * @file llchattranscriptindex.cpp
+ * @brief Sidecar index of the messages in a plain text chat transcript.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llchattranscriptindex.h"
+
+#include <algorithm>
+
+// index file layout, native byte order:
+// header: U32 magic, U32 version, S64 indexed size, U32 tail hash, U32 message count
+// then per message: S64 offset, U32 time
+const U32 INDEX_MAGIC = 0x78644954;	// "TIdx"
+const U32 INDEX_VERSION = 1;
+const S32 INDEX_HEADER_SIZE = 24;
+const S32 INDEX_ENTRY_SIZE = 12;
+
+// enough of a line to tell whether it starts a message and read its stamp
+const size_t LINE_HEAD_SIZE = 24;
+
+// days from 1970/01/01 to a date of the proleptic Gregorian calendar
+static S32 days_from_civil(S32 year, S32 month, S32 day)
+{
+	year -= (month <= 2) ? 1 : 0;
+	S32 era = (year >= 0 ? year : year - 399) / 400;
+	S32 year_of_era = year - era * 400;
+	S32 day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	S32 day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+	return era * 146097 + day_of_era - 719468;
+}
+
+LLChatTranscriptIndex::LLChatTranscriptIndex()
+:	mIndexedSize(0),
+	mTailHash(0)
+{
+}
+
+bool LLChatTranscriptIndex::load(const std::string& transcript_path)
+{
+	mOffsets.clear();
+	mTimes.clear();
+	mIndexedSize = 0;
+	mTailHash = 0;
+
+	LLFILE* fp = LLFile::fopen(transcript_path, "rb");
+	if (!fp)
+	{
+		return false;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	S64 size = ftell(fp);
+
+	std::string index_path = getIndexFileName(transcript_path);
+	bool valid = readIndex(index_path)
+				 && mIndexedSize <= size
+				 && hashTail(fp) == mTailHash;
+	if (!valid)
+	{
+		mOffsets.clear();
+		mTimes.clear();
+		mIndexedSize = 0;
+	}
+
+	S32 first_new_message = getMessageCount();
+	S64 indexed_size = mIndexedSize;
+	if (size > mIndexedSize)
+	{
+		scan(fp, mIndexedSize);
+	}
+
+	if (!valid || mIndexedSize != indexed_size)
+	{
+		mTailHash = hashTail(fp);
+		if (!writeIndex(index_path, first_new_message))
+		{
+			LL_WARNS() << "Couldn't write transcript index " << index_path << LL_ENDL;
+		}
+	}
+
+	fclose(fp);
+	return true;
+}
+
+void LLChatTranscriptIndex::getByteRange(S32 first, S32 count, S64& begin, S64& end) const
+{
+	S32 num_messages = getMessageCount();
+	first = llclamp(first, 0, num_messages);
+	S32 last = llclamp(first + count, first, num_messages);
+
+	begin = first < num_messages ? mOffsets[first] : mIndexedSize;
+	end = last < num_messages ? mOffsets[last] : mIndexedSize;
+}
+
+S32 LLChatTranscriptIndex::findMessageAtTime(U32 time) const
+{
+	return (S32)(std::lower_bound(mTimes.begin(), mTimes.end(), time) - mTimes.begin());
+}
+
+//static
+std::string LLChatTranscriptIndex::getIndexFileName(const std::string& transcript_path)
+{
+	return transcript_path + ".idx";
+}
+
+//static
+U32 LLChatTranscriptIndex::parseTimestamp(const char* line)
+{
+	S32 year, month, day, hour, minute;
+	if (sscanf(line, "[%4d/%2d/%2d %2d:%2d]", &year, &month, &day, &hour, &minute) != 5
+		|| year < 1970 || month < 1 || month > 12 || day < 1 || day > 31
+		|| hour < 0 || hour > 23 || minute < 0 || minute > 59)
+	{
+		return 0;
+	}
+	return (U32) days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60;
+}
+
+bool LLChatTranscriptIndex::readIndex(const std::string& index_path)
+{
+	LLFILE* fp = LLFile::fopen(index_path, "rb");
+	if (!fp)
+	{
+		return false;
+	}
+
+	U32 magic = 0, version = 0, count = 0;
+	bool ok = fread(&magic, sizeof(magic), 1, fp) == 1
+			  && fread(&version, sizeof(version), 1, fp) == 1
+			  && fread(&mIndexedSize, sizeof(mIndexedSize), 1, fp) == 1
+			  && fread(&mTailHash, sizeof(mTailHash), 1, fp) == 1
+			  && fread(&count, sizeof(count), 1, fp) == 1
+			  && magic == INDEX_MAGIC
+			  && version == INDEX_VERSION;
+
+	std::vector<U8> entries;
+	if (ok && count)
+	{
+		entries.resize(count * INDEX_ENTRY_SIZE);
+		ok = fread(&entries[0], INDEX_ENTRY_SIZE, count, fp) == count;
+	}
+	fclose(fp);
+
+	if (!ok)
+	{
+		return false;
+	}
+
+	mOffsets.resize(count);
+	mTimes.resize(count);
+	for (U32 i = 0; i < count; ++i)
+	{
+		memcpy(&mOffsets[i], &entries[i * INDEX_ENTRY_SIZE], sizeof(S64));
+		memcpy(&mTimes[i], &entries[i * INDEX_ENTRY_SIZE + sizeof(S64)], sizeof(U32));
+	}
+
+	// offsets must be increasing and inside the covered part
+	for (U32 i = 0; i < count; ++i)
+	{
+		if (mOffsets[i] >= mIndexedSize || (i && mOffsets[i] <= mOffsets[i - 1]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool LLChatTranscriptIndex::writeIndex(const std::string& index_path, S32 first_new_message) const
+{
+	// when only messages were added, append them and update the header
+	LLFILE* fp = first_new_message > 0 ? LLFile::fopen(index_path, "r+b") : NULL;
+	if (!fp)
+	{
+		first_new_message = 0;
+		fp = LLFile::fopen(index_path, "wb");
+		if (!fp)
+		{
+			return false;
+		}
+	}
+
+	S32 count = getMessageCount();
+	std::vector<U8> entries((count - first_new_message) * INDEX_ENTRY_SIZE);
+	for (S32 i = first_new_message; i < count; ++i)
+	{
+		U8* entry = &entries[(i - first_new_message) * INDEX_ENTRY_SIZE];
+		memcpy(entry, &mOffsets[i], sizeof(S64));
+		memcpy(entry + sizeof(S64), &mTimes[i], sizeof(U32));
+	}
+
+	// entries before the header, a header counting entries that aren't there fails to read
+	bool ok = fseek(fp, INDEX_HEADER_SIZE + first_new_message * INDEX_ENTRY_SIZE, SEEK_SET) == 0
+			  && (entries.empty() || fwrite(&entries[0], entries.size(), 1, fp) == 1);
+	if (ok)
+	{
+		U32 magic = INDEX_MAGIC;
+		U32 version = INDEX_VERSION;
+		U32 num_messages = count;
+		ok = fseek(fp, 0, SEEK_SET) == 0
+			 && fwrite(&magic, sizeof(magic), 1, fp) == 1
+			 && fwrite(&version, sizeof(version), 1, fp) == 1
+			 && fwrite(&mIndexedSize, sizeof(mIndexedSize), 1, fp) == 1
+			 && fwrite(&mTailHash, sizeof(mTailHash), 1, fp) == 1
+			 && fwrite(&num_messages, sizeof(num_messages), 1, fp) == 1;
+	}
+	fclose(fp);
+	return ok;
+}
+
+// Indexes the whole lines from begin on, a last line without its newline
+// may still be being written and is left for next time
+void LLChatTranscriptIndex::scan(LLFILE* fp, S64 begin)
+{
+	if (fseek(fp, begin, SEEK_SET))
+	{
+		return;
+	}
+
+	U32 time = mTimes.empty() ? 0 : mTimes.back();
+	S64 pos = begin;
+	S64 line_start = begin;
+	std::string head;
+	char buffer[65536];		/*Flawfinder: ignore*/
+	size_t bytes_read;
+	while ((bytes_read = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+	{
+		for (size_t i = 0; i < bytes_read; ++i, ++pos)
+		{
+			char c = buffer[i];
+			if (c != '\n')
+			{
+				if (head.size() < LINE_HEAD_SIZE)
+				{
+					head += c;
+				}
+				continue;
+			}
+
+			// continuation lines start with a space, empty lines separate paragraphs
+			if (!head.empty() && head[0] != ' ' && head != "\r")
+			{
+				U32 line_time = parseTimestamp(head.c_str());
+				if (line_time)
+				{
+					time = line_time;
+				}
+				mOffsets.push_back(line_start);
+				mTimes.push_back(time);
+			}
+			head.clear();
+			line_start = pos + 1;
+		}
+	}
+	mIndexedSize = line_start;
+}
+
+// FNV-1a of the last message, so an index can tell its transcript was replaced
+U32 LLChatTranscriptIndex::hashTail(LLFILE* fp) const
+{
+	S64 begin = mOffsets.empty() ? 0 : mOffsets.back();
+	U32 hash = 2166136261U;
+	if (fseek(fp, begin, SEEK_SET))
+	{
+		return hash;
+	}
+
+	char buffer[4096];		/*Flawfinder: ignore*/
+	S64 remaining = mIndexedSize - begin;
+	while (remaining > 0)
+	{
+		size_t bytes_read = fread(buffer, 1, (size_t) llmin(remaining, (S64) sizeof(buffer)), fp);
+		if (!bytes_read)
+		{
+			// shorter than indexed, can't be the same transcript
+			return ~hash;
+		}
+		for (size_t i = 0; i < bytes_read; ++i)
+		{
+			hash = (hash ^ (U8) buffer[i]) * 16777619U;
+		}
+		remaining -= bytes_read;
+	}
+	return hash;
+}
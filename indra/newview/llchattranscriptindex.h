@@ -0,0 +1,86 @@
+/**
+ * @file llchattranscriptindex.h
+ * @brief Sidecar index of the messages in a plain text chat transcript.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLCHATTRANSCRIPTINDEX_H
+#define LL_LLCHATTRANSCRIPTINDEX_H
+
+#include "llfile.h"
+
+#include <vector>
+
+//---------------------------------------------------------------------------
+// Where the messages of a plain text chat transcript start, kept in a file
+// next to it so a range of messages can be read by seeking instead of
+// parsing the transcript from the start.
+//
+// Transcripts are only ever appended to.  The index remembers how much of
+// the transcript it covers and a hash of the last message in it, load()
+// indexes whatever was appended since and starts over if the covered part
+// changed, e.g. the transcript was deleted or replaced.
+//
+// Every line that is neither empty nor starts with a space starts a
+// message, the others continue multi-line messages as written by
+// LLChatLogFormatter.  Message times come from "[YYYY/MM/DD HH:MM]" stamps
+// as written, messages without a dated stamp get the time of the message
+// before, so times don't decrease unless the clock was turned back.
+//---------------------------------------------------------------------------
+class LLChatTranscriptIndex
+{
+public:
+	LLChatTranscriptIndex();
+
+	// False if the transcript can't be read.  Updates the index file when
+	// it's missing or out of date, failing to write it isn't an error.
+	bool load(const std::string& transcript_path);
+
+	S32 getMessageCount() const { return (S32) mOffsets.size(); }
+	S64 getMessageOffset(S32 message) const { return mOffsets[message]; }
+	U32 getMessageTime(S32 message) const { return mTimes[message]; }
+
+	// bytes of messages [first, first + count), clamped to the messages there are
+	void getByteRange(S32 first, S32 count, S64& begin, S64& end) const;
+
+	// first message at or after time, getMessageCount() if there's none
+	S32 findMessageAtTime(U32 time) const;
+
+	static std::string getIndexFileName(const std::string& transcript_path);
+
+	// seconds since 1970 of a line's dated stamp as written, 0 if it has none
+	static U32 parseTimestamp(const char* line);
+
+private:
+	bool readIndex(const std::string& index_path);
+	bool writeIndex(const std::string& index_path, S32 first_new_message) const;
+	void scan(LLFILE* fp, S64 begin);
+	U32 hashTail(LLFILE* fp) const;
+
+	std::vector<S64>	mOffsets;		// by message
+	std::vector<U32>	mTimes;			// by message
+	S64					mIndexedSize;	// bytes of the transcript covered, always whole lines
+	U32					mTailHash;		// of the bytes of the last message
+};
+
+#endif // LL_LLCHATTRANSCRIPTINDEX_H
@@ -68,6 +68,17 @@ public:
 		return *this;
 	}
 
+	// one per face of every drawable, from a slab pool
+	void* operator new(size_t size)
+	{
+		return slab_new<LLFace>(size);
+	}
+
+	void operator delete(void* ptr, size_t size)
+	{
+		slab_delete<LLFace>(ptr, size);
+	}
+
 	enum EMasks
 	{
 		LIGHT			= 0x0001,
@@ -48,6 +48,9 @@ LLFloaterConversationPreview::LLFloaterConversationPreview(const LLSD& session_i
 	mMutex(NULL),
 	mShowHistory(false),
 	mMessages(NULL),
+	mFirstLoadedMessage(0),
+	mTotalMessages(0),
+	mLoadThread(NULL),
 	mHistoryThreadsBusy(false),
 	mOpened(false)
 {
@@ -100,7 +103,13 @@ void LLFloaterConversationPreview::setPages(std::list<LLSD>* messages, const std
 			delete mMessages; // Clean up temporary message list with "Loading..." text
 		}
 		mMessages = messages;
-		mCurrentPage = (mMessages->size() ? (mMessages->size() - 1) / mPageSize : 0);
+
+		// the thread loads just the last page when the transcript could be indexed
+		S32 total_messages = mLoadThread ? mLoadThread->getTotalMessages() : -1;
+		mTotalMessages = total_messages >= 0 ? total_messages : mMessages->size();
+		mCurrentPage = (mTotalMessages ? (mTotalMessages - 1) / mPageSize : 0);
+		mFirstLoadedMessage = total_messages >= 0 ? mCurrentPage * mPageSize : 0;
+		mLoadThread = NULL;
 
 		mPageSpinner->setEnabled(true);
 		mPageSpinner->setMaxValue(mCurrentPage+1);
@@ -141,9 +150,11 @@ void LLFloaterConversationPreview::onOpen(const LLSD& key)
 		closeFloater();
 		return;
 	}
-	LLSD load_params;
-	load_params["load_all_history"] = true;
-	load_params["cut_off_todays_date"] = false;
+	mLoadParams["cut_off_todays_date"] = false;
+
+	// only the last page, others are read from the transcript when shown
+	LLSD load_params = mLoadParams;
+	load_params["message_count"] = mPageSize;
 
 	// The temporary message list with "Loading..." text
 	// Will be deleted upon loading completion in setPages() method
@@ -153,6 +164,7 @@ void LLFloaterConversationPreview::onOpen(const LLSD& key)
 	LLSD loading;
 	loading[LL_IM_TEXT] = LLTrans::getString("loading_chat_logs");
 	mMessages->push_back(loading);
+	mTotalMessages = mMessages->size();
 	mPageSpinner = getChild<LLSpinCtrl>("history_page_spin");
 	mPageSpinner->setCommitCallback(boost::bind(&LLFloaterConversationPreview::onMoreHistoryBtnClick, this));
 	mPageSpinner->setMinValue(1);
@@ -168,6 +180,7 @@ void LLFloaterConversationPreview::onOpen(const LLSD& key)
 	
 	LLLoadHistoryThread* loadThread = new LLLoadHistoryThread(mChatHistoryFileName, messages, load_params);
 	loadThread->setLoadEndSignal(boost::bind(&LLFloaterConversationPreview::setPages, this, _1, _2));
+	mLoadThread = loadThread;
 	loadThread->start();
 	LLLogChat::addLoadHistoryThread(mSessionID, loadThread);
 
@@ -194,15 +207,22 @@ void LLFloaterConversationPreview::showHistory()
 {
 	// additional protection to avoid changes of mMessages in setPages
 	LLMutexLock lock(&mMutex);
-	if(mMessages == NULL || !mMessages->size() || mCurrentPage * mPageSize >= mMessages->size())
+	if(mMessages == NULL || !mMessages->size() || mCurrentPage * mPageSize >= mTotalMessages)
 	{
 		return;
 	}
 
+	S32 first_message = mCurrentPage * mPageSize - mFirstLoadedMessage;
+	if (first_message < 0 || first_message >= (S32)mMessages->size())
+	{
+		loadPage(mCurrentPage);
+		first_message = 0;
+	}
+
 	mChatHistory->clear();
 	std::ostringstream message;
 	std::list<LLSD>::const_iterator iter = mMessages->begin();
-	std::advance(iter, mCurrentPage * mPageSize);
+	std::advance(iter, first_message);
 
 	for (int msg_num = 0; iter != mMessages->end() && msg_num < mPageSize; ++iter, ++msg_num)
 	{
@@ -264,6 +284,14 @@ void LLFloaterConversationPreview::showHistory()
 	}
 }
 
+// Replaces the loaded messages with the ones of page, mMutex must be locked
+void LLFloaterConversationPreview::loadPage(S32 page)
+{
+	mMessages->clear();
+	mFirstLoadedMessage = page * mPageSize;
+	mTotalMessages = LLLogChat::loadChatHistoryPage(mChatHistoryFileName, *mMessages, mFirstLoadedMessage, mPageSize, mLoadParams);
+}
+
 void LLFloaterConversationPreview::onMoreHistoryBtnClick()
 {
 	mCurrentPage = (int)(mPageSpinner->getValueF32());
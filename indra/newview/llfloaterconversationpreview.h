@@ -33,6 +33,7 @@ extern const std::string LL_FCP_COMPLETE_NAME;	//"complete_name"
 extern const std::string LL_FCP_ACCOUNT_NAME;		//"user_name"
 
 class LLSpinCtrl;
+class LLLoadHistoryThread;
 
 class LLFloaterConversationPreview : public LLFloater
 {
@@ -51,6 +52,7 @@ public:
 private:
 	void onMoreHistoryBtnClick();
 	void showHistory();
+	void loadPage(S32 page);
 
 	LLMutex			mMutex;
 	LLSpinCtrl*		mPageSpinner;
@@ -59,7 +61,11 @@ private:
 	int				mCurrentPage;
 	int				mPageSize;
 
-	std::list<LLSD>*	mMessages;
+	std::list<LLSD>*	mMessages;			// the current page, or all messages
+	S32				mFirstLoadedMessage;	// number of the first message in mMessages
+	S32				mTotalMessages;
+	LLSD			mLoadParams;
+	LLLoadHistoryThread* mLoadThread;		// only while loading the first page
 	std::string		mAccountName;
 	std::string		mCompleteName;
 	std::string		mChatHistoryFileName;
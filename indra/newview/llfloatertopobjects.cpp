@@ -73,7 +73,8 @@ void LLFloaterTopObjects::show()
 LLFloaterTopObjects::LLFloaterTopObjects(const LLSD& key)
 :	LLFloater(key),
 	mInitialized(FALSE),
-	mtotalScore(0.f)
+	mtotalScore(0.f),
+	mObjectsList(NULL)
 {
 	mCommitCallbackRegistrar.add("TopObjects.ShowBeacon",		boost::bind(&LLFloaterTopObjects::onClickShowBeacon, this));
 	mCommitCallbackRegistrar.add("TopObjects.ReturnSelected",	boost::bind(&LLFloaterTopObjects::onReturnSelected, this));
@@ -94,10 +95,11 @@ LLFloaterTopObjects::~LLFloaterTopObjects()
 // virtual
 BOOL LLFloaterTopObjects::postBuild()
 {
-	LLScrollListCtrl *objects_list = getChild<LLScrollListCtrl>("objects_list");
-	getChild<LLUICtrl>("objects_list")->setFocus(TRUE);
-	objects_list->setDoubleClickCallback(onDoubleClickObjectsList, this);
-	objects_list->setCommitOnSelectionChange(TRUE);
+	mObjectsList = getChild<LLScrollListCtrl>("objects_list");
+	mObjectsList->setFocus(TRUE);
+	mObjectsList->setDoubleClickCallback(onDoubleClickObjectsList, this);
+	mObjectsList->setCommitOnSelectionChange(TRUE);
+	mObjectsList->setDataProvider(this);
 
 	setDefaultBtn("show_beacon_btn");
 
@@ -126,7 +128,7 @@ void LLFloaterTopObjects::handle_land_reply(LLMessageSystem* msg, void** data)
 
 	//HACK: for some reason sometimes top scripts originally comes back
 	//with no results even though they're there
-	if (!instance->mObjectListIDs.size() && !instance->mInitialized)
+	if (instance->mObjectRows.empty() && !instance->mInitialized)
 	{
 		instance->onRefresh();
 		instance->mInitialized = TRUE;
@@ -143,7 +145,7 @@ void LLFloaterTopObjects::handleReply(LLMessageSystem *msg, void** data)
 	msg->getU32Fast(_PREHASH_RequestData, _PREHASH_TotalObjectCount, total_count);
 	msg->getU32Fast(_PREHASH_RequestData, _PREHASH_ReportType, mCurrentMode);
 
-	LLScrollListCtrl *list = getChild<LLScrollListCtrl>("objects_list");
+	LLScrollListCtrl *list = mObjectsList;
 
 	S32 block_count = msg->getNumberOfBlocks("ReportData");
 	for (S32 block = 0; block < block_count; ++block)
@@ -183,63 +185,28 @@ void LLFloaterTopObjects::handleReply(LLMessageSystem *msg, void** data)
 			}
 		}
 
-		LLSD element;
-
-		element["id"] = task_id;
-
-		LLSD columns;
-		S32 column_num = 0;
-		columns[column_num]["column"] = "score";
-		columns[column_num]["value"] = llformat("%0.3f", score);
-		columns[column_num++]["font"] = "SANSSERIF";
-		
-		columns[column_num]["column"] = "name";
-		columns[column_num]["value"] = name_buf;
-		columns[column_num++]["font"] = "SANSSERIF";
-		
 		// Owner names can have trailing spaces sent from server
 		LLStringUtil::trim(owner_buf);
-		
-		// *TODO: Send owner_id from server and look up display name
-		owner_buf = LLCacheName::buildUsername(owner_buf);
-
-		columns[column_num]["column"] = "owner";
-		columns[column_num]["value"] = owner_buf;
-		columns[column_num++]["font"] = "SANSSERIF";
-
-		columns[column_num]["column"] = "location";
-		columns[column_num]["value"] = llformat("<%0.f, %0.f, %0.f>", location_x, location_y, location_z);
-		columns[column_num++]["font"] = "SANSSERIF";
 
-		columns[column_num]["column"] = "parcel";
-		columns[column_num]["value"] = parcel_buf;
-		columns[column_num++]["font"] = "SANSSERIF";
-
-		columns[column_num]["column"] = "time";
-		columns[column_num]["type"] = "date";
-		columns[column_num]["value"] = LLDate((time_t)time_stamp);
-		columns[column_num++]["font"] = "SANSSERIF";
-
-		if (mCurrentMode == STAT_REPORT_TOP_SCRIPTS
-			&& have_extended_data)
-		{
-			columns[column_num]["column"] = "memory";
-			columns[column_num]["value"] = llformat("%0.0f", (script_memory / 1000.f));
-			columns[column_num++]["font"] = "SANSSERIF";
-
-			columns[column_num]["column"] = "URLs";
-			columns[column_num]["value"] = llformat("%d", public_urls);
-			columns[column_num++]["font"] = "SANSSERIF";
-		}
-		element["columns"] = columns;
-		list->addElement(element);
-		
-		mObjectListData.append(element);
-		mObjectListIDs.push_back(task_id);
+		ObjectRow row;
+		row.mTaskID = task_id;
+		row.mScore = score;
+		row.mName = name_buf;
+		// *TODO: Send owner_id from server and look up display name
+		row.mOwner = LLCacheName::buildUsername(owner_buf);
+		row.mLocation.set(location_x, location_y, location_z);
+		row.mParcel = parcel_buf;
+		row.mTimeStamp = time_stamp;
+		row.mHasScriptData = mCurrentMode == STAT_REPORT_TOP_SCRIPTS && have_extended_data;
+		row.mScriptMemory = script_memory;
+		row.mPublicURLs = public_urls;
+		mObjectRows.push_back(row);
 
 		mtotalScore += score;
 	}
 
+	list->refreshFromDataProvider();
+
 	if (total_count == 0 && list->getItemCount() == 0)
 	{
 		list->setCommentText(getString("none_descriptor"));
@@ -330,13 +297,11 @@ void LLFloaterTopObjects::doToObjects(int action, bool all)
 	LLCtrlListInterface *list = getChild<LLUICtrl>("objects_list")->getListInterface();
 	if (!list || list->getItemCount() == 0) return;
 
-	uuid_vec_t::iterator id_itor;
-
 	bool start_message = true;
 
-	for (id_itor = mObjectListIDs.begin(); id_itor != mObjectListIDs.end(); ++id_itor)
+	for (std::vector<ObjectRow>::const_iterator row_itor = mObjectRows.begin(); row_itor != mObjectRows.end(); ++row_itor)
 	{
-		LLUUID task_id = *id_itor;
+		const LLUUID& task_id = row_itor->mTaskID;
 		if (!all && !list->isSelected(task_id))
 		{
 			// Selected only
@@ -435,8 +400,7 @@ void LLFloaterTopObjects::clearList()
 		list->operateOnAll(LLCtrlListInterface::OP_DELETE);
 	}
 
-	mObjectListData.clear();
-	mObjectListIDs.clear();
+	mObjectRows.clear();
 	mtotalScore = 0.f;
 }
 
@@ -524,3 +488,82 @@ void LLFloaterTopObjects::showBeacon()
 	std::string tooltip("");
 	LLTracker::trackLocation(pos_global, name, tooltip, LLTracker::LOCATION_ITEM);
 }
+
+// virtual
+S32 LLFloaterTopObjects::getRowCount() const
+{
+	return (S32)mObjectRows.size();
+}
+
+// virtual
+LLSD LLFloaterTopObjects::getRowValue(S32 row) const
+{
+	return mObjectRows[row].mTaskID;
+}
+
+// virtual
+void LLFloaterTopObjects::getRowCells(S32 row, LLScrollListItem::Params& row_params) const
+{
+	const ObjectRow& object_row = mObjectRows[row];
+
+	LLScrollListCell::Params cell_params;
+	cell_params.font = LLFontGL::getFontSansSerif();
+
+	static const char* columns[] = { "score", "name", "owner", "location", "parcel", "time", "memory", "URLs" };
+	S32 column_count = object_row.mHasScriptData ? LL_ARRAY_SIZE(columns) : LL_ARRAY_SIZE(columns) - 2;
+	for (S32 column = 0; column < column_count; ++column)
+	{
+		cell_params.column = columns[column];
+		if (cell_params.column() == "time")
+		{
+			cell_params.type = "date";
+			cell_params.value = LLDate((time_t)object_row.mTimeStamp);
+		}
+		else
+		{
+			cell_params.type = "text";
+			cell_params.value = getSortKey(row, columns[column]);
+		}
+		row_params.columns.add(cell_params);
+	}
+}
+
+// virtual
+std::string LLFloaterTopObjects::getSortKey(S32 row, const std::string& column) const
+{
+	const ObjectRow& object_row = mObjectRows[row];
+	if (column == "score")
+	{
+		return llformat("%0.3f", object_row.mScore);
+	}
+	else if (column == "name")
+	{
+		return object_row.mName;
+	}
+	else if (column == "owner")
+	{
+		return object_row.mOwner;
+	}
+	else if (column == "location")
+	{
+		return llformat("<%0.f, %0.f, %0.f>", object_row.mLocation.mV[VX], object_row.mLocation.mV[VY], object_row.mLocation.mV[VZ]);
+	}
+	else if (column == "parcel")
+	{
+		return object_row.mParcel;
+	}
+	else if (column == "time")
+	{
+		// what the date cell's value sorts by
+		return LLDate((time_t)object_row.mTimeStamp).asString();
+	}
+	else if (object_row.mHasScriptData && column == "memory")
+	{
+		return llformat("%0.0f", object_row.mScriptMemory / 1000.f);
+	}
+	else if (object_row.mHasScriptData && column == "URLs")
+	{
+		return llformat("%d", object_row.mPublicURLs);
+	}
+	return LLStringUtil::null;
+}
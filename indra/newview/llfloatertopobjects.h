@@ -28,6 +28,7 @@
 #define LL_LLFLOATERTOPOBJECTS_H
 
 #include "llfloater.h"
+#include "llscrolllistctrl.h"
 
 class LLUICtrl;
 
@@ -47,7 +48,9 @@ enum LAND_STAT_REPORT_TYPE
 	STAT_REPORT_TOP_COLLIDERS
 };
 
-class LLFloaterTopObjects : public LLFloater
+// The list can hold every scripted object of a region, so it runs in virtual
+// mode, the floater keeps the rows and builds the cells of the visible ones.
+class LLFloaterTopObjects : public LLFloater, public LLScrollListDataProvider
 {
 	friend class LLFloaterReg;
 public:
@@ -68,6 +71,12 @@ public:
 	static void setMode(U32 mode);
 	void disableRefreshBtn();
 
+	// LLScrollListDataProvider
+	/*virtual*/ S32 getRowCount() const;
+	/*virtual*/ LLSD getRowValue(S32 row) const;
+	/*virtual*/ void getRowCells(S32 row, LLScrollListItem::Params& row_params) const;
+	/*virtual*/ std::string getSortKey(S32 row, const std::string& column) const;
+
 private:
 	LLFloaterTopObjects(const LLSD& key);
 	~LLFloaterTopObjects();
@@ -97,8 +106,21 @@ private:
 private:
 	std::string mMethod;
 
-	LLSD mObjectListData;
-	uuid_vec_t mObjectListIDs;
+	struct ObjectRow
+	{
+		LLUUID		mTaskID;
+		F32			mScore;
+		std::string	mName;
+		std::string	mOwner;
+		LLVector3	mLocation;
+		std::string	mParcel;
+		U32			mTimeStamp;
+		bool		mHasScriptData;		// memory and URLs, top scripts only
+		F32			mScriptMemory;
+		S32			mPublicURLs;
+	};
+	std::vector<ObjectRow> mObjectRows;
+	LLScrollListCtrl* mObjectsList;
 
 	U32 mCurrentMode;
 	U32 mFlags;
@@ -218,13 +218,26 @@ bool LLFolderViewModelItemInventory::filter( LLFolderViewFilter& filter)
 		&& (getLastFilterGeneration() < must_pass_generation // haven't checked descendants against minimum required generation to pass
             || descendantsPassedFilter(must_pass_generation))) // or at least one descendant has passed the minimum requirement
 	{
-		// now query children
-		for (child_list_t::iterator iter = mChildren.begin(), end_iter = mChildren.end(); iter != end_iter; ++iter)
+		if (!filter.checkDescendants(this))
 		{
-			continue_filtering = filterChildItem((*iter), filter);
-            if (!continue_filtering)
+			// none of the children can pass, fail them without going through
+			// their own descendants
+			for (child_list_t::iterator iter = mChildren.begin(), end_iter = mChildren.end(); iter != end_iter; ++iter)
 			{
-				break;
+				(*iter)->setPassedFolderFilter(false, filter_generation);
+				(*iter)->setPassedFilter(false, filter_generation);
+			}
+		}
+		else
+		{
+			// now query children
+			for (child_list_t::iterator iter = mChildren.begin(), end_iter = mChildren.end(); iter != end_iter; ++iter)
+			{
+				continue_filtering = filterChildItem((*iter), filter);
+				if (!continue_filtering)
+				{
+					break;
+				}
 			}
 		}
 	}
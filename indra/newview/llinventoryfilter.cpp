@@ -40,6 +40,7 @@
 #include "llradiogroup.h"
 
 // linden library includes
+#include "llcachename.h"
 #include "llclipboard.h"
 #include "lltrans.h"
 
@@ -71,6 +72,10 @@ LLInventoryFilter::LLInventoryFilter(const Params& p)
 	mFilterModified(FILTER_NONE),
 	mEmptyLookupMessage("InventoryNoMatchingItems"),
 	mFilterSubStringTarget(SUBST_TARGET_NAME),	// ## Zi: Extended Inventory Search
+	mCandidatesDirty(true),
+	mCandidatesSlotEnd(0),
+	mCandidatesLayoutGeneration(0),
+	mCandidateFoldersValid(false),
 	mFilterOps(p.filter_ops),
 	mFilterSubString(p.substring),
 	mCurrentGeneration(0),
@@ -102,6 +107,8 @@ void LLInventoryFilter::setFilterSubStringTarget(const std::string& targetName)
 		mFilterSubStringTarget=SUBST_TARGET_ALL;
 	else
 		llwarns << "Unknown sub string target: " << targetName << llendl;
+
+	mCandidatesDirty = true;
 }
 
 LLInventoryFilter::EFilterSubstringTarget LLInventoryFilter::getFilterSubStringTarget() const
@@ -133,7 +140,16 @@ bool LLInventoryFilter::check(const LLFolderViewModelItem* item)
 	//std::string::size_type string_offset = mFilterSubString.size() ? listener->getSearchableName().find(mFilterSubString) : std::string::npos; <FS:TM> CHUI Merge LL new line 
 	//	Begin Multi-substring inventory search
 	std::string::size_type string_offset = std::string::npos;
-	if (mFilterSubStrings.size())
+	if (mFilterSubStrings.size() && !checkAgainstSearchIndex(listener))
+	{
+		// ruled out without building the search strings
+		for (std::vector<std::string::size_type>::iterator it=mSubStringMatchOffsets.begin();
+			it<mSubStringMatchOffsets.end(); it++)
+		{
+			*it = std::string::npos;
+		}
+	}
+	else if (mFilterSubStrings.size())
 	{
 		//const std::string& searchLabel=getSearchableTarget(item);		// ## Zi: Extended Inventory Search
 		std::string searchLabel;
@@ -274,6 +290,194 @@ bool LLInventoryFilter::checkFolder(const LLUUID& folder_id) const
 	return passed_clipboard;
 }
 
+// Returns false if the search index shows the item can't contain one of
+// the substrings.  Items that aren't indexed or changed after the
+// candidates were looked up go through the regular string search.
+bool LLInventoryFilter::checkAgainstSearchIndex(const LLFolderViewModelItemInventory* listener)
+{
+	updateSearchIndexCandidates();
+
+	S32 slot = gInventory.getSearchIndex().getSlot(listener->getUUID());
+	if (slot < 0 || (U32) slot >= mCandidatesSlotEnd)
+	{
+		return true;
+	}
+
+	for (U32 i = 0; i < mSubStringCandidates.size(); ++i)
+	{
+		const SubStringCandidates& candidates = mSubStringCandidates[i];
+		if (candidates.mIndexed
+			&& !std::binary_search(candidates.mSlots.begin(), candidates.mSlots.end(), (U32) slot))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Returns false if the search index shows no item or folder below the
+// folder can contain all of the substrings.  Folders that aren't in the
+// inventory model, like the contents of an object, are always filtered.
+bool LLInventoryFilter::checkDescendants(const LLFolderViewModelItem* folder)
+{
+	if (!mFilterSubString.size() || !mFilterSubStrings.size()
+		// empty folders are shown too, they all have to be filtered
+		|| mFilterOps.mShowFolderState == LLInventoryFilter::SHOW_ALL_FOLDERS)
+	{
+		return true;
+	}
+
+	const LLFolderViewModelItemInventory* listener = dynamic_cast<const LLFolderViewModelItemInventory*>(folder);
+	if (!listener || !gInventory.getCategory(listener->getUUID()))
+	{
+		return true;
+	}
+
+	if (gInventory.getSearchIndex().getSlotEnd() != mCandidatesSlotEnd)
+	{
+		// added, changed or moved since, the inventory doesn't change
+		// during a filter pass so this happens once a frame at most
+		mCandidatesDirty = true;
+	}
+	updateSearchIndexCandidates();
+
+	return !mCandidateFoldersValid || mCandidateFolders.find(listener->getUUID()) != mCandidateFolders.end();
+}
+
+void LLInventoryFilter::updateSearchIndexCandidates()
+{
+	const LLInventorySearchIndex& index = gInventory.getSearchIndex();
+	if (!mCandidatesDirty && mCandidatesLayoutGeneration == index.getLayoutGeneration())
+	{
+		return;
+	}
+	mCandidatesDirty = false;
+	mCandidatesLayoutGeneration = index.getLayoutGeneration();
+	mCandidatesSlotEnd = index.getSlotEnd();
+
+	// creator names the same way LLInvFVBridge::getSearchableCreator() gets them,
+	// names that aren't known yet match anything
+	uuid_vec_t creators;
+	std::vector<std::pair<bool, std::string> > creator_names;
+	if (mFilterSubStringTarget == SUBST_TARGET_CREATOR || mFilterSubStringTarget == SUBST_TARGET_ALL)
+	{
+		index.getCreators(creators);
+		creator_names.resize(creators.size());
+		for (U32 i = 0; i < creators.size(); ++i)
+		{
+			creator_names[i].first = gCacheName->getFullName(creators[i], creator_names[i].second);
+			LLStringUtil::toUpper(creator_names[i].second);
+		}
+	}
+
+	mSubStringCandidates.resize(mFilterSubStrings.size());
+	for (U32 i = 0; i < mFilterSubStrings.size(); ++i)
+	{
+		const std::string& sub_string = mFilterSubStrings[i];
+		SubStringCandidates& candidates = mSubStringCandidates[i];
+		candidates.mSlots.clear();
+
+		LLInventorySearchIndex::slot_vec_t slots;
+		switch (mFilterSubStringTarget)
+		{
+			case SUBST_TARGET_NAME:
+				candidates.mIndexed = index.findSlots(LLInventorySearchIndex::FIELD_NAME, sub_string, candidates.mSlots);
+				break;
+			case SUBST_TARGET_DESCRIPTION:
+				candidates.mIndexed = index.findSlots(LLInventorySearchIndex::FIELD_DESCRIPTION, sub_string, candidates.mSlots);
+				break;
+			case SUBST_TARGET_UUID:
+				candidates.mIndexed = index.findSlots(LLInventorySearchIndex::FIELD_ASSET_ID, sub_string, candidates.mSlots);
+				break;
+			case SUBST_TARGET_CREATOR:
+				candidates.mIndexed = true;
+				break;
+			case SUBST_TARGET_ALL:
+				// the substrings never contain the '+' the fields are joined with
+				candidates.mIndexed = index.findSlots(LLInventorySearchIndex::FIELD_NAME, sub_string, candidates.mSlots);
+				if (candidates.mIndexed)
+				{
+					index.findSlots(LLInventorySearchIndex::FIELD_DESCRIPTION, sub_string, slots);
+					candidates.mSlots.insert(candidates.mSlots.end(), slots.begin(), slots.end());
+					index.findSlots(LLInventorySearchIndex::FIELD_ASSET_ID, sub_string, slots);
+					candidates.mSlots.insert(candidates.mSlots.end(), slots.begin(), slots.end());
+				}
+				break;
+			default:
+				candidates.mIndexed = false;
+				break;
+		}
+
+		if (!candidates.mIndexed)
+		{
+			candidates.mSlots.clear();
+			continue;
+		}
+
+		for (U32 j = 0; j < creators.size(); ++j)
+		{
+			if (!creator_names[j].first || creator_names[j].second.find(sub_string) != std::string::npos)
+			{
+				index.appendCreatorSlots(creators[j], candidates.mSlots);
+			}
+		}
+
+		// whatever the index holds of these, their search strings hold more
+		index.appendFlaggedSlots(LLInventorySearchIndex::FLAG_LINK, candidates.mSlots);
+		if (mFilterSubStringTarget == SUBST_TARGET_NAME || mFilterSubStringTarget == SUBST_TARGET_ALL)
+		{
+			index.appendFlaggedSlots(LLInventorySearchIndex::FLAG_LABEL_SUFFIX, candidates.mSlots);
+		}
+
+		std::sort(candidates.mSlots.begin(), candidates.mSlots.end());
+		candidates.mSlots.erase(std::unique(candidates.mSlots.begin(), candidates.mSlots.end()), candidates.mSlots.end());
+	}
+
+	updateCandidateFolders();
+}
+
+void LLInventoryFilter::updateCandidateFolders()
+{
+	mCandidateFolders.clear();
+	mCandidateFoldersValid = false;
+
+	// candidates for all of the substrings
+	LLInventorySearchIndex::slot_vec_t slots;
+	LLInventorySearchIndex::slot_vec_t intersection;
+	for (U32 i = 0; i < mSubStringCandidates.size(); ++i)
+	{
+		const SubStringCandidates& candidates = mSubStringCandidates[i];
+		if (!candidates.mIndexed)
+		{
+			continue;
+		}
+		if (!mCandidateFoldersValid)
+		{
+			slots = candidates.mSlots;
+			mCandidateFoldersValid = true;
+		}
+		else
+		{
+			intersection.clear();
+			std::set_intersection(slots.begin(), slots.end(), candidates.mSlots.begin(), candidates.mSlots.end(), std::back_inserter(intersection));
+			slots.swap(intersection);
+		}
+	}
+
+	const LLInventorySearchIndex& index = gInventory.getSearchIndex();
+	for (LLInventorySearchIndex::slot_vec_t::const_iterator iter = slots.begin(); iter != slots.end(); ++iter)
+	{
+		const LLInventoryObject* object = gInventory.getObject(index.getItemID(*iter));
+		LLUUID parent_id = object ? object->getParentUUID() : LLUUID::null;
+		// stops at the first folder another candidate already went through
+		while (parent_id.notNull() && mCandidateFolders.insert(parent_id).second)
+		{
+			const LLViewerInventoryCategory* category = gInventory.getCategory(parent_id);
+			parent_id = category ? category->getParentUUID() : LLUUID::null;
+		}
+	}
+}
+
 bool LLInventoryFilter::checkAgainstFilterType(const LLFolderViewModelItemInventory* listener) const
 {
 	if (!listener) return FALSE;
@@ -664,6 +868,7 @@ void LLInventoryFilter::setFilterSubString(const std::string& string)
 	mFilterSubStringOrig = string;
 	LLStringUtil::trimHead(filter_sub_string_new);
 	LLStringUtil::toUpper(filter_sub_string_new);
+	mCandidatesDirty = true;
 
 	//	Begin Multi-substring inventory search
 	//	Cut filter string into several substrings, separated by +
@@ -30,6 +30,7 @@
 #include "llinventorytype.h"
 #include "llpermissionsflags.h"
 #include "llfolderviewmodel.h"
+#include "llinventorysearchindex.h"
 
 //	Begin Multi-substring inventory search
 #include <vector>
@@ -230,6 +231,7 @@ public:
 	bool				checkClipboard(const LLFolderViewModelItem* item);
 	bool				checkFolder(const LLFolderViewModelItem* listener) const;
 	bool				checkFolder(const LLUUID& folder_id) const;
+	bool				checkDescendants(const LLFolderViewModelItem* folder);
 
 	bool				showAllResults() const;
 
@@ -300,6 +302,9 @@ private:
 	bool 				checkAgainstPermissions(const LLInventoryItem* item) const;
 	bool 				checkAgainstFilterLinks(const class LLFolderViewModelItemInventory* listener) const;
 	bool				checkAgainstClipboard(const LLUUID& object_id) const;
+	bool				checkAgainstSearchIndex(const class LLFolderViewModelItemInventory* listener);
+	void				updateSearchIndexCandidates();
+	void				updateCandidateFolders();
 
 	FilterOps				mFilterOps;
 	FilterOps				mDefaultFilterOps;
@@ -312,6 +317,21 @@ private:
 	EFilterSubstringTarget mFilterSubStringTarget;		// ## Zi: Extended Inventory Search
 	//	End Multi-substring inventory search
 
+	// Slots in the inventory search index of the items and folders that
+	// may contain each of mFilterSubStrings.
+	struct SubStringCandidates
+	{
+		bool								mIndexed;	// false if every item is a candidate
+		LLInventorySearchIndex::slot_vec_t	mSlots;		// sorted
+	};
+	std::vector<SubStringCandidates>	mSubStringCandidates;
+	bool					mCandidatesDirty;
+	U32						mCandidatesSlotEnd;			// items indexed since are not covered
+	U32						mCandidatesLayoutGeneration;
+	// folders with a candidate for all of the substrings somewhere below
+	uuid_set_t				mCandidateFolders;
+	bool					mCandidateFoldersValid;		// false if any folder may hold one
+
 	std::string				mFilterSubStringOrig;
 	const std::string		mName;
 
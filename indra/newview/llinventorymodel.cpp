@@ -1121,7 +1121,7 @@ void LLInventoryModel::moveObject(const LLUUID& object_id, const LLUUID& cat_id)
 		return;
 	}
 
-	if((object_id == cat_id) || !is_in_map(mCategoryMap, cat_id))
+	if((object_id == cat_id) || (mCategoryMap.find(cat_id) == mCategoryMap.end()))
 	{
 		LL_WARNS(LOG_INV) << "Could not move inventory object " << object_id << " to "
 						  << cat_id << LL_ENDL;
@@ -1438,6 +1438,7 @@ void LLInventoryModel::deleteObject(const LLUUID& id, bool fix_broken_links, boo
 	LLUUID parent_id = obj->getParentUUID();
 	mCategoryMap.erase(id);
 	mItemMap.erase(id);
+	mSearchIndex.removeItem(id);
 	//mInventory.erase(id);
 	item_array_t* item_list = getUnlockedItemArray(parent_id);
 	if(item_list)
@@ -1603,6 +1604,9 @@ void LLInventoryModel::addChangedMask(U32 mask, const LLUUID& referent)
 	{
 		mChangedItemIDs.insert(referent);
 
+		// every change to an item's fields is reported here
+		updateSearchIndex(referent);
+
 		if (mask & LLInventoryObserver::ADD)
 		{
 			mAddedItemIDs.insert(referent);
@@ -1702,6 +1706,7 @@ void LLInventoryModel::addCategory(LLViewerInventoryCategory* category)
 		// Insert category uniquely into the map
 		mCategoryMap[category->getUUID()] = category; // LLPointer will deref and delete the old one
 		//mInventory[category->getUUID()] = category;
+		updateSearchIndex(category->getUUID());
 	}
 }
 
@@ -1779,7 +1784,70 @@ void LLInventoryModel::addItem(LLViewerInventoryItem* item)
 			addBacklinkInfo(link_id, target_id);
 		}
 		mItemMap[item->getUUID()] = item;
+		updateSearchIndex(item->getUUID());
+	}
+}
+
+// Whether the inventory panels may show more than the name of the item,
+// see LLItemBridge::getLabelSuffix() and its overrides.
+static bool has_label_suffix(const LLViewerInventoryItem* item)
+{
+	switch (item->getType())
+	{
+		case LLAssetType::AT_OBJECT:		// worn, attached
+		case LLAssetType::AT_CLOTHING:		// worn
+		case LLAssetType::AT_BODYPART:
+		case LLAssetType::AT_GESTURE:		// active
+		case LLAssetType::AT_CALLINGCARD:	// online
+			return true;
+		default:
+			break;
+	}
+
+	const LLPermissions& perm = item->getPermissions();
+	return perm.getOwner() == gAgent.getID()
+		&& (!perm.allowCopyBy(gAgent.getID())
+			|| !perm.allowModifyBy(gAgent.getID())
+			|| !perm.allowOperationBy(PERM_TRANSFER, gAgent.getID()));
+}
+
+void LLInventoryModel::updateSearchIndex(const LLUUID& object_id)
+{
+	item_map_t::const_iterator iter = mItemMap.find(object_id);
+	if (iter != mItemMap.end() && iter->second.notNull())
+	{
+		const LLViewerInventoryItem* item = iter->second;
+		if (item->getIsLinkType())
+		{
+			// links show the fields of whatever they point to, which can
+			// change without the link itself being touched
+			mSearchIndex.setItem(object_id, item->getParentUUID(), LLUUID::null, LLStringUtil::null, LLStringUtil::null,
+								 LLUUID::null, LLInventorySearchIndex::FLAG_LINK);
+		}
+		else
+		{
+			mSearchIndex.setItem(object_id, item->getParentUUID(), item->getCreatorUUID(), item->getName(), item->getDescription(),
+								 item->getAssetUUID(), has_label_suffix(item) ? LLInventorySearchIndex::FLAG_LABEL_SUFFIX : 0);
+		}
+		return;
+	}
+
+	cat_map_t::const_iterator cat_iter = mCategoryMap.find(object_id);
+	if (cat_iter != mCategoryMap.end() && cat_iter->second.notNull())
+	{
+		// system folders and the library's "Accessories" are shown by their
+		// localized names, see LLFolderBridge::buildDisplayName(), and
+		// folders that aren't fetched yet may show a loading notice
+		const LLViewerInventoryCategory* cat = cat_iter->second;
+		bool label_suffix = cat->getPreferredType() != LLFolderType::FT_NONE
+			|| cat->getName() == "Accessories"
+			|| cat->getVersion() == LLViewerInventoryCategory::VERSION_UNKNOWN;
+		mSearchIndex.setItem(object_id, cat->getParentUUID(), LLUUID::null, cat->getName(), LLStringUtil::null,
+							 LLUUID::null, label_suffix ? LLInventorySearchIndex::FLAG_LABEL_SUFFIX : 0);
+		return;
 	}
+
+	mSearchIndex.removeItem(object_id);
 }
 
 // Empty the entire contents
@@ -1799,6 +1867,7 @@ void LLInventoryModel::empty()
 	mBacklinkMMap.clear(); // forget all backlink information.
 	mCategoryMap.clear(); // remove all references (should delete entries)
 	mItemMap.clear(); // remove all references (should delete entries)
+	mSearchIndex.clear();
 	mLastItem = NULL;
 	//mInventory.clear();
 }
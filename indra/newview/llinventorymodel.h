@@ -36,7 +36,9 @@
 #include "llfoldertype.h"
 #include "llframetimer.h"
 #include "llcurl.h"
+#include "llinventorysearchindex.h"
 #include "lluuid.h"
+#include "lluuidflatmap.h"
 #include "llpermissionsflags.h"
 #include "llviewerinventory.h"
 #include "llstring.h"
@@ -169,8 +171,8 @@ private:
 	// the inventory using several different identifiers.
 	// mInventory member data is the 'master' list of inventory, and
 	// mCategoryMap and mItemMap store uuid->object mappings. 
-	typedef std::map<LLUUID, LLPointer<LLViewerInventoryCategory> > cat_map_t;
-	typedef std::map<LLUUID, LLPointer<LLViewerInventoryItem> > item_map_t;
+	typedef LLUUIDFlatMap<LLPointer<LLViewerInventoryCategory> > cat_map_t;
+	typedef LLUUIDFlatMap<LLPointer<LLViewerInventoryItem> > item_map_t;
 	cat_map_t mCategoryMap;
 	item_map_t mItemMap;
 	// This last set of indices is used to map parents to children.
@@ -187,6 +189,13 @@ private:
 	bool hasBacklinkInfo(const LLUUID& link_id, const LLUUID& target_id) const;
 	void addBacklinkInfo(const LLUUID& link_id, const LLUUID& target_id);
 	void removeBacklinkInfo(const LLUUID& link_id, const LLUUID& target_id);
+
+	// Fields of items and folders the inventory filter searches, kept up
+	// to date with mItemMap and mCategoryMap.
+	LLInventorySearchIndex mSearchIndex;
+	void updateSearchIndex(const LLUUID& object_id);
+public:
+	const LLInventorySearchIndex& getSearchIndex() const { return mSearchIndex; }
 	
 	//--------------------------------------------------------------------
 	// Login
@@ -0,0 +1,267 @@
+/**
+ * @file llinventorysearchindex.cpp
+ * @brief Trigram index over inventory item search fields.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventorysearchindex.h"
+
+#include "llstring.h"
+
+#include <algorithm>
+
+// unused slots tolerated before compacting, on top of one per live item
+const U32 MIN_STALE_SLOTS = 1024;
+
+static void get_trigrams(const std::string& text, std::vector<U32>& trigrams)
+{
+	trigrams.clear();
+	for (size_t i = 2; i < text.size(); ++i)
+	{
+		trigrams.push_back(((U32)(U8)text[i - 2] << 16) | ((U32)(U8)text[i - 1] << 8) | (U32)(U8)text[i]);
+	}
+	std::sort(trigrams.begin(), trigrams.end());
+	trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+LLInventorySearchIndex::LLInventorySearchIndex()
+:	mLayoutGeneration(0)
+{
+}
+
+void LLInventorySearchIndex::setItem(const LLUUID& item_id, const LLUUID& parent_id, const LLUUID& creator_id,
+									 const std::string& name, const std::string& description, const LLUUID& asset_id, U32 flags)
+{
+	slot_map_t::iterator iter = mSlots.find(item_id);
+	if (iter != mSlots.end())
+	{
+		Entry& old_entry = mEntries[iter->second];
+		if (old_entry.mParentID == parent_id
+			&& old_entry.mCreatorID == creator_id
+			&& old_entry.mAssetID == asset_id
+			&& old_entry.mFlags == flags
+			&& old_entry.mName == name
+			&& old_entry.mDescription == description)
+		{
+			return;
+		}
+		old_entry.mItemID.setNull();
+		old_entry.mName.clear();
+		old_entry.mDescription.clear();
+		mSlots.erase(iter);
+	}
+
+	Entry entry;
+	entry.mItemID = item_id;
+	entry.mParentID = parent_id;
+	entry.mCreatorID = creator_id;
+	entry.mAssetID = asset_id;
+	entry.mName = name;
+	entry.mDescription = description;
+	entry.mFlags = flags;
+	addEntry(entry);
+
+	if (mEntries.size() > 2 * mSlots.size() + MIN_STALE_SLOTS)
+	{
+		compact();
+	}
+}
+
+void LLInventorySearchIndex::removeItem(const LLUUID& item_id)
+{
+	slot_map_t::iterator iter = mSlots.find(item_id);
+	if (iter == mSlots.end())
+	{
+		return;
+	}
+
+	Entry& entry = mEntries[iter->second];
+	entry.mItemID.setNull();
+	entry.mName.clear();
+	entry.mDescription.clear();
+	mSlots.erase(iter);
+
+	if (mEntries.size() > 2 * mSlots.size() + MIN_STALE_SLOTS)
+	{
+		compact();
+	}
+}
+
+void LLInventorySearchIndex::clear()
+{
+	mEntries.clear();
+	mSlots.clear();
+	for (S32 field = 0; field < FIELD_COUNT; ++field)
+	{
+		mPostings[field].clear();
+	}
+	mCreatorSlots.clear();
+	mLinkSlots.clear();
+	mLabelSuffixSlots.clear();
+	mLayoutGeneration++;
+}
+
+S32 LLInventorySearchIndex::getSlot(const LLUUID& item_id) const
+{
+	slot_map_t::const_iterator iter = mSlots.find(item_id);
+	return iter == mSlots.end() ? -1 : (S32) iter->second;
+}
+
+bool LLInventorySearchIndex::findSlots(EField field, const std::string& sub_string, slot_vec_t& slots) const
+{
+	slots.clear();
+
+	std::vector<U32> trigrams;
+	get_trigrams(sub_string, trigrams);
+	if (trigrams.empty())
+	{
+		return false;
+	}
+
+	// intersect starting with the shortest list
+	std::vector<const slot_vec_t*> lists;
+	for (std::vector<U32>::const_iterator iter = trigrams.begin(); iter != trigrams.end(); ++iter)
+	{
+		posting_map_t::const_iterator found = mPostings[field].find(*iter);
+		if (found == mPostings[field].end())
+		{
+			return true;
+		}
+		lists.push_back(&found->second);
+	}
+
+	const slot_vec_t* shortest = lists[0];
+	for (U32 i = 1; i < lists.size(); ++i)
+	{
+		if (lists[i]->size() < shortest->size())
+		{
+			shortest = lists[i];
+		}
+	}
+
+	slots = *shortest;
+	slot_vec_t intersection;
+	for (U32 i = 0; i < lists.size() && !slots.empty(); ++i)
+	{
+		if (lists[i] != shortest)
+		{
+			intersection.clear();
+			std::set_intersection(slots.begin(), slots.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(intersection));
+			slots.swap(intersection);
+		}
+	}
+	return true;
+}
+
+void LLInventorySearchIndex::getCreators(uuid_vec_t& creators) const
+{
+	creators.clear();
+	creators.reserve(mCreatorSlots.size());
+	for (creator_map_t::const_iterator iter = mCreatorSlots.begin(); iter != mCreatorSlots.end(); ++iter)
+	{
+		creators.push_back(iter->first);
+	}
+}
+
+void LLInventorySearchIndex::appendCreatorSlots(const LLUUID& creator_id, slot_vec_t& slots) const
+{
+	creator_map_t::const_iterator iter = mCreatorSlots.find(creator_id);
+	if (iter != mCreatorSlots.end())
+	{
+		slots.insert(slots.end(), iter->second.begin(), iter->second.end());
+	}
+}
+
+void LLInventorySearchIndex::appendFlaggedSlots(EFlag flag, slot_vec_t& slots) const
+{
+	const slot_vec_t& flagged = flag == FLAG_LINK ? mLinkSlots : mLabelSuffixSlots;
+	slots.insert(slots.end(), flagged.begin(), flagged.end());
+}
+
+void LLInventorySearchIndex::addEntry(const Entry& entry)
+{
+	U32 slot = mEntries.size();
+	mEntries.push_back(entry);
+	mSlots[entry.mItemID] = slot;
+	if (entry.mCreatorID.notNull())
+	{
+		mCreatorSlots[entry.mCreatorID].push_back(slot);
+	}
+	if (entry.mFlags & FLAG_LINK)
+	{
+		mLinkSlots.push_back(slot);
+	}
+	if (entry.mFlags & FLAG_LABEL_SUFFIX)
+	{
+		mLabelSuffixSlots.push_back(slot);
+	}
+
+	std::vector<U32> trigrams;
+	for (S32 field = 0; field < FIELD_COUNT; ++field)
+	{
+		std::string text;
+		switch (field)
+		{
+		case FIELD_NAME:
+			text = entry.mName;
+			break;
+		case FIELD_DESCRIPTION:
+			text = entry.mDescription;
+			break;
+		case FIELD_ASSET_ID:
+			if (entry.mAssetID.notNull())
+			{
+				text = entry.mAssetID.asString();
+			}
+			break;
+		}
+		LLStringUtil::toUpper(text);
+
+		get_trigrams(text, trigrams);
+		for (std::vector<U32>::const_iterator iter = trigrams.begin(); iter != trigrams.end(); ++iter)
+		{
+			mPostings[field][*iter].push_back(slot);
+		}
+	}
+}
+
+void LLInventorySearchIndex::compact()
+{
+	std::vector<Entry> entries;
+	entries.reserve(mSlots.size());
+	for (std::vector<Entry>::const_iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+	{
+		if (iter->mItemID.notNull())
+		{
+			entries.push_back(*iter);
+		}
+	}
+
+	clear();
+	for (std::vector<Entry>::const_iterator iter = entries.begin(); iter != entries.end(); ++iter)
+	{
+		addEntry(*iter);
+	}
+}
@@ -0,0 +1,133 @@
+/**
+ * @file llinventorysearchindex.h
+ * @brief Trigram index over inventory item search fields.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYSEARCHINDEX_H
+#define LL_LLINVENTORYSEARCHINDEX_H
+
+#include "lluuid.h"
+
+#include <boost/unordered_map.hpp>
+#include <vector>
+
+//---------------------------------------------------------------------------
+// Trigram index over the searchable fields of inventory items and folders,
+// so a substring search only has to look at the objects that contain every
+// three character sequence of the substring instead of building the search
+// strings of everything in the inventory.
+//
+// Every object gets a slot.  Slots are handed out in increasing order and
+// an object that changes, or moves to another folder, gets a new one, so
+// slot lists are always sorted and a user of the index can tell whether
+// anything changed since it looked by comparing getSlotEnd() with its value
+// at the time.  Slots of removed and changed objects stay behind in the
+// lists until enough of them pile up for the index to be compacted, which
+// renumbers all slots and changes getLayoutGeneration().  Results are
+// candidates only, they may include objects that don't match after all.
+//
+// Objects whose search strings hold more than the indexed fields are
+// flagged, and users of the index must treat them as candidates whatever
+// the substring.
+//
+// Text is indexed upper case, substrings are expected to be upper case.
+//
+// Thread:  main only
+class LLInventorySearchIndex
+{
+public:
+	enum EField
+	{
+		FIELD_NAME,
+		FIELD_DESCRIPTION,
+		FIELD_ASSET_ID,
+		FIELD_COUNT
+	};
+
+	enum EFlag
+	{
+		FLAG_LINK = 0x1,			// searched by the fields of what it points to
+		FLAG_LABEL_SUFFIX = 0x2		// the searchable name may add to the name (worn, no copy, loading)
+	};
+
+	typedef std::vector<U32> slot_vec_t;
+
+	LLInventorySearchIndex();
+
+	// add or update an item or folder, does nothing if nothing changed,
+	// parent_id only tells moves apart
+	void setItem(const LLUUID& item_id, const LLUUID& parent_id, const LLUUID& creator_id,
+				 const std::string& name, const std::string& description, const LLUUID& asset_id, U32 flags = 0);
+	void removeItem(const LLUUID& item_id);
+	void clear();
+
+	// -1 if the item is not indexed
+	S32 getSlot(const LLUUID& item_id) const;
+	U32 getSlotEnd() const { return mEntries.size(); }
+	// null for slots that are no longer used
+	const LLUUID& getItemID(U32 slot) const { return mEntries[slot].mItemID; }
+	U32 getLayoutGeneration() const { return mLayoutGeneration; }
+	S32 getNumItems() const { return mSlots.size(); }
+
+	// Sorted slots of items whose field may contain sub_string.  Returns
+	// false if the substring is too short to be looked up, in which case
+	// every item is a candidate.
+	bool findSlots(EField field, const std::string& sub_string, slot_vec_t& slots) const;
+
+	// creators of indexed items and the slots of their items
+	void getCreators(uuid_vec_t& creators) const;
+	void appendCreatorSlots(const LLUUID& creator_id, slot_vec_t& slots) const;
+
+	// slots of the objects with the flag
+	void appendFlaggedSlots(EFlag flag, slot_vec_t& slots) const;
+
+private:
+	struct Entry
+	{
+		LLUUID		mItemID;		// null once the slot is no longer used
+		LLUUID		mParentID;
+		LLUUID		mCreatorID;		// null for folders and links
+		LLUUID		mAssetID;
+		std::string	mName;			// as given, not upper case
+		std::string	mDescription;
+		U32			mFlags;
+	};
+
+	void addEntry(const Entry& entry);
+	void compact();
+
+	typedef boost::unordered_map<U32, slot_vec_t> posting_map_t;
+	typedef boost::unordered_map<LLUUID, U32, FSUUIDHash> slot_map_t;
+	typedef boost::unordered_map<LLUUID, slot_vec_t, FSUUIDHash> creator_map_t;
+
+	std::vector<Entry>	mEntries;					// by slot
+	slot_map_t			mSlots;						// item id to slot of live items
+	posting_map_t		mPostings[FIELD_COUNT];		// trigram to slots
+	creator_map_t		mCreatorSlots;
+	slot_vec_t			mLinkSlots;
+	slot_vec_t			mLabelSuffixSlots;
+	U32					mLayoutGeneration;
+};
+
+#endif // LL_LLINVENTORYSEARCHINDEX_H
@@ -29,6 +29,7 @@
 #include "llagent.h"
 #include "llagentui.h"
 #include "llavatarnamecache.h"
+#include "llchattranscriptindex.h"
 #include "lllogchat.h"
 #include "lltrans.h"
 #include "llviewercontrol.h"
@@ -130,6 +131,37 @@ void append_to_last_message(std::list<LLSD>& messages, const std::string& line)
 	messages.back()[LL_IM_TEXT] = im_text;
 }
 
+// Adds a line read from a transcript to messages, continuation lines of
+// multi-line messages are appended to the last message
+void add_transcript_line(char* buffer, std::list<LLSD>& messages, const LLSD& load_params)
+{
+	S32 len = strlen(buffer) - 1;		/*Flawfinder: ignore*/
+	for (char* bptr = (buffer + len); (*bptr == '\n' || *bptr == '\r') && bptr>buffer; bptr--)	*bptr='\0';
+
+	std::string line(buffer);
+
+	//updated 1.23 plain text log format requires a space added before subsequent lines in a multilined message
+	if (' ' == line[0])
+	{
+		line.erase(0, MULTI_LINE_PREFIX.length());
+		append_to_last_message(messages, '\n' + line);
+	}
+	else if (0 == len && ('\n' == line[0] || '\r' == line[0]))
+	{
+		//to support old format's multilined messages with new lines used to divide paragraphs
+		append_to_last_message(messages, line);
+	}
+	else
+	{
+		LLSD item;
+		if (!LLChatLogParser::parse(line, item, load_params))
+		{
+			item[LL_IM_TEXT] = line;
+		}
+		messages.push_back(item);
+	}
+}
+
 class LLLogChatTimeScanner: public LLSingleton<LLLogChatTimeScanner>
 {
 public:
@@ -359,8 +391,6 @@ void LLLogChat::loadChatHistory(const std::string& file_name, std::list<LLSD>& m
 	}
 
 	char buffer[LOG_RECALL_SIZE];		/*Flawfinder: ignore*/
-	char *bptr;
-	S32 len;
 	bool firstline = TRUE;
 
 	if (load_all_history || fseek(fptr, (LOG_RECALL_SIZE - 1) * -1  , SEEK_END))
@@ -374,39 +404,68 @@ void LLLogChat::loadChatHistory(const std::string& file_name, std::list<LLSD>& m
 	}
 	while (fgets(buffer, LOG_RECALL_SIZE, fptr)  && !feof(fptr))
 	{
-		len = strlen(buffer) - 1;		/*Flawfinder: ignore*/
-		for (bptr = (buffer + len); (*bptr == '\n' || *bptr == '\r') && bptr>buffer; bptr--)	*bptr='\0';
-
 		if (firstline)
 		{
 			firstline = FALSE;
 			continue;
 		}
 
-		std::string line(buffer);
+		add_transcript_line(buffer, messages, load_params);
+	}
+	fclose(fptr);
+}
 
-		//updated 1.23 plain text log format requires a space added before subsequent lines in a multilined message
-		if (' ' == line[0])
-		{
-			line.erase(0, MULTI_LINE_PREFIX.length());
-			append_to_last_message(messages, '\n' + line);
-		}
-		else if (0 == len && ('\n' == line[0] || '\r' == line[0]))
-		{
-			//to support old format's multilined messages with new lines used to divide paragraphs
-			append_to_last_message(messages, line);
-		}
-		else
+// static
+S32 LLLogChat::loadChatHistoryPage(const std::string& file_name, std::list<LLSD>& messages, S32 first_message, S32 message_count, const LLSD& load_params)
+{
+	if (file_name.empty() || message_count <= 0)
+	{
+		return 0;
+	}
+
+	// same fallback as loadChatHistory()
+	std::string path = LLLogChat::makeLogFileName(file_name);
+	if (!LLFile::isfile(path))
+	{
+		path = LLLogChat::oldLogFileName(file_name);
+	}
+
+	LLChatTranscriptIndex index;
+	if (!index.load(path))
+	{
+		return 0;						//No previous conversation with this name.
+	}
+
+	S32 num_messages = index.getMessageCount();
+	if (first_message < 0)
+	{
+		first_message = num_messages ? ((num_messages - 1) / message_count) * message_count : 0;
+	}
+
+	S64 begin, end;
+	index.getByteRange(first_message, message_count, begin, end);
+	if (begin >= end)
+	{
+		return num_messages;
+	}
+
+	LLFILE* fptr = LLFile::fopen(path, "rb");/*Flawfinder: ignore*/
+	if (!fptr)
+	{
+		return num_messages;
+	}
+
+	char buffer[LOG_RECALL_SIZE];		/*Flawfinder: ignore*/
+	if (!fseek(fptr, begin, SEEK_SET))
+	{
+		while (ftell(fptr) < end && fgets(buffer, LOG_RECALL_SIZE, fptr))
 		{
-			LLSD item;
-			if (!LLChatLogParser::parse(line, item, load_params))
-			{
-				item[LL_IM_TEXT] = line;
-			}
-			messages.push_back(item);
+			add_transcript_line(buffer, messages, load_params);
 		}
 	}
 	fclose(fptr);
+
+	return num_messages;
 }
 
 // static
@@ -566,41 +625,50 @@ void LLLogChat::findTranscriptFiles(std::string pattern, std::vector<std::string
 	while (iter.next(filename))
 	{
 		std::string fullname = gDirUtilp->add(dirname, filename);
-
-		LLFILE * filep = LLFile::fopen(fullname, "rb");
-		if (NULL != filep)
+		if (isTranscriptFile(fullname))
 		{
-			if(makeLogFileName("chat")== fullname)
-			{
-				//Add Nearby chat history to the list of transcriptions
-				list_of_transcriptions.push_back(gDirUtilp->add(dirname, filename));
-				LLFile::close(filep);
-				continue;
-			}
-			char buffer[LOG_RECALL_SIZE];
+			list_of_transcriptions.push_back(fullname);
+		}
+	}
+}
+
+// static
+bool LLLogChat::isTranscriptFile(const std::string& fullname)
+{
+	LLFILE * filep = LLFile::fopen(fullname, "rb");
+	if (NULL == filep)
+	{
+		return false;
+	}
 
-			fseek(filep, 0, SEEK_END);			// seek to end of file
-			S32 bytes_to_read = ftell(filep);	// get current file pointer
-			fseek(filep, 0, SEEK_SET);			// seek back to beginning of file
+	if(makeLogFileName("chat")== fullname)
+	{
+		//Nearby chat history is always a transcript
+		LLFile::close(filep);
+		return true;
+	}
 
-			// limit the number characters to read from file
-			if (bytes_to_read >= LOG_RECALL_SIZE)
-			{
-				bytes_to_read = LOG_RECALL_SIZE - 1;
-			}
+	bool is_transcript = false;
+	char buffer[LOG_RECALL_SIZE];
 
-			if (bytes_to_read > 0 && NULL != fgets(buffer, bytes_to_read, filep))
-			{
-				//matching a timestamp
-				boost::match_results<std::string::const_iterator> matches;
-				if (boost::regex_match(std::string(buffer), matches, TIMESTAMP))
-				{
-					list_of_transcriptions.push_back(gDirUtilp->add(dirname, filename));
-				}
-			}
-			LLFile::close(filep);
-		}
+	fseek(filep, 0, SEEK_END);			// seek to end of file
+	S32 bytes_to_read = ftell(filep);	// get current file pointer
+	fseek(filep, 0, SEEK_SET);			// seek back to beginning of file
+
+	// limit the number characters to read from file
+	if (bytes_to_read >= LOG_RECALL_SIZE)
+	{
+		bytes_to_read = LOG_RECALL_SIZE - 1;
+	}
+
+	if (bytes_to_read > 0 && NULL != fgets(buffer, bytes_to_read, filep))
+	{
+		//matching a timestamp
+		boost::match_results<std::string::const_iterator> matches;
+		is_transcript = boost::regex_match(std::string(buffer), matches, TIMESTAMP);
 	}
+	LLFile::close(filep);
+	return is_transcript;
 }
 
 // static
@@ -678,6 +746,12 @@ bool LLLogChat::moveTranscripts(const std::string originDirectory,
 			else
 			{
 				listOfFilesMoved.push_back(newFullPath);
+				// the index is rebuilt where the transcript is read next
+				std::string index_path = LLChatTranscriptIndex::getIndexFileName(fullpath);
+				if (LLFile::isfile(index_path))
+				{
+					LLFile::remove(index_path);
+				}
 
 				if (retry_count)
 				{
@@ -738,6 +812,11 @@ void LLLogChat::deleteTranscripts()
 				{
 					LL_WARNS("LLLogChat::deleteTranscripts") << "Successfully removed " << fullpath << LL_ENDL;
 				}
+				std::string index_path = LLChatTranscriptIndex::getIndexFileName(fullpath);
+				if (LLFile::isfile(index_path))
+				{
+					LLFile::remove(index_path);
+				}
 				break;
 			}			
 		}
@@ -749,6 +828,14 @@ void LLLogChat::deleteTranscripts()
 // static
 bool LLLogChat::isTranscriptExist(const LLUUID& avatar_id, bool is_group)
 {
+	if (is_group)
+	{
+		// no need to list the directory for a file with a known name
+		std::string file_name;
+		gCacheName->getGroupName(avatar_id, file_name);
+		return isTranscriptFile(makeLogFileName(file_name));
+	}
+
 	std::vector<std::string> list_of_transcriptions;
 	LLLogChat::getListOfTranscriptFiles(list_of_transcriptions);
 
@@ -757,31 +844,14 @@ bool LLLogChat::isTranscriptExist(const LLUUID& avatar_id, bool is_group)
 		LLAvatarName avatar_name;
 		LLAvatarNameCache::get(avatar_id, &avatar_name);
 		std::string avatar_user_name = avatar_name.getAccountName();
-		if(!is_group)
-		{
-			std::replace(avatar_user_name.begin(), avatar_user_name.end(), '.', '_');
-			BOOST_FOREACH(std::string& transcript_file_name, list_of_transcriptions)
-			{
-				if (std::string::npos != transcript_file_name.find(avatar_user_name))
-				{
-					return true;
-				}
-			}
-		}
-		else
+		std::replace(avatar_user_name.begin(), avatar_user_name.end(), '.', '_');
+		BOOST_FOREACH(std::string& transcript_file_name, list_of_transcriptions)
 		{
-			std::string file_name;
-			gCacheName->getGroupName(avatar_id, file_name);
-			file_name = makeLogFileName(file_name);
-			BOOST_FOREACH(std::string& transcript_file_name, list_of_transcriptions)
+			if (std::string::npos != transcript_file_name.find(avatar_user_name))
 			{
-				if (transcript_file_name == file_name)
-				{
-					return true;
-				}
+				return true;
 			}
 		}
-
 	}
 
 	return false;
@@ -789,19 +859,8 @@ bool LLLogChat::isTranscriptExist(const LLUUID& avatar_id, bool is_group)
 
 bool LLLogChat::isNearbyTranscriptExist()
 {
-	std::vector<std::string> list_of_transcriptions;
-	LLLogChat::getListOfTranscriptFiles(list_of_transcriptions);
-
-	std::string file_name;
-	file_name = makeLogFileName("chat");
-	BOOST_FOREACH(std::string& transcript_file_name, list_of_transcriptions)
-	{
-	   	if (transcript_file_name == file_name)
-	   	{
-			return true;
-		 }
-	}
-	return false;
+	// no need to list the directory for a file with a known name
+	return isTranscriptFile(makeLogFileName("chat"));
 }
 
 //*TODO mark object's names in a special way so that they will be distinguishable form avatar name 
@@ -1008,6 +1067,7 @@ LLLoadHistoryThread::LLLoadHistoryThread(const std::string& file_name, std::list
 	mFileName(file_name),
 	mLoadParams(load_params),
 	mNewLoad(true),
+	mTotalMessages(-1),
 	mLoadEndSignal(NULL)
 {
 }
@@ -1035,6 +1095,17 @@ void LLLoadHistoryThread::loadHistory(const std::string& file_name, std::list<LL
 		return ;
 	}
 
+	// a page of messages, found through the transcript's index
+	if (load_params.has("message_count"))
+	{
+		mTotalMessages = LLLogChat::loadChatHistoryPage(file_name, *messages,
+														load_params.has("first_message") ? load_params["first_message"].asInteger() : -1,
+														load_params["message_count"].asInteger(), load_params);
+		mNewLoad = false;
+		(*mLoadEndSignal)(messages, file_name);
+		return;
+	}
+
 	bool load_all_history = load_params.has("load_all_history") ? load_params["load_all_history"].asBoolean() : false;
 	LLFILE* fptr = LLFile::fopen(LLLogChat::makeLogFileName(file_name), "r");/*Flawfinder: ignore*/
 
@@ -1051,8 +1122,6 @@ void LLLoadHistoryThread::loadHistory(const std::string& file_name, std::list<LL
 
 	char buffer[LOG_RECALL_SIZE];		/*Flawfinder: ignore*/
 
-	char *bptr;
-	S32 len;
 	bool firstline = TRUE;
 
 	if (load_all_history || fseek(fptr, (LOG_RECALL_SIZE - 1) * -1  , SEEK_END))
@@ -1070,38 +1139,13 @@ void LLLoadHistoryThread::loadHistory(const std::string& file_name, std::list<LL
 
 	while (fgets(buffer, LOG_RECALL_SIZE, fptr)  && !feof(fptr))
 	{
-		len = strlen(buffer) - 1;		/*Flawfinder: ignore*/
-
-		for (bptr = (buffer + len); (*bptr == '\n' || *bptr == '\r') && bptr>buffer; bptr--)	*bptr='\0';
-
-
 		if (firstline)
 		{
 			firstline = FALSE;
 			continue;
 		}
-		std::string line(buffer);
 
-		//updated 1.23 plaint text log format requires a space added before subsequent lines in a multilined message
-		if (' ' == line[0])
-		{
-			line.erase(0, MULTI_LINE_PREFIX.length());
-			append_to_last_message(*messages, '\n' + line);
-		}
-		else if (0 == len && ('\n' == line[0] || '\r' == line[0]))
-		{
-			//to support old format's multilined messages with new lines used to divide paragraphs
-			append_to_last_message(*messages, line);
-		}
-		else
-		{
-			LLSD item;
-			if (!LLChatLogParser::parse(line, item, load_params))
-			{
-				item[LL_IM_TEXT] = line;
-			}
-			messages->push_back(item);
-		}
+		add_transcript_line(buffer, *messages, load_params);
 	}
 
 	fclose(fptr);
@@ -53,6 +53,7 @@ private:
 	std::list<LLSD>* mMessages;
 	LLSD mLoadParams;
 	bool mNewLoad;
+	S32 mTotalMessages;
 public:
 	LLLoadHistoryThread(const std::string& file_name, std::list<LLSD>* messages, const LLSD& load_params);
 	~LLLoadHistoryThread();
@@ -60,6 +61,10 @@ public:
 	virtual void loadHistory(const std::string& file_name, std::list<LLSD>* messages, const LLSD& load_params);
     virtual void run();
 
+	// messages in the transcript when a page was loaded ("message_count"
+	// in the load params), -1 otherwise
+	S32 getTotalMessages() const { return mTotalMessages; }
+
 	typedef boost::signals2::signal<void (std::list<LLSD>* messages,const std::string& file_name)> load_end_signal_t;
 	load_end_signal_t * mLoadEndSignal;
 	boost::signals2::connection setLoadEndSignal(const load_end_signal_t::slot_type& cb);
@@ -106,6 +111,15 @@ public:
 
 	static void loadChatHistory(const std::string& file_name, std::list<LLSD>& messages, const LLSD& load_params = LLSD());
 
+	/**
+	 * Loads messages [first_message, first_message + message_count) by seeking
+	 * through the transcript's index, first_message < 0 loads the last page of
+	 * message_count messages.
+	 * @return number of messages in the transcript
+	 */
+	static S32 loadChatHistoryPage(const std::string& file_name, std::list<LLSD>& messages,
+								   S32 first_message, S32 message_count, const LLSD& load_params = LLSD());
+
 	typedef boost::signals2::signal<void ()> save_history_signal_t;
 	static boost::signals2::connection setSaveHistorySignal(const save_history_signal_t::slot_type& cb);
 
@@ -130,6 +144,7 @@ public:
 
 private:
 	static std::string cleanFileName(std::string filename);
+	static bool isTranscriptFile(const std::string& fullname);
 	static save_history_signal_t * sSaveHistorySignal;
 
 	static std::map<LLUUID,LLLoadHistoryThread *> sLoadHistoryThreads;
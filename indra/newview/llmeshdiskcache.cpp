@@ -0,0 +1,329 @@
+/**
+ * @file llmeshdiskcache.cpp
+ * @brief Disk cache of decoded mesh LODs.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llmeshdiskcache.h"
+
+#include "lldiriterator.h"
+#include "llfile.h"
+#include "llmutex.h"
+#include "llthread.h"
+#include "llvolume.h"
+
+#include <ctime>
+
+const char* mesh_cache_dirname = "meshcache";
+const U32 MESH_DISK_CACHE_MAGIC = 0x444d4c4c;	// "LLMD"
+const U32 MESH_DISK_CACHE_VERSION = 1;
+
+// on disk header, keep at 48 bytes so the face data stays 16 byte aligned
+struct LLMeshDiskCacheHeader
+{
+	U32 mMagic;
+	U32 mVersion;
+	U32 mFacesVersion;
+	S32 mLOD;
+	U8 mMeshID[UUID_BYTES];
+	U32 mSculptType;
+	U32 mDataSize;
+	U32 mReserved[2];
+};
+
+const S32 MESH_DISK_CACHE_HEADER_SIZE = 48;
+
+LLMeshDiskCache::LLMeshDiskCache()
+:	mInitialized(false),
+	mReadOnly(true),
+	mMaxSize(0),
+	mCurrentSize(0)
+{
+	mMutex = new LLMutex(NULL);
+}
+
+LLMeshDiskCache::~LLMeshDiskCache()
+{
+	delete mMutex;
+	mMutex = NULL;
+}
+
+void LLMeshDiskCache::initCache(ELLPath location, U32 max_size_mb)
+{
+	llassert(sizeof(LLMeshDiskCacheHeader) == MESH_DISK_CACHE_HEADER_SIZE);
+
+	if (mInitialized)
+	{
+		LL_WARNS() << "Mesh disk cache already initialized." << LL_ENDL;
+		return;
+	}
+
+	mMaxSize = (U64) max_size_mb*1024*1024;
+	if (mMaxSize == 0)
+	{
+		LL_INFOS("AppCache") << "Mesh disk cache disabled." << LL_ENDL;
+		return;
+	}
+
+	mCacheDirName = gDirUtilp->getExpandedFilename(location, mesh_cache_dirname);
+
+	std::string name;
+	if (!mReadOnly)
+	{
+		LLFile::mkdir(mCacheDirName);
+
+		// leftovers of interrupted writes
+		LLDirIterator tmp_iter(mCacheDirName, "*.tmp");
+		while (tmp_iter.next(name))
+		{
+			LLFile::remove(mCacheDirName + gDirUtilp->getDirDelimiter() + name);
+		}
+	}
+
+	LLMutexLock lock(mMutex);
+
+	LLDirIterator iter(mCacheDirName, "*.mesh");
+	while (iter.next(name))
+	{
+		llstat stat_data;
+		if (!LLFile::stat(mCacheDirName + gDirUtilp->getDirDelimiter() + name, &stat_data))
+		{
+			Entry& entry = mEntries[name];
+			entry.mTime = (U32) stat_data.st_mtime;
+			entry.mSize = (U32) stat_data.st_size;
+			mCurrentSize += entry.mSize;
+		}
+	}
+
+	mInitialized = true;
+
+	if (mCurrentSize > mMaxSize && !mReadOnly)
+	{
+		purgeEntries(mMaxSize*9/10);
+	}
+
+	LL_INFOS("AppCache") << "Mesh disk cache: " << mEntries.size() << " entries, "
+						 << mCurrentSize/(1024*1024) << " MB of " << max_size_mb << " MB" << LL_ENDL;
+}
+
+void LLMeshDiskCache::removeCache(ELLPath location)
+{
+	if (mReadOnly)
+	{
+		LL_WARNS() << "Not removing mesh disk cache for read-only cache." << LL_ENDL;
+		return;
+	}
+
+	std::string cache_dir = gDirUtilp->getExpandedFilename(location, mesh_cache_dirname);
+	LL_INFOS() << "Removing mesh disk cache at " << cache_dir << LL_ENDL;
+
+	LLMutexLock lock(mMutex);
+	gDirUtilp->deleteFilesInDir(cache_dir, "*");
+	mEntries.clear();
+	mCurrentSize = 0;
+}
+
+std::string LLMeshDiskCache::getEntryName(const LLVolumeParams& mesh_params, S32 lod) const
+{
+	return llformat("%s_%d_%02x.mesh", mesh_params.getSculptID().asString().c_str(), lod, (U32) mesh_params.getSculptType());
+}
+
+bool LLMeshDiskCache::hasEntry(const LLVolumeParams& mesh_params, S32 lod)
+{
+	std::string name = getEntryName(mesh_params, lod);
+
+	LLMutexLock lock(mMutex);
+	return mInitialized && mEntries.find(name) != mEntries.end();
+}
+
+bool LLMeshDiskCache::readFromCache(const LLVolumeParams& mesh_params, S32 lod, LLVolume* volume)
+{
+	std::string name = getEntryName(mesh_params, lod);
+
+	{
+		LLMutexLock lock(mMutex);
+		if (!mInitialized)
+		{
+			return false;
+		}
+
+		entry_map_t::iterator iter = mEntries.find(name);
+		if (iter == mEntries.end())
+		{
+			return false;
+		}
+		iter->second.mTime = (U32) time(NULL);
+	}
+
+	bool success = false;
+
+	LLFILE* fp = LLFile::fopen(mCacheDirName + gDirUtilp->getDirDelimiter() + name, "rb");
+	if (fp)
+	{
+		fseek(fp, 0, SEEK_END);
+		S32 size = (S32) ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+
+		if (size > MESH_DISK_CACHE_HEADER_SIZE)
+		{
+			// aligned so the face arrays are aligned in memory as well
+			U8* buffer = (U8*) ll_aligned_malloc_16(size);
+			if (fread(buffer, 1, size, fp) == (size_t) size)
+			{
+				LLMeshDiskCacheHeader header;
+				memcpy(&header, buffer, sizeof(header));
+
+				if (header.mMagic == MESH_DISK_CACHE_MAGIC &&
+					header.mVersion == MESH_DISK_CACHE_VERSION &&
+					header.mFacesVersion == LLVolume::DECODED_FACES_VERSION &&
+					header.mLOD == lod &&
+					!memcmp(header.mMeshID, mesh_params.getSculptID().mData, UUID_BYTES) &&
+					header.mSculptType == (U32) mesh_params.getSculptType() &&
+					(S32) header.mDataSize == size-MESH_DISK_CACHE_HEADER_SIZE)
+				{
+					success = volume->unpackDecodedFaces(buffer+MESH_DISK_CACHE_HEADER_SIZE, header.mDataSize);
+				}
+			}
+			ll_aligned_free_16(buffer);
+		}
+
+		fclose(fp);
+	}
+
+	if (!success)
+	{
+		LL_WARNS() << "Discarding unreadable mesh disk cache entry " << name << LL_ENDL;
+		removeEntry(name);
+	}
+
+	return success;
+}
+
+void LLMeshDiskCache::writeToCache(const LLVolumeParams& mesh_params, S32 lod, const LLVolume* volume)
+{
+	if (!mInitialized || mReadOnly || volume->getNumVolumeFaces() == 0)
+	{
+		return;
+	}
+
+	std::vector<U8> data;
+	volume->packDecodedFaces(data);
+
+	LLMeshDiskCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	header.mMagic = MESH_DISK_CACHE_MAGIC;
+	header.mVersion = MESH_DISK_CACHE_VERSION;
+	header.mFacesVersion = LLVolume::DECODED_FACES_VERSION;
+	header.mLOD = lod;
+	memcpy(header.mMeshID, mesh_params.getSculptID().mData, UUID_BYTES);
+	header.mSculptType = mesh_params.getSculptType();
+	header.mDataSize = data.size();
+
+	std::string name = getEntryName(mesh_params, lod);
+	std::string filename = mCacheDirName + gDirUtilp->getDirDelimiter() + name;
+
+	// write under a per-thread name and move into place so readers never see a partial file
+	std::string tmp_filename = filename + llformat(".%u.tmp", LLThread::currentID());
+
+	LLFILE* fp = LLFile::fopen(tmp_filename, "wb");
+	if (!fp)
+	{
+		return;
+	}
+
+	bool success = fwrite(&header, 1, sizeof(header), fp) == sizeof(header) &&
+				   fwrite(&data[0], 1, data.size(), fp) == data.size();
+	fclose(fp);
+
+	if (success)
+	{
+		// rename doesn't replace an existing file on every platform
+		LLFile::remove(filename);
+		success = LLFile::rename(tmp_filename, filename) == 0;
+	}
+
+	if (!success)
+	{
+		LLFile::remove(tmp_filename);
+		return;
+	}
+
+	LLMutexLock lock(mMutex);
+	Entry& entry = mEntries[name];
+	mCurrentSize -= entry.mSize;
+	entry.mSize = sizeof(header) + data.size();
+	entry.mTime = (U32) time(NULL);
+	mCurrentSize += entry.mSize;
+
+	if (mCurrentSize > mMaxSize)
+	{
+		purgeEntries(mMaxSize*9/10);
+	}
+}
+
+void LLMeshDiskCache::removeEntry(const std::string& name)
+{
+	{
+		LLMutexLock lock(mMutex);
+		entry_map_t::iterator iter = mEntries.find(name);
+		if (iter == mEntries.end())
+		{
+			return;
+		}
+		mCurrentSize -= iter->second.mSize;
+		mEntries.erase(iter);
+	}
+
+	if (!mReadOnly)
+	{
+		LLFile::remove(mCacheDirName + gDirUtilp->getDirDelimiter() + name);
+	}
+}
+
+// Mutex:  must be holding mMutex when called
+void LLMeshDiskCache::purgeEntries(U64 target_size)
+{
+	// oldest first
+	std::vector<std::pair<U32, std::string> > entries;
+	entries.reserve(mEntries.size());
+	for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+	{
+		entries.push_back(std::make_pair(iter->second.mTime, iter->first));
+	}
+	std::sort(entries.begin(), entries.end());
+
+	U32 purged = 0;
+	for (U32 i = 0; i < entries.size() && mCurrentSize > target_size; ++i)
+	{
+		entry_map_t::iterator iter = mEntries.find(entries[i].second);
+		mCurrentSize -= iter->second.mSize;
+		mEntries.erase(iter);
+		LLFile::remove(mCacheDirName + gDirUtilp->getDirDelimiter() + entries[i].second);
+		++purged;
+	}
+
+	LL_INFOS("AppCache") << "Purged " << purged << " mesh disk cache entries, "
+						 << mCurrentSize/(1024*1024) << " MB remaining" << LL_ENDL;
+}
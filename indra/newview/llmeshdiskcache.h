@@ -0,0 +1,91 @@
+/**
+ * @file llmeshdiskcache.h
+ * @brief Disk cache of decoded mesh LODs.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMESHDISKCACHE_H
+#define LL_LLMESHDISKCACHE_H
+
+#include "lldir.h"
+#include "llsingleton.h"
+
+class LLMutex;
+class LLVolume;
+class LLVolumeParams;
+
+//---------------------------------------------------------------------------
+// Second tier behind the VFS holding mesh LODs as they are laid out in
+// memory after decoding and optimization, so a revisited mesh skips zlib,
+// LLSD and the vertex cache optimizer entirely.  One file per mesh, LOD
+// and sculpt flags (mirror/invert are baked into the decoded faces).
+//
+// Files start with a 48 byte header followed by the block written by
+// LLVolume::packDecodedFaces, all arrays 16 byte aligned from the start
+// of the file so the whole file can be read or mapped in one go.
+//
+// Thread:  main initializes, any thread reads and writes afterwards
+class LLMeshDiskCache : public LLSingleton<LLMeshDiskCache>
+{
+private:
+	struct Entry
+	{
+		Entry() : mTime(0), mSize(0) {}
+		U32 mTime;
+		U32 mSize;
+	};
+	typedef std::map<std::string, Entry> entry_map_t;	// keyed by file name
+
+	friend class LLSingleton<LLMeshDiskCache>;
+	LLMeshDiskCache();
+
+public:
+	~LLMeshDiskCache();
+
+	void initCache(ELLPath location, U32 max_size_mb);
+	void removeCache(ELLPath location);
+	void setReadOnly(bool read_only) { mReadOnly = read_only; }
+
+	// true if a decoded copy of the LOD is on disk, does not touch the disk
+	bool hasEntry(const LLVolumeParams& mesh_params, S32 lod);
+
+	// fill volume with the cached faces of the LOD, a bad entry is removed
+	bool readFromCache(const LLVolumeParams& mesh_params, S32 lod, LLVolume* volume);
+	void writeToCache(const LLVolumeParams& mesh_params, S32 lod, const LLVolume* volume);
+
+private:
+	std::string getEntryName(const LLVolumeParams& mesh_params, S32 lod) const;
+	void removeEntry(const std::string& name);
+	void purgeEntries(U64 target_size);
+
+private:
+	bool			mInitialized;
+	bool			mReadOnly;
+	U64				mMaxSize;
+	U64				mCurrentSize;	// bytes in mEntries
+	std::string		mCacheDirName;
+	LLMutex*		mMutex;			// guards mEntries and mCurrentSize
+	entry_map_t		mEntries;
+};
+
+#endif
@@ -45,6 +45,8 @@
 #include "llimagej2c.h"
 #include "llhost.h"
 #include "llmath.h"
+#include "llmemorystream.h"
+#include "llmeshdiskcache.h"
 #include "llnotificationsutil.h"
 #include "llsd.h"
 #include "llsdutil_math.h"
@@ -105,6 +107,7 @@
 //   main     Main rendering thread, very sensitive to locking and other stalls
 //   repo     Overseeing worker thread associated with the LLMeshRepoThread class
 //   decom    Worker thread for mesh decomposition requests
+//   decodeN  1-N mesh decode pool threads (LLMeshDecodePool)
 //   core     HTTP worker thread:  does the work but doesn't intrude here
 //   uploadN  0-N temporary mesh upload threads (0-1 in practice)
 //
@@ -144,9 +147,14 @@
 //                             ...
 //                             onCompleted() invoked for GET
 //                               data copied
-//                               lodReceived() invoked
-//                                 unpack data into LLVolume
-//                                 append LoadedMesh to mLoadedQ
+//                               submit to LLMeshDecodePool
+//                             ...
+//                                                 decode thread
+//                                                 lodReceived() invoked
+//                                                   unpack data into LLVolume
+//                                                   write faces to LLMeshDiskCache
+//                                                   append LoadedMesh to mLoadedQ
+//                                                 write block to VFS
 //                             ...
 //         notifyLoadedMeshes() invoked again
 //           scan mLoadedQ
@@ -155,12 +163,18 @@
 //             notifyMeshLoaded() invoked for each interested object
 //         ...
 //
+//   LODs found in LLMeshDiskCache skip the header wait, the GET and
+//   lodReceived():  the decode pool reads the decoded faces straight
+//   into an LLVolume and appends it to mLoadedQ.
+//
 // Mutexes
 //
 //   LLMeshRepository::mMeshMutex
 //   LLMeshRepoThread::mMutex
 //   LLMeshRepoThread::mHeaderMutex
 //   LLMeshRepoThread::mSignal (LLCondition)
+//   LLMeshDecodePool::mSignal (LLCondition)
+//   LLMeshDiskCache::mMutex
 //   LLPhysicsDecomp::mSignal (LLCondition)
 //   LLPhysicsDecomp::mMutex
 //   LLMeshUploadThread::mMutex
@@ -216,10 +230,11 @@
 //     sHTTPErrorCount                 "
 //     sLODPending                     mMeshMutex [4]  rw.main.mMeshMutex
 //     sLODProcessing                  Repo::mMutex    rw.any.Repo::mMutex
-//     sCacheBytesRead                 none            rw.repo.none, ro.main.none [1]
+//     sCacheBytesRead                 atomic          rw.repo.none, rw.decode.none, ro.main.none
 //     sCacheBytesWritten              "
 //     sCacheReads                     "
 //     sCacheWrites                    "
+//     sDecodedCacheHits               atomic          rw.decode.none, ro.repo.none
 //     mLoadingMeshes                  mMeshMutex [4]  rw.main.none, rw.any.mMeshMutex
 //     mSkinMap                        none            rw.main.none
 //     mDecompositionMap               none            rw.main.none
@@ -250,8 +265,8 @@
 //     mDecompositionQ          mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
 //     mHeaderReqQ              mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
 //     mLODReqQ                 mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
-//     mUnavailableQ            mMutex        rw.repo.none [0], ro.main.none [5], rw.main.mMutex
-//     mLoadedQ                 mMutex        rw.repo.mMutex, ro.main.none [5], rw.main.mMutex
+//     mUnavailableQ            mMutex        rw.repo.none [0], ro.main.none [5], rw.main.mMutex, wo.decode.mMutex
+//     mLoadedQ                 mMutex        rw.repo.mMutex, ro.main.none [5], rw.main.mMutex, wo.decode.mMutex
 //     mPendingLOD              mMutex        rw.repo.mMutex, rw.any.mMutex
 //     mGetMeshCapability       mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
 //     mGetMesh2Capability      mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
@@ -385,10 +400,11 @@ U32 LLMeshRepository::sHTTPErrorCount = 0;
 U32 LLMeshRepository::sLODProcessing = 0;
 U32 LLMeshRepository::sLODPending = 0;
 
-U32 LLMeshRepository::sCacheBytesRead = 0;
-U32 LLMeshRepository::sCacheBytesWritten = 0;
-U32 LLMeshRepository::sCacheReads = 0;
-U32 LLMeshRepository::sCacheWrites = 0;
+LLAtomicU32 LLMeshRepository::sCacheBytesRead(0);
+LLAtomicU32 LLMeshRepository::sCacheBytesWritten(0);
+LLAtomicU32 LLMeshRepository::sCacheReads(0);
+LLAtomicU32 LLMeshRepository::sCacheWrites(0);
+LLAtomicU32 LLMeshRepository::sDecodedCacheHits(0);
 U32 LLMeshRepository::sMaxLockHoldoffs = 0;
 	
 LLDeadmanTimer LLMeshRepository::sQuiescentTimer(15.0, false);	// true -> gather cpu metrics
@@ -740,6 +756,206 @@ void log_upload_error(LLCore::HttpStatus status, const LLSD& content,
 	}
 }
 
+LLMeshDecodePool::DecodeThread::DecodeThread(LLMeshDecodePool* pool, const std::string& name)
+: LLThread(name),
+  mPool(pool)
+{
+}
+
+void LLMeshDecodePool::DecodeThread::run()
+{
+	Request request(LLVolumeParams(), 0, NULL, 0, 0, false);
+	while (mPool->getNextRequest(request))
+	{
+		mPool->processRequest(request);
+	}
+}
+
+LLMeshDecodePool::LLMeshDecodePool(LLMeshRepoThread* repo_thread, U32 num_threads)
+: mRepoThread(repo_thread),
+  mOverdrawThreshold(0.f),
+  mLogOptimizerStats(false),
+  mQuitting(false)
+{
+	mSignal = new LLCondition(NULL);
+
+	num_threads = llclamp(num_threads, (U32) 1, (U32) 8);
+	for (U32 i = 0; i < num_threads; ++i)
+	{
+		DecodeThread* thread = new DecodeThread(this, llformat("mesh decode %d", i));
+		mThreads.push_back(thread);
+		thread->start();
+	}
+}
+
+LLMeshDecodePool::~LLMeshDecodePool()
+{
+	shutdown();
+
+	delete mSignal;
+	mSignal = NULL;
+}
+
+void LLMeshDecodePool::shutdown()
+{
+	if (!mSignal)
+	{
+		return;
+	}
+
+	mSignal->lock();
+	mQuitting = true;
+	mSignal->broadcast();
+	mSignal->unlock();
+
+	for (U32 i = 0; i < mThreads.size(); ++i)
+	{
+		while (!mThreads[i]->isStopped())
+		{
+			apr_sleep(10);
+		}
+		delete mThreads[i];
+	}
+	mThreads.clear();
+
+	while (!mRequestQ.empty())
+	{
+		delete [] mRequestQ.front().mData;
+		mRequestQ.pop();
+	}
+}
+
+void LLMeshDecodePool::submitRequest(const Request& request)
+{
+	mSignal->lock();
+	mRequestQ.push(request);
+	mRequestQ.back().mOverdrawThreshold = mOverdrawThreshold;
+	mRequestQ.back().mLogOptimizerStats = mLogOptimizerStats;
+	mSignal->signal();
+	mSignal->unlock();
+}
+
+void LLMeshDecodePool::setOptimizerSettings(F32 overdraw_threshold, bool log_stats)
+{
+	// the main thread is the only writer, it can compare without the lock
+	if (overdraw_threshold != mOverdrawThreshold || log_stats != mLogOptimizerStats)
+	{
+		mSignal->lock();
+		mOverdrawThreshold = overdraw_threshold;
+		mLogOptimizerStats = log_stats;
+		mSignal->unlock();
+	}
+}
+
+bool LLMeshDecodePool::getNextRequest(Request& request)
+{
+	mSignal->lock();
+	while (!mQuitting && mRequestQ.empty())
+	{
+		mSignal->wait();
+	}
+
+	bool ret = !mQuitting;
+	if (ret)
+	{
+		request = mRequestQ.front();
+		mRequestQ.pop();
+	}
+	mSignal->unlock();
+
+	return ret;
+}
+
+// Thread:  decode pool
+void LLMeshDecodePool::processRequest(Request& request)
+{
+	const LLUUID mesh_id = request.mMeshParams.getSculptID();
+	bool valid = true;
+
+	if (request.mFromCache)
+	{
+		// already decoded and optimized on a previous visit?
+		LLPointer<LLVolume> volume = new LLVolume(request.mMeshParams, LLVolumeLODGroup::getVolumeScaleFromDetail(request.mLOD));
+		if (LLMeshDiskCache::getInstance()->readFromCache(request.mMeshParams, request.mLOD, volume))
+		{
+			++LLMeshRepository::sDecodedCacheHits;
+			LLMutexLock lock(mRepoThread->mMutex);
+			mRepoThread->mLoadedQ.push(LLMeshRepoThread::LoadedMesh(volume, request.mMeshParams, request.mLOD));
+			return;
+		}
+	}
+
+	if (request.mFromCache && request.mDataSize <= 0)
+	{ //requested before the header arrived, go through the header
+		mRepoThread->lockAndLoadMeshLOD(request.mMeshParams, request.mLOD);
+		return;
+	}
+
+	if (request.mFromCache)
+	{
+		LLVFile file(gVFS, mesh_id, LLAssetType::AT_MESH);
+		if (file.getSize() >= request.mOffset+request.mDataSize)
+		{
+			LLMeshRepository::sCacheBytesRead += request.mDataSize;
+			++LLMeshRepository::sCacheReads;
+			request.mData = new U8[request.mDataSize];
+			file.seek(request.mOffset);
+			file.read(request.mData, request.mDataSize);
+
+			//make sure buffer isn't all 0's by checking the first 1KB (reserved block but not written)
+			bool zero = true;
+			for (S32 i = 0; i < llmin(request.mDataSize, 1024) && zero; ++i)
+			{
+				zero = request.mData[i] > 0 ? false : true;
+			}
+			valid = !zero;
+		}
+		else
+		{
+			valid = false;
+		}
+	}
+
+	if (valid && mRepoThread->lodReceived(request.mMeshParams, request.mLOD, request.mData, request.mDataSize,
+										  request.mOverdrawThreshold, request.mLogOptimizerStats))
+	{
+		if (!request.mFromCache)
+		{ //good fetch from sim, write to VFS for caching
+			LLVFile file(gVFS, mesh_id, LLAssetType::AT_MESH, LLVFile::WRITE);
+
+			if (file.getSize() >= request.mOffset+request.mDataSize)
+			{
+				file.seek(request.mOffset);
+				file.write(request.mData, request.mDataSize);
+				LLMeshRepository::sCacheBytesWritten += request.mDataSize;
+				++LLMeshRepository::sCacheWrites;
+			}
+		}
+	}
+	else if (request.mFromCache)
+	{ //reading from VFS failed for whatever reason, fetch from sim
+		LLMeshRepoThread::LODRequest req(request.mMeshParams, request.mLOD);
+		req.mSkipCache = true;
+		{
+			LLMutexLock lock(mRepoThread->mMutex);
+			mRepoThread->mLODReqQ.push(req);
+			++LLMeshRepository::sLODProcessing;
+		}
+		mRepoThread->mSignal->signal();
+	}
+	else
+	{
+		LL_WARNS(LOG_MESH) << "Error during mesh LOD processing.  ID:  " << mesh_id
+						   << ", Unknown reason.  Not retrying."
+						   << LL_ENDL;
+		LLMutexLock lock(mRepoThread->mMutex);
+		mRepoThread->mUnavailableQ.push(LLMeshRepoThread::LODRequest(request.mMeshParams, request.mLOD));
+	}
+
+	delete [] request.mData;
+	request.mData = NULL;
+}
+
 LLMeshRepoThread::LLMeshRepoThread()
 : LLThread("mesh repo"),
   mHttpRequest(NULL),
@@ -750,7 +966,8 @@ LLMeshRepoThread::LLMeshRepoThread()
   mHttpLegacyPolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
   mHttpLargePolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
   mHttpPriority(0),
-  mGetMeshVersion(2)
+  mGetMeshVersion(2),
+  mDecodePool(NULL)
 {
 	LLAppCoreHttp & app_core_http(LLAppViewer::instance()->getAppCoreHttp());
 
@@ -769,6 +986,8 @@ LLMeshRepoThread::LLMeshRepoThread()
 	mHttpPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH2);
 	mHttpLegacyPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH1);
 	mHttpLargePolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_LARGE_MESH);
+
+	mDecodePool = new LLMeshDecodePool(this, gSavedSettings.getU32("MeshDecodeThreads"));
 }
 
 			
@@ -777,8 +996,13 @@ LLMeshRepoThread::~LLMeshRepoThread()
 	LL_INFOS(LOG_MESH) << "Small GETs issued:  " << LLMeshRepository::sHTTPRequestCount
 					   << ", Large GETs issued:  " << LLMeshRepository::sHTTPLargeRequestCount
 					   << ", Max Lock Holdoffs:  " << LLMeshRepository::sMaxLockHoldoffs
+					   << ", Decoded cache hits:  " << (U32) LLMeshRepository::sDecodedCacheHits
 					   << LL_ENDL;
 
+	// decode threads push results under mMutex, stop them first
+	delete mDecodePool;
+	mDecodePool = NULL;
+
 	for (http_request_set::iterator iter(mHttpRequestSet.begin());
 		 iter != mHttpRequestSet.end();
 		 ++iter)
@@ -862,7 +1086,7 @@ void LLMeshRepoThread::run()
 			LLMeshRepository::sLODProcessing--;
 			mMutex->unlock();
 
-			if (!fetchMeshLOD(req.mMeshParams, req.mLOD))		// failed, resubmit
+			if (!fetchMeshLOD(req.mMeshParams, req.mLOD, !req.mSkipCache))		// failed, resubmit
 			{
 				mMutex->lock();
 				mLODReqQ.push(req); 
@@ -1041,6 +1265,16 @@ void LLMeshRepoThread::loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod)
 			LLMeshRepository::sLODProcessing++;
 		}
 	}
+	else if (LLMeshDiskCache::getInstance()->hasEntry(mesh_params, lod))
+	{ //decoded copy on disk, don't wait for the header to load it
+		mDecodePool->submitRequest(LLMeshDecodePool::Request(mesh_params, lod, NULL, 0, 0, true));
+
+		if (mPendingLOD.find(mesh_params) == mPendingLOD.end())
+		{ //skin info and physics still need the header
+			mHeaderReqQ.push(HeaderRequest(mesh_params));
+			mPendingLOD[mesh_params];
+		}
+	}
 	else
 	{ 
 		HeaderRequest req(mesh_params);
@@ -1551,7 +1785,7 @@ bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params)
 }
 
 //return false if failed to get mesh lod.
-bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod)
+bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool use_cache)
 {
 	if (!mHeaderMutex)
 	{
@@ -1577,36 +1811,18 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod)
 		if (version <= MAX_MESH_VERSION && offset >= 0 && size > 0)
 		{
 
-			//check VFS for mesh asset
-			LLVFile file(gVFS, mesh_id, LLAssetType::AT_MESH);
-			if (file.getSize() >= offset+size)
+			//check the decoded cache and VFS for mesh asset, the decode pool reads and parses it
+			if (use_cache)
 			{
-				LLMeshRepository::sCacheBytesRead += size;
-				++LLMeshRepository::sCacheReads;
-				file.seek(offset);
-				U8* buffer = new U8[size];
-				file.read(buffer, size);
-
-				//make sure buffer isn't all 0's by checking the first 1KB (reserved block but not written)
-				bool zero = true;
-				for (S32 i = 0; i < llmin(size, 1024) && zero; ++i)
+				LLVFile file(gVFS, mesh_id, LLAssetType::AT_MESH);
+				if (LLMeshDiskCache::getInstance()->hasEntry(mesh_params, lod) || file.getSize() >= offset+size)
 				{
-					zero = buffer[i] > 0 ? false : true;
-				}
-
-				if (!zero)
-				{ //attempt to parse
-					if (lodReceived(mesh_params, lod, buffer, size))
-					{
-						delete[] buffer;
-						return true;
-					}
+					mDecodePool->submitRequest(LLMeshDecodePool::Request(mesh_params, lod, NULL, size, offset, true));
+					return true;
 				}
-
-				delete[] buffer;
 			}
 
-			//reading from VFS failed for whatever reason, fetch from sim
+			//not in VFS or the cached copy failed to decode, fetch from sim
 			int cap_version(2);
 			std::string http_url;
 			constructUrl(mesh_id, &http_url, &cap_version);
@@ -1657,18 +1873,17 @@ bool LLMeshRepoThread::headerReceived(const LLVolumeParams& mesh_params, U8* dat
 	U32 header_size = 0;
 	if (data_size > 0)
 	{
-		std::string res_str((char*) data, data_size);
-
 		std::string deprecated_header("<? LLSD/Binary ?>");
 
-		if (res_str.substr(0, deprecated_header.size()) == deprecated_header)
+		if (data_size > (S32) deprecated_header.size() &&
+			!memcmp(data, deprecated_header.data(), deprecated_header.size()))
 		{
-			res_str = res_str.substr(deprecated_header.size()+1, data_size);
 			header_size = deprecated_header.size()+1;
 		}
-		data_size = res_str.size();
+		data_size -= header_size;
 
-		std::istringstream stream(res_str);
+		// parse in place rather than copying the response into a string
+		LLMemoryStream stream(data+header_size, data_size);
 
 		if (!LLSDSerialize::fromBinary(header, stream, data_size))
 		{
@@ -1677,7 +1892,8 @@ bool LLMeshRepoThread::headerReceived(const LLVolumeParams& mesh_params, U8* dat
 			return false;
 		}
 
-		header_size += stream.tellg();
+		// LLMemoryStream can't seek, count what the parser left behind instead
+		header_size += data_size - stream.rdbuf()->in_avail();
 	}
 	else
 	{
@@ -1714,16 +1930,19 @@ bool LLMeshRepoThread::headerReceived(const LLVolumeParams& mesh_params, U8* dat
 	return true;
 }
 
-bool LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size)
+// Thread:  decode pool
+bool LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size,
+								   F32 overdraw_threshold, bool log_stats)
 {
 	LLPointer<LLVolume> volume = new LLVolume(mesh_params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
-	std::string mesh_string((char*) data, data_size);
-	std::istringstream stream(mesh_string);
 
-	if (volume->unpackVolumeFaces(stream, data_size))
+	if (volume->unpackVolumeFaces(data, data_size))
 	{
 		if (volume->getNumFaces() > 0)
 		{
+			optimizeLOD(volume, mesh_params.getSculptID(), lod, overdraw_threshold, log_stats);
+			LLMeshDiskCache::getInstance()->writeToCache(mesh_params, lod, volume);
+
 			LoadedMesh mesh(volume, mesh_params, lod);
 			{
 				LLMutexLock lock(mMutex);
@@ -1736,6 +1955,54 @@ bool LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_params, S32 lod, U
 	return false;
 }
 
+void LLMeshRepoThread::optimizeLOD(LLVolume* volume, const LLUUID& mesh_id, S32 lod, F32 overdraw_threshold, bool log_stats)
+{
+	if (!log_stats)
+	{
+		volume->cacheOptimize(overdraw_threshold);
+		return;
+	}
+
+	const U32 cache_size = 16;
+	F32 acmr_before = 0.f, atvr_before = 0.f;
+	F32 acmr_after = 0.f, atvr_after = 0.f;
+	U32 num_tris = 0;
+	U32 num_verts = 0;
+
+	for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+	{
+		const LLVolumeFace& face = volume->getVolumeFace(i);
+		F32 acmr, atvr;
+		face.getVertexCacheStats(cache_size, acmr, atvr);
+		acmr_before += acmr*(face.mNumIndices/3);
+		atvr_before += atvr*face.mNumVertices;
+		num_tris += face.mNumIndices/3;
+		num_verts += face.mNumVertices;
+	}
+
+	LLTimer timer;
+	volume->cacheOptimize(overdraw_threshold);
+	F32 elapsed = timer.getElapsedTimeF32();
+
+	for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+	{
+		const LLVolumeFace& face = volume->getVolumeFace(i);
+		F32 acmr, atvr;
+		face.getVertexCacheStats(cache_size, acmr, atvr);
+		acmr_after += acmr*(face.mNumIndices/3);
+		atvr_after += atvr*face.mNumVertices;
+	}
+
+	if (num_tris && num_verts)
+	{
+		LL_INFOS(LOG_MESH) << "Optimized mesh " << mesh_id << " LOD " << lod
+						   << " (" << num_tris << " triangles, " << num_verts << " vertices)"
+						   << " ACMR " << acmr_before/num_tris << " -> " << acmr_after/num_tris
+						   << " ATVR " << atvr_before/num_verts << " -> " << atvr_after/num_verts
+						   << " in " << elapsed*1000.f << " ms" << LL_ENDL;
+	}
+}
+
 bool LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size)
 {
 	LLSD skin;
@@ -2886,21 +3153,15 @@ void LLMeshLODHandler::processFailure(LLCore::HttpStatus status)
 void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
 								   U8 * data, S32 data_size)
 {
-	if ((! MESH_LOD_PROCESS_FAILED) && gMeshRepo.mThread->lodReceived(mMeshParams, mLOD, data, data_size))
+	if ((! MESH_LOD_PROCESS_FAILED) && data && data_size > 0)
 	{
-		//good fetch from sim, write to VFS for caching
-		LLVFile file(gVFS, mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLVFile::WRITE);
-
-		S32 offset = mOffset;
-		S32 size = mRequestedBytes;
-
-		if (file.getSize() >= offset+size)
-		{
-			file.seek(offset);
-			file.write(data, size);
-			LLMeshRepository::sCacheBytesWritten += size;
-			++LLMeshRepository::sCacheWrites;
-		}
+		// hand the block to the decode pool, which also writes it to
+		// the VFS once it's known to be good.  Only the requested range
+		// belongs to this LOD.
+		S32 size = llmin(data_size, (S32) mRequestedBytes);
+		U8* buffer = new U8[size];
+		memcpy(buffer, data, size);		/* Flawfinder: ignore */
+		gMeshRepo.mThread->mDecodePool->submitRequest(LLMeshDecodePool::Request(mMeshParams, mLOD, buffer, size, mOffset, false));
 	}
 	else
 	{
@@ -3258,6 +3519,12 @@ void LLMeshRepository::notifyLoadedMeshes()
 													 REQUEST2_LOW_WATER_MAX);
 	}
 
+	if (mThread && mThread->mDecodePool)
+	{
+		mThread->mDecodePool->setOptimizerSettings(gSavedSettings.getF32("MeshOverdrawThreshold"),
+												   gSavedSettings.getBOOL("MeshOptimizerStats"));
+	}
+
 	//clean up completed upload threads
 	for (std::vector<LLMeshUploadThread*>::iterator iter = mUploads.begin(); iter != mUploads.end(); )
 	{
@@ -217,6 +217,66 @@ public:
 
 };
 
+class LLMeshRepoThread;
+
+// Pool of worker threads that inflate and unpack mesh LOD blocks
+// into LLVolumes so the repo thread is left with networking and
+// bookkeeping only.  Blocks come either from an HTTP response or
+// from the VFS, in which case the read also happens on the pool.
+class LLMeshDecodePool
+{
+public:
+	class Request
+	{
+	public:
+		LLVolumeParams mMeshParams;
+		S32 mLOD;
+		U8* mData;			// owned by the pool once submitted, NULL to read from VFS
+		S32 mDataSize;
+		S32 mOffset;		// offset of the block in the cached asset
+		bool mFromCache;
+		F32 mOverdrawThreshold;		// optimizer settings as of submitRequest()
+		bool mLogOptimizerStats;
+
+		Request(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size, S32 offset, bool from_cache)
+			: mMeshParams(mesh_params), mLOD(lod), mData(data), mDataSize(data_size), mOffset(offset), mFromCache(from_cache),
+			  mOverdrawThreshold(0.f), mLogOptimizerStats(false)
+		{
+		}
+	};
+
+	class DecodeThread : public LLThread
+	{
+	public:
+		DecodeThread(LLMeshDecodePool* pool, const std::string& name);
+		virtual void run();
+
+		LLMeshDecodePool* mPool;
+	};
+
+	LLMeshDecodePool(LLMeshRepoThread* repo_thread, U32 num_threads);
+	~LLMeshDecodePool();
+
+	void shutdown();
+	// Copies the optimizer settings into the request
+	void submitRequest(const Request& request);
+
+	// Thread:  main
+	void setOptimizerSettings(F32 overdraw_threshold, bool log_stats);
+
+	// Blocks until a request is available, false when shutting down
+	bool getNextRequest(Request& request);
+	void processRequest(Request& request);
+
+	LLMeshRepoThread* mRepoThread;
+	LLCondition* mSignal;				// guards mRequestQ and the optimizer settings
+	std::queue<Request> mRequestQ;
+	F32 mOverdrawThreshold;				// Allowed ACMR growth for overdraw ordering, < 1 disables
+	bool mLogOptimizerStats;			// Log ACMR/ATVR and optimizer time for each LOD received
+	std::vector<DecodeThread*> mThreads;
+	bool mQuitting;
+};
+
 class LLMeshRepoThread : public LLThread
 {
 public:
@@ -260,9 +320,10 @@ public:
 		LLVolumeParams  mMeshParams;
 		S32 mLOD;
 		F32 mScore;
+		bool mSkipCache;	// cached copy failed to decode, go to the network
 
 		LODRequest(const LLVolumeParams&  mesh_params, S32 lod)
-			: mMeshParams(mesh_params), mLOD(lod), mScore(0.f)
+			: mMeshParams(mesh_params), mLOD(lod), mScore(0.f), mSkipCache(false)
 		{
 		}
 	};
@@ -339,6 +400,8 @@ public:
 	std::string mGetMesh2Capability;
 	int mGetMeshVersion;
 
+	LLMeshDecodePool* mDecodePool;
+
 	LLMeshRepoThread();
 	~LLMeshRepoThread();
 
@@ -348,9 +411,10 @@ public:
 	void loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 
 	bool fetchMeshHeader(const LLVolumeParams& mesh_params);
-	bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
+	bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool use_cache = true);
 	bool headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size);
-	bool lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size);
+	bool lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size, F32 overdraw_threshold, bool log_stats);
+	void optimizeLOD(LLVolume* volume, const LLUUID& mesh_id, S32 lod, F32 overdraw_threshold, bool log_stats);
 	bool skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
 	bool decompositionReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
 	bool physicsShapeReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
@@ -514,10 +578,11 @@ public:
 	static U32 sHTTPErrorCount;					// Requests ending in error
 	static U32 sLODPending;
 	static U32 sLODProcessing;
-	static U32 sCacheBytesRead;
-	static U32 sCacheBytesWritten;
-	static U32 sCacheReads;						
-	static U32 sCacheWrites;
+	static LLAtomicU32 sCacheBytesRead;			// the decode threads read from the cache too
+	static LLAtomicU32 sCacheBytesWritten;
+	static LLAtomicU32 sCacheReads;
+	static LLAtomicU32 sCacheWrites;
+	static LLAtomicU32 sDecodedCacheHits;		// LODs loaded from LLMeshDiskCache
 	static U32 sMaxLockHoldoffs;				// Maximum sequential locking failures
 	
 	static LLDeadmanTimer sQuiescentTimer;		// Time-to-complete-mesh-downloads after significant events
@@ -73,6 +73,17 @@ public:
 		return *this;
 	}
 
+	// rebuilt with the geometry of every changed group, from a slab pool
+	void* operator new(size_t size)
+	{
+		return slab_new<LLDrawInfo>(size);
+	}
+
+	void operator delete(void* ptr, size_t size)
+	{
+		slab_delete<LLDrawInfo>(ptr, size);
+	}
+
 	LLDrawInfo(U16 start, U16 end, U32 count, U32 offset, 
 				LLViewerTexture* image, LLVertexBuffer* buffer, 
 				BOOL fullbright = FALSE, U8 bump = 0, BOOL particle = FALSE, F32 part_size = 0);
@@ -469,6 +480,10 @@ public:
 
 };
 
+// The lists keep their memory from one cull to the next, clear() only resets
+// their sizes, so once they have grown to the scene culling and sorting make
+// no allocations for them.  That's also why they don't come from the frame
+// arena: it would hand them fresh blocks to grow into every other frame.
 class LLCullResult 
 {
 public:
@@ -38,6 +38,7 @@
 #include <time.h>
 
 #include "llviewermedia_streamingaudio.h"
+#include "llaudiodecodemgr.h"
 #include "llaudioengine.h"
 
 #ifdef LL_FMODEX
@@ -756,6 +757,8 @@ bool idle_startup()
 #else
 				void* window_handle = NULL;
 #endif
+				LLAudioDecodeMgr::sNumDecodeThreads = gSavedSettings.getU32("AudioDecodeThreads");
+				LLAudioDecodeMgr::sMaxCacheBytes = (U64) gSavedSettings.getU32("AudioDecodeCacheSize") * 1024 * 1024;
 				bool init = gAudiop->init(kAUDIO_NUM_SOURCES, window_handle);
 				if(init)
 				{
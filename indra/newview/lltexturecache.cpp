@@ -756,7 +756,7 @@ void LLTextureCacheWorker::endWork(S32 param, bool aborted)
 //////////////////////////////////////////////////////////////////////////////
 
 LLTextureCache::LLTextureCache(bool threaded)
-	: LLWorkerThread("TextureCache", threaded),
+	: LLWorkerThread("TextureCache", threaded, false, 1),
 	  mWorkersMutex(NULL),
 	  mHeaderMutex(NULL),
 	  mListMutex(NULL),
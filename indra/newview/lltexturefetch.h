@@ -33,6 +33,7 @@
 #include "lldir.h"
 #include "llimage.h"
 #include "lluuid.h"
+#include "lluuidflatmap.h"
 #include "llworkerthread.h"
 #include "lltextureinfo.h"
 #include "llapr.h"
@@ -320,7 +321,7 @@ private:
 	LLImageDecodeThread* mImageDecodeThread;
 	
 	// Map of all requests by UUID
-	typedef std::map<LLUUID,LLTextureFetchWorker*> map_t;
+	typedef LLUUIDFlatMap<LLTextureFetchWorker*> map_t;
 	map_t mRequestMap;													// Mfq
 
 	// Set of requests that require network data
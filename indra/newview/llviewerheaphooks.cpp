@@ -0,0 +1,102 @@
+/**
+ * @file llviewerheaphooks.cpp
+ * @brief Global operator new and delete, reporting to LLHeapAllocationCounter
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h" // must be first include
+
+#include "llmemory.h"
+
+#include <cstdlib>
+#include <new>
+
+// The replacements behave like the standard ones and use the same heap, so
+// memory from either may be freed by the other.  With tcmalloc the
+// operators are its own and the counters only see the aligned allocations.
+#if !LL_USE_TCMALLOC
+
+void* operator new(size_t size) throw(std::bad_alloc)
+{
+	LLHeapAllocationCounter::countAllocation();
+	if (size == 0)
+	{
+		size = 1;
+	}
+	void* ptr;
+	while (!(ptr = malloc(size)))
+	{
+		std::new_handler handler = std::set_new_handler(NULL);
+		std::set_new_handler(handler);
+		if (!handler)
+		{
+			throw std::bad_alloc();
+		}
+		handler();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size) throw(std::bad_alloc)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+	try
+	{
+		return operator new(size);
+	}
+	catch (std::bad_alloc&)
+	{
+		return NULL;
+	}
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) throw()
+{
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void* ptr) throw()
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr) throw()
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) throw()
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) throw()
+{
+	free(ptr);
+}
+
+#endif // !LL_USE_TCMALLOC
@@ -54,7 +54,7 @@ F32 LLViewerPartSim::sParticleAdaptiveRate = 0.0625f;
 F32 LLViewerPartSim::sParticleBurstRate = 0.5f;
 
 //static
-const S32 LLViewerPartSim::MAX_PART_COUNT = 8192;
+const S32 LLViewerPartSim::MAX_PART_COUNT = LL_MAX_PARTICLE_COUNT;
 const F32 LLViewerPartSim::PART_THROTTLE_THRESHOLD = 0.9f;
 const F32 LLViewerPartSim::PART_ADAPT_RATE_MULT = 2.0f;
 
@@ -126,6 +126,180 @@ void LLViewerPart::init(LLPointer<LLViewerPartSource> sourcep, LLViewerTexture *
 }
 
 
+/////////////////////////////
+//
+// LLViewerPartStore implementation
+//
+//
+
+LLViewerPartStore::LLViewerPartStore()
+:	mPosAgent(NULL),
+	mVelocity(NULL),
+	mAccel(NULL),
+	mColor(NULL),
+	mStartColor(NULL),
+	mEndColor(NULL),
+	mScale(NULL),
+	mStartScale(NULL),
+	mEndScale(NULL),
+	mAge(NULL),
+	mMaxAge(NULL),
+	mSkipOffset(NULL),
+	mStartGlow(NULL),
+	mEndGlow(NULL),
+	mDt(NULL),
+	mIntegrateDt(NULL),
+	mFlags(NULL),
+	mNeedsPart(NULL),
+	mCount(0),
+	mCapacity(0)
+{
+}
+
+LLViewerPartStore::~LLViewerPartStore()
+{
+	ll_aligned_free_16(mPosAgent);
+	ll_aligned_free_16(mVelocity);
+	ll_aligned_free_16(mAccel);
+	ll_aligned_free_16(mColor);
+	ll_aligned_free_16(mStartColor);
+	ll_aligned_free_16(mEndColor);
+	ll_aligned_free_16(mScale);
+	ll_aligned_free_16(mStartScale);
+	ll_aligned_free_16(mEndScale);
+	ll_aligned_free_16(mAge);
+	ll_aligned_free_16(mMaxAge);
+	ll_aligned_free_16(mSkipOffset);
+	ll_aligned_free_16(mStartGlow);
+	ll_aligned_free_16(mEndGlow);
+	ll_aligned_free_16(mDt);
+	ll_aligned_free_16(mIntegrateDt);
+	ll_aligned_free_16(mFlags);
+	ll_aligned_free_16(mNeedsPart);
+}
+
+template <class T> static void grow_array(T*& array, S32 count, S32 old_count)
+{
+	array = (T*) ll_aligned_realloc_16(array, sizeof(T) * count, sizeof(T) * old_count);
+}
+
+void LLViewerPartStore::reserve(S32 count)
+{
+	if (count <= mCapacity)
+	{
+		return;
+	}
+
+	count = llmax(count, mCapacity * 2, 16);
+	grow_array(mPosAgent, count, mCapacity);
+	grow_array(mVelocity, count, mCapacity);
+	grow_array(mAccel, count, mCapacity);
+	grow_array(mColor, count, mCapacity);
+	grow_array(mStartColor, count, mCapacity);
+	grow_array(mEndColor, count, mCapacity);
+	grow_array(mScale, count, mCapacity);
+	grow_array(mStartScale, count, mCapacity);
+	grow_array(mEndScale, count, mCapacity);
+	grow_array(mAge, count, mCapacity);
+	grow_array(mMaxAge, count, mCapacity);
+	grow_array(mSkipOffset, count, mCapacity);
+	grow_array(mStartGlow, count, mCapacity);
+	grow_array(mEndGlow, count, mCapacity);
+	grow_array(mDt, count, mCapacity);
+	grow_array(mIntegrateDt, count, mCapacity);
+	grow_array(mFlags, count, mCapacity);
+	grow_array(mNeedsPart, count, mCapacity);
+	mCapacity = count;
+}
+
+//static
+bool LLViewerPartStore::needsPart(const LLViewerPart* part)
+{
+	const U32 SOURCE_FLAGS = LLPartData::LL_PART_FOLLOW_SRC_MASK |
+							 LLPartData::LL_PART_WIND_MASK |
+							 LLPartData::LL_PART_TARGET_POS_MASK |
+							 LLPartData::LL_PART_TARGET_LINEAR_MASK |
+							 LLPartData::LL_PART_BOUNCE_MASK;
+
+	return part->mVPCallback || (part->mFlags & SOURCE_FLAGS);
+}
+
+void LLViewerPartStore::push_back(const LLViewerPart* part)
+{
+	reserve(mCount + 1);
+	load(mCount++, part);
+}
+
+void LLViewerPartStore::load(S32 i, const LLViewerPart* part)
+{
+	llassert(i < mCount);
+
+	mPosAgent[i].load3(part->mPosAgent.mV);
+	mVelocity[i].load3(part->mVelocity.mV);
+	mAccel[i].load3(part->mAccel.mV);
+	mColor[i].loadua(part->mColor.mV);
+	mStartColor[i].loadua(part->mStartColor.mV);
+	mEndColor[i].loadua(part->mEndColor.mV);
+	mScale[i].set(part->mScale.mV[VX], part->mScale.mV[VY], 0.f);
+	mStartScale[i].set(part->mStartScale.mV[VX], part->mStartScale.mV[VY], 0.f);
+	mEndScale[i].set(part->mEndScale.mV[VX], part->mEndScale.mV[VY], 0.f);
+	mAge[i] = part->mLastUpdateTime;
+	mMaxAge[i] = part->mMaxAge;
+	mSkipOffset[i] = part->mSkipOffset;
+	mStartGlow[i] = part->mStartGlow;
+	mEndGlow[i] = part->mEndGlow;
+	mDt[i] = 0.f;
+	mIntegrateDt[i] = 0.f;
+	mFlags[i] = part->mFlags;
+	mNeedsPart[i] = needsPart(part);
+}
+
+void LLViewerPartStore::store(S32 i, LLViewerPart* part) const
+{
+	llassert(i < mCount);
+
+	const F32* scale = mScale[i].getF32ptr();
+
+	part->mPosAgent.set(mPosAgent[i].getF32ptr());
+	part->mVelocity.set(mVelocity[i].getF32ptr());
+	part->mColor.set(mColor[i].getF32ptr());
+	part->mScale.set(scale[VX], scale[VY]);
+	part->mLastUpdateTime = mAge[i];
+	part->mSkipOffset = mSkipOffset[i];
+	part->mFlags = mFlags[i];
+}
+
+void LLViewerPartStore::swapRemove(S32 i)
+{
+	llassert(i < mCount);
+
+	S32 last = --mCount;
+	if (i == last)
+	{
+		return;
+	}
+
+	mPosAgent[i] = mPosAgent[last];
+	mVelocity[i] = mVelocity[last];
+	mAccel[i] = mAccel[last];
+	mColor[i] = mColor[last];
+	mStartColor[i] = mStartColor[last];
+	mEndColor[i] = mEndColor[last];
+	mScale[i] = mScale[last];
+	mStartScale[i] = mStartScale[last];
+	mEndScale[i] = mEndScale[last];
+	mAge[i] = mAge[last];
+	mMaxAge[i] = mMaxAge[last];
+	mSkipOffset[i] = mSkipOffset[last];
+	mStartGlow[i] = mStartGlow[last];
+	mEndGlow[i] = mEndGlow[last];
+	mDt[i] = mDt[last];
+	mIntegrateDt[i] = mIntegrateDt[last];
+	mFlags[i] = mFlags[last];
+	mNeedsPart[i] = mNeedsPart[last];
+}
+
+
 /////////////////////////////
 //
 // LLViewerPartGroup implementation
@@ -268,156 +442,198 @@ BOOL LLViewerPartGroup::addPart(LLViewerPart* part, F32 desired_size)
 	
 	mParticles.push_back(part);
 	part->mSkipOffset=mSkippedTime;
+	mPartStore.push_back(part);
 	LLViewerPartSim::incPartCount(1);
 	return TRUE;
 }
 
 
-void LLViewerPartGroup::updateParticles(const F32 lastdt)
+// Moves a particle that depends on its source, the region wind or a
+// callback.  These run on the LLViewerPart, everything else is integrated
+// in LLViewerPartGroup::updateParticles.
+static void simulate_part(LLViewerPart* part, const F32 dt, LLViewerRegion* regionp)
 {
-	F32 dt;
-	
-	LLVector3 gravity(0.f, 0.f, GRAVITY);
+	const F32 cur_time = part->mLastUpdateTime + dt;
+	const F32 frac = cur_time / part->mMaxAge;
 
-	LLViewerPartSim::checkParticleCount(mParticles.size());
+	// "Drift" the object based on the source object
+	if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
+	{
+		part->mPosAgent = part->mPartSourcep->mPosAgent;
+		part->mPosAgent += part->mPosOffset;
+	}
 
-	LLViewerCamera* camera = LLViewerCamera::getInstance();
-	LLViewerRegion *regionp = getRegion();
-	S32 end = (S32) mParticles.size();
-	for (S32 i = 0 ; i < (S32)mParticles.size();)
+	// Do a custom callback if we have one...
+	if (part->mVPCallback)
 	{
-		LLVector3 a(0.f, 0.f, 0.f);
-		LLViewerPart* part = mParticles[i] ;
+		(*part->mVPCallback)(*part, dt);
+	}
+
+	if (part->mFlags & LLPartData::LL_PART_WIND_MASK)
+	{
+		part->mVelocity *= 1.f - 0.1f*dt;
+		part->mVelocity += 0.1f*dt*regionp->mWind.getVelocity(regionp->getPosRegionFromAgent(part->mPosAgent));
+	}
 
-		dt = lastdt + mSkippedTime - part->mSkipOffset;
-		part->mSkipOffset = 0.f;
+	// Now do interpolation towards a target
+	if (part->mFlags & LLPartData::LL_PART_TARGET_POS_MASK)
+	{
+		F32 remaining = part->mMaxAge - part->mLastUpdateTime;
+		F32 step = dt / remaining;
 
-		// Update current time
-		const F32 cur_time = part->mLastUpdateTime + dt;
-		const F32 frac = cur_time / part->mMaxAge;
+		step = llclamp(step, 0.f, 0.1f);
+		step *= 5.f;
+		// we want a velocity that will result in reaching the target in the 
+		// Interpolate towards the target.
+		LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPosAgent;
 
-		// "Drift" the object based on the source object
-		if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
-		{
-			part->mPosAgent = part->mPartSourcep->mPosAgent;
-			part->mPosAgent += part->mPosOffset;
-		}
+		delta_pos /= remaining;
 
-		// Do a custom callback if we have one...
-		if (part->mVPCallback)
-		{
-			(*part->mVPCallback)(*part, dt);
-		}
+		part->mVelocity *= (1.f - step);
+		part->mVelocity += step*delta_pos;
+	}
 
-		if (part->mFlags & LLPartData::LL_PART_WIND_MASK)
+
+	if (part->mFlags & LLPartData::LL_PART_TARGET_LINEAR_MASK)
+	{
+		LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPartSourcep->mPosAgent;			
+		part->mPosAgent = part->mPartSourcep->mPosAgent;
+		part->mPosAgent += frac*delta_pos;
+		part->mVelocity = delta_pos;
+	}
+	else
+	{
+		// Do velocity interpolation
+		part->mPosAgent += dt*part->mVelocity;
+		part->mPosAgent += 0.5f*dt*dt*part->mAccel;
+		part->mVelocity += part->mAccel*dt;
+	}
+
+	// Do a bounce test
+	if (part->mFlags & LLPartData::LL_PART_BOUNCE_MASK)
+	{
+		// Need to do point vs. plane check...
+		// For now, just check relative to object height...
+		F32 dz = part->mPosAgent.mV[VZ] - part->mPartSourcep->mPosAgent.mV[VZ];
+		if (dz < 0)
 		{
-			LLVector3 tempVel(part->mVelocity);
-			part->mVelocity *= 1.f - 0.1f*dt;
-			part->mVelocity += 0.1f*dt*regionp->mWind.getVelocity(regionp->getPosRegionFromAgent(part->mPosAgent));
+			part->mPosAgent.mV[VZ] += -2.f*dz;
+			part->mVelocity.mV[VZ] *= -0.75f;
 		}
+	}
 
-		// Now do interpolation towards a target
-		if (part->mFlags & LLPartData::LL_PART_TARGET_POS_MASK)
-		{
-			F32 remaining = part->mMaxAge - part->mLastUpdateTime;
-			F32 step = dt / remaining;
 
-			step = llclamp(step, 0.f, 0.1f);
-			step *= 5.f;
-			// we want a velocity that will result in reaching the target in the 
-			// Interpolate towards the target.
-			LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPosAgent;
+	// Reset the offset from the source position
+	if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
+	{
+		part->mPosOffset = part->mPosAgent;
+		part->mPosOffset -= part->mPartSourcep->mPosAgent;
+	}
+}
 
-			delta_pos /= remaining;
+void LLViewerPartGroup::updateParticles(const F32 lastdt)
+{
+	LLViewerPartSim::checkParticleCount(mParticles.size());
+	llassert(mPartStore.size() == (S32) mParticles.size());
 
-			part->mVelocity *= (1.f - step);
-			part->mVelocity += step*delta_pos;
-		}
+	LLViewerCamera* camera = LLViewerCamera::getInstance();
+	LLViewerRegion *regionp = getRegion();
+	LLViewerPartStore& store = mPartStore;
+	S32 end = (S32) mParticles.size();
 
+	// Time steps, and the particles that need their source or a callback
+	for (S32 i = 0; i < end; i++)
+	{
+		const F32 dt = lastdt + mSkippedTime - store.mSkipOffset[i];
+		store.mSkipOffset[i] = 0.f;
+		store.mDt[i] = dt;
 
-		if (part->mFlags & LLPartData::LL_PART_TARGET_LINEAR_MASK)
+		if (store.mNeedsPart[i])
 		{
-			LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPartSourcep->mPosAgent;			
-			part->mPosAgent = part->mPartSourcep->mPosAgent;
-			part->mPosAgent += frac*delta_pos;
-			part->mVelocity = delta_pos;
+			LLViewerPart* part = mParticles[i];
+			store.store(i, part);
+			simulate_part(part, dt, regionp);
+			store.load(i, part);
+			store.mDt[i] = dt;
+			store.mIntegrateDt[i] = 0.f;
 		}
 		else
 		{
-			// Do velocity interpolation
-			part->mPosAgent += dt*part->mVelocity;
-			part->mPosAgent += 0.5f*dt*dt*part->mAccel;
-			part->mVelocity += part->mAccel*dt;
-		}
-
-		// Do a bounce test
-		if (part->mFlags & LLPartData::LL_PART_BOUNCE_MASK)
-		{
-			// Need to do point vs. plane check...
-			// For now, just check relative to object height...
-			F32 dz = part->mPosAgent.mV[VZ] - part->mPartSourcep->mPosAgent.mV[VZ];
-			if (dz < 0)
-			{
-				part->mPosAgent.mV[VZ] += -2.f*dz;
-				part->mVelocity.mV[VZ] *= -0.75f;
-			}
+			store.mIntegrateDt[i] = dt;
 		}
+	}
 
+	// Velocity integration
+	for (S32 i = 0; i < end; i++)
+	{
+		LLVector4a dt;
+		dt.splat(store.mIntegrateDt[i]);
+		LLVector4a half_dt_sq;
+		half_dt_sq.splat(0.5f*store.mIntegrateDt[i]*store.mIntegrateDt[i]);
+
+		LLVector4a delta;
+		delta.setMul(store.mVelocity[i], dt);
+		store.mPosAgent[i].add(delta);
+		delta.setMul(store.mAccel[i], half_dt_sq);
+		store.mPosAgent[i].add(delta);
+		delta.setMul(store.mAccel[i], dt);
+		store.mVelocity[i].add(delta);
+	}
 
-		// Reset the offset from the source position
-		if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
-		{
-			part->mPosOffset = part->mPosAgent;
-			part->mPosOffset -= part->mPartSourcep->mPosAgent;
-		}
+	// Color and scale interpolation, age
+	for (S32 i = 0; i < end; i++)
+	{
+		const F32 cur_time = store.mAge[i] + store.mDt[i];
+		const F32 frac = cur_time / store.mMaxAge[i];
 
-		// Do color interpolation
-		if (part->mFlags & LLPartData::LL_PART_INTERP_COLOR_MASK)
+		if (store.mFlags[i] & LLPartData::LL_PART_INTERP_COLOR_MASK)
 		{
-			part->mColor.setVec(part->mStartColor);
-			// note: LLColor4's v%k means multiply-alpha-only,
-			//       LLColor4's v*k means multiply-rgb-only
-			part->mColor *= 1.f - frac; // rgb*k
-			part->mColor %= 1.f - frac; // alpha*k
-			part->mColor += frac%(frac*part->mEndColor); // rgb,alpha
+			store.mColor[i].setLerp(store.mStartColor[i], store.mEndColor[i], frac);
 		}
 
-		// Do scale interpolation
-		if (part->mFlags & LLPartData::LL_PART_INTERP_SCALE_MASK)
+		if (store.mFlags[i] & LLPartData::LL_PART_INTERP_SCALE_MASK)
 		{
-			part->mScale.setVec(part->mStartScale);
-			part->mScale *= 1.f - frac;
-			part->mScale += frac*part->mEndScale;
+			store.mScale[i].setLerp(store.mStartScale[i], store.mEndScale[i], frac);
 		}
 
-		// Do glow interpolation
-		part->mGlow.mV[3] = (U8) llround(lerp(part->mStartGlow, part->mEndGlow, frac)*255.f);
-
 		// Set the last update time to now.
-		part->mLastUpdateTime = cur_time;
+		store.mAge[i] = cur_time;
+	}
 
+	// Hand the new state to the particles, kill or transfer the ones that
+	// are done here
+	for (S32 i = 0 ; i < (S32)mParticles.size();)
+	{
+		LLViewerPart* part = mParticles[i] ;
 
 		// Kill dead particles (either flagged dead, or too old)
-		if ((part->mLastUpdateTime > part->mMaxAge) || (LLViewerPart::LL_PART_DEAD_MASK == part->mFlags))
+		if ((store.mAge[i] > store.mMaxAge[i]) || (LLViewerPart::LL_PART_DEAD_MASK == store.mFlags[i]))
 		{
 			mParticles[i] = mParticles.back() ;
 			mParticles.pop_back() ;
+			store.swapRemove(i);
 			delete part ;
+			continue;
+		}
+
+		store.store(i, part);
+
+		// Do glow interpolation
+		const F32 frac = store.mAge[i] / store.mMaxAge[i];
+		part->mGlow.mV[3] = (U8) llround(lerp(store.mStartGlow[i], store.mEndGlow[i], frac)*255.f);
+
+		F32 desired_size = calc_desired_size(camera, part->mPosAgent, part->mScale);
+		if (!posInGroup(part->mPosAgent, desired_size))
+		{
+			// Transfer particles between groups
+			mParticles[i] = mParticles.back() ;
+			mParticles.pop_back() ;
+			store.swapRemove(i);
+			LLViewerPartSim::getInstance()->put(part) ;
 		}
-		else 
+		else
 		{
-			F32 desired_size = calc_desired_size(camera, part->mPosAgent, part->mScale);
-			if (!posInGroup(part->mPosAgent, desired_size))
-			{
-				// Transfer particles between groups
-				LLViewerPartSim::getInstance()->put(part) ;
-				mParticles[i] = mParticles.back() ;
-				mParticles.pop_back() ;
-			}
-			else
-			{
-				i++ ;
-			}
+			i++ ;
 		}
 	}
 
@@ -449,9 +665,13 @@ void LLViewerPartGroup::shift(const LLVector3 &offset)
 	mMinObjPos += offset;
 	mMaxObjPos += offset;
 
+	LLVector4a offset4a;
+	offset4a.load3(offset.mV);
+
 	for (S32 i = 0 ; i < (S32)mParticles.size(); i++)
 	{
 		mParticles[i]->mPosAgent += offset;
+		mPartStore.mPosAgent[i].add(offset4a);
 	}
 }
 
@@ -462,6 +682,7 @@ void LLViewerPartGroup::removeParticlesByID(const U32 source_id)
 		if(mParticles[i]->mPartSourcep->getID() == source_id)
 		{
 			mParticles[i]->mFlags = LLViewerPart::LL_PART_DEAD_MASK;
+			mPartStore.mFlags[i] = LLViewerPart::LL_PART_DEAD_MASK;
 		}		
 	}
 }
@@ -30,14 +30,16 @@
 #include "llframetimer.h"
 #include "llpointer.h"
 #include "llpartdata.h"
+#include "llslaballocator.h"
 #include "llviewerpartsource.h"
 
+class LLVector4a;
 class LLViewerTexture;
 class LLViewerPart;
 class LLViewerRegion;
 class LLVOPartGroup;
 
-#define LL_MAX_PARTICLE_COUNT 8192
+#define LL_MAX_PARTICLE_COUNT 16384	// 4 vertices each, must fit 16 bit indices
 
 typedef void (*LLVPCallback)(LLViewerPart &part, const F32 dt);
 
@@ -47,7 +49,8 @@ typedef void (*LLVPCallback)(LLViewerPart &part, const F32 dt);
 //
 
 
-class LLViewerPart : public LLPartData
+// thousands are born and die every second, they come from a slab pool
+class LLViewerPart : public LLPartData, public LLSlabAllocated<LLViewerPart>
 {
 public:
 	~LLViewerPart();
@@ -85,6 +88,66 @@ public:
 
 
 
+///////////////////
+//
+// Simulation state of the particles in a group, entry i belongs to
+// LLViewerPartGroup::mParticles[i].  The per frame integration runs over
+// these aligned arrays; the LLViewerPart fields are the copy the renderer,
+// ribbons, callbacks and group transfers see and are refreshed from here
+// once per update.
+//
+
+class LLViewerPartStore
+{
+public:
+	LLViewerPartStore();
+	~LLViewerPartStore();
+
+	S32 size() const { return mCount; }
+
+	// add an entry at the end from the state of part
+	void push_back(const LLViewerPart* part);
+
+	// copy entry i from/to the fields of part
+	void load(S32 i, const LLViewerPart* part);
+	void store(S32 i, LLViewerPart* part) const;
+
+	// move the last entry into slot i
+	void swapRemove(S32 i);
+
+	// true if the particle needs its source, the region or a callback to
+	// move and has to be simulated on the LLViewerPart
+	static bool needsPart(const LLViewerPart* part);
+
+private:
+	void reserve(S32 count);
+
+public:
+	LLVector4a*		mPosAgent;
+	LLVector4a*		mVelocity;
+	LLVector4a*		mAccel;
+	LLVector4a*		mColor;
+	LLVector4a*		mStartColor;
+	LLVector4a*		mEndColor;
+	LLVector4a*		mScale;			// x, y, 0, 0
+	LLVector4a*		mStartScale;
+	LLVector4a*		mEndScale;
+	F32*			mAge;			// LLViewerPart::mLastUpdateTime
+	F32*			mMaxAge;
+	F32*			mSkipOffset;
+	F32*			mStartGlow;
+	F32*			mEndGlow;
+	F32*			mDt;			// time step of the current update
+	F32*			mIntegrateDt;	// mDt, or 0 if integrated on the LLViewerPart
+	U32*			mFlags;
+	U8*				mNeedsPart;
+
+private:
+	S32				mCount;
+	S32				mCapacity;
+};
+
+
 class LLViewerPartGroup
 {
 public:
@@ -116,6 +179,7 @@ public:
 	void removeParticlesByID(const U32 source_id);
 	
 	LLPointer<LLVOPartGroup> mVOPartGroupp;
+	LLViewerPartStore mPartStore;
 
 	BOOL mUniformParticles;
 	U32 mID;
@@ -651,7 +651,7 @@ public:
 				ypos += y_inc;
 				// </FS:Ansariel>
 
-				addText(xpos, ypos, llformat("%.3f/%.3f MB Mesh Cache Read/Write ", LLMeshRepository::sCacheBytesRead/(1024.f*1024.f), LLMeshRepository::sCacheBytesWritten/(1024.f*1024.f)));
+				addText(xpos, ypos, llformat("%.3f/%.3f MB Mesh Cache Read/Write ", (U32) LLMeshRepository::sCacheBytesRead/(1024.f*1024.f), (U32) LLMeshRepository::sCacheBytesWritten/(1024.f*1024.f)));
 
 				ypos += y_inc;
 			}
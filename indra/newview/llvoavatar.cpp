@@ -3236,7 +3236,7 @@ void LLVOAvatar::slamPosition()
 	{
 		gPipeline.updateMoveNormalAsync(mDrawable);
 	}
-	mRoot->updateWorldMatrixChildren();
+	mJointHierarchy.updateWorldMatrices();
 }
 
 bool LLVOAvatar::isVisuallyMuted()
@@ -3917,7 +3917,7 @@ BOOL LLVOAvatar::updateCharacter(LLAgent &agent)
 		}
 	}
 
-	mRoot->updateWorldMatrixChildren();
+	mJointHierarchy.updateWorldMatrices();
 
 	//mesh vertices need to be reskinned
 	mNeedsSkin = TRUE;
@@ -3952,7 +3952,7 @@ void LLVOAvatar::updateHeadOffset()
 //------------------------------------------------------------------------
 void LLVOAvatar::postPelvisSetRecalc( void )
 {		
-	mRoot->updateWorldMatrixChildren();			
+	mJointHierarchy.updateWorldMatrices();			
 	computeBodySize();
 	dirtyMesh(2);
 }
@@ -5745,7 +5745,7 @@ void LLVOAvatar::updateVisualParams()
 	{
 		computeBodySize();
 		mLastSkeletonSerialNum = mSkeletonSerialNum;
-		mRoot->updateWorldMatrixChildren();
+		mJointHierarchy.updateWorldMatrices();
 	}
 
 	dirtyMesh();
@@ -6273,7 +6273,7 @@ void LLVOAvatar::sitOnObject(LLViewerObject *sit_object)
 	sitDown(TRUE);
 	mRoot->getXform()->setParent(&sit_object->mDrawable->mXform); // LLVOAvatar::sitOnObject
 	mRoot->setPosition(getPosition());
-	mRoot->updateWorldMatrixChildren();
+	mJointHierarchy.updateWorldMatrices();
 
 	stopMotion(ANIM_AGENT_BODY_NOISE);
 
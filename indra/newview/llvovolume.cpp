@@ -36,6 +36,7 @@
 #include "lldir.h"
 #include "llflexibleobject.h"
 #include "llfloatertools.h"
+#include "llframearena.h"
 #include "llmaterialid.h"
 #include "llmaterialtable.h"
 #include "llprimitive.h"
@@ -5447,6 +5448,11 @@ static LLTrace::BlockTimerStatHandle FTM_GEN_DRAW_INFO_ALLOCATE("Allocate VB");
 static LLTrace::BlockTimerStatHandle FTM_GEN_DRAW_INFO_FIND_VB("Find VB");
 static LLTrace::BlockTimerStatHandle FTM_GEN_DRAW_INFO_RESIZE_VB("Resize VB");
 
+// the buffers made for one mask of a group, copied to the group's own map at the end
+typedef std::vector<LLPointer<LLVertexBuffer>, LLFrameAllocator<LLPointer<LLVertexBuffer> > > frame_buffer_list_t;
+typedef std::map<LLFace*, frame_buffer_list_t, std::less<LLFace*>,
+				 LLFrameAllocator<std::pair<LLFace* const, frame_buffer_list_t> > > frame_buffer_texture_map_t;
+
 
 
 
@@ -5500,7 +5506,7 @@ void LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFac
 	LLFace** face_iter = faces;
 	LLFace** end_faces = faces+face_count;
 	
-	LLSpatialGroup::buffer_map_t buffer_map;
+	frame_buffer_texture_map_t buffer_map;
 
 	LLViewerTexture* last_tex = NULL;
 	S32 buffer_index = 0;
@@ -5699,7 +5705,7 @@ void LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFac
 		group->mGeometryBytes += buffer->getSize() + buffer->getIndicesSize();
 
 
-		buffer_map[mask][*face_iter].push_back(buffer);
+		buffer_map[*face_iter].push_back(buffer);
 
 		//add face geometry
 
@@ -6037,9 +6043,9 @@ void LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFac
 	}
 
 	group->mBufferMap[mask].clear();
-	for (LLSpatialGroup::buffer_texture_map_t::iterator i = buffer_map[mask].begin(); i != buffer_map[mask].end(); ++i)
+	for (frame_buffer_texture_map_t::iterator i = buffer_map.begin(); i != buffer_map.end(); ++i)
 	{
-		group->mBufferMap[mask][i->first] = i->second;
+		group->mBufferMap[mask][i->first].assign(i->second.begin(), i->second.end());
 	}
 }
 
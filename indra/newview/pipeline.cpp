@@ -34,6 +34,7 @@
 #include "llviewercontrol.h"
 #include "llfasttimer.h"
 #include "llfontgl.h"
+#include "llframearena.h"
 #include "llnamevalue.h"
 #include "llpointer.h"
 #include "llprimitive.h"
@@ -2424,6 +2425,27 @@ BOOL LLPipeline::getVisibleExtents(LLCamera& camera, LLVector3& min, LLVector3&
 
 static LLTrace::BlockTimerStatHandle FTM_CULL("Object Culling");
 
+// Every heap allocation the render thread makes while culling and sorting,
+// through operator new or the aligned allocators: the cull results and
+// build lists growing, frame arena chunks, draw infos, vertex buffers and
+// whatever else stateSort() ends up creating.  Not zero even in a static
+// scene, rebuilds allocate, but a rising count points at a container that
+// doesn't keep its memory.
+static LLTrace::CountStatHandle<S32> sCullSortHeapAllocations("cull_sort_heap_allocations", "Heap allocations made by the render thread while culling and sorting");
+
+// adds the heap allocations made during its scope to the stat above
+class LLCullSortAllocationCounter
+{
+public:
+	~LLCullSortAllocationCounter()
+	{
+		LLTrace::add(sCullSortHeapAllocations, (S32) mCounter.getAllocations());
+	}
+
+private:
+	LLHeapAllocationCounter mCounter;
+};
+
 void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result, S32 water_clip, LLPlane* planep)
 {
 	static LLCachedControl<bool> use_occlusion(gSavedSettings,"UseOcclusion");
@@ -2432,6 +2454,7 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result, S32 water_cl
 									&& gGLManager.mHasOcclusionQuery;
 
 	LL_RECORD_BLOCK_TIME(FTM_CULL);
+	LLCullSortAllocationCounter allocation_counter;
 
 	grabReferences(result);
 
@@ -3420,6 +3443,7 @@ void LLPipeline::stateSort(LLCamera& camera, LLCullResult &result)
 	}
 
 	LL_RECORD_BLOCK_TIME(FTM_STATESORT);
+	LLCullSortAllocationCounter allocation_counter;
 
 	//LLVertexBuffer::unbind();
 
@@ -8410,6 +8434,9 @@ static LLTrace::BlockTimerStatHandle FTM_FULLSCREEN_LIGHTS("Fullscreen Lights");
 static LLTrace::BlockTimerStatHandle FTM_PROJECTORS("Projectors");
 static LLTrace::BlockTimerStatHandle FTM_POST("Post");
 
+// the lights gathered for one frame, from the frame arena
+typedef std::list<LLVector4, LLFrameAllocator<LLVector4> > frame_light_list_t;
+typedef std::list<LLPointer<LLDrawable>, LLFrameAllocator<LLPointer<LLDrawable> > > frame_drawable_list_t;
 
 void LLPipeline::renderDeferredLighting()
 {
@@ -8642,16 +8669,16 @@ void LLPipeline::renderDeferredLighting()
 		if (render_local)
 		{
 			gGL.setSceneBlendType(LLRender::BT_ADD);
-			std::list<LLVector4> fullscreen_lights;
-			LLDrawable::drawable_list_t spot_lights;
-			LLDrawable::drawable_list_t fullscreen_spot_lights;
+			frame_light_list_t fullscreen_lights;
+			frame_drawable_list_t spot_lights;
+			frame_drawable_list_t fullscreen_spot_lights;
 
 			for (U32 i = 0; i < 2; i++)
 			{
 				mTargetShadowSpotLight[i] = NULL;
 			}
 
-			std::list<LLVector4> light_colors;
+			frame_light_list_t light_colors;
 
 			LLVertexBuffer::unbind();
 
@@ -8770,7 +8797,7 @@ void LLPipeline::renderDeferredLighting()
 
 				gDeferredSpotLightProgram.enableTexture(LLShaderMgr::DEFERRED_PROJECTION);
 
-				for (LLDrawable::drawable_list_t::iterator iter = spot_lights.begin(); iter != spot_lights.end(); ++iter)
+				for (frame_drawable_list_t::iterator iter = spot_lights.begin(); iter != spot_lights.end(); ++iter)
 				{
 					LL_RECORD_BLOCK_TIME(FTM_PROJECTORS);
 					LLDrawable* drawablep = *iter;
@@ -8864,7 +8891,7 @@ void LLPipeline::renderDeferredLighting()
 
 				mDeferredVB->setBuffer(LLVertexBuffer::MAP_VERTEX);
 
-				for (LLDrawable::drawable_list_t::iterator iter = fullscreen_spot_lights.begin(); iter != fullscreen_spot_lights.end(); ++iter)
+				for (frame_drawable_list_t::iterator iter = fullscreen_spot_lights.begin(); iter != fullscreen_spot_lights.end(); ++iter)
 				{
 					LL_RECORD_BLOCK_TIME(FTM_PROJECTORS);
 					LLDrawable* drawablep = *iter;
@@ -9190,16 +9217,16 @@ void LLPipeline::renderDeferredLightingToRT(LLRenderTarget* target)
 		if (render_local)
 		{
 			gGL.setSceneBlendType(LLRender::BT_ADD);
-			std::list<LLVector4> fullscreen_lights;
-			LLDrawable::drawable_list_t spot_lights;
-			LLDrawable::drawable_list_t fullscreen_spot_lights;
+			frame_light_list_t fullscreen_lights;
+			frame_drawable_list_t spot_lights;
+			frame_drawable_list_t fullscreen_spot_lights;
 
 			for (U32 i = 0; i < 2; i++)
 			{
 				mTargetShadowSpotLight[i] = NULL;
 			}
 
-			std::list<LLVector4> light_colors;
+			frame_light_list_t light_colors;
 
 			LLVertexBuffer::unbind();
 
@@ -9318,7 +9345,7 @@ void LLPipeline::renderDeferredLightingToRT(LLRenderTarget* target)
 
 				gDeferredSpotLightProgram.enableTexture(LLShaderMgr::DEFERRED_PROJECTION);
 
-				for (LLDrawable::drawable_list_t::iterator iter = spot_lights.begin(); iter != spot_lights.end(); ++iter)
+				for (frame_drawable_list_t::iterator iter = spot_lights.begin(); iter != spot_lights.end(); ++iter)
 				{
 					LL_RECORD_BLOCK_TIME(FTM_PROJECTORS);
 					LLDrawable* drawablep = *iter;
@@ -9413,7 +9440,7 @@ void LLPipeline::renderDeferredLightingToRT(LLRenderTarget* target)
 
 				mDeferredVB->setBuffer(LLVertexBuffer::MAP_VERTEX);
 
-				for (LLDrawable::drawable_list_t::iterator iter = fullscreen_spot_lights.begin(); iter != fullscreen_spot_lights.end(); ++iter)
+				for (frame_drawable_list_t::iterator iter = fullscreen_spot_lights.begin(); iter != fullscreen_spot_lights.end(); ++iter)
 				{
 					LL_RECORD_BLOCK_TIME(FTM_PROJECTORS);
 					LLDrawable* drawablep = *iter;
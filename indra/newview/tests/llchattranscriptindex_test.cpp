@@ -0,0 +1,132 @@
+/**
+ * @file llchattranscriptindex_test.cpp
+ * @brief LLChatTranscriptIndex test cases.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llchattranscriptindex.h"
+
+#include "lluuid.h"
+
+namespace tut
+{
+	struct transcriptindex_test
+	{
+		std::string mPath;
+
+		transcriptindex_test()
+		{
+			LLUUID id;
+			id.generate();
+			mPath = LLFile::tmpdir() + id.asString() + ".txt";
+		}
+
+		~transcriptindex_test()
+		{
+			LLFile::remove(mPath);
+			LLFile::remove(LLChatTranscriptIndex::getIndexFileName(mPath));
+		}
+
+		void write(const char* mode, const std::string& text)
+		{
+			LLFILE* fp = LLFile::fopen(mPath, mode);
+			fwrite(text.data(), 1, text.size(), fp);
+			fclose(fp);
+		}
+	};
+
+	typedef test_group<transcriptindex_test> transcriptindex_t;
+	typedef transcriptindex_t::object transcriptindex_object_t;
+	tut::transcriptindex_t tut_transcriptindex("LLChatTranscriptIndex");
+
+	template<> template<>
+	void transcriptindex_object_t::test<1>()
+	{
+		ensure_equals("dated stamp", LLChatTranscriptIndex::parseTimestamp("[2016/01/02 03:04]  Someone: hi"), (U32) 1451703840);
+		ensure_equals("epoch", LLChatTranscriptIndex::parseTimestamp("[1970/01/01 00:00] x"), (U32) 0);
+		ensure_equals("time only", LLChatTranscriptIndex::parseTimestamp("[03:04]  Someone: hi"), (U32) 0);
+		ensure_equals("no stamp", LLChatTranscriptIndex::parseTimestamp("Someone: hi"), (U32) 0);
+		ensure_equals("bad month", LLChatTranscriptIndex::parseTimestamp("[2016/13/02 03:04] x"), (U32) 0);
+	}
+
+	template<> template<>
+	void transcriptindex_object_t::test<2>()
+	{
+		write("wb", "[2016/01/02 03:04]  Someone: one\n"
+					"[2016/01/02 03:05]  Someone: two\n"
+					" still two\n"
+					"\n"
+					"[2016/01/02 03:07]  Someone: three\n"
+					"[2016/01/02 03:08]  Someone: unfinished");
+
+		LLChatTranscriptIndex index;
+		ensure("loaded", index.load(mPath));
+		ensure_equals("whole messages", index.getMessageCount(), 3);
+		ensure_equals("second offset", index.getMessageOffset(1), (S64) 33);
+		ensure_equals("third offset", index.getMessageOffset(2), (S64) 78);
+
+		S64 begin, end;
+		index.getByteRange(1, 1, begin, end);
+		ensure_equals("range begin", begin, (S64) 33);
+		ensure_equals("range end", end, (S64) 78);
+		index.getByteRange(2, 10, begin, end);
+		ensure_equals("clamped end", end, (S64) 113);
+
+		ensure_equals("at time", index.findMessageAtTime(LLChatTranscriptIndex::parseTimestamp("[2016/01/02 03:06]")), 2);
+		ensure_equals("after all", index.findMessageAtTime(LLChatTranscriptIndex::parseTimestamp("[2016/01/03 00:00]")), 3);
+		ensure("index file", LLFile::isfile(LLChatTranscriptIndex::getIndexFileName(mPath)));
+	}
+
+	template<> template<>
+	void transcriptindex_object_t::test<3>()
+	{
+		write("wb", "[2016/01/02 03:04]  Someone: one\n");
+		LLChatTranscriptIndex index;
+		index.load(mPath);
+		ensure_equals("first load", index.getMessageCount(), 1);
+
+		// appended messages are added to the saved index
+		write("ab", "[2016/01/02 03:05]  Someone: two\n[03:06]  Someone: three\n");
+		LLChatTranscriptIndex appended;
+		appended.load(mPath);
+		ensure_equals("appended", appended.getMessageCount(), 3);
+		ensure_equals("offset", appended.getMessageOffset(2), (S64) 66);
+		ensure_equals("undated keeps time", appended.getMessageTime(2), appended.getMessageTime(1));
+
+		// a replaced transcript is indexed again
+		write("wb", "[2017/05/06 07:08]  Other: new\n[2017/05/06 07:09]  Other: log\n");
+		LLChatTranscriptIndex replaced;
+		replaced.load(mPath);
+		ensure_equals("replaced", replaced.getMessageCount(), 2);
+		ensure_equals("replaced offset", replaced.getMessageOffset(1), (S64) 31);
+
+		LLFile::remove(mPath);
+		LLChatTranscriptIndex missing;
+		ensure("missing transcript", !missing.load(mPath));
+		ensure_equals("empty", missing.getMessageCount(), 0);
+	}
+}
@@ -0,0 +1,183 @@
+/**
+ * @file llinventorysearchindex_test.cpp
+ * @brief LLInventorySearchIndex test cases.
+ *
+ * $LicenseInfo:firstyear=2016&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2016, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llinventorysearchindex.h"
+
+#include <algorithm>
+
+namespace tut
+{
+	struct searchindex_test
+	{
+		LLInventorySearchIndex mIndex;
+		LLUUID mItems[4];
+		LLUUID mCreators[2];
+		LLUUID mFolder;
+
+		searchindex_test()
+		{
+			for (S32 i = 0; i < 4; ++i)
+			{
+				mItems[i].generate();
+			}
+			mCreators[0].generate();
+			mCreators[1].generate();
+			mFolder.generate();
+
+			mIndex.setItem(mItems[0], mFolder, mCreators[0], "Chair", "Red wooden chair", LLUUID("0a1b2c3d-0000-4000-8000-000000000001"));
+			mIndex.setItem(mItems[1], mFolder, mCreators[0], "Table", "blue wooden table", LLUUID::null);
+			mIndex.setItem(mItems[2], mFolder, mCreators[1], "Vase", "", LLUUID("0a1b2c3d-0000-4000-8000-000000000002"));
+			mIndex.setItem(mItems[3], mFolder, mCreators[1], "Glass", "Red glass", LLUUID::null);
+		}
+
+		bool found(LLInventorySearchIndex::EField field, const std::string& sub_string, S32 item)
+		{
+			LLInventorySearchIndex::slot_vec_t slots;
+			mIndex.findSlots(field, sub_string, slots);
+			S32 slot = mIndex.getSlot(mItems[item]);
+			return slot >= 0 && std::binary_search(slots.begin(), slots.end(), (U32) slot);
+		}
+	};
+
+	typedef test_group<searchindex_test> searchindex_t;
+	typedef searchindex_t::object searchindex_object_t;
+	tut::searchindex_t tut_searchindex("LLInventorySearchIndex");
+
+	template<> template<>
+	void searchindex_object_t::test<1>()
+	{
+		LLInventorySearchIndex::slot_vec_t slots;
+		ensure("short substrings aren't indexed", !mIndex.findSlots(LLInventorySearchIndex::FIELD_DESCRIPTION, "RE", slots));
+		ensure("unknown trigram", mIndex.findSlots(LLInventorySearchIndex::FIELD_DESCRIPTION, "XYZ", slots) && slots.empty());
+
+		ensure("red 0", found(LLInventorySearchIndex::FIELD_DESCRIPTION, "RED", 0));
+		ensure("red 1", !found(LLInventorySearchIndex::FIELD_DESCRIPTION, "RED", 1));
+		ensure("red 3", found(LLInventorySearchIndex::FIELD_DESCRIPTION, "RED", 3));
+		ensure("wooden 0", found(LLInventorySearchIndex::FIELD_DESCRIPTION, "WOODEN", 0));
+		ensure("wooden 1", found(LLInventorySearchIndex::FIELD_DESCRIPTION, "WOODEN", 1));
+		ensure("wooden 3", !found(LLInventorySearchIndex::FIELD_DESCRIPTION, "WOODEN", 3));
+		ensure("lower case text", found(LLInventorySearchIndex::FIELD_DESCRIPTION, "BLUE WOOD", 1));
+
+		ensure("asset 0", found(LLInventorySearchIndex::FIELD_ASSET_ID, "0A1B2C3D", 0));
+		ensure("asset 2", found(LLInventorySearchIndex::FIELD_ASSET_ID, "0A1B2C3D", 2));
+		ensure("null asset", !found(LLInventorySearchIndex::FIELD_ASSET_ID, "000", 1));
+		ensure("fields are separate", !found(LLInventorySearchIndex::FIELD_DESCRIPTION, "0A1B", 0));
+
+		ensure("name 0", found(LLInventorySearchIndex::FIELD_NAME, "CHAIR", 0));
+		ensure("name 1", !found(LLInventorySearchIndex::FIELD_NAME, "CHAIR", 1));
+		ensure("name not description", !found(LLInventorySearchIndex::FIELD_NAME, "WOODEN", 0));
+	}
+
+	template<> template<>
+	void searchindex_object_t::test<2>()
+	{
+		U32 slot_end = mIndex.getSlotEnd();
+		S32 old_slot = mIndex.getSlot(mItems[1]);
+
+		// unchanged fields keep the slot
+		mIndex.setItem(mItems[1], mFolder, mCreators[0], "Table", "blue wooden table", LLUUID::null);
+		ensure_equals("same slot", mIndex.getSlot(mItems[1]), old_slot);
+
+		// changes move the item past the old end
+		mIndex.setItem(mItems[1], mFolder, mCreators[0], "Table", "red plastic table", LLUUID::null);
+		ensure("new slot", mIndex.getSlot(mItems[1]) >= (S32) slot_end);
+		ensure("new text", found(LLInventorySearchIndex::FIELD_DESCRIPTION, "PLASTIC", 1));
+		ensure("old text", !found(LLInventorySearchIndex::FIELD_DESCRIPTION, "WOODEN", 1));
+
+		mIndex.removeItem(mItems[0]);
+		ensure_equals("removed", mIndex.getSlot(mItems[0]), -1);
+		ensure_equals("item count", mIndex.getNumItems(), 3);
+
+		LLInventorySearchIndex::slot_vec_t slots;
+		mIndex.appendCreatorSlots(mCreators[1], slots);
+		ensure("creator 2", std::find(slots.begin(), slots.end(), (U32) mIndex.getSlot(mItems[2])) != slots.end());
+		ensure("creator 3", std::find(slots.begin(), slots.end(), (U32) mIndex.getSlot(mItems[3])) != slots.end());
+		ensure("other creator", std::find(slots.begin(), slots.end(), (U32) mIndex.getSlot(mItems[1])) == slots.end());
+	}
+
+	template<> template<>
+	void searchindex_object_t::test<3>()
+	{
+		// enough churn compacts the index and renumbers the slots
+		U32 layout = mIndex.getLayoutGeneration();
+		for (S32 i = 0; i < 3000; ++i)
+		{
+			mIndex.setItem(mItems[2], mFolder, mCreators[1], "Vase", llformat("glass vase %d", i), LLUUID::null);
+		}
+		ensure("compacted", mIndex.getLayoutGeneration() != layout);
+		ensure("stays small", mIndex.getSlotEnd() < 2000);
+		ensure_equals("item count", mIndex.getNumItems(), 4);
+		ensure("latest text", found(LLInventorySearchIndex::FIELD_DESCRIPTION, "VASE 2999", 2));
+		ensure("older text", !found(LLInventorySearchIndex::FIELD_DESCRIPTION, "VASE 2998", 2));
+		ensure("others kept", found(LLInventorySearchIndex::FIELD_DESCRIPTION, "WOODEN", 0));
+
+		mIndex.clear();
+		ensure_equals("cleared", mIndex.getNumItems(), 0);
+		ensure_equals("no slot", mIndex.getSlot(mItems[3]), -1);
+	}
+
+	template<> template<>
+	void searchindex_object_t::test<4>()
+	{
+		// moves and flags
+		U32 slot_end = mIndex.getSlotEnd();
+		LLUUID other_folder;
+		other_folder.generate();
+		mIndex.setItem(mItems[3], other_folder, mCreators[1], "Glass", "Red glass", LLUUID::null);
+		ensure("moved", mIndex.getSlot(mItems[3]) >= (S32) slot_end);
+		ensure("item of the slot", mIndex.getItemID(mIndex.getSlot(mItems[3])) == mItems[3]);
+
+		LLUUID link;
+		link.generate();
+		mIndex.setItem(link, mFolder, LLUUID::null, "", "", LLUUID::null, LLInventorySearchIndex::FLAG_LINK);
+		mIndex.setItem(mItems[0], mFolder, mCreators[0], "Chair", "Red wooden chair", LLUUID("0a1b2c3d-0000-4000-8000-000000000001"),
+					   LLInventorySearchIndex::FLAG_LABEL_SUFFIX);
+		ensure("same fields, new flags", mIndex.getItemID(mIndex.getSlot(mItems[0])) == mItems[0] && mIndex.getSlot(mItems[0]) >= (S32) slot_end);
+
+		LLInventorySearchIndex::slot_vec_t slots;
+		mIndex.appendFlaggedSlots(LLInventorySearchIndex::FLAG_LINK, slots);
+		ensure_equals("one link", slots.size(), (size_t) 1);
+		ensure_equals("link slot", (S32) slots[0], mIndex.getSlot(link));
+		slots.clear();
+		mIndex.appendFlaggedSlots(LLInventorySearchIndex::FLAG_LABEL_SUFFIX, slots);
+		ensure_equals("one suffix", slots.size(), (size_t) 1);
+		ensure_equals("suffix slot", (S32) slots[0], mIndex.getSlot(mItems[0]));
+
+		// links have no creator of their own
+		uuid_vec_t creators;
+		mIndex.getCreators(creators);
+		ensure_equals("creators", creators.size(), (size_t) 2);
+
+		// removed items leave their slots behind, without an item
+		U32 link_slot = mIndex.getSlot(link);
+		mIndex.removeItem(link);
+		ensure("stale slot", mIndex.getItemID(link_slot).isNull());
+	}
+}